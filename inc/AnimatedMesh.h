@@ -10,6 +10,27 @@ class AnimatedMesh
 {
 public:
 
+   // A range of triangles whose vertices are influenced by at most numInfluences joints
+   // Each range can be rendered with a shader variant that only fetches numInfluences skin matrices
+   struct InfluenceBucket
+   {
+      unsigned int numInfluences;
+      unsigned int firstIndex;
+      unsigned int numIndices;
+   };
+
+   // A simplified version of the mesh that uses the same vertices (see GenerateLevelsOfDetail)
+   // Its indices are stored after the ones of the full-detail mesh, in the same index buffer
+   struct LevelOfDetail
+   {
+      unsigned int                 firstIndex;
+      unsigned int                 numIndices;
+      // The influence buckets of the simplified triangles, whose first indices are relative to the start of the index buffer
+      std::vector<InfluenceBucket> influenceBuckets;
+      // The largest distance between the simplified surface and the full-detail one, in the units of the mesh
+      float                        error;
+   };
+
    AnimatedMesh();
    ~AnimatedMesh();
 
@@ -26,9 +47,29 @@ public:
    std::vector<glm::ivec4>&   GetInfluences() { return mInfluences; }
    std::vector<unsigned int>& GetIndices()    { return mIndices;    }
 
+   const std::vector<glm::vec3>&    GetPositions()  const { return mPositions;  }
+   const std::vector<glm::vec3>&    GetNormals()    const { return mNormals;    }
+   const std::vector<glm::vec2>&    GetTexCoords()  const { return mTexCoords;  }
+   const std::vector<glm::vec4>&    GetWeights()    const { return mWeights;    }
+   const std::vector<glm::ivec4>&   GetInfluences() const { return mInfluences; }
+   const std::vector<unsigned int>& GetIndices()    const { return mIndices;    }
+
+   std::vector<InfluenceBucket>& GetInfluenceBuckets() { return mInfluenceBuckets; }
+   std::vector<LevelOfDetail>&   GetLevelsOfDetail()   { return mLevelsOfDetail;   }
+
+   // Level 0 is the full-detail mesh, and levels 1 and above are the simplified versions
+   unsigned int                        GetNumberOfLevelsOfDetail() const;
+   unsigned int                        GetNumberOfIndicesOfLevelOfDetail(unsigned int levelOfDetail) const;
+   float                               GetErrorOfLevelOfDetail(unsigned int levelOfDetail) const;
+   const std::vector<InfluenceBucket>& GetInfluenceBucketsOfLevelOfDetail(unsigned int levelOfDetail) const;
+
    void                       LoadBuffers();
    void                       ClearMeshData();
 
+   bool                       CanPackVertices() const;
+   void                       LoadPackedBuffers();
+   bool                       UsesPackedVertices() const { return mUsesPackedVertices; }
+
    void                       ConfigureVAO(int posAttribLocation,
                                            int normalAttribLocation,
                                            int texCoordsAttribLocation,
@@ -41,21 +82,54 @@ public:
                                              int weightsAttribLocation,
                                              int influencesAttribLocation);
 
+   void                       ConfigurePackedVAO(int posAttribLocation,
+                                                 int normalAttribLocation,
+                                                 int texCoordsAttribLocation,
+                                                 int weightsAttribLocation,
+                                                 int influencesAttribLocation);
+
+   // The skinned VAO reads the positions and normals from a VBO that is written by CaptureSkinnedVertices,
+   // which makes it possible to render the skinned mesh with a static mesh shader
+   // This must be called after the buffers are loaded, since the size of the skinned VBO depends on the number of vertices
+   void                       ConfigureSkinnedVAO(int posAttribLocation,
+                                                  int normalAttribLocation,
+                                                  int texCoordsAttribLocation);
+
    void                       BindFloatAttribute(int attribLocation, unsigned int VBO, int numComponents);
    void                       BindIntAttribute(int attribLocation, unsigned int VBO, int numComponents);
    void                       UnbindAttribute(int attribLocation, unsigned int VBO);
 
    void                       Render();
    void                       RenderInstanced(unsigned int numInstances);
+   void                       RenderInfluenceBucket(const InfluenceBucket& bucket);
+
+   // These only issue the draw calls, so the VAO must already be bound (e.g. by a RenderQueue)
+   unsigned int               GetVAO() const { return mVAO; }
+   void                       Draw() const;
+   void                       DrawLevelOfDetail(unsigned int levelOfDetail) const;
+   void                       DrawInfluenceBucket(const InfluenceBucket& bucket) const;
+
+   // This skins every vertex once and writes the result into the skinned VBO with transform feedback
+   // Like the functions above, it only issues the draw call, so the VAO and a program that outputs the skinned vertices must already be bound
+   unsigned int               GetSkinnedVAO() const { return mSkinnedVAO; }
+   void                       CaptureSkinnedVertices() const;
+#ifndef __EMSCRIPTEN__
+   // Reads the skinned VBO back, which is slow and is only meant to verify its contents
+   void                       ReadSkinnedVertices(std::vector<glm::vec3>& outPositions, std::vector<glm::vec3>& outNormals) const;
+#endif
 
 private:
 
-   std::vector<glm::vec3>      mPositions;
-   std::vector<glm::vec3>      mNormals;
-   std::vector<glm::vec2>      mTexCoords;
-   std::vector<glm::vec4>      mWeights;
-   std::vector<glm::ivec4>     mInfluences;
-   std::vector<unsigned int>   mIndices;
+   void                         LoadIndexBuffer();
+
+   std::vector<glm::vec3>       mPositions;
+   std::vector<glm::vec3>       mNormals;
+   std::vector<glm::vec2>       mTexCoords;
+   std::vector<glm::vec4>       mWeights;
+   std::vector<glm::ivec4>      mInfluences;
+   std::vector<unsigned int>    mIndices;
+   std::vector<InfluenceBucket> mInfluenceBuckets;
+   std::vector<LevelOfDetail>   mLevelsOfDetail;
 
    enum VBOTypes : unsigned int
    {
@@ -66,11 +140,19 @@ private:
       influences = 4
    };
 
-   unsigned int                mNumVertices;
-   unsigned int                mNumIndices;
-   unsigned int                mVAO;
-   std::array<unsigned int, 5> mVBOs;
-   unsigned int                mEBO;
+   unsigned int                 mNumVertices;
+   // The number of indices of the full-detail mesh, which doesn't include the indices of the levels of detail
+   unsigned int                 mNumIndices;
+   // GL_UNSIGNED_SHORT when the mesh has few enough vertices, GL_UNSIGNED_INT otherwise
+   unsigned int                 mIndexType;
+   // When this is true, all the attributes are interleaved in the positions VBO (see LoadPackedBuffers)
+   bool                         mUsesPackedVertices;
+   unsigned int                 mVAO;
+   std::array<unsigned int, 5>  mVBOs;
+   unsigned int                 mEBO;
+   // These are only created by ConfigureSkinnedVAO
+   unsigned int                 mSkinnedVAO;
+   unsigned int                 mSkinnedVBO;
 };
 
 #endif
@@ -0,0 +1,85 @@
+#ifndef BAKED_CLIP_H
+#define BAKED_CLIP_H
+
+#include <vector>
+
+#include "Clip.h"
+#include "Skeleton.h"
+
+/*
+   A BakedClip stores the poses of a clip at a fixed frame rate, so that playing it back doesn't require sampling any tracks
+   Playing it back only requires blending the two frames that surround the playback time, or even just selecting the nearest one
+
+   The frames can store the local poses of the clip, which still have to be converted into skin matrices,
+   or the skin matrices themselves, which can be used as they are by the skinning shaders
+
+   This trades memory for speed, so it's meant for the clips that are played all the time (e.g. the idle loop of a main character)
+   EstimateMemoryFootprint can be used to find out how much memory a clip will occupy before baking it
+
+   The first frame is sampled at the start of the clip, each frame after it is 1 / framesPerSecond seconds later than the previous one,
+   and the last frame is sampled at the end of the clip, so it can be closer to the second to last frame than the others
+   Since sampling a looping clip at its end time produces its first pose, the last frame of a looping clip blends smoothly into the first one
+*/
+
+class BakedClip
+{
+public:
+
+   enum class Content
+   {
+      LocalPoses,
+      SkinMatrices
+   };
+
+   enum class Playback
+   {
+      Blend,
+      Nearest
+   };
+
+   BakedClip();
+   BakedClip(const FastClip& clip, Skeleton& skeleton, float framesPerSecond, Content content);
+   ~BakedClip() = default;
+
+   BakedClip(const BakedClip&) = delete;
+   BakedClip& operator=(const BakedClip&) = delete;
+
+   BakedClip(BakedClip&&) = default;
+   BakedClip& operator=(BakedClip&&) = default;
+
+   static unsigned int CalculateNumberOfFrames(float duration, float framesPerSecond);
+   static size_t       EstimateMemoryFootprint(float duration, unsigned int numJoints, float framesPerSecond, Content content);
+
+   Content             GetContent() const;
+   float               GetFramesPerSecond() const;
+   unsigned int        GetNumberOfFrames() const;
+   unsigned int        GetNumberOfJoints() const;
+   size_t              GetMemoryFootprint() const;
+
+   // The functions below expect a time that's already within the range of the clip (see TClip::AdjustTimeToBeWithinClip)
+   // SamplePose can only be used when the clip stores local poses, and SampleSkinMatrices when it stores skin matrices
+   void                SamplePose(float time, Playback playback, Pose& ioPose) const;
+   void                SampleSkinMatrices(float time, Playback playback, std::vector<glm::mat4>& outSkinMatrices) const;
+
+   // Skin matrices don't store the global transforms of the joints, which are only needed to display the skeleton,
+   // so this recovers them by undoing the inverse bind pose
+   void                GetPosePaletteFromSkinMatrices(const std::vector<glm::mat4>& skinMatrices, std::vector<glm::mat4>& outPosePalette) const;
+
+private:
+
+   void                FindFramesToSample(float time, Playback playback, unsigned int& outFrameIndex, float& outBlendFactor) const;
+
+   Content                mContent;
+   float                  mFramesPerSecond;
+   float                  mStartTime;
+   float                  mDuration;
+   unsigned int           mNumFrames;
+   unsigned int           mNumJoints;
+
+   // The frames are stored one after the other, and each frame stores the local transforms or the skin matrices of all the joints
+   std::vector<Transform> mLocalTransforms;
+   std::vector<glm::mat4> mSkinMatrices;
+   std::vector<glm::mat4> mBindPosePalette;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CPU_SKINNING_H
+#define CPU_SKINNING_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AnimatedMesh.h"
+#include "ThreadPool.h"
+
+/*
+   The functions below skin vertices on the CPU in the same way as animated_mesh_with_pregenerated_skin_matrices.vert,
+   which is useful when the skinned vertices are needed outside of a vertex shader (e.g. for validation, picking, bounds or exporting)
+
+   Each vertex is transformed by the weighted sum of the skin matrices of its 4 influences, and its normal is normalized afterwards
+   The influences of the vertices must be valid indices into the skin matrices
+
+   On x86 SkinVertices and SkinMesh use SSE, and on other platforms (including the web build) they use the scalar code of SkinVerticesWithScalarCode
+   SkinVerticesWithScalarCode is compiled on every platform, so that the SSE code can be checked against it
+   The overloads that take a ThreadPool also split the vertices into chunks that are skinned in parallel,
+   but in the web build the chunks are skinned on the calling thread, since the pool doesn't have any threads there
+*/
+
+// The normals can be null, in which case outNormals isn't written
+void SkinVertices(const glm::vec3*              positions,
+                  const glm::vec3*              normals,
+                  const glm::vec4*              weights,
+                  const glm::ivec4*             influences,
+                  unsigned int                  numVertices,
+                  const std::vector<glm::mat4>& skinMatrices,
+                  glm::vec3*                    outPositions,
+                  glm::vec3*                    outNormals);
+
+void SkinVerticesWithScalarCode(const glm::vec3*              positions,
+                                const glm::vec3*              normals,
+                                const glm::vec4*              weights,
+                                const glm::ivec4*             influences,
+                                unsigned int                  numVertices,
+                                const std::vector<glm::mat4>& skinMatrices,
+                                glm::vec3*                    outPositions,
+                                glm::vec3*                    outNormals);
+
+// These resize outPositions and outNormals to the number of vertices of the mesh
+// If the mesh doesn't have any weights, its positions and normals are copied as they are
+void SkinMesh(const AnimatedMesh&           mesh,
+              const std::vector<glm::mat4>& skinMatrices,
+              std::vector<glm::vec3>&       outPositions,
+              std::vector<glm::vec3>&       outNormals);
+
+void SkinMesh(const AnimatedMesh&           mesh,
+              const std::vector<glm::mat4>& skinMatrices,
+              std::vector<glm::vec3>&       outPositions,
+              std::vector<glm::vec3>&       outNormals,
+              ThreadPool&                   threadPool);
+
+#endif
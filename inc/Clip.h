@@ -39,10 +39,10 @@ public:
 
    float               Sample(Pose& ioPose, float time) const;
 
-private:
-
    float               AdjustTimeToBeWithinClip(float time) const;
 
+private:
+
    std::vector<TRACK> mTransformTracks;
    std::string        mName;
    float              mStartTime;
@@ -0,0 +1,102 @@
+#ifndef CLIP_LIBRARY_H
+#define CLIP_LIBRARY_H
+
+#include <list>
+#include <deque>
+#include <memory>
+
+#include "GLTFLoader.h"
+#include "Clip.h"
+#include "BakedClip.h"
+#include "RearrangeBones.h"
+
+/*
+   A ClipLibrary stores the clips of a single character
+
+   Decoding, optimizing and rearranging a clip is expensive, and the viewer only displays one clip at a time,
+   so instead of doing all that work up front for every clip, a ClipLibrary only copies the raw key frames of each clip
+   out of the glTF data when it's created, and it decodes each clip the first time it's requested
+   The raw key frames are much smaller than the glTF data, which can be freed as soon as the library is created
+
+   To keep the resident memory in check, decoded clips are evicted in least recently used order
+   whenever the memory they occupy exceeds a budget
+   The raw key frames can't be evicted, but they count towards the budget too
+   The clip that was requested last is never evicted, since the viewer is still using it
+   Prefetched clips are treated as the most recently used clips after it, since the user is likely to select them next
+
+   Baking can be enabled for each clip individually, in which case the clip is baked the first time its baked version is requested
+   The baked clips count towards the memory budget, and they are evicted together with the clips they were baked from
+*/
+
+class ClipLibrary
+{
+public:
+
+   // An empty library is used as a placeholder for characters that haven't been loaded yet
+   ClipLibrary();
+   // The glTF data is only read by the constructor, so it can be freed as soon as the library is created
+   ClipLibrary(cgltf_data* data, const JointMap& jointMap);
+   ~ClipLibrary() = default;
+
+   ClipLibrary(const ClipLibrary&) = delete;
+   ClipLibrary& operator=(const ClipLibrary&) = delete;
+
+   ClipLibrary(ClipLibrary&& rhs) noexcept;
+   ClipLibrary& operator=(ClipLibrary&& rhs) noexcept;
+
+   unsigned int       GetNumberOfClips() const;
+   const std::string& GetClipName(unsigned int clipIndex) const;
+   bool               IsClipDecoded(unsigned int clipIndex) const;
+
+   FastClip&          GetClip(unsigned int clipIndex);
+
+   void               RequestPrefetch(unsigned int clipIndex);
+   void               RequestPrefetchOfNeighbors(unsigned int clipIndex);
+   void               ProcessPrefetchQueue(unsigned int maxNumClipsToDecode = 1);
+
+   // Changing the options of a clip that's already baked discards its baked version
+   void               EnableBakingOfClip(unsigned int clipIndex, float framesPerSecond, BakedClip::Content content);
+   void               DisableBakingOfClip(unsigned int clipIndex);
+   bool               IsBakingOfClipEnabled(unsigned int clipIndex) const;
+
+   // This returns null if baking isn't enabled for the clip
+   // The skeleton is only used to bake the clip, so it must always be the same one
+   const BakedClip*   GetBakedClip(unsigned int clipIndex, Skeleton& skeleton);
+
+   size_t             GetMemoryBudget() const;
+   void               SetMemoryBudget(size_t memoryBudgetInBytes);
+   // This includes the memory of the raw key frames
+   size_t             GetMemoryUsage() const;
+   size_t             GetMemoryUsageOfRawClips() const;
+
+private:
+
+   struct ClipDescriptor
+   {
+      RawClip                    rawClip;
+      std::unique_ptr<FastClip>  decodedClip;
+      std::unique_ptr<BakedClip> bakedClip;
+      bool                       bakingIsEnabled;
+      float                      bakingFramesPerSecond;
+      BakedClip::Content         bakedContent;
+      // This includes the memory of the baked clip, but not the one of the raw clip
+      size_t                     memoryFootprint;
+   };
+
+   void DecodeClip(unsigned int clipIndex);
+   void DiscardBakedClip(unsigned int clipIndex);
+   void EvictLeastRecentlyUsedClips();
+
+   JointMap                    mJointMap;
+   std::vector<ClipDescriptor> mClipDescriptors;
+
+   // The front of this list is the most recently used clip and the back is the least recently used one
+   std::list<unsigned int>     mLeastRecentlyUsedClips;
+   std::deque<unsigned int>    mPrefetchQueue;
+
+   size_t                      mMemoryBudget;
+   size_t                      mMemoryUsage;
+   size_t                      mMemoryUsageOfRawClips;
+};
+
+#endif
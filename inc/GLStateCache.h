@@ -0,0 +1,56 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <array>
+
+/*
+   A GLStateCache shadows the program, vertex array and texture bindings of the OpenGL context,
+   and it only forwards the calls that actually change them
+
+   The cache can only eliminate redundant calls if every change to that state goes through it
+   Code that binds things directly (e.g. loaders or ImGui) must be followed by a call to Invalidate,
+   which makes the cache forget what it knows so that the next call of each kind is always issued
+
+   The number of issued and skipped calls is counted so that the savings can be displayed
+*/
+
+class GLStateCache
+{
+public:
+
+   GLStateCache();
+   ~GLStateCache() = default;
+
+   GLStateCache(const GLStateCache&) = delete;
+   GLStateCache& operator=(const GLStateCache&) = delete;
+
+   GLStateCache(GLStateCache&&) = default;
+   GLStateCache& operator=(GLStateCache&&) = default;
+
+   void         UseProgram(unsigned int programID);
+   void         BindVertexArray(unsigned int vertexArrayID);
+   void         BindTexture(unsigned int textureUnit, unsigned int textureID);
+
+   void         Invalidate();
+   void         RestoreDefaultState();
+
+   void         ResetCounters();
+   unsigned int GetNumberOfIssuedCalls() const;
+   unsigned int GetNumberOfSkippedCalls() const;
+
+   static constexpr unsigned int maxNumTextureUnits = 8;
+
+private:
+
+   bool         ChangeState(unsigned int& cachedValue, unsigned int newValue);
+
+   unsigned int                                 mProgram;
+   unsigned int                                 mVertexArray;
+   unsigned int                                 mActiveTextureUnit;
+   std::array<unsigned int, maxNumTextureUnits> mTextures;
+
+   unsigned int                                 mNumIssuedCalls;
+   unsigned int                                 mNumSkippedCalls;
+};
+
+#endif
@@ -9,15 +9,39 @@
 #include <vector>
 #include <string>
 
+// The key frames of a channel of an animation, copied out of the glTF data so that they can be decoded after it has been freed
+struct RawAnimationChannel
+{
+   int                       targetJoint;
+   cgltf_animation_path_type targetPath;
+   cgltf_interpolation_type  interpolation;
+   std::vector<float>        keyFrameTimes;
+   std::vector<float>        keyFrameValues;
+};
+
+struct RawClip
+{
+   std::string                      name;
+   std::vector<RawAnimationChannel> channels;
+};
+
 cgltf_data*               LoadGLTFFile(const char* path);
 void                      FreeGLTFFile(cgltf_data* handle);
 
 Pose                      LoadRestPose(cgltf_data* data);
 std::vector<std::string>  LoadJointNames(cgltf_data* data);
 std::vector<Clip>         LoadClips(cgltf_data* data);
+Clip                      LoadClip(cgltf_data* data, unsigned int clipIndex);
+RawClip                   LoadRawClip(cgltf_data* data, unsigned int clipIndex);
+std::vector<RawClip>      LoadRawClips(cgltf_data* data);
+Clip                      DecodeRawClip(const RawClip& rawClip);
+size_t                    GetMemoryFootprintOfRawClip(const RawClip& rawClip);
+std::vector<std::string>  LoadClipNames(cgltf_data* data);
 Pose                      LoadBindPose(cgltf_data* data);
 Skeleton                  LoadSkeleton(cgltf_data* data);
-std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data);
+// When optimizeMeshes is false, the caller must call OptimizeMesh and GenerateLevelsOfDetail on each mesh,
+// which allows that work to be spread across multiple frames
+std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data, bool optimizeMeshes = true);
 std::vector<AnimatedMesh> LoadStaticMeshes(cgltf_data* data);
 
 #endif
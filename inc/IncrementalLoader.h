@@ -0,0 +1,65 @@
+#ifndef INCREMENTAL_LOADER_H
+#define INCREMENTAL_LOADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+   An IncrementalLoader splits the work of loading an application into a list of steps,
+   and it executes as many of those steps as it can in each frame without exceeding a time budget
+
+   This is important in the browser, where the main thread can't be blocked for long periods of time
+   without freezing the tab, but the same code path is used natively
+
+   Note that a step is never interrupted, so a step that takes longer than the time budget will exceed it
+   Because of this, the work should be split into steps that are as small as possible
+   Work whose size isn't known up front (e.g. processing every mesh of a file that hasn't been parsed yet) can be added as a resumable step,
+   which is called repeatedly until it returns true, so that it can do a small part of the work each time
+   At least one step is executed each time the loader is processed, which guarantees that loading always makes progress
+
+   The loader doesn't depend on OpenGL, so it can be tested headlessly with steps that don't issue GL calls
+*/
+
+class IncrementalLoader
+{
+public:
+
+   explicit IncrementalLoader(float timeBudgetInMilliseconds = 8.0f);
+   ~IncrementalLoader() = default;
+
+   IncrementalLoader(const IncrementalLoader&) = delete;
+   IncrementalLoader& operator=(const IncrementalLoader&) = delete;
+
+   IncrementalLoader(IncrementalLoader&&) = default;
+   IncrementalLoader& operator=(IncrementalLoader&&) = default;
+
+   void               AddStep(const std::string& description, const std::function<void()>& step);
+   void               AddResumableStep(const std::string& description, const std::function<bool()>& step);
+
+   bool               ProcessSteps();
+
+   bool               IsDone() const;
+   float              GetProgress() const;
+   unsigned int       GetNumberOfSteps() const;
+   unsigned int       GetNumberOfCompletedSteps() const;
+   const std::string& GetDescriptionOfNextStep() const;
+
+   float              GetTimeBudget() const;
+   void               SetTimeBudget(float timeBudgetInMilliseconds);
+
+private:
+
+   struct LoadStep
+   {
+      std::string           description;
+      // Returns true once the step is done
+      std::function<bool()> step;
+   };
+
+   std::vector<LoadStep> mSteps;
+   unsigned int          mIndexOfNextStep;
+   float                 mTimeBudgetInMilliseconds;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef JOINT_HIERARCHY_H
+#define JOINT_HIERARCHY_H
+
+#include <vector>
+
+#include "Pose.h"
+
+/*
+   A JointHierarchy stores the parent, the depth, the first child and the end of the subtree of each joint of a pose in a flat array,
+   so that the hierarchy can be traversed without having to search the parents of all the joints
+
+   When the joints are ordered depth first (see RearrangeSkeleton), the subtree of each joint is stored contiguously,
+   so the subtree of a joint is simply the range [jointIndex, subtreeEnd), and operations like bone masks, partial pose updates
+   and skipping entire subtrees become range operations:
+
+   (root) 0 ---- 1 ---- 2
+                 |
+                 |
+                 3 ---- 4
+
+                +----+----+----+----+----+
+      Joint IDs |  0 |  1 |  2 |  3 |  4 |
+                +----+----+----+----+----+
+     Parent IDs | -1 |  0 |  1 |  1 |  3 |
+                +----+----+----+----+----+
+         Depths |  0 |  1 |  2 |  2 |  3 |
+                +----+----+----+----+----+
+    First Child |  1 |  2 | -1 |  4 | -1 |
+                +----+----+----+----+----+
+   Subtree Ends |  5 |  5 |  3 |  5 |  5 |
+                +----+----+----+----+----+
+
+   When the joints are ordered breadth first, the subtrees aren't contiguous, so the subtree ends must not be used
+   (see HasContiguousSubtrees), but the direct children of each joint are still stored next to each other
+*/
+
+class JointHierarchy
+{
+public:
+
+   struct Joint
+   {
+      int          parent;
+      unsigned int depth;
+      // The child with the lowest index, or -1 if the joint doesn't have any children
+      int          firstChild;
+      // One past the index of the last joint of the subtree, which is only meaningful when the subtrees are contiguous
+      unsigned int subtreeEnd;
+   };
+
+   JointHierarchy();
+   JointHierarchy(const Pose& pose);
+
+   void                      Set(const Pose& pose);
+
+   unsigned int              GetNumberOfJoints() const;
+   const std::vector<Joint>& GetJoints() const;
+   const Joint&              GetJoint(unsigned int jointIndex) const;
+
+   bool                      HasContiguousSubtrees() const;
+
+   // This is a range check when the subtrees are contiguous, and a walk up the parents of the joint otherwise
+   bool                      IsInSubtree(unsigned int jointIndex, unsigned int rootOfSubtree) const;
+
+   // The mask has one entry per joint, which is set to true for the joints of the subtree and left unmodified for all the other ones
+   void                      AddSubtreeToMask(unsigned int rootOfSubtree, std::vector<bool>& ioMask) const;
+
+private:
+
+   std::vector<Joint> mJoints;
+   bool               mHasContiguousSubtrees;
+};
+
+#endif
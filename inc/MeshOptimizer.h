@@ -0,0 +1,30 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+
+#include "AnimatedMesh.h"
+
+// The statistics that OptimizeMesh returns, so that the caller can decide whether and how to report them
+// The number of triangles that use each influence count is stored in the influence buckets of the mesh
+struct MeshOptimizationStatistics
+{
+   unsigned int numVerticesBefore;
+   unsigned int numVerticesAfter;
+   unsigned int numTriangles;
+   float        acmrBefore;
+   float        acmrAfter;
+};
+
+float CalculateACMR(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize = 16);
+void  WeldVertices(AnimatedMesh& mesh);
+void  OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices);
+void  OptimizeVertexFetch(AnimatedMesh& mesh);
+void  PruneSkinWeights(AnimatedMesh& mesh, float minWeight = 0.01f);
+void  BucketTrianglesByInfluenceCount(AnimatedMesh& mesh);
+MeshOptimizationStatistics OptimizeMesh(AnimatedMesh& mesh);
+
+std::vector<unsigned int> SimplifyMesh(AnimatedMesh& mesh, const std::vector<unsigned int>& indices, unsigned int targetNumIndices, float& outError);
+void                      GenerateLevelsOfDetail(AnimatedMesh& mesh, unsigned int maxNumLevels = 3);
+
+#endif
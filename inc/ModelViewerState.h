@@ -1,23 +1,37 @@
 #ifndef MODEL_VIEWER_STATE_H
 #define MODEL_VIEWER_STATE_H
 
+#include <map>
+#ifndef __EMSCRIPTEN__
+#include <chrono>
+#endif
+
 #include "state.h"
 #include "finite_state_machine.h"
 #include "window.h"
 #include "Camera3.h"
 #include "texture.h"
 #include "AnimatedMesh.h"
+#include "MeshOptimizer.h"
 #include "SkeletonViewer.h"
-#include "Clip.h"
+#include "ClipLibrary.h"
 #include "TrackVisualizer.h"
+#include "IncrementalLoader.h"
+#include "RenderQueue.h"
+#include "PerFrameUniformBuffer.h"
+#include "PaletteAtlas.h"
+#include "PoseCache.h"
+#include "resource_manager.h"
 
 class ModelViewerState : public State
 {
 public:
 
+   // The loading time budget is the time that the viewer spends loading characters in each frame until all of them are loaded
    ModelViewerState(const std::shared_ptr<FiniteStateMachine>& finiteStateMachine,
-                    const std::shared_ptr<Window>&             window);
-   ~ModelViewerState() = default;
+                    const std::shared_ptr<Window>&             window,
+                    float                                      loadingTimeBudgetInMilliseconds = 8.0f);
+   ~ModelViewerState();
 
    ModelViewerState(const ModelViewerState&) = delete;
    ModelViewerState& operator=(const ModelViewerState&) = delete;
@@ -35,10 +49,35 @@ public:
 
 private:
 
-   void loadCharacters();
+   void enqueueLoadSteps();
+   void loadShaders();
+   void enqueueCharacterLoadSteps(unsigned int characterIndex);
+   void parseCharacter(unsigned int characterIndex);
+   void loadCharacterClips(unsigned int characterIndex);
+   void loadCharacterTexture(unsigned int characterIndex);
+   bool optimizeNextCharacterMesh(unsigned int characterIndex);
+   void uploadCharacterMeshes(unsigned int characterIndex);
    void loadGround();
+   void updateCharacterNames();
+
+   void loadingScreen();
+
+   // The handles of the uniforms of the skinned mesh shaders that change every frame
+   struct SkinnedMeshUniforms
+   {
+      Uniform<glm::mat4>              model;
+      Uniform<std::vector<glm::mat4>> skinMatrices;
+   };
+
+   SkinnedMeshUniforms resolveSkinnedMeshUniforms(const std::shared_ptr<Shader>& shader);
+
+   void updatePerFrameUniforms();
 
-   void configureLights(const std::shared_ptr<Shader>& shader);
+   unsigned int selectLevelOfDetail(const AnimatedMesh& mesh);
+
+#ifndef __EMSCRIPTEN__
+   void verifyTransformFeedbackSkinning();
+#endif
 
    void userInterface();
 
@@ -46,6 +85,12 @@ private:
 
    void resetCamera();
 
+   void resetTrackVisualizer();
+
+#ifndef __EMSCRIPTEN__
+   void generateStressTestTracks(unsigned int numTracks);
+#endif
+
    std::shared_ptr<FiniteStateMachine>    mFSM;
 
    std::shared_ptr<Window>                mWindow;
@@ -54,16 +99,46 @@ private:
 
    std::vector<AnimatedMesh>              mGroundMeshes;
    std::shared_ptr<Texture>               mGroundTexture;
+   ResourceHandle<Texture>                mGroundTextureHandle;
    std::shared_ptr<Shader>                mGroundShader;
 
    std::shared_ptr<Shader>                mAnimatedMeshShader;
+   SkinnedMeshUniforms                    mAnimatedMeshShaderUniforms;
+   // The variants of the packed animated mesh shader, indexed by the number of influences that they support (1, 2 or 4)
+   std::map<unsigned int, std::shared_ptr<Shader>> mPackedAnimatedMeshShaders;
+   std::map<unsigned int, SkinnedMeshUniforms>     mPackedAnimatedMeshShaderUniforms;
+   // When transform feedback skinning is enabled, the vertices of the packed meshes are skinned once per frame by the skinning shader,
+   // and the skinned vertices that it captures are rendered by the pre-skinned mesh shader, which is a static mesh shader
+   std::shared_ptr<Shader>                mSkinningShader;
+   Uniform<std::vector<glm::mat4>>        mSkinningShaderSkinMatrices;
+   std::shared_ptr<Shader>                mPreSkinnedMeshShader;
+   Uniform<glm::mat4>                     mPreSkinnedMeshShaderModel;
    std::vector<std::shared_ptr<Texture>>  mCharacterTextures;
+   std::vector<ResourceHandle<Texture>>   mCharacterTextureHandles;
+   // The cell of the palette atlas that stores the texture of each character, or -1 if the character has its own texture
+   std::vector<int>                       mCharacterPaletteCells;
+   PaletteAtlas                           mPaletteAtlas;
    std::vector<Skeleton>                  mCharacterBaseSkeletons;
    Skeleton                               mCharacterSkeleton;
    std::vector<std::vector<AnimatedMesh>> mCharacterMeshes;
-   std::vector<std::vector<FastClip>>     mCharacterClips;
+   std::vector<ClipLibrary>               mCharacterClips;
    std::string                            mCharacterNames;
    std::vector<std::string>               mCharacterClipNames;
+   std::vector<std::string>               mCharacterTextureFilePaths;
+   std::vector<std::string>               mCharacterModelFilePaths;
+   std::vector<std::string>               mCharacterDisplayNames;
+   std::vector<bool>                      mCharacterIsLoaded;
+   std::vector<bool>                      mCharacterUsesPackedVertices;
+   // The statistics of all the meshes of each character, whose ACMRs are weighted by the number of triangles of each mesh
+   std::vector<MeshOptimizationStatistics> mCharacterMeshStatistics;
+   // The state of the characters that are still being loaded, which is shared by their load steps
+   std::vector<cgltf_data*>               mCharacterGLTFData;
+   std::vector<JointMap>                  mCharacterJointMaps;
+   std::vector<unsigned int>              mCharacterNumOptimizedMeshes;
+   bool                                   mGroundIsLoaded;
+
+   IncrementalLoader                      mLoader;
+   bool                                   mStateIsInitialized;
 
    unsigned int                           mCurrentCharacterIndex;
    std::vector<unsigned int>              mCurrentClipIndex;
@@ -71,6 +146,18 @@ private:
    Pose                                   mPose;
    std::vector<glm::mat4>                 mPosePalette;
    std::vector<glm::mat4>                 mSkinMatrices;
+   // This points either to mSkinMatrices or to the skin matrices of an entry of the pose cache, which stay valid until the next update
+   const std::vector<glm::mat4>*          mCurrentSkinMatrices;
+   PoseCache                              mPoseCache;
+   float                                  mSelectedPoseCacheTimeStepInMilliseconds;
+   // The options that are used to bake the current clip, and how the baked clips are played back
+   float                                  mSelectedBakingFramesPerSecond;
+   int                                    mSelectedBakedContent;
+   int                                    mSelectedBakedPlayback;
+#ifndef __EMSCRIPTEN__
+   // The time it takes to sample the current clip (or its baked version) and to generate the skin matrices
+   float                                  mPoseUpdateTimeInMicroseconds;
+#endif
    std::vector<Transform>                 mModelTransform;
    std::vector<float>                     mJointScaleFactors;
 
@@ -82,17 +169,57 @@ private:
    bool                                   mDisplayMesh;
    bool                                   mDisplayBones;
    bool                                   mDisplayJoints;
+   bool                                   mSkinWithTransformFeedback;
+#ifndef __EMSCRIPTEN__
+   // The skinned vertices that are captured with transform feedback are compared to the ones of the CPU skinning when this is true
+   bool                                   mVerifyTransformFeedbackSkinning;
+   bool                                   mTransformFeedbackSkinningWasVerified;
+   float                                  mMaxPositionDifferenceOfTransformFeedbackSkinning;
+   float                                  mMaxNormalDifferenceOfTransformFeedbackSkinning;
+#endif
 #ifndef __EMSCRIPTEN__
    bool                                   mWireframeModeForCharacter;
    bool                                   mWireframeModeForJoints;
    bool                                   mPerformDepthTesting;
 #endif
    bool                                   mFillEmptyTilesWithRepeatedGraphs;
+   bool                                   mEvaluateCurvesOnGPU;
+   int                                    mNumSamplesPerCurve;
+#ifndef __EMSCRIPTEN__
+   bool                                   mCurvesWereVerified;
+   float                                  mMaxSampleDifferenceOfCurves;
+#endif
+   int                                    mSelectedGraphPage;
+   // The level of detail that is used to render the character, or -1 to select it automatically based on the distance to the camera
+   int                                    mSelectedLevelOfDetail;
+   unsigned int                           mCurrentLevelOfDetail;
+#ifndef __EMSCRIPTEN__
+   // When this is true, the track visualizer displays synthetic tracks instead of the tracks of the current clip
+   bool                                   mStressTestGraphs;
+   std::vector<FastTransformTrack>        mStressTestTracks;
+   float                                  mGraphBuildTimeInMilliseconds;
+#endif
 
 #ifndef __EMSCRIPTEN__
    bool                                   mPause = false;
+
+   // Used to measure the time it takes to display the initial character, which is logged once
+   std::chrono::steady_clock::time_point  mStartTime;
+   bool                                   mTimeToFirstFrameWasLogged;
 #endif
 
+   RenderQueue                            mRenderQueue;
+   PerFrameUniformBuffer                  mPerFrameUniformBuffer;
+
+   // The programs are shared by all the subsystems that load them, so identical programs are only compiled once
+   // This must be declared before the subsystems that use it
+   ResourceManager<Shader>                mShaderManager;
+
+   // The textures are decoded on the threads of the pool and uploaded on the main thread
+   // The pool must be declared after the texture manager, so that its jobs are finished before the manager is destroyed
+   ResourceManager<Texture>               mTextureManager;
+   ThreadPool                             mThreadPool;
+
    SkeletonViewer                         mSkeletonViewer;
    TrackVisualizer                        mTrackVisualizer;
 };
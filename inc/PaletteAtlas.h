@@ -0,0 +1,57 @@
+#ifndef PALETTE_ATLAS_H
+#define PALETTE_ATLAS_H
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "texture.h"
+#include "texture_loader.h"
+
+/*
+   A PaletteAtlas packs the small color palette textures that most characters use into a single texture,
+   so that all of those characters can be drawn without rebinding textures (e.g. in a crowd made of different characters)
+
+   The atlas is a row of square cells, and each palette is stored in the top-left corner of its own cell
+   The rest of the cell is filled by repeating the last row and column of the palette, and the remapped texture coordinates are clamped
+   to the centers of the edge texels of the palette, so that bilinear filtering doesn't bleed into other cells
+   The cells are aligned to their size and the number of mipmap levels is limited so that no level mixes the texels of different cells,
+   which means that the mipmaps of each palette are the same as if it had its own texture
+
+   The texture coordinates of the meshes that use a palette must be remapped with RemapTexCoords before they are uploaded
+   Since the cells are clamped, this only works for meshes whose texture coordinates don't wrap around (see CanRemapTexCoords)
+*/
+
+class PaletteAtlas
+{
+public:
+
+   static constexpr int cellSize = 64;
+
+   PaletteAtlas();
+   ~PaletteAtlas() = default;
+
+   PaletteAtlas(const PaletteAtlas&) = delete;
+   PaletteAtlas& operator=(const PaletteAtlas&) = delete;
+
+   PaletteAtlas(PaletteAtlas&&) = default;
+   PaletteAtlas& operator=(PaletteAtlas&&) = default;
+
+   static bool              CanHoldImage(int width, int height);
+   static bool              CanRemapTexCoords(const std::vector<glm::vec2>& texCoords);
+
+   void                     Initialize(unsigned int numCells);
+   void                     SetCell(unsigned int cellIndex, const TextureLoader::DecodedResource& palette);
+   void                     RemapTexCoords(unsigned int cellIndex, int paletteWidth, int paletteHeight, std::vector<glm::vec2>& texCoords) const;
+
+   unsigned int             GetNumberOfCells() const;
+   std::shared_ptr<Texture> GetTexture() const;
+
+private:
+
+   unsigned int             mNumCells;
+   std::shared_ptr<Texture> mTexture;
+};
+
+#endif
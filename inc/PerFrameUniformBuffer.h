@@ -0,0 +1,89 @@
+#ifndef PER_FRAME_UNIFORM_BUFFER_H
+#define PER_FRAME_UNIFORM_BUFFER_H
+
+#include <glm/glm.hpp>
+
+/*
+   A PerFrameUniformBuffer stores the data that is the same for every program in a frame (the camera and the lights)
+   in a single std140 uniform buffer, which is uploaded once per frame and shared by all the programs that declare the PerFrame block
+
+   Shaders declare the block with the line #include "PerFrame", which the ShaderLoader replaces with glslDeclaration,
+   and the ShaderLoader connects the block to bindingPoint in every program that declares it
+   The structs below must be kept in sync with glslDeclaration, including its padding
+*/
+
+class PerFrameUniformBuffer
+{
+public:
+
+   static constexpr unsigned int bindingPoint           = 0;
+   static constexpr const char*  blockName              = "PerFrame";
+   static constexpr unsigned int maxNumberOfPointLights = 4;
+
+   // The ShaderLoader defines MAX_NUMBER_OF_POINT_LIGHTS as maxNumberOfPointLights before the declaration
+   // Its members are highp because the declarations in the vertex and fragment shaders must match,
+   // and the default precision of floats is different in each stage in WebGL 2
+   static constexpr const char*  glslIncludeDirective   = "#include \"PerFrame\"";
+   static constexpr const char*  glslDeclaration        = R"(
+struct PointLight
+{
+   highp vec3  worldPos;
+   highp vec3  color;
+   highp float constantAtt;
+   highp float linearAtt;
+   highp float quadraticAtt;
+};
+
+layout(std140) uniform PerFrame
+{
+   highp mat4 view;
+   highp mat4 projection;
+   highp mat4 projectionView;
+   highp vec3 cameraPos;
+   highp int  numPointLightsInScene;
+   PointLight pointLights[MAX_NUMBER_OF_POINT_LIGHTS];
+};
+)";
+
+   struct PointLight
+   {
+      glm::vec3 worldPos;
+      float     padding0;
+      glm::vec3 color;
+      float     constantAtt;
+      float     linearAtt;
+      float     quadraticAtt;
+      float     padding1[2];
+   };
+
+   struct Data
+   {
+      glm::mat4  view;
+      glm::mat4  projection;
+      glm::mat4  projectionView;
+      glm::vec3  cameraPos;
+      int        numPointLightsInScene;
+      PointLight pointLights[maxNumberOfPointLights];
+   };
+
+   PerFrameUniformBuffer();
+   ~PerFrameUniformBuffer();
+
+   PerFrameUniformBuffer(const PerFrameUniformBuffer&) = delete;
+   PerFrameUniformBuffer& operator=(const PerFrameUniformBuffer&) = delete;
+
+   PerFrameUniformBuffer(PerFrameUniformBuffer&& rhs) noexcept;
+   PerFrameUniformBuffer& operator=(PerFrameUniformBuffer&& rhs) noexcept;
+
+   void Upload(const Data& data) const;
+
+private:
+
+   unsigned int mUBO;
+};
+
+// In std140, structs are aligned to 16 bytes, and a vec3 is followed by a float in the same 16 bytes
+static_assert(sizeof(PerFrameUniformBuffer::PointLight) == 48, "PointLight doesn't match the std140 layout of its GLSL counterpart");
+static_assert(sizeof(PerFrameUniformBuffer::Data) == 208 + (48 * PerFrameUniformBuffer::maxNumberOfPointLights), "Data doesn't match the std140 layout of the PerFrame block");
+
+#endif
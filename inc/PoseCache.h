@@ -0,0 +1,85 @@
+#ifndef POSE_CACHE_H
+#define POSE_CACHE_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Clip.h"
+#include "Skeleton.h"
+
+/*
+   A PoseCache shares the sampled poses of the instances that play the same clip at the same time (e.g. a synchronized crowd),
+   so that the pose, its matrix palette and its skin matrices are only calculated once for each unique pose
+
+   The poses are keyed by their clip and by their time, which is quantized with a configurable time step,
+   so instances whose times are less than a time step apart also share their pose
+   A time step of 0 disables the quantization, so only instances whose times are exactly the same share their pose
+
+   The poses that aren't used during a frame are evicted at the start of the next one (see BeginFrame)
+   Since the clips are identified by their addresses, the cache must be cleared whenever a clip that it has sampled is destroyed,
+   and a clip must always be sampled with the same skeleton
+*/
+
+class PoseCache
+{
+public:
+
+   struct Entry
+   {
+      Pose                   pose;
+      std::vector<glm::mat4> posePalette;
+      std::vector<glm::mat4> skinMatrices;
+   };
+
+   struct Statistics
+   {
+      unsigned int numHits;
+      unsigned int numMisses;
+   };
+
+   PoseCache();
+   ~PoseCache() = default;
+
+   PoseCache(const PoseCache&) = delete;
+   PoseCache& operator=(const PoseCache&) = delete;
+
+   PoseCache(PoseCache&&) = default;
+   PoseCache& operator=(PoseCache&&) = default;
+
+   float             GetTimeStep() const;
+   // Changing the time step clears the cache, since the existing keys were quantized with the old one
+   void              SetTimeStep(float timeStep);
+
+   void              BeginFrame();
+   void              Clear();
+
+   // The time must already be within the range of the clip (see TClip::AdjustTimeToBeWithinClip)
+   // The returned entry stays valid until the start of the next frame
+   const Entry&      GetPose(const FastClip& clip, float time, Skeleton& skeleton);
+
+   unsigned int      GetNumberOfCachedPoses() const;
+   const Statistics& GetStatisticsOfLastFrame() const;
+   // The statistics of all the frames since the cache was last cleared
+   const Statistics& GetTotalStatistics() const;
+
+private:
+
+   typedef std::pair<const FastClip*, long long> Key;
+
+   struct CachedPose
+   {
+      Entry        entry;
+      unsigned int lastUsedFrame;
+   };
+
+   std::map<Key, CachedPose> mCachedPoses;
+   float                     mTimeStep;
+   unsigned int              mCurrentFrame;
+
+   Statistics                mStatisticsOfCurrentFrame;
+   Statistics                mStatisticsOfLastFrame;
+   Statistics                mTotalStatistics;
+};
+
+#endif
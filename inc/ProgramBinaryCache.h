@@ -0,0 +1,43 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#ifndef __EMSCRIPTEN__
+
+#include <string>
+
+/*
+   The ProgramBinaryCache stores the binaries of the shader programs that are linked by the ShaderLoader in a file,
+   so that later runs can load them instead of compiling and linking them from source
+
+   Each binary is keyed by a hash of the source code of its shaders and of the strings that identify the driver,
+   since a binary can only be loaded by the driver that produced it
+   A driver can still reject a binary (e.g. after an update that doesn't change those strings),
+   in which case LoadProgram fails and the program must be compiled from source as usual
+
+   Program binaries require OpenGL 4.1 or ARB_get_program_binary, which is why the functions are loaded at runtime,
+   and they aren't available at all in WebGL, which is why this class only exists natively
+*/
+
+class ProgramBinaryCache
+{
+public:
+
+   static unsigned long long CalculateKey(const std::string& vShaderCode, const std::string& fShaderCode);
+
+   // Returns the ID of a linked program, or 0 if the cache doesn't have a valid binary for the key
+   static unsigned int       LoadProgram(unsigned long long key);
+
+   // Must be called before a program is linked so that the driver keeps its binary around
+   static void               PrepareProgramForStorage(unsigned int shaderProgID);
+   static void               StoreProgram(unsigned long long key, unsigned int shaderProgID);
+
+   static unsigned int       GetNumberOfLoadedPrograms();
+   static unsigned int       GetNumberOfCompiledPrograms();
+
+   // The path of the file is relative to the working directory
+   static const char*        GetCacheFilePath();
+};
+
+#endif
+
+#endif
@@ -1,16 +1,26 @@
 #ifndef REARRANGE_BONES_H
 #define REARRANGE_BONES_H
 
-#include <map>
+#include <vector>
 #include "Skeleton.h"
 #include "AnimatedMesh.h"
 #include "Clip.h"
 
-typedef std::map<int, int> JointMap;
+// A JointMap stores the new index of each joint at its old index
+// The functions that use it leave the indices that it doesn't cover unmodified, so an empty JointMap doesn't rearrange anything
+typedef std::vector<int> JointMap;
 
-JointMap RearrangeSkeleton(Skeleton& skeleton);
-void     RearrangeClip(Clip& clip, JointMap& jointMap);
-void     RearrangeFastClip(FastClip& fastClip, JointMap& jointMap);
-void     RearrangeMesh(AnimatedMesh& mesh, JointMap& jointMap);
+// Both orderings store the parents before their children
+// Depth first ordering also stores each subtree contiguously (see JointHierarchy), while breadth first ordering stores each level contiguously
+enum class JointOrdering
+{
+   BreadthFirst,
+   DepthFirst
+};
+
+JointMap RearrangeSkeleton(Skeleton& skeleton, JointOrdering ordering = JointOrdering::BreadthFirst);
+void     RearrangeClip(Clip& clip, const JointMap& jointMap);
+void     RearrangeFastClip(FastClip& fastClip, const JointMap& jointMap);
+void     RearrangeMesh(AnimatedMesh& mesh, const JointMap& jointMap);
 
 #endif
@@ -0,0 +1,86 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "shader.h"
+#include "GLStateCache.h"
+
+/*
+   A RenderQueue collects the draw items of a pass, sorts them by shader, texture and VAO,
+   and then executes them through a GLStateCache so that the state that two consecutive items share is only set once
+
+   The uniforms that are the same for all the items that use a shader (e.g. the view and projection matrices)
+   are set with SetShaderUniforms, and they are only uploaded once per execution when the queue switches to that shader
+   The draw function of each item sets the uniforms that are specific to it and issues the draw call,
+   and it must not bind or unbind any of the state that the queue manages
+
+   The order in which items with the same sort key are submitted is preserved
+   Passes that need different fixed-function state (e.g. a different polygon mode) must be executed separately
+*/
+
+class RenderQueue
+{
+public:
+
+   static constexpr unsigned int maxNumTexturesPerItem = 2;
+
+   struct DrawItem
+   {
+      std::shared_ptr<Shader>                          shader;
+      unsigned int                                     vertexArray;
+      // The textures are bound to texture units 0, 1, ..., and the units whose texture is 0 are left untouched
+      std::array<unsigned int, maxNumTexturesPerItem>  textures;
+      std::function<void()>                            draw;
+   };
+
+   // The number of GL calls of the last frame, with and without redundant-state elimination
+   struct Statistics
+   {
+      unsigned int numDrawCalls;
+      unsigned int numIssuedStateCalls;
+      unsigned int numSkippedStateCalls;
+      // The number of state calls that the same draw items would have needed if each one had bound its state,
+      // drawn and unbound its state, which is what the render paths did before the queue was introduced
+      unsigned int numStateCallsWithoutQueue;
+   };
+
+   RenderQueue();
+   ~RenderQueue() = default;
+
+   RenderQueue(const RenderQueue&) = delete;
+   RenderQueue& operator=(const RenderQueue&) = delete;
+
+   RenderQueue(RenderQueue&&) = default;
+   RenderQueue& operator=(RenderQueue&&) = default;
+
+   void              BeginFrame();
+   void              EndFrame();
+
+   void              SetShaderUniforms(const std::shared_ptr<Shader>& shader, const std::function<void()>& setUniforms);
+   void              Submit(const DrawItem& item);
+   void              Execute();
+
+   const Statistics& GetStatisticsOfLastFrame() const;
+
+private:
+
+   struct SortedDrawItem
+   {
+      unsigned long long sortKey;
+      DrawItem           item;
+   };
+
+   std::vector<SortedDrawItem>                   mItems;
+   std::map<unsigned int, std::function<void()>> mShaderUniforms;
+   GLStateCache                                  mStateCache;
+
+   Statistics                                    mStatisticsOfCurrentFrame;
+   Statistics                                    mStatisticsOfLastFrame;
+};
+
+#endif
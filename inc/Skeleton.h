@@ -2,6 +2,7 @@
 #define SKELETON_H
 
 #include "Pose.h"
+#include "JointHierarchy.h"
 #include <string>
 
 // TODO: Check const-correctness
@@ -19,6 +20,8 @@ public:
    std::vector<glm::mat4>&   GetInvBindPose();
    std::vector<std::string>& GetJointNames();
    std::string&              GetJointName(unsigned int jointIndex);
+   // The hierarchy of the rest pose, which is updated whenever the skeleton is set
+   const JointHierarchy&     GetJointHierarchy() const;
 
 protected:
 
@@ -28,6 +31,7 @@ protected:
    Pose                     mBindPose;
    std::vector<glm::mat4>   mInvBindPose;
    std::vector<std::string> mJointNames;
+   JointHierarchy           mJointHierarchy;
 };
 
 #endif
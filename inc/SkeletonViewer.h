@@ -5,12 +5,14 @@
 
 #include "Pose.h"
 #include "shader.h"
+#include "resource_manager.h"
+#include "RenderQueue.h"
 
 class SkeletonViewer
 {
 public:
 
-   SkeletonViewer();
+   explicit SkeletonViewer(ResourceManager<Shader>& shaderManager);
    ~SkeletonViewer();
 
    SkeletonViewer(const SkeletonViewer&) = delete;
@@ -21,34 +23,45 @@ public:
 
    void InitializeBones(const Pose& pose);
 
-   void UpdateBones(const Pose& animatedPose, const std::vector<glm::mat4>& animatedPosePalette);
+   void UpdateBones(const std::vector<glm::mat4>& animatedPosePalette);
 
-   void RenderBones(const Transform& model, const glm::mat4& projectionView);
-   void RenderJoints(const Transform& model, const glm::mat4& projectionView, const std::vector<glm::mat4>& animatedPosePalette, float scaleFactor, int indexOfGlowingJoint);
+   // Both passes read the matrices of the joints from the pose texture that is uploaded by UpdateBones,
+   // and the camera from the PerFrameUniformBuffer
+   // The joints of the range [indexOfGlowingJoint, endOfGlowingSubtree) glow, which is the subtree of the glowing joint
+   // when the joints are ordered depth first (see JointHierarchy)
+   void SubmitBones(RenderQueue& renderQueue, const Transform& model);
+   void SubmitJoints(RenderQueue& renderQueue, const Transform& model, float scaleFactor, int indexOfGlowingJoint, int endOfGlowingSubtree);
 
 private:
 
-   void LoadBoneBuffers();
-   void ConfigureBonesVAO(int posAttribLocation, int colorAttribLocation);
-
+   void LoadJointInfoTexture(const Pose& pose);
+   void AllocatePoseTexture();
    void LoadJointBuffers();
    void ConfigureJointsVAO(int posAttribLocation, int normalAttribLocation);
 
-   void ResizeBoneContainers(const Pose& animatedPose);
-
+   // The bones don't have any vertex attributes, but we still need to bind a VAO to render them
    unsigned int             mBonesVAO;
-   unsigned int             mBonesVBO;
 
    unsigned int             mJointsVAO;
    unsigned int             mJointsVBO;
    unsigned int             mJointsEBO;
 
+   // The pose texture stores the 4 columns of the matrix of each joint in a row (RGBA32F, 4 x numJoints)
+   // The joint info texture stores the index of the parent of each joint and the index of its color (RG32I, numJoints x 1)
+   unsigned int             mPoseTexture;
+   unsigned int             mJointInfoTexture;
+   unsigned int             mNumJoints;
+
    std::shared_ptr<Shader>  mBoneShader;
    std::shared_ptr<Shader>  mJointShader;
 
+   Uniform<glm::mat4>       mBoneModelUniform;
+   Uniform<glm::mat4>       mJointModelUniform;
+   Uniform<float>           mJointScaleFactorUniform;
+   Uniform<int>             mJointIndexOfGlowingJointUniform;
+   Uniform<int>             mJointEndOfGlowingSubtreeUniform;
+
    std::array<glm::vec3, 3> mBoneColorPalette;
-   std::vector<glm::vec3>   mBonePositions;
-   std::vector<glm::vec3>   mBoneColors;
 
    bool                     mInitialized;
 };
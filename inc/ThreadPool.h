@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+#ifndef __EMSCRIPTEN__
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+/*
+   A ThreadPool executes jobs on a fixed set of worker threads, in the order in which they are submitted
+   Jobs must not issue GL calls, since the GL context is only current on the main thread
+
+   The web build doesn't use pthreads, so there a ThreadPool doesn't have any threads,
+   and each job is executed on the calling thread as soon as it's submitted
+*/
+
+class ThreadPool
+{
+public:
+
+   // When numThreads is 0, one thread is created for each hardware thread except the main one
+   explicit ThreadPool(unsigned int numThreads = 0);
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   ThreadPool(ThreadPool&&) = delete;
+   ThreadPool& operator=(ThreadPool&&) = delete;
+
+   void         Submit(const std::function<void()>& job);
+
+   unsigned int GetNumberOfThreads() const;
+
+private:
+
+#ifndef __EMSCRIPTEN__
+   void         ExecuteJobs();
+
+   std::vector<std::thread>          mThreads;
+   std::deque<std::function<void()>> mJobs;
+   std::mutex                        mMutex;
+   std::condition_variable           mJobsAvailable;
+   bool                              mStopping;
+#endif
+};
+
+#endif
@@ -17,7 +17,9 @@ public:
    Track();
    virtual ~Track() = default;
 
+   // The non-const overload invalidates the cached bounds, since the frame may be modified through the returned reference
    Frame<N>&       GetFrame(unsigned int frameIndex);
+   const Frame<N>& GetFrame(unsigned int frameIndex) const;
    void            SetFrame(unsigned int frameIndex, const Frame<N>& frame);
 
    unsigned int    GetNumberOfFrames() const;
@@ -31,6 +33,11 @@ public:
 
    T               Sample(float time, bool looping) const;
 
+   // Calculates the per-component bounds of the values that Sample can return
+   // The bounds are calculated analytically for each segment of the track, so unlike sampling they don't miss any extrema,
+   // and they are cached until the frames or the interpolation of the track change
+   void            GetBounds(T& outMin, T& outMax) const;
+
 protected:
 
    virtual int     GetIndexOfLastFrameBeforeTime(float time, bool looping) const;
@@ -45,8 +52,15 @@ protected:
    T               SampleLinear(float time, bool looping) const;
    T               SampleCubic(float time, bool looping) const;
 
+   void            CalculateBounds() const;
+   void            ExpandBounds(const T& value) const;
+
    std::vector<Frame<N>> mFrames;
    Interpolation         mInterpolation;
+
+   mutable bool          mBoundsAreValid;
+   mutable float         mMinValues[N];
+   mutable float         mMaxValues[N];
 };
 
 typedef Track<float, 1>     ScalarTrack;
@@ -78,7 +92,8 @@ public:
    FastTrack() = default;
    virtual ~FastTrack() = default;
 
-   void        GenerateSampleToFrameIndexMap();
+   void         GenerateSampleToFrameIndexMap();
+   unsigned int GetSizeOfSampleToFrameIndexMap() const;
 
 protected:
 
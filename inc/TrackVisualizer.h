@@ -2,79 +2,236 @@
 #define TRACK_VISUALIZER_H
 
 #include <memory>
+#include <list>
+#include <map>
 
 #include "TransformTrack.h"
 #include "window.h"
 #include "shader.h"
+#include "texture.h"
+#include "resource_manager.h"
 
 class TrackVisualizer
 {
 public:
 
-   TrackVisualizer();
+   explicit TrackVisualizer(ResourceManager<Shader>& shaderManager);
    ~TrackVisualizer();
 
    void setTracks(std::vector<FastTransformTrack>& tracks);
 
-   void update(float deltaTime, float playbackSpeed, const std::shared_ptr<Window>& window, bool fillEmptyTilesWithRepeatedGraphs, bool graphsAreVisible);
+   // The cache key identifies the clip that the tracks belong to
+   // The graphs of the previous clip are kept in a cache, so switching back to a clip whose graphs are cached
+   // doesn't require copying, sampling or uploading anything
+   void setTracks(std::vector<FastTransformTrack>& tracks, unsigned long long cacheKey);
 
-   void render(bool fillEmptyTilesWithRepeatedGraphs);
-
-   int  getIndexOfSelectedGraph() const;
+   // Cached graph sets are evicted in least recently used order whenever the memory they occupy exceeds the budget
+   // The graph set that is being displayed is not stored in the cache, so it's never evicted
+   size_t getCacheMemoryBudget() const;
+   void   setCacheMemoryBudget(size_t memoryBudgetInBytes);
+   size_t getCacheMemoryUsage() const;
+   void   clearCache();
 
-private:
+   // The graphs are split into pages so that skeletons with hundreds of joints remain readable
+   // Only the graphs on the current page are sampled and get geometry
+   unsigned int getNumberOfPages() const;
+   unsigned int getPage() const;
+   void         setPage(unsigned int page);
 
-   void initializeReferenceLines();
+   // The state of the right mouse button is passed by the caller so that the track visualizer doesn't depend on the input handling
+   // of the window, which needs GLFW and ImGui, and can be built by the tools
+   void update(float deltaTime, float playbackSpeed, const std::shared_ptr<Window>& window, bool rightMouseButtonIsPressed, bool fillEmptyTilesWithRepeatedGraphs, bool graphsAreVisible);
 
-   void initializeTrackLines();
+   void render(bool fillEmptyTilesWithRepeatedGraphs);
 
-   void deleteBuffers();
+   // Returns the index of the transform track displayed by the selected graph, or -1 if no graph is selected
+   int  getIndexOfSelectedGraph() const;
 
-   float                               mWidthOfGraphSpace;
-   float                               mHeightOfGraphSpace;
-   unsigned int                        mNumGraphs;
-   unsigned int                        mNumCurves;
-   unsigned int                        mNumTiles;
-   unsigned int                        mNumEmptyRows;
-   unsigned int                        mNumEmptyTilesInIncompleteRow;
-   float                               mTileWidth;
-   float                               mTileHeight;
-   float                               mTileHorizontalOffset;
-   float                               mTileVerticalOffset;
-   float                               mGraphWidth;
-   float                               mGraphHeight;
+   // When this is true, the curves are evaluated by graph_keyframes.vert from the raw keyframes of the tracks,
+   // and when it's false, they are sampled on the CPU and stored in the lines buffer
+   // The new value only takes effect the next time setTracks is called
+   bool getEvaluateCurvesOnGPU() const;
+   void setEvaluateCurvesOnGPU(bool evaluateCurvesOnGPU);
 
-   unsigned int                        mReferenceLinesVAO;
-   unsigned int                        mReferenceLinesVBO;
+   // When the curves are evaluated on the GPU, the new number of samples takes effect immediately
+   unsigned int getNumberOfSamplesPerCurve() const;
+   void         setNumberOfSamplesPerCurve(unsigned int numSamplesPerCurve);
 
-   unsigned int                        mEmptyLinesVAO[4];
-   unsigned int                        mEmptyLinesVBO[4];
+#ifndef __EMSCRIPTEN__
+   // Captures the samples that graph_keyframes.vert evaluates on the GPU with transform feedback and compares them against the ones of Track::Sample
+   // Returns the largest difference between the components of the samples, or a negative value if the curves aren't evaluated on the GPU
+   float verifyCurvesAgainstCPU();
+#endif
 
-   std::vector<unsigned int>           mTrackLinesVAOs;
-   std::vector<unsigned int>           mTrackLinesVBOs;
+private:
 
-   std::shared_ptr<Shader>             mTrackShader;
+   /*
+      A GraphSet stores everything that is built for a set of tracks (their keyframes, the layout of their current page,
+      and the buffers and texture of that page)
+      The graph set that is being displayed lives in the members of the TrackVisualizer, and it's swapped with
+      the cached ones when the tracks change (see swapGraphSet)
+   */
+   struct GraphSet
+   {
+      unsigned int                     numPages = 1;
+      unsigned int                     page = 0;
+      std::vector<FastQuaternionTrack> tracksOfAllPages;
+      std::vector<unsigned int>        trackIndicesOfAllPages;
+
+      unsigned int                     numGraphs = 0;
+      unsigned int                     numCurves = 0;
+      unsigned int                     numTiles = 0;
+      unsigned int                     numEmptyRows = 0;
+      unsigned int                     numEmptyTilesInIncompleteRow = 0;
+      float                            tileWidth = 0.0f;
+      float                            tileHeight = 0.0f;
+      float                            tileHorizontalOffset = 0.0f;
+      float                            tileVerticalOffset = 0.0f;
+      float                            graphWidth = 0.0f;
+      float                            graphHeight = 0.0f;
+
+      unsigned int                     linesVAO = 0;
+      unsigned int                     linesVBO = 0;
+      unsigned int                     indexOfFirstReferenceLineVertex = 0;
+      unsigned int                     indexOfFirstRepeatedCurveVertex = 0;
+      unsigned int                     numLineVertices = 0;
+      unsigned int                     keyframeCurvesVAO = 0;
+      std::shared_ptr<Texture>         keyframeTexture;
+      size_t                           keyframeTextureSizeInBytes = 0;
+
+      std::vector<FastQuaternionTrack> tracks;
+      std::vector<unsigned int>        trackIndices;
+      std::vector<glm::vec4>           minSamples;
+      std::vector<glm::vec4>           inverseSampleRanges;
+      std::vector<glm::vec2>           graphLowerLeftCorners;
+      std::vector<glm::vec2>           graphUpperRightCorners;
+
+      size_t                           memoryFootprint = 0;
+   };
+
+   void   buildGraphSet(std::vector<FastTransformTrack>& tracks);
+   void   swapGraphSet(GraphSet& graphSet);
+   void   deleteGraphSet(GraphSet& graphSet);
+   size_t calculateMemoryFootprintOfGraphSet() const;
+   void   evictLeastRecentlyUsedGraphSets();
+
+   void initializePage();
 
-   glm::mat4                           mProjectionViewMatrix;
-   glm::mat4                           mInverseProjectionViewMatrix;
+   void initializeReferenceLines();
 
-   std::vector<FastQuaternionTrack>    mTracks;
-   std::vector<glm::vec4>              mMinSamples;
-   std::vector<glm::vec4>              mInverseSampleRanges;
-   std::vector<glm::vec3>              mReferenceLines;
-   std::vector<std::vector<glm::vec3>> mEmptyLines;
-   std::vector<std::vector<glm::vec3>> mTrackLines;
+   void initializeTrackLines();
 
-   glm::vec3                           mTrackLinesColorPalette[4];
-   glm::vec3                           mSelectedTrackLinesColorPalette[4];
+   void initializeKeyframeTexture();
 
-   bool                                mInitialized;
+   void deleteBuffers();
 
-   std::vector<glm::vec2>              mGraphLowerLeftCorners;
-   std::vector<glm::vec2>              mGraphUpperRightCorners;
-   int                                 mIndexOfSelectedGraph;
+   /*
+      All the lines are stored in a single buffer with the following layout:
+
+      +-------------+-----------------+-------------+-----------------+
+      | Empty lines | Reference lines | Real curves | Repeated curves |
+      +-------------+-----------------+-------------+-----------------+
+
+      This allows us to render everything with a single draw call:
+      - When the empty tiles are filled with repeated graphs, we render everything except the empty lines
+      - When they aren't, we render everything except the repeated curves
+   */
+   struct LineVertex
+   {
+      glm::vec3  position;
+      glm::vec2  phase;
+      glm::ivec2 colorAndGraphIndices;
+   };
+
+   float                                  mWidthOfGraphSpace;
+   float                                  mHeightOfGraphSpace;
+   unsigned int                           mNumGraphs;
+   unsigned int                           mNumCurves;
+   unsigned int                           mNumTiles;
+   unsigned int                           mNumEmptyRows;
+   unsigned int                           mNumEmptyTilesInIncompleteRow;
+   float                                  mTileWidth;
+   float                                  mTileHeight;
+   float                                  mTileHorizontalOffset;
+   float                                  mTileVerticalOffset;
+   float                                  mGraphWidth;
+   float                                  mGraphHeight;
+
+   unsigned int                           mLinesVAO;
+   unsigned int                           mLinesVBO;
+   unsigned int                           mIndexOfFirstReferenceLineVertex;
+   unsigned int                           mIndexOfFirstRepeatedCurveVertex;
+   unsigned int                           mNumLineVertices;
+
+   // The handles of the uniforms of the graph shaders that change every frame
+   // Some of them only exist in the shader that evaluates the curves from the keyframes
+   struct GraphUniforms
+   {
+      Uniform<glm::mat4> projectionView;
+      Uniform<float>     timeOffset;
+      Uniform<float>     graphWidth;
+      Uniform<float>     graphHeight;
+      Uniform<int>       numSamplesPerCurve;
+      Uniform<int>       indexOfSelectedGraph;
+      Uniform<int>       keyframes;
+   };
+
+   std::shared_ptr<Shader>                mTrackShader;
+   GraphUniforms                          mTrackShaderUniforms;
+
+   // The curves that are evaluated on the GPU don't have any vertex attributes,
+   // but we still need to bind a VAO to render them
+   bool                                   mEvaluateCurvesOnGPU;
+   unsigned int                           mNumSamplesPerCurve;
+   unsigned int                           mKeyframeCurvesVAO;
+   std::shared_ptr<Texture>               mKeyframeTexture;
+   size_t                                 mKeyframeTextureSizeInBytes;
+   std::shared_ptr<Shader>                mKeyframeShader;
+   GraphUniforms                          mKeyframeShaderUniforms;
+#ifndef __EMSCRIPTEN__
+   // The same program as the one above, except that it captures the samples of the curves with transform feedback
+   std::shared_ptr<Shader>                mKeyframeCaptureShader;
+   GraphUniforms                          mKeyframeCaptureShaderUniforms;
+#endif
 
-   bool                                mRightMouseButtonWasPressed;
+   glm::mat4                              mProjectionViewMatrix;
+   glm::mat4                              mInverseProjectionViewMatrix;
+
+   unsigned int                           mMaxNumGraphsPerPage;
+   unsigned int                           mNumPages;
+   unsigned int                           mPage;
+   std::vector<FastQuaternionTrack>       mTracksOfAllPages;
+   std::vector<unsigned int>              mTrackIndicesOfAllPages;
+
+   // The tracks on the current page and the indices of their transform tracks
+   std::vector<FastQuaternionTrack>       mTracks;
+   std::vector<unsigned int>              mTrackIndices;
+   std::vector<glm::vec4>                 mMinSamples;
+   std::vector<glm::vec4>                 mInverseSampleRanges;
+   std::vector<LineVertex>                mReferenceLines;
+   std::vector<LineVertex>                mEmptyLines;
+   std::vector<LineVertex>                mTrackLines;
+   float                                  mTimeOffset;
+
+   glm::vec3                              mTrackLinesColorPalette[4];
+   glm::vec3                              mSelectedTrackLinesColorPalette[4];
+
+   bool                                   mInitialized;
+
+   std::vector<glm::vec2>                 mGraphLowerLeftCorners;
+   std::vector<glm::vec2>                 mGraphUpperRightCorners;
+   int                                    mIndexOfSelectedGraph;
+
+   bool                                   mRightMouseButtonWasPressed;
+
+   // The cache key of the graph set that is being displayed, which is only valid if mCurrentGraphSetIsCacheable is true
+   unsigned long long                     mCurrentCacheKey;
+   bool                                   mCurrentGraphSetIsCacheable;
+   std::map<unsigned long long, GraphSet> mCachedGraphSets;
+   // The front of this list is the most recently used graph set and the back is the least recently used one
+   std::list<unsigned long long>          mLeastRecentlyUsedGraphSets;
+   size_t                                 mCacheMemoryBudget;
+   size_t                                 mCacheMemoryUsage;
 };
 
 #endif
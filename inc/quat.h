@@ -39,12 +39,8 @@ namespace Q
             float w;
          };
 
-         struct
-         {
-            glm::vec3 vector;
-            float     scalar;
-         };
-
+         // The vector part of the quaternion is (x, y, z) and its scalar part is w
+         // They aren't exposed as a glm::vec3 and a float here because GCC doesn't allow members with constructors in anonymous structs
          float v[4];
       };
    };
@@ -5,6 +5,107 @@
 #include <unordered_map>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+
+#include "ThreadPool.h"
+
+// Collapses the "." and ".." segments and the repeated separators of a path, so that different spellings of the same path
+// produce the same resource ID (e.g. "resources/./models//zombie/../zombie/zombie.png" becomes "resources/models/zombie/zombie.png")
+inline std::string canonicalizeResourcePath(const std::string& path)
+{
+   std::vector<std::string> segments;
+   std::string::size_type segmentStart = 0;
+   while (segmentStart <= path.size())
+   {
+      std::string::size_type segmentEnd = path.find_first_of("/\\", segmentStart);
+      if (segmentEnd == std::string::npos)
+      {
+         segmentEnd = path.size();
+      }
+
+      std::string segment = path.substr(segmentStart, segmentEnd - segmentStart);
+      if (segment == "..")
+      {
+         if (!segments.empty() && segments.back() != "..")
+         {
+            segments.pop_back();
+         }
+         else
+         {
+            segments.push_back(segment);
+         }
+      }
+      else if (!segment.empty() && segment != ".")
+      {
+         segments.push_back(segment);
+      }
+
+      segmentStart = segmentEnd + 1;
+   }
+
+   std::string canonicalPath = (!path.empty() && (path[0] == '/' || path[0] == '\\')) ? "/" : "";
+   for (unsigned int i = 0, size = static_cast<unsigned int>(segments.size()); i < size; ++i)
+   {
+      canonicalPath += (i == 0) ? segments[i] : ("/" + segments[i]);
+   }
+
+   return canonicalPath;
+}
+
+template<typename TResource>
+class ResourceManager;
+
+// A ResourceHandle refers to a resource that is being loaded asynchronously by a ResourceManager
+// All the handles that are returned for the same resource ID share the same state
+// Handles must only be used on the thread that owns the ResourceManager
+template<typename TResource>
+class ResourceHandle
+{
+public:
+
+   ResourceHandle() = default;
+
+   bool                       isValid() const   { return mState != nullptr; }
+   bool                       isReady() const   { return mState && mState->ready; }
+   bool                       hasFailed() const { return mState && mState->ready && !mState->resource; }
+
+   // This is a nullptr until the resource is ready
+   std::shared_ptr<TResource> get() const       { return mState ? mState->resource : nullptr; }
+
+private:
+
+   friend class ResourceManager<TResource>;
+
+   struct State
+   {
+      bool                       ready = false;
+      std::shared_ptr<TResource> resource;
+   };
+
+   explicit ResourceHandle(const std::shared_ptr<State>& state)
+      : mState(state)
+   {
+
+   }
+
+   std::shared_ptr<State> mState;
+};
+
+/*
+   A ResourceManager stores resources by ID, and it can load them synchronously or asynchronously
+
+   Asynchronous loads are split into 2 stages:
+   - The decode stage runs on the threads of a ThreadPool, and it must not issue GL calls (e.g. reading and decompressing an image)
+   - The upload stage runs on the thread that owns the manager when processUploads is called (e.g. creating a texture from the image)
+   A loader supports asynchronous loads when it has a DecodedResource type and decodeResource, uploadResource and getSizeInBytes functions
+
+   Loads are deduplicated by ID, including the ones that are still in flight, so a resource that's requested multiple times is only decoded and uploaded once
+   The resources that are only referenced by the manager are evicted in least recently used order when the memory budget is exceeded
+*/
 
 template<typename TResource>
 class ResourceManager
@@ -17,8 +118,8 @@ public:
    ResourceManager(const ResourceManager&) = delete;
    ResourceManager& operator=(const ResourceManager&) = delete;
 
-   ResourceManager(ResourceManager&&) = default;
-   ResourceManager& operator=(ResourceManager&&) = default;
+   ResourceManager(ResourceManager&&) = delete;
+   ResourceManager& operator=(ResourceManager&&) = delete;
 
    template<typename TResourceLoader, typename... Args>
    std::shared_ptr<TResource> loadResource(const std::string& resourceID, Args&&... args);
@@ -26,6 +127,20 @@ public:
    template<typename TResourceLoader, typename... Args>
    std::shared_ptr<TResource> loadUnmanagedResource(Args&&... args) const;
 
+   // Unlike loadResource, this silently returns the existing resource when the ID is already in use,
+   // which makes it possible to share identical resources between the systems that load them
+   template<typename TResourceLoader, typename... Args>
+   std::shared_ptr<TResource> getOrLoadResource(const std::string& resourceID, Args&&... args);
+
+   template<typename TResourceLoader, typename... Args>
+   ResourceHandle<TResource>  loadResourceAsync(const std::string& resourceID, ThreadPool& threadPool, Args&&... args);
+
+   // Executes the upload stage of the resources that have been decoded, and then evicts resources if the memory budget is exceeded
+   void                       processUploads();
+
+   // Blocks until the resource of the handle is ready, and then returns it
+   std::shared_ptr<TResource> finishLoading(const ResourceHandle<TResource>& handle);
+
    std::shared_ptr<TResource> getResource(const std::string& resourceID) const;
 
    bool                       containsResource(const std::string& resourceID) const noexcept;
@@ -33,9 +148,42 @@ public:
    void                       stopManagingResource(const std::string& resourceID) noexcept;
    void                       stopManagingAllResources() noexcept;
 
+   size_t                     getMemoryBudget() const;
+   void                       setMemoryBudget(size_t memoryBudgetInBytes);
+   size_t                     getMemoryUsage() const;
+
 private:
 
-   std::unordered_map<std::string, std::shared_ptr<TResource>> mResources;
+   struct ManagedResource
+   {
+      std::shared_ptr<TResource> resource;
+      size_t                     sizeInBytes;
+      unsigned long long         lastUse;
+   };
+
+   struct DecodedResource
+   {
+      std::string                                  resourceID;
+      std::function<std::shared_ptr<TResource>()>  upload;
+      size_t                                       sizeInBytes;
+   };
+
+   void                       storeResource(const std::string& resourceID, const std::shared_ptr<TResource>& resource, size_t sizeInBytes);
+   void                       evictUnusedResources();
+
+   std::unordered_map<std::string, ManagedResource>                                           mResources;
+   // The states of the asynchronous loads that haven't been uploaded yet, which are used to deduplicate them
+   std::unordered_map<std::string, std::shared_ptr<typename ResourceHandle<TResource>::State>> mPendingLoads;
+   // The resources that have been decoded by the worker threads and that are waiting to be uploaded
+   std::vector<DecodedResource>                                                               mDecodedResources;
+
+   // Protects mDecodedResources, which is the only member that's accessed by the worker threads
+   std::mutex                                                                                 mMutex;
+   std::condition_variable                                                                    mResourceDecoded;
+
+   size_t                                                                                     mMemoryBudget = 256 * 1024 * 1024;
+   size_t                                                                                     mMemoryUsage  = 0;
+   unsigned long long                                                                         mUseCounter   = 0;
 };
 
 template<typename TResource>
@@ -53,13 +201,15 @@ std::shared_ptr<TResource> ResourceManager<TResource>::loadResource(const std::s
       // We expect the loaders to print an error message when they are unable to load a resource successfully, which is why we don't print anything here
       if (resource)
       {
-         mResources[resourceID] = resource;
+         // The size of the resources that are loaded synchronously is unknown, so they don't count towards the memory budget
+         storeResource(resourceID, resource, 0);
       }
    }
    else
    {
       std::cout << "Warning - ResourceManager::loadResource - A resource with the following ID already exists: " << resourceID << "\n";
-      resource = it->second;
+      it->second.lastUse = ++mUseCounter;
+      resource = it->second.resource;
    }
 
    return resource;
@@ -73,13 +223,136 @@ std::shared_ptr<TResource> ResourceManager<TResource>::loadUnmanagedResource(Arg
    return TResourceLoader{}.loadResource(std::forward<Args>(args)...);
 }
 
+template<typename TResource>
+template<typename TResourceLoader, typename... Args>
+std::shared_ptr<TResource> ResourceManager<TResource>::getOrLoadResource(const std::string& resourceID, Args&&... args)
+{
+   auto it = mResources.find(resourceID);
+   if (it != mResources.cend())
+   {
+      it->second.lastUse = ++mUseCounter;
+      return it->second.resource;
+   }
+
+   return loadResource<TResourceLoader>(resourceID, std::forward<Args>(args)...);
+}
+
+template<typename TResource>
+template<typename TResourceLoader, typename... Args>
+ResourceHandle<TResource> ResourceManager<TResource>::loadResourceAsync(const std::string& resourceID, ThreadPool& threadPool, Args&&... args)
+{
+   typedef typename ResourceHandle<TResource>::State HandleState;
+
+   // Resources that are already loaded are returned immediately
+   auto it = mResources.find(resourceID);
+   if (it != mResources.cend())
+   {
+      it->second.lastUse = ++mUseCounter;
+      std::shared_ptr<HandleState> state = std::make_shared<HandleState>();
+      state->ready    = true;
+      state->resource = it->second.resource;
+      return ResourceHandle<TResource>(state);
+   }
+
+   // Resources that are already being loaded share the state of the first load
+   auto pendingIt = mPendingLoads.find(resourceID);
+   if (pendingIt != mPendingLoads.cend())
+   {
+      return ResourceHandle<TResource>(pendingIt->second);
+   }
+
+   std::shared_ptr<HandleState> state = std::make_shared<HandleState>();
+   mPendingLoads[resourceID] = state;
+
+   // The arguments are copied by std::bind, since the job can outlive them
+   std::function<std::shared_ptr<typename TResourceLoader::DecodedResource>()> decode =
+      std::bind([](const typename std::decay<Args>::type&... decodeArgs) { return TResourceLoader{}.decodeResource(decodeArgs...); },
+                std::forward<Args>(args)...);
+
+   std::function<void()> decodeJob = [this, resourceID, decode]()
+   {
+      std::shared_ptr<typename TResourceLoader::DecodedResource> decodedResource = decode();
+
+      size_t sizeInBytes = decodedResource ? TResourceLoader::getSizeInBytes(*decodedResource) : 0;
+      std::function<std::shared_ptr<TResource>()> upload = [decodedResource]()
+      {
+         return decodedResource ? TResourceLoader{}.uploadResource(*decodedResource) : nullptr;
+      };
+
+      {
+         std::lock_guard<std::mutex> lock(mMutex);
+         mDecodedResources.push_back(DecodedResource{resourceID, upload, sizeInBytes});
+      }
+      mResourceDecoded.notify_all();
+   };
+
+   threadPool.Submit(decodeJob);
+
+   return ResourceHandle<TResource>(state);
+}
+
+template<typename TResource>
+void ResourceManager<TResource>::processUploads()
+{
+   std::vector<DecodedResource> decodedResources;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      decodedResources.swap(mDecodedResources);
+   }
+
+   for (DecodedResource& decodedResource : decodedResources)
+   {
+      std::shared_ptr<TResource> resource = decodedResource.upload();
+
+      // We expect the loaders to print an error message when they are unable to load a resource successfully, which is why we don't print anything here
+      if (resource)
+      {
+         storeResource(decodedResource.resourceID, resource, decodedResource.sizeInBytes);
+      }
+
+      auto pendingIt = mPendingLoads.find(decodedResource.resourceID);
+      if (pendingIt != mPendingLoads.end())
+      {
+         pendingIt->second->ready    = true;
+         pendingIt->second->resource = resource;
+         mPendingLoads.erase(pendingIt);
+      }
+   }
+
+   if (!decodedResources.empty())
+   {
+      evictUnusedResources();
+   }
+}
+
+template<typename TResource>
+std::shared_ptr<TResource> ResourceManager<TResource>::finishLoading(const ResourceHandle<TResource>& handle)
+{
+   if (!handle.isValid())
+   {
+      return nullptr;
+   }
+
+   while (!handle.isReady())
+   {
+      {
+         std::unique_lock<std::mutex> lock(mMutex);
+         mResourceDecoded.wait(lock, [this]() { return !mDecodedResources.empty(); });
+      }
+
+      processUploads();
+   }
+
+   return handle.get();
+}
+
 template<typename TResource>
 std::shared_ptr<TResource> ResourceManager<TResource>::getResource(const std::string& resourceID) const
 {
    auto it = mResources.find(resourceID);
    if (it != mResources.end())
    {
-      return it->second;
+      return it->second.resource;
    }
    else
    {
@@ -100,6 +373,7 @@ void ResourceManager<TResource>::stopManagingResource(const std::string& resourc
    auto it = mResources.find(resourceID);
    if (it != mResources.end())
    {
+      mMemoryUsage -= it->second.sizeInBytes;
       mResources.erase(it);
    }
    else
@@ -112,6 +386,60 @@ template<typename TResource>
 void ResourceManager<TResource>::stopManagingAllResources() noexcept
 {
    mResources.clear();
+   mMemoryUsage = 0;
+}
+
+template<typename TResource>
+size_t ResourceManager<TResource>::getMemoryBudget() const
+{
+   return mMemoryBudget;
+}
+
+template<typename TResource>
+void ResourceManager<TResource>::setMemoryBudget(size_t memoryBudgetInBytes)
+{
+   mMemoryBudget = memoryBudgetInBytes;
+   evictUnusedResources();
+}
+
+template<typename TResource>
+size_t ResourceManager<TResource>::getMemoryUsage() const
+{
+   return mMemoryUsage;
+}
+
+template<typename TResource>
+void ResourceManager<TResource>::storeResource(const std::string& resourceID, const std::shared_ptr<TResource>& resource, size_t sizeInBytes)
+{
+   mResources[resourceID] = ManagedResource{resource, sizeInBytes, ++mUseCounter};
+   mMemoryUsage += sizeInBytes;
+}
+
+template<typename TResource>
+void ResourceManager<TResource>::evictUnusedResources()
+{
+   while (mMemoryUsage > mMemoryBudget)
+   {
+      // Find the least recently used resource that's only referenced by the manager
+      auto leastRecentlyUsedIt = mResources.end();
+      for (auto it = mResources.begin(); it != mResources.end(); ++it)
+      {
+         if (it->second.sizeInBytes > 0 && it->second.resource.use_count() == 1 &&
+             (leastRecentlyUsedIt == mResources.end() || it->second.lastUse < leastRecentlyUsedIt->second.lastUse))
+         {
+            leastRecentlyUsedIt = it;
+         }
+      }
+
+      // The resources that are still in use can't be evicted, so the budget can be exceeded
+      if (leastRecentlyUsedIt == mResources.end())
+      {
+         break;
+      }
+
+      mMemoryUsage -= leastRecentlyUsedIt->second.sizeInBytes;
+      mResources.erase(leastRecentlyUsedIt);
+   }
 }
 
 #endif
@@ -12,6 +12,50 @@
 #include <map>
 #include <vector>
 
+/*
+   A Uniform is a typed handle to the location of a uniform of a shader program
+   Handles are meant to be resolved once after a program is loaded (see Shader::getUniform),
+   so that the uniforms that are set every frame don't have to be looked up by name
+*/
+
+template<typename T>
+class Uniform
+{
+public:
+
+   Uniform()
+      : mLocation(-1)
+   {
+
+   }
+
+   explicit Uniform(int location)
+      : mLocation(location)
+   {
+
+   }
+
+   // The program that the uniform belongs to must be in use
+   void set(const T& value) const;
+
+   int  getLocation() const { return mLocation; }
+
+private:
+
+   int mLocation;
+};
+
+template<> void Uniform<bool>::set(const bool& value) const;
+template<> void Uniform<int>::set(const int& value) const;
+template<> void Uniform<float>::set(const float& value) const;
+template<> void Uniform<glm::vec2>::set(const glm::vec2& value) const;
+template<> void Uniform<glm::vec3>::set(const glm::vec3& value) const;
+template<> void Uniform<glm::vec4>::set(const glm::vec4& value) const;
+template<> void Uniform<glm::mat2>::set(const glm::mat2& value) const;
+template<> void Uniform<glm::mat3>::set(const glm::mat3& value) const;
+template<> void Uniform<glm::mat4>::set(const glm::mat4& value) const;
+template<> void Uniform<std::vector<glm::mat4>>::set(const std::vector<glm::mat4>& values) const;
+
 class Shader
 {
 public:
@@ -50,6 +94,10 @@ public:
    int          getAttributeLocation(const std::string& attributeName) const;
    int          getUniformLocation(const std::string& uniformName) const;
 
+   // For arrays, the name must include the index of the first element (e.g. "animated[0]")
+   template<typename T>
+   Uniform<T>   getUniform(const std::string& uniformName) const { return Uniform<T>(getUniformLocation(uniformName)); }
+
 private:
 
    unsigned int                        mShaderProgID;
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 
 #include "shader.h"
 
@@ -22,19 +23,41 @@ public:
    std::shared_ptr<Shader> loadResource(const std::string& vShaderFilePath,
                                         const std::string& fShaderFilePath) const;
 
+   // The defines are inserted right after the version directive of each shader (e.g. "NUM_INFLUENCES 2" becomes "#define NUM_INFLUENCES 2"),
+   // which makes it possible to compile multiple variants of the same shader
+   std::shared_ptr<Shader> loadResource(const std::string&              vShaderFilePath,
+                                        const std::string&              fShaderFilePath,
+                                        const std::vector<std::string>& defines) const;
+
+   // The varyings are captured by transform feedback in the given order, interleaved in a single buffer
+   std::shared_ptr<Shader> loadResource(const std::string&              vShaderFilePath,
+                                        const std::string&              fShaderFilePath,
+                                        const std::vector<std::string>& defines,
+                                        const std::vector<std::string>& transformFeedbackVaryings) const;
+
 #ifndef __EMSCRIPTEN__
    std::shared_ptr<Shader> loadResource(const std::string& vShaderFilePath,
                                         const std::string& fShaderFilePath,
                                         const std::string& gShaderFilePath) const;
 #endif
 
+   // Identical programs get the same ID, so a ResourceManager<Shader> can share them between the subsystems that use them
+   static std::string      getResourceID(const std::string&              vShaderFilePath,
+                                         const std::string&              fShaderFilePath,
+                                         const std::vector<std::string>& defines = std::vector<std::string>(),
+                                         const std::vector<std::string>& transformFeedbackVaryings = std::vector<std::string>());
+
 private:
 
+   std::shared_ptr<Shader> createShader(unsigned int shaderProgID) const;
+
    bool                    readShaderFile(const std::string& shaderFilePath, std::string& outShaderCode) const;
    void                    addVersionToShaderCode(std::string& ioShaderCode, GLenum shaderType) const;
+   void                    addDefinesToShaderCode(std::string& ioShaderCode, const std::vector<std::string>& defines) const;
+   void                    addPerFrameUniformsToShaderCode(std::string& ioShaderCode) const;
 
    unsigned int            createAndCompileShader(const std::string& shaderCode, GLenum shaderType) const;
-   unsigned int            createAndLinkShaderProgram(unsigned int vShaderID, unsigned int fShaderID) const;
+   unsigned int            createAndLinkShaderProgram(unsigned int vShaderID, unsigned int fShaderID, const std::vector<std::string>& transformFeedbackVaryings) const;
 #ifndef __EMSCRIPTEN__
    unsigned int            createAndLinkShaderProgram(unsigned int vShaderID, unsigned int fShaderID, unsigned int gShaderID) const;
 #endif
@@ -47,6 +70,7 @@ private:
 
    void                    readAttributes(unsigned int shaderProgID, std::map<std::string, unsigned int>& outAttributes) const;
    void                    readUniforms(unsigned int shaderProgID, std::map<std::string, unsigned int>& outUniforms) const;
+   void                    bindUniformBlocks(unsigned int shaderProgID) const;
 };
 
 #endif
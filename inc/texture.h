@@ -20,8 +20,10 @@ public:
    Texture(Texture&& rhs) noexcept;
    Texture& operator=(Texture&& rhs) noexcept;
 
-   void bind(unsigned int textureUnit, int uniformLocation) const;
-   void unbind(unsigned int textureUnit) const;
+   void         bind(unsigned int textureUnit, int uniformLocation) const;
+   void         unbind(unsigned int textureUnit) const;
+
+   unsigned int getID() const;
 
 private:
 
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "texture.h"
 
@@ -19,24 +20,58 @@ public:
    TextureLoader(TextureLoader&&) = default;
    TextureLoader& operator=(TextureLoader&&) = default;
 
-   std::shared_ptr<Texture> loadResource(const std::string& texFilePath,
-                                         unsigned int       wrapS     = GL_REPEAT,
-                                         unsigned int       wrapT     = GL_REPEAT,
-                                         unsigned int       minFilter = GL_LINEAR_MIPMAP_LINEAR,
-                                         unsigned int       magFilter = GL_LINEAR,
-                                         bool               genMipmap = true) const;
+   // The result of the decode stage of an asynchronous load, which doesn't require a GL context
+   struct DecodedResource
+   {
+      // The levels of the texture are tightly packed one after the other, starting with the base level
+      std::vector<unsigned char> texData;
+      std::vector<size_t>        levelOffsets;
+      int                        width;
+      int                        height;
+      int                        numComponents;
+      unsigned int               wrapS;
+      unsigned int               wrapT;
+      unsigned int               minFilter;
+      unsigned int               magFilter;
+      bool                       genMipmap;
+   };
+
+   std::shared_ptr<Texture>         loadResource(const std::string& texFilePath,
+                                                 unsigned int       wrapS     = GL_REPEAT,
+                                                 unsigned int       wrapT     = GL_REPEAT,
+                                                 unsigned int       minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                                                 unsigned int       magFilter = GL_LINEAR,
+                                                 bool               genMipmap = true) const;
+
+   // Reads and decompresses the image and generates its mipmaps, which can be done on a worker thread
+   // In the native build, the decoded levels are cached on disk, so the image is only decompressed the first time it's loaded
+   std::shared_ptr<DecodedResource> decodeResource(const std::string& texFilePath,
+                                                   unsigned int       wrapS     = GL_REPEAT,
+                                                   unsigned int       wrapT     = GL_REPEAT,
+                                                   unsigned int       minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                                                   unsigned int       magFilter = GL_LINEAR,
+                                                   bool               genMipmap = true) const;
+
+   // Creates the texture from the decoded image, which must be done on the thread that owns the GL context
+   std::shared_ptr<Texture>         uploadResource(const DecodedResource& decodedTexture) const;
+
+   // The approximate amount of GPU memory that's used by the texture, including its mipmaps
+   static size_t                    getSizeInBytes(const DecodedResource& decodedTexture);
+
+   // Textures that are loaded with the same parameters from different spellings of the same path share the same ID
+   static std::string               getResourceID(const std::string& texFilePath,
+                                                  unsigned int       wrapS     = GL_REPEAT,
+                                                  unsigned int       wrapT     = GL_REPEAT,
+                                                  unsigned int       minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                                                  unsigned int       magFilter = GL_LINEAR,
+                                                  bool               genMipmap = true);
+
+   // Only reads the header of the image, which is much cheaper than decoding it
+   static bool                      readImageSize(const std::string& texFilePath, int& width, int& height);
 
 private:
 
-   unsigned int generateTexture(const std::unique_ptr<unsigned char, void(*)(void*)>& texData,
-                                int          width,
-                                int          height,
-                                int          numComponents,
-                                unsigned int wrapS,
-                                unsigned int wrapT,
-                                unsigned int minFilter,
-                                unsigned int magFilter,
-                                bool         genMipmap) const;
+   unsigned int generateTexture(const DecodedResource& decodedTexture) const;
 };
 
 #endif
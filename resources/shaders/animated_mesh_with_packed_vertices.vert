@@ -0,0 +1,58 @@
+// The locations of the attributes are explicit because each variant of this shader uses a different subset of them
+// (e.g. the weights are optimized away when NUM_INFLUENCES is 1), and all the variants must be able to use the same VAO
+layout(location = 0) in vec3  position;
+layout(location = 1) in vec2  normal;
+layout(location = 2) in vec2  texCoord;
+layout(location = 3) in vec4  weights;
+layout(location = 4) in uvec4 joints;
+
+// The number of skin matrices that are fetched for each vertex (1, 2 or 4)
+#ifndef NUM_INFLUENCES
+#define NUM_INFLUENCES 4
+#endif
+
+uniform mat4 model;
+
+#include "PerFrame"
+
+#define MAX_NUMBER_OF_SKIN_MATRICES 49
+uniform mat4 animated[MAX_NUMBER_OF_SKIN_MATRICES];
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+// This function must be kept in sync with AnimatedMeshHelpers::EncodeOctahedralNormal
+vec3 decodeOctahedralNormal(vec2 encodedNormal)
+{
+   vec3 n = vec3(encodedNormal.x, encodedNormal.y, 1.0f - abs(encodedNormal.x) - abs(encodedNormal.y));
+
+   // Unfold the lower hemisphere
+   float t = max(-n.z, 0.0f);
+   n.x += (n.x >= 0.0f) ? -t : t;
+   n.y += (n.y >= 0.0f) ? -t : t;
+
+   return normalize(n);
+}
+
+void main()
+{
+#if NUM_INFLUENCES == 1
+   // Rigidly skinned vertices are fully influenced by a single joint, so their weight is always 1
+   mat4 skin = animated[joints.x];
+#elif NUM_INFLUENCES == 2
+   mat4 skin = (animated[joints.x] * weights.x) +
+               (animated[joints.y] * weights.y);
+#else
+   mat4 skin = (animated[joints.x] * weights.x) +
+               (animated[joints.y] * weights.y) +
+               (animated[joints.z] * weights.z) +
+               (animated[joints.w] * weights.w);
+#endif
+
+   gl_Position = projectionView * model * skin * vec4(position, 1.0f);
+
+   fragPos = vec3(model * skin * vec4(position, 1.0f));
+   norm    = normalize(vec3(model * skin * vec4(decodeOctahedralNormal(normal), 0.0f)));
+   uv      = texCoord;
+}
@@ -5,8 +5,8 @@ in vec4  weights;
 in ivec4 joints;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+#include "PerFrame"
 
 #define MAX_NUMBER_OF_SKIN_MATRICES 49
 uniform mat4 animated[MAX_NUMBER_OF_SKIN_MATRICES];
@@ -22,7 +22,7 @@ void main()
                (animated[joints.z] * weights.z) +
                (animated[joints.w] * weights.w);
 
-   gl_Position = projection * view * model * skin * vec4(position, 1.0f);
+   gl_Position = projectionView * model * skin * vec4(position, 1.0f);
 
    fragPos = vec3(model * skin * vec4(position, 1.0f));
    norm    = normalize(vec3(model * skin * vec4(normal, 0.0f)));
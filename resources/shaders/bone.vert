@@ -1,13 +1,28 @@
-in vec3 inPos;
-in vec3 inCol;
+// The bones are expanded from gl_VertexID, so this shader doesn't use any vertex attributes
+// Each joint is represented by 2 vertices: the first one is placed at the joint and the second one at its parent
+// The joints that don't have a parent use themselves as their parent, which produces a line with zero length that isn't rasterized
+
+// The pose texture stores the 4 columns of the matrix of each joint in a row
+uniform highp sampler2D  poseTexture;
+// The joint info texture stores the index of the parent of each joint and the index of its color in the palette
+uniform highp isampler2D jointInfoTexture;
 
 uniform mat4 model;
-uniform mat4 projectionView;
+uniform vec3 colorPalette[3];
+
+#include "PerFrame"
 
 out vec3 col;
 
 void main()
 {
-   col = inCol;
-   gl_Position = projectionView * model * vec4(inPos, 1.0f);
+   int   jointIndex = gl_VertexID / 2;
+   ivec2 jointInfo  = texelFetch(jointInfoTexture, ivec2(jointIndex, 0), 0).xy;
+
+   // The position of a joint is stored in the last column of its matrix
+   int  indexOfEndpoint = ((gl_VertexID % 2) == 0) ? jointIndex : jointInfo.x;
+   vec3 position        = texelFetch(poseTexture, ivec2(3, indexOfEndpoint), 0).xyz;
+
+   col = colorPalette[jointInfo.y];
+   gl_Position = projectionView * model * vec4(position, 1.0f);
 }
@@ -2,20 +2,7 @@ in vec3 fragPos;
 in vec3 norm;
 in vec2 uv;
 
-struct PointLight
-{
-   vec3  worldPos;
-   vec3  color;
-   float constantAtt;
-   float linearAtt;
-   float quadraticAtt;
-};
-
-#define MAX_NUMBER_OF_POINT_LIGHTS 5
-uniform PointLight pointLights[MAX_NUMBER_OF_POINT_LIGHTS];
-uniform int numPointLightsInScene;
-
-uniform vec3 cameraPos;
+#include "PerFrame"
 
 uniform sampler2D diffuseTex;
 
@@ -1,4 +1,4 @@
-uniform vec3 color;
+in vec3 color;
 
 out vec4 FragColor;
 
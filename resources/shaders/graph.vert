@@ -1,8 +1,40 @@
-in vec3 position;
+in vec3  position;
+in vec2  phase;
+in ivec2 colorAndGraphIndices;
 
-uniform mat4 projectionView;
+uniform mat4  projectionView;
+uniform float timeOffset;
+uniform float graphWidth;
+uniform int   indexOfSelectedGraph;
+
+#define NUMBER_OF_COLORS 5
+uniform vec3 colorPalette[NUMBER_OF_COLORS];
+uniform vec3 selectedColorPalette[NUMBER_OF_COLORS];
+
+out vec3 color;
 
 void main()
 {
-   gl_Position = projectionView * vec4(position, 1.0);
+   // All the lines are stored in a single buffer
+   // colorAndGraphIndices.x is the index of the color of a line in the palettes
+   // colorAndGraphIndices.y is the index of the graph that a line belongs to, or -1 for lines that don't belong to a graph (e.g. the reference lines)
+   int colorIndex = colorAndGraphIndices.x;
+   int graphIndex = colorAndGraphIndices.y;
+
+   vec3 pos = position;
+
+   // The curves are stored once and scrolled here, which is why they don't need to be updated on the CPU every frame
+   // For the vertices of a curve:
+   // - position.x is the X coordinate of the origin of the graph that the curve belongs to
+   // - phase.x is the position of the segment that the vertex belongs to along the graph, normalized to [0, 1)
+   // - phase.y is the offset of the vertex from the start of its segment, also normalized
+   // Wrapping phase.x - timeOffset makes the segments that scroll past the origin of a graph reappear at its end
+   if (graphIndex >= 0)
+   {
+      pos.x += (fract(phase.x - timeOffset) + phase.y) * graphWidth;
+   }
+
+   color = (graphIndex >= 0 && graphIndex == indexOfSelectedGraph) ? selectedColorPalette[colorIndex] : colorPalette[colorIndex];
+
+   gl_Position = projectionView * vec4(pos, 1.0);
 }
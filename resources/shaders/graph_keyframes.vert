@@ -0,0 +1,172 @@
+// This shader evaluates the curves of the graphs directly from the keyframes of the rotation tracks
+// It doesn't use any vertex attributes: everything is derived from gl_VertexID and fetched from the keyframe texture
+// See TrackVisualizer::initializeKeyframeTexture for a description of the layout of that texture
+
+uniform highp sampler2D keyframes;
+
+uniform mat4  projectionView;
+uniform float timeOffset;
+uniform float graphWidth;
+uniform float graphHeight;
+uniform int   numSamplesPerCurve;
+uniform int   indexOfSelectedGraph;
+
+uniform vec3 colorPalette[4];
+uniform vec3 selectedColorPalette[4];
+
+out vec3 color;
+
+// This is only captured with transform feedback by TrackVisualizer::verifyCurvesAgainstCPU, and it's ignored when the curves are rendered
+out vec4 sampledRotation;
+
+// These must match the values of the Interpolation enum
+#define INTERPOLATION_CONSTANT 0
+#define INTERPOLATION_LINEAR   1
+
+vec4 fetchTexel(int texelIndex)
+{
+   int textureWidth = textureSize(keyframes, 0).x;
+   return texelFetch(keyframes, ivec2(texelIndex % textureWidth, texelIndex / textureWidth), 0);
+}
+
+// Each frame is stored in 4 texels: value, in slope, out slope and time
+vec4  fetchValue(int firstFrameTexel, int frameIndex)    { return fetchTexel(firstFrameTexel + (frameIndex * 4));     }
+vec4  fetchInSlope(int firstFrameTexel, int frameIndex)  { return fetchTexel(firstFrameTexel + (frameIndex * 4) + 1); }
+vec4  fetchOutSlope(int firstFrameTexel, int frameIndex) { return fetchTexel(firstFrameTexel + (frameIndex * 4) + 2); }
+float fetchTime(int firstFrameTexel, int frameIndex)     { return fetchTexel(firstFrameTexel + (frameIndex * 4) + 3).x; }
+
+// Equivalent to Track::GetIndexOfLastFrameBeforeTime when not looping, but with a binary search instead of a linear one
+int getIndexOfLastFrameBeforeTime(int firstFrameTexel, int numFrames, float time)
+{
+   if (time <= fetchTime(firstFrameTexel, 0))
+   {
+      return 0;
+   }
+
+   if (time >= fetchTime(firstFrameTexel, numFrames - 2))
+   {
+      return numFrames - 2;
+   }
+
+   int low  = 0;
+   int high = numFrames - 2;
+   while (low < high)
+   {
+      int middle = (low + high + 1) / 2;
+      if (fetchTime(firstFrameTexel, middle) <= time)
+      {
+         low = middle;
+      }
+      else
+      {
+         high = middle - 1;
+      }
+   }
+
+   return low;
+}
+
+// Equivalent to Track::Sample for quaternion tracks when not looping
+// Note that the values of the frames are normalized before they are uploaded, just like Track::Cast does
+vec4 sampleTrack(int trackTexel, float time)
+{
+   vec4 trackInfo    = fetchTexel(trackTexel);
+   int numFrames     = int(trackInfo.x);
+   int interpolation = int(trackInfo.y);
+   float startTime   = trackInfo.z;
+   float endTime     = trackInfo.w;
+
+   int firstFrameTexel = trackTexel + 3;
+
+   if (numFrames <= 1)
+   {
+      return vec4(0.0, 0.0, 0.0, 1.0);
+   }
+
+   int thisFrame = getIndexOfLastFrameBeforeTime(firstFrameTexel, numFrames, time);
+
+   if (interpolation == INTERPOLATION_CONSTANT)
+   {
+      return fetchValue(firstFrameTexel, thisFrame);
+   }
+
+   int nextFrame = thisFrame + 1;
+   float timeOfThisFrame   = fetchTime(firstFrameTexel, thisFrame);
+   float timeBetweenFrames = fetchTime(firstFrameTexel, nextFrame) - timeOfThisFrame;
+   if (timeBetweenFrames <= 0.0)
+   {
+      return vec4(0.0, 0.0, 0.0, 1.0);
+   }
+
+   float t = (clamp(time, startTime, endTime) - timeOfThisFrame) / timeBetweenFrames;
+
+   vec4 p1 = fetchValue(firstFrameTexel, thisFrame);
+   vec4 p2 = fetchValue(firstFrameTexel, nextFrame);
+
+   // Quaternion neighborhood check
+   if (dot(p1, p2) < 0.0)
+   {
+      p2 = -p2;
+   }
+
+   if (interpolation == INTERPOLATION_LINEAR)
+   {
+      return normalize(mix(p1, p2, t));
+   }
+
+   vec4 outTangentOfP1 = fetchOutSlope(firstFrameTexel, thisFrame) * timeBetweenFrames;
+   vec4 inTangentOfP2  = fetchInSlope(firstFrameTexel, nextFrame) * timeBetweenFrames;
+
+   float tt  = t * t;
+   float ttt = tt * t;
+
+   vec4 result = (p1 * (2.0 * ttt - 3.0 * tt + 1.0)) +
+                 (outTangentOfP1 * (ttt - 2.0 * tt + t)) +
+                 (p2 * (-2.0 * ttt + 3.0 * tt)) +
+                 (inTangentOfP2 * (ttt - tt));
+
+   return normalize(result);
+}
+
+void main()
+{
+   // Each graph has 4 curves, and each curve is made of (numSamplesPerCurve - 1) segments with 2 vertices each
+   int numSegmentsPerCurve  = numSamplesPerCurve - 1;
+   int numVerticesPerCurve  = numSegmentsPerCurve * 2;
+   int numVerticesPerGraph  = numVerticesPerCurve * 4;
+
+   int graphIndex           = gl_VertexID / numVerticesPerGraph;
+   int vertexIndexInGraph   = gl_VertexID % numVerticesPerGraph;
+   int curveIndex           = vertexIndexInGraph / numVerticesPerCurve;
+   int vertexIndexInCurve   = vertexIndexInGraph % numVerticesPerCurve;
+   int segmentIndex         = vertexIndexInCurve / 2;
+   int sampleIndex          = segmentIndex + (vertexIndexInCurve % 2);
+
+   // The header of each graph stores the origin of its tile and the index of the first texel of its track
+   vec4 graphInfo     = fetchTexel(graphIndex);
+   vec2 originOfGraph = graphInfo.xy;
+   int  trackTexel    = int(graphInfo.z);
+
+   // The header of each track stores its number of frames, its interpolation, its start and end times,
+   // and the values that are used to normalize its samples
+   vec4 trackInfo           = fetchTexel(trackTexel);
+   vec4 minSamples          = fetchTexel(trackTexel + 1);
+   vec4 inverseSampleRanges = fetchTexel(trackTexel + 2);
+
+   float sampleIndexNormalized = float(sampleIndex) / float(numSegmentsPerCurve);
+   vec4  rotation = sampleTrack(trackTexel, sampleIndexNormalized * (trackInfo.w - trackInfo.z));
+   sampledRotation = rotation;
+
+   // Scroll the curve in the same way as graph.vert
+   float segmentPhase = float(segmentIndex) / float(numSegmentsPerCurve);
+   float vertexPhase  = sampleIndexNormalized - segmentPhase;
+
+   vec3 pos;
+   pos.x = originOfGraph.x + (fract(segmentPhase - timeOffset) + vertexPhase) * graphWidth;
+   pos.y = originOfGraph.y + ((rotation[curveIndex] - minSamples[curveIndex]) * inverseSampleRanges[curveIndex] * graphHeight);
+   pos.z = 3.0 - float(curveIndex);
+
+   color = (graphIndex == indexOfSelectedGraph) ? selectedColorPalette[curveIndex] : colorPalette[curveIndex];
+
+   gl_Position = projectionView * vec4(pos, 1.0);
+}
@@ -1,10 +1,17 @@
 in vec3 inPos;
 in vec3 inNormal;
 
-#define MAX_NUMBER_OF_SKIN_MATRICES 49
-uniform mat4 modelMatrices[MAX_NUMBER_OF_SKIN_MATRICES];
-uniform mat4 projectionView;
-uniform int  indexOfGlowingJoint;
+// The pose texture stores the 4 columns of the matrix of each joint in a row
+// Since the matrices are fetched from a texture, there's no limit on the number of joints other than the maximum texture size
+uniform highp sampler2D poseTexture;
+
+uniform mat4  model;
+uniform float scaleFactor;
+uniform int   indexOfGlowingJoint;
+// The joints are ordered depth first, so the subtree of the glowing joint is the range [indexOfGlowingJoint, endOfGlowingSubtree)
+uniform int   endOfGlowingSubtree;
+
+#include "PerFrame"
 
 out vec3 norm;
 out vec3 fragPos;
@@ -12,13 +19,28 @@ out vec3 col;
 
 void main()
 {
-   fragPos = vec3(modelMatrices[gl_InstanceID] * vec4(inPos, 1.0f));
-   norm    = normalize(vec3(modelMatrices[gl_InstanceID] * vec4(inNormal, 0.0f)));
+   mat4 poseMatrix = mat4(texelFetch(poseTexture, ivec2(0, gl_InstanceID), 0),
+                          texelFetch(poseTexture, ivec2(1, gl_InstanceID), 0),
+                          texelFetch(poseTexture, ivec2(2, gl_InstanceID), 0),
+                          texelFetch(poseTexture, ivec2(3, gl_InstanceID), 0));
+
+   // The model transform is applied first, then the transform of the joint, and then the scale that increases the size of the pyramids
+   float scale       = (indexOfGlowingJoint == gl_InstanceID) ? (scaleFactor * 3.5f) : scaleFactor;
+   mat4  scaleMatrix = mat4(scale);
+   scaleMatrix[3][3] = 1.0f;
+   mat4  modelMatrix = model * poseMatrix * scaleMatrix;
+
+   fragPos = vec3(modelMatrix * vec4(inPos, 1.0f));
+   norm    = normalize(vec3(modelMatrix * vec4(inNormal, 0.0f)));
 
    if (indexOfGlowingJoint == gl_InstanceID)
    {
       col = vec3(0.0f, 0.25f, 0.25f);
    }
+   else if (gl_InstanceID > indexOfGlowingJoint && gl_InstanceID < endOfGlowingSubtree)
+   {
+      col = vec3(0.0f, 0.2f, 0.35f);
+   }
    else
    {
       col = vec3(0.0f, 0.35f, 0.0f);
@@ -0,0 +1,8 @@
+// Nothing is rasterized while the skinned vertices are captured, but a program still needs a fragment shader to be linked in WebGL 2
+
+out vec4 fragColor;
+
+void main()
+{
+   fragColor = vec4(0.0f);
+}
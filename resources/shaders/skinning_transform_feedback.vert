@@ -0,0 +1,42 @@
+// This shader skins the vertices of a mesh that uses the packed vertex format, and the skinned vertices are captured with transform feedback
+// It runs with GL_RASTERIZER_DISCARD enabled, so nothing is rasterized
+// The skinned vertices are in model space, so they can be rendered by static_mesh.vert with the model matrix of the character
+
+// The locations of the attributes must match the ones of animated_mesh_with_packed_vertices.vert, since both shaders use the same VAO
+layout(location = 0) in vec3  position;
+layout(location = 1) in vec2  normal;
+layout(location = 3) in vec4  weights;
+layout(location = 4) in uvec4 joints;
+
+#define MAX_NUMBER_OF_SKIN_MATRICES 49
+uniform mat4 animated[MAX_NUMBER_OF_SKIN_MATRICES];
+
+// These are captured in this order, so they must match AnimatedMeshHelpers::SkinnedVertex
+out vec3 skinnedPosition;
+out vec3 skinnedNormal;
+
+// This function must be kept in sync with AnimatedMeshHelpers::EncodeOctahedralNormal
+vec3 decodeOctahedralNormal(vec2 encodedNormal)
+{
+   vec3 n = vec3(encodedNormal.x, encodedNormal.y, 1.0f - abs(encodedNormal.x) - abs(encodedNormal.y));
+
+   // Unfold the lower hemisphere
+   float t = max(-n.z, 0.0f);
+   n.x += (n.x >= 0.0f) ? -t : t;
+   n.y += (n.y >= 0.0f) ? -t : t;
+
+   return normalize(n);
+}
+
+void main()
+{
+   mat4 skin = (animated[joints.x] * weights.x) +
+               (animated[joints.y] * weights.y) +
+               (animated[joints.z] * weights.z) +
+               (animated[joints.w] * weights.w);
+
+   skinnedPosition = vec3(skin * vec4(position, 1.0f));
+   skinnedNormal   = normalize(vec3(skin * vec4(decodeOctahedralNormal(normal), 0.0f)));
+
+   gl_Position = vec4(skinnedPosition, 1.0f);
+}
@@ -3,8 +3,8 @@ in vec3 normal;
 in vec2 texCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+#include "PerFrame"
 
 out vec3 norm;
 out vec3 fragPos;
@@ -12,7 +12,7 @@ out vec2 uv;
 
 void main()
 {
-   gl_Position = projection * view * model * vec4(position, 1.0f);
+   gl_Position = projectionView * model * vec4(position, 1.0f);
 
    fragPos = vec3(model * vec4(position, 1.0f));
    norm    = normalize(vec3(model * vec4(normal, 0.0f)));
@@ -4,10 +4,101 @@
 #include <glad/glad.h>
 #endif
 
+#include <cstddef>
+#include <utility>
+
+#include <glm/gtc/packing.hpp>
+
 #include "AnimatedMesh.h"
 #include "Transform.h"
 
+namespace AnimatedMeshHelpers
+{
+   /*
+      The packed vertex format interleaves all the attributes of a vertex in a single 28 byte struct:
+
+      +----------------------+-------------+-------------+-------------+-------------+
+      | Position             | Normal      | UV          | Weights     | Joints      |
+      | float x 3 (12 bytes) | snorm16 x 2 | half x 2    | unorm8 x 4  | uint8 x 4   |
+      +----------------------+-------------+-------------+-------------+-------------+
+
+      The unpacked format uses 68 bytes per vertex spread across 5 VBOs
+
+      The normal is encoded using an octahedral mapping, which projects the unit sphere onto an octahedron
+      and then unfolds the octahedron onto a square, so that only 2 components need to be stored
+      Note that the joint indices are stored as bytes, so this format can only be used for skeletons with fewer than 256 joints
+   */
+   struct PackedVertex
+   {
+      glm::vec3   position;
+      uint32_t    normal;
+      uint32_t    texCoord;
+      uint32_t    weights;
+      glm::u8vec4 joints;
+   };
+
+   static_assert(sizeof(PackedVertex) == 28, "The size of a PackedVertex must be 28 bytes");
+
+   // The function below quantizes a set of weights that add up to 1 into unorm8 values that add up to exactly 255
+   // Rounding each weight independently can make the sum drift by a few units, so the error is absorbed by the largest weight
+   uint32_t QuantizeWeights(const glm::vec4& weights)
+   {
+      glm::ivec4 quantizedWeights = glm::ivec4(glm::round(glm::clamp(weights, 0.0f, 1.0f) * 255.0f));
+
+      int indexOfLargestWeight = 0;
+      for (int i = 1; i < 4; ++i)
+      {
+         if (quantizedWeights[i] > quantizedWeights[indexOfLargestWeight])
+         {
+            indexOfLargestWeight = i;
+         }
+      }
+
+      int sum = quantizedWeights.x + quantizedWeights.y + quantizedWeights.z + quantizedWeights.w;
+      quantizedWeights[indexOfLargestWeight] += 255 - sum;
+
+      return static_cast<uint32_t>(quantizedWeights.x)         |
+             (static_cast<uint32_t>(quantizedWeights.y) << 8)  |
+             (static_cast<uint32_t>(quantizedWeights.z) << 16) |
+             (static_cast<uint32_t>(quantizedWeights.w) << 24);
+   }
+
+   // The layout of the vertices that are captured by skinning_transform_feedback.vert
+   struct SkinnedVertex
+   {
+      glm::vec3 position;
+      glm::vec3 normal;
+   };
+
+   glm::vec2 SignNotZero(const glm::vec2& v)
+   {
+      return glm::vec2((v.x >= 0.0f) ? 1.0f : -1.0f, (v.y >= 0.0f) ? 1.0f : -1.0f);
+   }
+
+   // The function below must be kept in sync with decodeOctahedralNormal in animated_mesh_with_packed_vertices.vert and skinning_transform_feedback.vert
+   glm::vec2 EncodeOctahedralNormal(const glm::vec3& normal)
+   {
+      // Project the normal onto the octahedron
+      glm::vec3 n = normal / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+
+      // Fold the lower hemisphere over the diagonals
+      glm::vec2 encodedNormal(n.x, n.y);
+      if (n.z < 0.0f)
+      {
+         encodedNormal = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * SignNotZero(encodedNormal);
+      }
+
+      return encodedNormal;
+   }
+}
+
 AnimatedMesh::AnimatedMesh()
+   : mNumVertices(0)
+   , mNumIndices(0)
+   , mIndexType(GL_UNSIGNED_INT)
+   , mUsesPackedVertices(false)
+   , mSkinnedVAO(0)
+   , mSkinnedVBO(0)
 {
    glGenVertexArrays(1, &mVAO);
    glGenBuffers(5, &mVBOs[0]);
@@ -19,6 +110,8 @@ AnimatedMesh::~AnimatedMesh()
    glDeleteVertexArrays(1, &mVAO);
    glDeleteBuffers(5, &mVBOs[0]);
    glDeleteBuffers(1, &mEBO);
+   glDeleteVertexArrays(1, &mSkinnedVAO);
+   glDeleteBuffers(1, &mSkinnedVBO);
 }
 
 AnimatedMesh::AnimatedMesh(AnimatedMesh&& rhs) noexcept
@@ -28,28 +121,40 @@ AnimatedMesh::AnimatedMesh(AnimatedMesh&& rhs) noexcept
    , mWeights(std::move(rhs.mWeights))
    , mInfluences(std::move(rhs.mInfluences))
    , mIndices(std::move(rhs.mIndices))
+   , mInfluenceBuckets(std::move(rhs.mInfluenceBuckets))
+   , mLevelsOfDetail(std::move(rhs.mLevelsOfDetail))
    , mNumVertices(std::exchange(rhs.mNumVertices, 0))
    , mNumIndices(std::exchange(rhs.mNumIndices, 0))
+   , mIndexType(rhs.mIndexType)
+   , mUsesPackedVertices(rhs.mUsesPackedVertices)
    , mVAO(std::exchange(rhs.mVAO, 0))
    , mVBOs(std::exchange(rhs.mVBOs, std::array<unsigned int, 5>()))
    , mEBO(std::exchange(rhs.mEBO, 0))
+   , mSkinnedVAO(std::exchange(rhs.mSkinnedVAO, 0))
+   , mSkinnedVBO(std::exchange(rhs.mSkinnedVBO, 0))
 {
 
 }
 
 AnimatedMesh& AnimatedMesh::operator=(AnimatedMesh&& rhs) noexcept
 {
-   mPositions   = std::move(rhs.mPositions);
-   mNormals     = std::move(rhs.mNormals);
-   mTexCoords   = std::move(rhs.mTexCoords);
-   mWeights     = std::move(rhs.mWeights);
-   mInfluences  = std::move(rhs.mInfluences);
-   mIndices     = std::move(rhs.mIndices);
-   mNumVertices = std::exchange(rhs.mNumVertices, 0);
-   mNumIndices  = std::exchange(rhs.mNumIndices, 0);
-   mVAO         = std::exchange(rhs.mVAO, 0);
-   mVBOs        = std::exchange(rhs.mVBOs, std::array<unsigned int, 5>());
-   mEBO         = std::exchange(rhs.mEBO, 0);
+   mPositions          = std::move(rhs.mPositions);
+   mNormals            = std::move(rhs.mNormals);
+   mTexCoords          = std::move(rhs.mTexCoords);
+   mWeights            = std::move(rhs.mWeights);
+   mInfluences         = std::move(rhs.mInfluences);
+   mIndices            = std::move(rhs.mIndices);
+   mInfluenceBuckets   = std::move(rhs.mInfluenceBuckets);
+   mLevelsOfDetail     = std::move(rhs.mLevelsOfDetail);
+   mNumVertices        = std::exchange(rhs.mNumVertices, 0);
+   mNumIndices         = std::exchange(rhs.mNumIndices, 0);
+   mIndexType          = rhs.mIndexType;
+   mUsesPackedVertices = rhs.mUsesPackedVertices;
+   mVAO                = std::exchange(rhs.mVAO, 0);
+   mVBOs               = std::exchange(rhs.mVBOs, std::array<unsigned int, 5>());
+   mEBO                = std::exchange(rhs.mEBO, 0);
+   mSkinnedVAO         = std::exchange(rhs.mSkinnedVAO, 0);
+   mSkinnedVBO         = std::exchange(rhs.mSkinnedVBO, 0);
    return *this;
 }
 
@@ -85,16 +190,107 @@ void AnimatedMesh::LoadBuffers()
 
    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-   // Indices
+   glBindVertexArray(0);
+
+   LoadIndexBuffer();
+
+   mNumVertices = static_cast<unsigned int>(mPositions.size());
+   mNumIndices = mLevelsOfDetail.empty() ? static_cast<unsigned int>(mIndices.size()) : mLevelsOfDetail[0].firstIndex;
+   mUsesPackedVertices = false;
+}
+
+// The function below checks if the vertices of the mesh can be stored using the packed format described in AnimatedMeshHelpers
+bool AnimatedMesh::CanPackVertices() const
+{
+   size_t numVertices = mPositions.size();
+   if (numVertices == 0 ||
+       mNormals.size()    != numVertices ||
+       mTexCoords.size()  != numVertices ||
+       mWeights.size()    != numVertices ||
+       mInfluences.size() != numVertices)
+   {
+      return false;
+   }
+
+   for (const glm::ivec4& influence : mInfluences)
+   {
+      if (glm::any(glm::lessThan(influence, glm::ivec4(0))) || glm::any(glm::greaterThan(influence, glm::ivec4(255))))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+void AnimatedMesh::LoadPackedBuffers()
+{
+   // Pack the vertices
+   std::vector<AnimatedMeshHelpers::PackedVertex> packedVertices(mPositions.size());
+   for (unsigned int i = 0,
+        size = static_cast<unsigned int>(mPositions.size());
+        i < size;
+        ++i)
+   {
+      AnimatedMeshHelpers::PackedVertex& packedVertex = packedVertices[i];
+      packedVertex.position = mPositions[i];
+      packedVertex.normal   = glm::packSnorm2x16(AnimatedMeshHelpers::EncodeOctahedralNormal(mNormals[i]));
+      packedVertex.texCoord = glm::packHalf2x16(mTexCoords[i]);
+      packedVertex.weights  = AnimatedMeshHelpers::QuantizeWeights(mWeights[i]);
+      packedVertex.joints   = glm::u8vec4(mInfluences[i]);
+   }
+
+   glBindVertexArray(mVAO);
+
+   // All the attributes are stored in the positions VBO
+   glBindBuffer(GL_ARRAY_BUFFER, mVBOs[VBOTypes::positions]);
+   glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(AnimatedMeshHelpers::PackedVertex), &packedVertices[0], GL_STATIC_DRAW);
+
+   // Release the memory of the other VBOs, in case they were loaded by LoadBuffers
+   for (unsigned int vboIndex = VBOTypes::normals; vboIndex <= VBOTypes::influences; ++vboIndex)
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, mVBOs[vboIndex]);
+      glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+   }
+
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   glBindVertexArray(0);
+
+   LoadIndexBuffer();
+
+   mNumVertices = static_cast<unsigned int>(mPositions.size());
+   mNumIndices = mLevelsOfDetail.empty() ? static_cast<unsigned int>(mIndices.size()) : mLevelsOfDetail[0].firstIndex;
+   mUsesPackedVertices = true;
+}
+
+void AnimatedMesh::LoadIndexBuffer()
+{
+   // 16-bit indices are used whenever every vertex can be addressed with them, which halves the size of the index buffer
+   // Note that the largest index is reserved because WebGL 2 always enables primitive restart with a fixed index of 0xFFFF
+   mIndexType = GL_UNSIGNED_INT;
+   if (mIndices.size() == 0)
+   {
+      return;
+   }
+
+   glBindVertexArray(mVAO);
+
    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-   glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
+   if (mPositions.size() <= 0xFFFF)
+   {
+      std::vector<unsigned short> shortIndices(mIndices.begin(), mIndices.end());
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), &shortIndices[0], GL_STATIC_DRAW);
+      mIndexType = GL_UNSIGNED_SHORT;
+   }
+   else
+   {
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
+   }
 
    // Unbind the VAO first, then the EBO
    glBindVertexArray(0);
    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-   mNumVertices = static_cast<unsigned int>(mPositions.size());
-   mNumIndices = static_cast<unsigned int>(mIndices.size());
 }
 
 void AnimatedMesh::ClearMeshData()
@@ -144,6 +340,100 @@ void AnimatedMesh::UnconfigureVAO(int posAttribLocation,
    glBindVertexArray(0);
 }
 
+void AnimatedMesh::ConfigurePackedVAO(int posAttribLocation,
+                                      int normalAttribLocation,
+                                      int texCoordsAttribLocation,
+                                      int weightsAttribLocation,
+                                      int influencesAttribLocation)
+{
+   glBindVertexArray(mVAO);
+   glBindBuffer(GL_ARRAY_BUFFER, mVBOs[VBOTypes::positions]);
+
+   // Set the vertex attribute pointers
+   const int stride = sizeof(AnimatedMeshHelpers::PackedVertex);
+   if (posAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(posAttribLocation);
+      glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(AnimatedMeshHelpers::PackedVertex, position));
+   }
+   if (normalAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(normalAttribLocation);
+      glVertexAttribPointer(normalAttribLocation, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(AnimatedMeshHelpers::PackedVertex, normal));
+   }
+   if (texCoordsAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(texCoordsAttribLocation);
+      glVertexAttribPointer(texCoordsAttribLocation, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(AnimatedMeshHelpers::PackedVertex, texCoord));
+   }
+   if (weightsAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(weightsAttribLocation);
+      glVertexAttribPointer(weightsAttribLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(AnimatedMeshHelpers::PackedVertex, weights));
+   }
+   if (influencesAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(influencesAttribLocation);
+      glVertexAttribIPointer(influencesAttribLocation, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(AnimatedMeshHelpers::PackedVertex, joints));
+   }
+
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+}
+
+void AnimatedMesh::ConfigureSkinnedVAO(int posAttribLocation,
+                                       int normalAttribLocation,
+                                       int texCoordsAttribLocation)
+{
+   if (mSkinnedVAO == 0)
+   {
+      glGenVertexArrays(1, &mSkinnedVAO);
+      glGenBuffers(1, &mSkinnedVBO);
+   }
+
+   glBindVertexArray(mSkinnedVAO);
+
+   // The skinned VBO is written by the GPU and read by the GPU, so its contents never go through the CPU
+   glBindBuffer(GL_ARRAY_BUFFER, mSkinnedVBO);
+   glBufferData(GL_ARRAY_BUFFER, mNumVertices * sizeof(AnimatedMeshHelpers::SkinnedVertex), nullptr, GL_DYNAMIC_COPY);
+
+   const int skinnedStride = sizeof(AnimatedMeshHelpers::SkinnedVertex);
+   if (posAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(posAttribLocation);
+      glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, skinnedStride, (void*)offsetof(AnimatedMeshHelpers::SkinnedVertex, position));
+   }
+   if (normalAttribLocation >= 0)
+   {
+      glEnableVertexAttribArray(normalAttribLocation);
+      glVertexAttribPointer(normalAttribLocation, 3, GL_FLOAT, GL_FALSE, skinnedStride, (void*)offsetof(AnimatedMeshHelpers::SkinnedVertex, normal));
+   }
+
+   // The texture coordinates aren't affected by skinning, so they are read from the VBO that stores them
+   if (texCoordsAttribLocation >= 0)
+   {
+      if (mUsesPackedVertices)
+      {
+         glBindBuffer(GL_ARRAY_BUFFER, mVBOs[VBOTypes::positions]);
+         glEnableVertexAttribArray(texCoordsAttribLocation);
+         glVertexAttribPointer(texCoordsAttribLocation, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(AnimatedMeshHelpers::PackedVertex), (void*)offsetof(AnimatedMeshHelpers::PackedVertex, texCoord));
+      }
+      else
+      {
+         BindFloatAttribute(texCoordsAttribLocation, mVBOs[VBOTypes::texCoords], 2);
+      }
+   }
+
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   // The skinned mesh is drawn with the same indices as the original one
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+
+   // Unbind the VAO first, then the EBO
+   glBindVertexArray(0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
 void AnimatedMesh::BindFloatAttribute(int attribLocation, unsigned int VBO, int numComponents)
 {
    if (attribLocation >= 0)
@@ -179,35 +469,124 @@ void AnimatedMesh::UnbindAttribute(int attribLocation, unsigned int VBO)
 // TODO: GL_TRIANGLES shouldn't be hardcoded here
 //       Can we load that from the GLTF file?
 void AnimatedMesh::Render()
+{
+   glBindVertexArray(mVAO);
+   Draw();
+   glBindVertexArray(0);
+}
+
+// TODO: GL_TRIANGLES shouldn't be hardcoded here
+//       Can we load that from the GLTF file?
+void AnimatedMesh::RenderInstanced(unsigned int numInstances)
 {
    glBindVertexArray(mVAO);
 
    if (mNumIndices > 0)
    {
-      glDrawElements(GL_TRIANGLES, mNumIndices, GL_UNSIGNED_INT, 0);
+      glDrawElementsInstanced(GL_TRIANGLES, mNumIndices, mIndexType, 0, numInstances);
    }
    else
    {
-      glDrawArrays(GL_TRIANGLES, 0, mNumVertices);
+      glDrawArraysInstanced(GL_TRIANGLES, 0, mNumVertices, numInstances);
    }
 
    glBindVertexArray(0);
 }
 
-// TODO: GL_TRIANGLES shouldn't be hardcoded here
-//       Can we load that from the GLTF file?
-void AnimatedMesh::RenderInstanced(unsigned int numInstances)
+void AnimatedMesh::RenderInfluenceBucket(const InfluenceBucket& bucket)
 {
    glBindVertexArray(mVAO);
+   DrawInfluenceBucket(bucket);
+   glBindVertexArray(0);
+}
 
+// TODO: GL_TRIANGLES shouldn't be hardcoded here
+//       Can we load that from the GLTF file?
+void AnimatedMesh::Draw() const
+{
    if (mNumIndices > 0)
    {
-      glDrawElementsInstanced(GL_TRIANGLES, mNumIndices, GL_UNSIGNED_INT, 0, numInstances);
+      glDrawElements(GL_TRIANGLES, mNumIndices, mIndexType, 0);
    }
    else
    {
-      glDrawArraysInstanced(GL_TRIANGLES, 0, mNumVertices, numInstances);
+      glDrawArrays(GL_TRIANGLES, 0, mNumVertices);
    }
+}
 
-   glBindVertexArray(0);
+void AnimatedMesh::DrawInfluenceBucket(const InfluenceBucket& bucket) const
+{
+   size_t sizeOfIndex = (mIndexType == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+   glDrawElements(GL_TRIANGLES, bucket.numIndices, mIndexType, (void*)(bucket.firstIndex * sizeOfIndex));
+}
+
+void AnimatedMesh::DrawLevelOfDetail(unsigned int levelOfDetail) const
+{
+   if (levelOfDetail == 0 || levelOfDetail > mLevelsOfDetail.size())
+   {
+      Draw();
+      return;
+   }
+
+   const LevelOfDetail& level = mLevelsOfDetail[levelOfDetail - 1];
+   size_t sizeOfIndex = (mIndexType == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+   glDrawElements(GL_TRIANGLES, level.numIndices, mIndexType, (void*)(level.firstIndex * sizeOfIndex));
+}
+
+unsigned int AnimatedMesh::GetNumberOfLevelsOfDetail() const
+{
+   return static_cast<unsigned int>(mLevelsOfDetail.size()) + 1;
+}
+
+unsigned int AnimatedMesh::GetNumberOfIndicesOfLevelOfDetail(unsigned int levelOfDetail) const
+{
+   return (levelOfDetail == 0 || levelOfDetail > mLevelsOfDetail.size()) ? mNumIndices : mLevelsOfDetail[levelOfDetail - 1].numIndices;
 }
+
+float AnimatedMesh::GetErrorOfLevelOfDetail(unsigned int levelOfDetail) const
+{
+   return (levelOfDetail == 0 || levelOfDetail > mLevelsOfDetail.size()) ? 0.0f : mLevelsOfDetail[levelOfDetail - 1].error;
+}
+
+const std::vector<AnimatedMesh::InfluenceBucket>& AnimatedMesh::GetInfluenceBucketsOfLevelOfDetail(unsigned int levelOfDetail) const
+{
+   return (levelOfDetail == 0 || levelOfDetail > mLevelsOfDetail.size()) ? mInfluenceBuckets : mLevelsOfDetail[levelOfDetail - 1].influenceBuckets;
+}
+
+void AnimatedMesh::CaptureSkinnedVertices() const
+{
+   // Each vertex is skinned exactly once by drawing the vertices as points, and nothing is rasterized
+   glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mSkinnedVBO);
+   glEnable(GL_RASTERIZER_DISCARD);
+
+   glBeginTransformFeedback(GL_POINTS);
+   glDrawArrays(GL_POINTS, 0, mNumVertices);
+   glEndTransformFeedback();
+
+   glDisable(GL_RASTERIZER_DISCARD);
+   glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+}
+
+#ifndef __EMSCRIPTEN__
+void AnimatedMesh::ReadSkinnedVertices(std::vector<glm::vec3>& outPositions, std::vector<glm::vec3>& outNormals) const
+{
+   std::vector<AnimatedMeshHelpers::SkinnedVertex> skinnedVertices(mNumVertices);
+   if (mSkinnedVBO != 0 && mNumVertices != 0)
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, mSkinnedVBO);
+      glGetBufferSubData(GL_ARRAY_BUFFER, 0, skinnedVertices.size() * sizeof(AnimatedMeshHelpers::SkinnedVertex), &skinnedVertices[0]);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+
+   outPositions.resize(skinnedVertices.size());
+   outNormals.resize(skinnedVertices.size());
+   for (unsigned int i = 0,
+        size = static_cast<unsigned int>(skinnedVertices.size());
+        i < size;
+        ++i)
+   {
+      outPositions[i] = skinnedVertices[i].position;
+      outNormals[i]   = skinnedVertices[i].normal;
+   }
+}
+#endif
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "BakedClip.h"
+
+BakedClip::BakedClip()
+   : mContent(Content::LocalPoses)
+   , mFramesPerSecond(0.0f)
+   , mStartTime(0.0f)
+   , mDuration(0.0f)
+   , mNumFrames(0)
+   , mNumJoints(0)
+   , mLocalTransforms()
+   , mSkinMatrices()
+   , mBindPosePalette()
+{
+
+}
+
+BakedClip::BakedClip(const FastClip& clip, Skeleton& skeleton, float framesPerSecond, Content content)
+   : mContent(content)
+   , mFramesPerSecond(framesPerSecond)
+   , mStartTime(clip.GetStartTime())
+   , mDuration(std::max(clip.GetDuration(), 0.0f))
+   , mNumFrames(CalculateNumberOfFrames(clip.GetDuration(), framesPerSecond))
+   , mNumJoints(skeleton.GetRestPose().GetNumberOfJoints())
+   , mLocalTransforms()
+   , mSkinMatrices()
+   , mBindPosePalette()
+{
+   if (framesPerSecond <= 0.0f)
+   {
+      std::cout << "Error - BakedClip::BakedClip - The frame rate must be greater than zero, so only the first pose of the clip was baked" << "\n";
+   }
+
+   std::vector<glm::mat4>& inverseBindPose = skeleton.GetInvBindPose();
+
+   if (mContent == Content::LocalPoses)
+   {
+      mLocalTransforms.resize(mNumFrames * mNumJoints);
+   }
+   else
+   {
+      mSkinMatrices.resize(mNumFrames * mNumJoints);
+
+      mBindPosePalette.resize(mNumJoints);
+      for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+      {
+         mBindPosePalette[jointIndex] = glm::inverse(inverseBindPose[jointIndex]);
+      }
+   }
+
+   Pose                   pose;
+   std::vector<glm::mat4> posePalette;
+   for (unsigned int frameIndex = 0; frameIndex < mNumFrames; ++frameIndex)
+   {
+      // Sample the clip, starting from the rest pose so that the joints that the clip doesn't animate keep their rest transforms
+      float timeOfFrame = (framesPerSecond > 0.0f) ? std::min(frameIndex / framesPerSecond, mDuration) : 0.0f;
+      pose = skeleton.GetRestPose();
+      clip.Sample(pose, mStartTime + timeOfFrame);
+
+      unsigned int firstJointOfFrame = frameIndex * mNumJoints;
+      if (mContent == Content::LocalPoses)
+      {
+         for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+         {
+            mLocalTransforms[firstJointOfFrame + jointIndex] = pose.GetLocalTransform(jointIndex);
+         }
+      }
+      else
+      {
+         pose.GetMatrixPalette(posePalette);
+         for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+         {
+            mSkinMatrices[firstJointOfFrame + jointIndex] = posePalette[jointIndex] * inverseBindPose[jointIndex];
+         }
+      }
+   }
+}
+
+unsigned int BakedClip::CalculateNumberOfFrames(float duration, float framesPerSecond)
+{
+   if (duration <= 0.0f || framesPerSecond <= 0.0f)
+   {
+      return 1;
+   }
+
+   // A small tolerance prevents durations that are a multiple of the frame time from getting an extra frame due to rounding errors
+   return static_cast<unsigned int>(std::ceil((duration * framesPerSecond) - 0.001f)) + 1;
+}
+
+size_t BakedClip::EstimateMemoryFootprint(float duration, unsigned int numJoints, float framesPerSecond, Content content)
+{
+   size_t numFrames = CalculateNumberOfFrames(duration, framesPerSecond);
+   if (content == Content::LocalPoses)
+   {
+      return sizeof(BakedClip) + (numFrames * numJoints * sizeof(Transform));
+   }
+
+   return sizeof(BakedClip) + ((numFrames + 1) * numJoints * sizeof(glm::mat4));
+}
+
+BakedClip::Content BakedClip::GetContent() const
+{
+   return mContent;
+}
+
+float BakedClip::GetFramesPerSecond() const
+{
+   return mFramesPerSecond;
+}
+
+unsigned int BakedClip::GetNumberOfFrames() const
+{
+   return mNumFrames;
+}
+
+unsigned int BakedClip::GetNumberOfJoints() const
+{
+   return mNumJoints;
+}
+
+size_t BakedClip::GetMemoryFootprint() const
+{
+   return sizeof(BakedClip) +
+          (mLocalTransforms.size() * sizeof(Transform)) +
+          (mSkinMatrices.size() * sizeof(glm::mat4)) +
+          (mBindPosePalette.size() * sizeof(glm::mat4));
+}
+
+void BakedClip::SamplePose(float time, Playback playback, Pose& ioPose) const
+{
+   if (mContent != Content::LocalPoses || ioPose.GetNumberOfJoints() != mNumJoints)
+   {
+      std::cout << "Error - BakedClip::SamplePose - The clip doesn't store local poses, or the pose doesn't have the same number of joints" << "\n";
+      return;
+   }
+
+   unsigned int frameIndex;
+   float        blendFactor;
+   FindFramesToSample(time, playback, frameIndex, blendFactor);
+
+   const Transform* frame = &mLocalTransforms[frameIndex * mNumJoints];
+   if (blendFactor == 0.0f)
+   {
+      for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+      {
+         ioPose.SetLocalTransform(jointIndex, frame[jointIndex]);
+      }
+
+      return;
+   }
+
+   const Transform* nextFrame = frame + mNumJoints;
+   for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+   {
+      ioPose.SetLocalTransform(jointIndex, mix(frame[jointIndex], nextFrame[jointIndex], blendFactor));
+   }
+}
+
+void BakedClip::SampleSkinMatrices(float time, Playback playback, std::vector<glm::mat4>& outSkinMatrices) const
+{
+   if (mContent != Content::SkinMatrices)
+   {
+      std::cout << "Error - BakedClip::SampleSkinMatrices - The clip doesn't store skin matrices" << "\n";
+      return;
+   }
+
+   unsigned int frameIndex;
+   float        blendFactor;
+   FindFramesToSample(time, playback, frameIndex, blendFactor);
+
+   outSkinMatrices.resize(mNumJoints);
+
+   const glm::mat4* frame = &mSkinMatrices[frameIndex * mNumJoints];
+   if (blendFactor == 0.0f)
+   {
+      std::copy(frame, frame + mNumJoints, outSkinMatrices.begin());
+      return;
+   }
+
+   // Blending the matrices linearly doesn't preserve their rotations exactly, but the error is negligible between consecutive frames
+   const glm::mat4* nextFrame = frame + mNumJoints;
+   for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
+   {
+      outSkinMatrices[jointIndex] = (frame[jointIndex] * (1.0f - blendFactor)) + (nextFrame[jointIndex] * blendFactor);
+   }
+}
+
+void BakedClip::GetPosePaletteFromSkinMatrices(const std::vector<glm::mat4>& skinMatrices, std::vector<glm::mat4>& outPosePalette) const
+{
+   outPosePalette.resize(mBindPosePalette.size());
+   for (unsigned int jointIndex = 0,
+        numJoints = static_cast<unsigned int>(std::min(mBindPosePalette.size(), skinMatrices.size()));
+        jointIndex < numJoints;
+        ++jointIndex)
+   {
+      outPosePalette[jointIndex] = skinMatrices[jointIndex] * mBindPosePalette[jointIndex];
+   }
+}
+
+void BakedClip::FindFramesToSample(float time, Playback playback, unsigned int& outFrameIndex, float& outBlendFactor) const
+{
+   outFrameIndex  = 0;
+   outBlendFactor = 0.0f;
+
+   if (mNumFrames <= 1)
+   {
+      return;
+   }
+
+   float timeWithinClip = glm::clamp(time - mStartTime, 0.0f, mDuration);
+   outFrameIndex = std::min(static_cast<unsigned int>(timeWithinClip * mFramesPerSecond), mNumFrames - 1);
+   if (outFrameIndex == mNumFrames - 1)
+   {
+      return;
+   }
+
+   // The last frame is sampled at the end of the clip, so the interval before it can be shorter than the others
+   float timeOfFrame     = outFrameIndex / mFramesPerSecond;
+   float timeOfNextFrame = std::min((outFrameIndex + 1) / mFramesPerSecond, mDuration);
+   float blendFactor     = (timeOfNextFrame > timeOfFrame) ? glm::clamp((timeWithinClip - timeOfFrame) / (timeOfNextFrame - timeOfFrame), 0.0f, 1.0f) : 0.0f;
+
+   if (playback == Playback::Nearest)
+   {
+      outFrameIndex += (blendFactor >= 0.5f) ? 1 : 0;
+      return;
+   }
+
+   outBlendFactor = blendFactor;
+}
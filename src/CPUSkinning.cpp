@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#ifndef __EMSCRIPTEN__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CPU_SKINNING_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "CPUSkinning.h"
+
+namespace CPUSkinningHelpers
+{
+   // Chunks smaller than this aren't worth the cost of submitting them to a thread pool
+   const unsigned int minNumVerticesPerChunk = 2048;
+
+   glm::vec3 NormalizeOrZero(const glm::vec3& vector)
+   {
+      float length = glm::length(vector);
+      return (length > 0.0f) ? (vector / length) : vector;
+   }
+
+#ifdef CPU_SKINNING_USE_SSE
+   void SkinVerticesWithSSE(const glm::vec3*              positions,
+                            const glm::vec3*              normals,
+                            const glm::vec4*              weights,
+                            const glm::ivec4*             influences,
+                            unsigned int                  numVertices,
+                            const std::vector<glm::mat4>& skinMatrices,
+                            glm::vec3*                    outPositions,
+                            glm::vec3*                    outNormals)
+   {
+      alignas(16) float result[4];
+
+      for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+      {
+         const glm::vec4&  weight    = weights[vertexIndex];
+         const glm::ivec4& influence = influences[vertexIndex];
+
+         // The matrices are stored in column-major order, so each column is loaded into its own register
+         const float* matrix0 = glm::value_ptr(skinMatrices[influence.x]);
+         const float* matrix1 = glm::value_ptr(skinMatrices[influence.y]);
+         const float* matrix2 = glm::value_ptr(skinMatrices[influence.z]);
+         const float* matrix3 = glm::value_ptr(skinMatrices[influence.w]);
+
+         __m128 weight0 = _mm_set1_ps(weight.x);
+         __m128 weight1 = _mm_set1_ps(weight.y);
+         __m128 weight2 = _mm_set1_ps(weight.z);
+         __m128 weight3 = _mm_set1_ps(weight.w);
+
+         // Blend the skin matrices
+         __m128 skin[4];
+         for (int column = 0; column < 4; ++column)
+         {
+            __m128 blendedColumn = _mm_mul_ps(_mm_loadu_ps(matrix0 + (column * 4)), weight0);
+            blendedColumn = _mm_add_ps(blendedColumn, _mm_mul_ps(_mm_loadu_ps(matrix1 + (column * 4)), weight1));
+            blendedColumn = _mm_add_ps(blendedColumn, _mm_mul_ps(_mm_loadu_ps(matrix2 + (column * 4)), weight2));
+            blendedColumn = _mm_add_ps(blendedColumn, _mm_mul_ps(_mm_loadu_ps(matrix3 + (column * 4)), weight3));
+            skin[column] = blendedColumn;
+         }
+
+         // Transform the position as a point
+         const glm::vec3& position = positions[vertexIndex];
+         __m128 skinnedPosition = skin[3];
+         skinnedPosition = _mm_add_ps(skinnedPosition, _mm_mul_ps(skin[0], _mm_set1_ps(position.x)));
+         skinnedPosition = _mm_add_ps(skinnedPosition, _mm_mul_ps(skin[1], _mm_set1_ps(position.y)));
+         skinnedPosition = _mm_add_ps(skinnedPosition, _mm_mul_ps(skin[2], _mm_set1_ps(position.z)));
+         _mm_store_ps(result, skinnedPosition);
+         outPositions[vertexIndex] = glm::vec3(result[0], result[1], result[2]);
+
+         if (normals == nullptr)
+         {
+            continue;
+         }
+
+         // Transform the normal as a direction
+         const glm::vec3& normal = normals[vertexIndex];
+         __m128 skinnedNormal = _mm_mul_ps(skin[0], _mm_set1_ps(normal.x));
+         skinnedNormal = _mm_add_ps(skinnedNormal, _mm_mul_ps(skin[1], _mm_set1_ps(normal.y)));
+         skinnedNormal = _mm_add_ps(skinnedNormal, _mm_mul_ps(skin[2], _mm_set1_ps(normal.z)));
+         _mm_store_ps(result, skinnedNormal);
+         outNormals[vertexIndex] = NormalizeOrZero(glm::vec3(result[0], result[1], result[2]));
+      }
+   }
+#endif
+
+   // The function below returns false if the mesh can't be skinned, in which case outPositions and outNormals are filled with its unskinned vertices
+   bool PrepareToSkinMesh(const AnimatedMesh& mesh, std::vector<glm::vec3>& outPositions, std::vector<glm::vec3>& outNormals)
+   {
+      const std::vector<glm::vec3>& positions = mesh.GetPositions();
+      const std::vector<glm::vec3>& normals   = mesh.GetNormals();
+
+      if (mesh.GetWeights().empty())
+      {
+         outPositions = positions;
+         outNormals   = normals;
+         return false;
+      }
+
+      if (mesh.GetWeights().size() != positions.size() || mesh.GetInfluences().size() != positions.size() ||
+          (!normals.empty() && normals.size() != positions.size()))
+      {
+         std::cout << "Error - SkinMesh - The attributes of the mesh don't have the same number of vertices" << "\n";
+         outPositions = positions;
+         outNormals   = normals;
+         return false;
+      }
+
+      outPositions.resize(positions.size());
+      outNormals.resize(normals.size());
+      return true;
+   }
+
+   void SkinRangeOfMesh(const AnimatedMesh&           mesh,
+                        const std::vector<glm::mat4>& skinMatrices,
+                        unsigned int                  firstVertex,
+                        unsigned int                  numVertices,
+                        std::vector<glm::vec3>&       outPositions,
+                        std::vector<glm::vec3>&       outNormals)
+   {
+      bool hasNormals = !outNormals.empty();
+      SkinVertices(mesh.GetPositions().data() + firstVertex,
+                   hasNormals ? (mesh.GetNormals().data() + firstVertex) : nullptr,
+                   mesh.GetWeights().data() + firstVertex,
+                   mesh.GetInfluences().data() + firstVertex,
+                   numVertices,
+                   skinMatrices,
+                   outPositions.data() + firstVertex,
+                   hasNormals ? (outNormals.data() + firstVertex) : nullptr);
+   }
+}
+
+void SkinVertices(const glm::vec3*              positions,
+                  const glm::vec3*              normals,
+                  const glm::vec4*              weights,
+                  const glm::ivec4*             influences,
+                  unsigned int                  numVertices,
+                  const std::vector<glm::mat4>& skinMatrices,
+                  glm::vec3*                    outPositions,
+                  glm::vec3*                    outNormals)
+{
+#ifdef CPU_SKINNING_USE_SSE
+   CPUSkinningHelpers::SkinVerticesWithSSE(positions, normals, weights, influences, numVertices, skinMatrices, outPositions, outNormals);
+#else
+   SkinVerticesWithScalarCode(positions, normals, weights, influences, numVertices, skinMatrices, outPositions, outNormals);
+#endif
+}
+
+void SkinVerticesWithScalarCode(const glm::vec3*              positions,
+                                const glm::vec3*              normals,
+                                const glm::vec4*              weights,
+                                const glm::ivec4*             influences,
+                                unsigned int                  numVertices,
+                                const std::vector<glm::mat4>& skinMatrices,
+                                glm::vec3*                    outPositions,
+                                glm::vec3*                    outNormals)
+{
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      const glm::vec4&  weight    = weights[vertexIndex];
+      const glm::ivec4& influence = influences[vertexIndex];
+
+      glm::mat4 skin = (skinMatrices[influence.x] * weight.x) +
+                       (skinMatrices[influence.y] * weight.y) +
+                       (skinMatrices[influence.z] * weight.z) +
+                       (skinMatrices[influence.w] * weight.w);
+
+      outPositions[vertexIndex] = glm::vec3(skin * glm::vec4(positions[vertexIndex], 1.0f));
+
+      if (normals != nullptr)
+      {
+         outNormals[vertexIndex] = CPUSkinningHelpers::NormalizeOrZero(glm::vec3(skin * glm::vec4(normals[vertexIndex], 0.0f)));
+      }
+   }
+}
+
+void SkinMesh(const AnimatedMesh&           mesh,
+              const std::vector<glm::mat4>& skinMatrices,
+              std::vector<glm::vec3>&       outPositions,
+              std::vector<glm::vec3>&       outNormals)
+{
+   if (!CPUSkinningHelpers::PrepareToSkinMesh(mesh, outPositions, outNormals))
+   {
+      return;
+   }
+
+   CPUSkinningHelpers::SkinRangeOfMesh(mesh, skinMatrices, 0, static_cast<unsigned int>(outPositions.size()), outPositions, outNormals);
+}
+
+#ifdef __EMSCRIPTEN__
+void SkinMesh(const AnimatedMesh&           mesh,
+              const std::vector<glm::mat4>& skinMatrices,
+              std::vector<glm::vec3>&       outPositions,
+              std::vector<glm::vec3>&       outNormals,
+              ThreadPool&                   /*threadPool*/)
+{
+   SkinMesh(mesh, skinMatrices, outPositions, outNormals);
+}
+#else
+void SkinMesh(const AnimatedMesh&           mesh,
+              const std::vector<glm::mat4>& skinMatrices,
+              std::vector<glm::vec3>&       outPositions,
+              std::vector<glm::vec3>&       outNormals,
+              ThreadPool&                   threadPool)
+{
+   if (!CPUSkinningHelpers::PrepareToSkinMesh(mesh, outPositions, outNormals))
+   {
+      return;
+   }
+
+   // The calling thread skins the first chunk while the threads of the pool skin the other ones
+   unsigned int numVertices         = static_cast<unsigned int>(outPositions.size());
+   unsigned int maxNumChunks        = (numVertices + CPUSkinningHelpers::minNumVerticesPerChunk - 1) / CPUSkinningHelpers::minNumVerticesPerChunk;
+   unsigned int numChunks           = std::max(1u, std::min(threadPool.GetNumberOfThreads() + 1, maxNumChunks));
+   unsigned int numVerticesPerChunk = (numVertices + numChunks - 1) / numChunks;
+
+   std::mutex              mutex;
+   std::condition_variable chunksAreSkinned;
+   unsigned int            numPendingChunks = numChunks - 1;
+
+   for (unsigned int chunkIndex = 1; chunkIndex < numChunks; ++chunkIndex)
+   {
+      unsigned int firstVertex        = chunkIndex * numVerticesPerChunk;
+      unsigned int numVerticesInChunk = std::min(numVerticesPerChunk, numVertices - firstVertex);
+      threadPool.Submit([&, firstVertex, numVerticesInChunk]()
+      {
+         CPUSkinningHelpers::SkinRangeOfMesh(mesh, skinMatrices, firstVertex, numVerticesInChunk, outPositions, outNormals);
+
+         std::lock_guard<std::mutex> lock(mutex);
+         if (--numPendingChunks == 0)
+         {
+            chunksAreSkinned.notify_one();
+         }
+      });
+   }
+
+   CPUSkinningHelpers::SkinRangeOfMesh(mesh, skinMatrices, 0, std::min(numVerticesPerChunk, numVertices), outPositions, outNormals);
+
+   std::unique_lock<std::mutex> lock(mutex);
+   chunksAreSkinned.wait(lock, [&numPendingChunks]() { return numPendingChunks == 0; });
+}
+#endif
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "GLTFLoader.h"
+#include "ClipLibrary.h"
+
+namespace ClipLibraryHelpers
+{
+   // The function below estimates how many bytes of memory a track occupies
+   // It takes into account the frames of the track and the map that's used to find frames in constant time
+   template<typename T, unsigned int N>
+   size_t GetMemoryFootprintOfTrack(const FastTrack<T, N>& track)
+   {
+      return (track.GetNumberOfFrames() * sizeof(Frame<N>)) +
+             (track.GetSizeOfSampleToFrameIndexMap() * sizeof(unsigned int));
+   }
+
+   size_t GetMemoryFootprintOfClip(FastClip& clip)
+   {
+      size_t memoryFootprint = sizeof(FastClip) + clip.GetName().size();
+
+      std::vector<FastTransformTrack>& transformTracks = clip.GetTransformTracks();
+      for (FastTransformTrack& transformTrack : transformTracks)
+      {
+         memoryFootprint += sizeof(FastTransformTrack);
+         memoryFootprint += GetMemoryFootprintOfTrack(transformTrack.GetPositionTrack());
+         memoryFootprint += GetMemoryFootprintOfTrack(transformTrack.GetRotationTrack());
+         memoryFootprint += GetMemoryFootprintOfTrack(transformTrack.GetScaleTrack());
+      }
+
+      return memoryFootprint;
+   }
+}
+
+ClipLibrary::ClipLibrary()
+   : mJointMap()
+   , mClipDescriptors()
+   , mLeastRecentlyUsedClips()
+   , mPrefetchQueue()
+   , mMemoryBudget(std::numeric_limits<size_t>::max())
+   , mMemoryUsage(0)
+   , mMemoryUsageOfRawClips(0)
+{
+
+}
+
+ClipLibrary::ClipLibrary(cgltf_data* data, const JointMap& jointMap)
+   : mJointMap(jointMap)
+   , mClipDescriptors()
+   , mLeastRecentlyUsedClips()
+   , mPrefetchQueue()
+   , mMemoryBudget(std::numeric_limits<size_t>::max())
+   , mMemoryUsage(0)
+   , mMemoryUsageOfRawClips(0)
+{
+   // Copy the raw key frames of each clip out of the glTF data
+   // The clips themselves are only decoded when they are requested
+   std::vector<std::string> clipNames = LoadClipNames(data);
+   std::vector<RawClip>     rawClips  = LoadRawClips(data);
+   mClipDescriptors.resize(rawClips.size());
+   for (unsigned int clipIndex = 0,
+        numClips = static_cast<unsigned int>(rawClips.size());
+        clipIndex < numClips;
+        ++clipIndex)
+   {
+      // The raw clips don't have a name if the animation doesn't have one, so the default name of LoadClipNames is used instead
+      rawClips[clipIndex].name = clipNames[clipIndex];
+      mMemoryUsageOfRawClips += GetMemoryFootprintOfRawClip(rawClips[clipIndex]);
+
+      mClipDescriptors[clipIndex].rawClip               = std::move(rawClips[clipIndex]);
+      mClipDescriptors[clipIndex].bakingIsEnabled       = false;
+      mClipDescriptors[clipIndex].bakingFramesPerSecond = 0.0f;
+      mClipDescriptors[clipIndex].bakedContent          = BakedClip::Content::LocalPoses;
+      mClipDescriptors[clipIndex].memoryFootprint       = 0;
+   }
+
+   mMemoryUsage = mMemoryUsageOfRawClips;
+}
+
+ClipLibrary::ClipLibrary(ClipLibrary&& rhs) noexcept
+   : mJointMap(std::move(rhs.mJointMap))
+   , mClipDescriptors(std::move(rhs.mClipDescriptors))
+   , mLeastRecentlyUsedClips(std::move(rhs.mLeastRecentlyUsedClips))
+   , mPrefetchQueue(std::move(rhs.mPrefetchQueue))
+   , mMemoryBudget(rhs.mMemoryBudget)
+   , mMemoryUsage(std::exchange(rhs.mMemoryUsage, 0))
+   , mMemoryUsageOfRawClips(std::exchange(rhs.mMemoryUsageOfRawClips, 0))
+{
+
+}
+
+ClipLibrary& ClipLibrary::operator=(ClipLibrary&& rhs) noexcept
+{
+   mJointMap               = std::move(rhs.mJointMap);
+   mClipDescriptors        = std::move(rhs.mClipDescriptors);
+   mLeastRecentlyUsedClips = std::move(rhs.mLeastRecentlyUsedClips);
+   mPrefetchQueue          = std::move(rhs.mPrefetchQueue);
+   mMemoryBudget           = rhs.mMemoryBudget;
+   mMemoryUsage            = std::exchange(rhs.mMemoryUsage, 0);
+   mMemoryUsageOfRawClips  = std::exchange(rhs.mMemoryUsageOfRawClips, 0);
+   return *this;
+}
+
+unsigned int ClipLibrary::GetNumberOfClips() const
+{
+   return static_cast<unsigned int>(mClipDescriptors.size());
+}
+
+const std::string& ClipLibrary::GetClipName(unsigned int clipIndex) const
+{
+   return mClipDescriptors[clipIndex].rawClip.name;
+}
+
+bool ClipLibrary::IsClipDecoded(unsigned int clipIndex) const
+{
+   return (mClipDescriptors[clipIndex].decodedClip != nullptr);
+}
+
+FastClip& ClipLibrary::GetClip(unsigned int clipIndex)
+{
+   if (!IsClipDecoded(clipIndex))
+   {
+      DecodeClip(clipIndex);
+   }
+
+   // Move the clip to the front of the LRU list, since it's now the most recently used one
+   std::list<unsigned int>::iterator it = std::find(mLeastRecentlyUsedClips.begin(), mLeastRecentlyUsedClips.end(), clipIndex);
+   if (it != mLeastRecentlyUsedClips.begin())
+   {
+      mLeastRecentlyUsedClips.splice(mLeastRecentlyUsedClips.begin(), mLeastRecentlyUsedClips, it);
+   }
+
+   EvictLeastRecentlyUsedClips();
+
+   return *mClipDescriptors[clipIndex].decodedClip;
+}
+
+void ClipLibrary::RequestPrefetch(unsigned int clipIndex)
+{
+   if (clipIndex >= mClipDescriptors.size() || IsClipDecoded(clipIndex))
+   {
+      return;
+   }
+
+   if (std::find(mPrefetchQueue.begin(), mPrefetchQueue.end(), clipIndex) == mPrefetchQueue.end())
+   {
+      mPrefetchQueue.push_back(clipIndex);
+   }
+}
+
+void ClipLibrary::RequestPrefetchOfNeighbors(unsigned int clipIndex)
+{
+   unsigned int numClips = GetNumberOfClips();
+   if (numClips <= 1)
+   {
+      return;
+   }
+
+   // The clips are displayed in a list, so the user is most likely to select the ones that are next to the current one
+   RequestPrefetch((clipIndex + 1) % numClips);
+   RequestPrefetch((clipIndex + numClips - 1) % numClips);
+}
+
+void ClipLibrary::ProcessPrefetchQueue(unsigned int maxNumClipsToDecode)
+{
+   // The prefetch queue is processed a few clips at a time while the application is running,
+   // which spreads the cost of decoding clips across multiple frames
+   unsigned int numDecodedClips = 0;
+   while (!mPrefetchQueue.empty() && numDecodedClips < maxNumClipsToDecode)
+   {
+      // Prefetching a clip when the budget is already exhausted would only cause it or another clip to be evicted
+      if (mMemoryUsage >= mMemoryBudget)
+      {
+         mPrefetchQueue.clear();
+         return;
+      }
+
+      unsigned int clipIndex = mPrefetchQueue.front();
+      mPrefetchQueue.pop_front();
+
+      if (!IsClipDecoded(clipIndex))
+      {
+         DecodeClip(clipIndex);
+         ++numDecodedClips;
+      }
+   }
+
+   // The last clip that was decoded can push the memory usage over the budget
+   EvictLeastRecentlyUsedClips();
+}
+
+void ClipLibrary::EnableBakingOfClip(unsigned int clipIndex, float framesPerSecond, BakedClip::Content content)
+{
+   ClipDescriptor& descriptor = mClipDescriptors[clipIndex];
+   if (descriptor.bakingIsEnabled && descriptor.bakingFramesPerSecond == framesPerSecond && descriptor.bakedContent == content)
+   {
+      return;
+   }
+
+   DiscardBakedClip(clipIndex);
+
+   descriptor.bakingIsEnabled       = true;
+   descriptor.bakingFramesPerSecond = framesPerSecond;
+   descriptor.bakedContent          = content;
+}
+
+void ClipLibrary::DisableBakingOfClip(unsigned int clipIndex)
+{
+   DiscardBakedClip(clipIndex);
+   mClipDescriptors[clipIndex].bakingIsEnabled = false;
+}
+
+bool ClipLibrary::IsBakingOfClipEnabled(unsigned int clipIndex) const
+{
+   return mClipDescriptors[clipIndex].bakingIsEnabled;
+}
+
+const BakedClip* ClipLibrary::GetBakedClip(unsigned int clipIndex, Skeleton& skeleton)
+{
+   if (!mClipDescriptors[clipIndex].bakingIsEnabled)
+   {
+      return nullptr;
+   }
+
+   // This decodes the clip if necessary and marks it as the most recently used one
+   FastClip& clip = GetClip(clipIndex);
+
+   ClipDescriptor& descriptor = mClipDescriptors[clipIndex];
+   if (!descriptor.bakedClip)
+   {
+      descriptor.bakedClip = std::make_unique<BakedClip>(clip, skeleton, descriptor.bakingFramesPerSecond, descriptor.bakedContent);
+
+      size_t memoryFootprintOfBakedClip = descriptor.bakedClip->GetMemoryFootprint();
+      descriptor.memoryFootprint += memoryFootprintOfBakedClip;
+      mMemoryUsage += memoryFootprintOfBakedClip;
+
+      EvictLeastRecentlyUsedClips();
+   }
+
+   return descriptor.bakedClip.get();
+}
+
+size_t ClipLibrary::GetMemoryBudget() const
+{
+   return mMemoryBudget;
+}
+
+void ClipLibrary::SetMemoryBudget(size_t memoryBudgetInBytes)
+{
+   mMemoryBudget = memoryBudgetInBytes;
+   EvictLeastRecentlyUsedClips();
+}
+
+size_t ClipLibrary::GetMemoryUsage() const
+{
+   return mMemoryUsage;
+}
+
+size_t ClipLibrary::GetMemoryUsageOfRawClips() const
+{
+   return mMemoryUsageOfRawClips;
+}
+
+void ClipLibrary::DecodeClip(unsigned int clipIndex)
+{
+   // Decode the clip, optimize it and rearrange it
+   Clip clip = DecodeRawClip(mClipDescriptors[clipIndex].rawClip);
+   std::unique_ptr<FastClip> decodedClip = std::make_unique<FastClip>(OptimizeClip(clip));
+   RearrangeFastClip(*decodedClip, mJointMap);
+
+   ClipDescriptor& descriptor = mClipDescriptors[clipIndex];
+   descriptor.memoryFootprint = ClipLibraryHelpers::GetMemoryFootprintOfClip(*decodedClip);
+   descriptor.decodedClip     = std::move(decodedClip);
+   mMemoryUsage += descriptor.memoryFootprint;
+
+   // Newly decoded clips are added right after the clip that's currently in use, so that the budget evicts older clips before them
+   // If the clip was requested by the user, GetClip moves it to the front
+   std::list<unsigned int>::iterator positionOfClip = mLeastRecentlyUsedClips.begin();
+   if (positionOfClip != mLeastRecentlyUsedClips.end())
+   {
+      ++positionOfClip;
+   }
+   mLeastRecentlyUsedClips.insert(positionOfClip, clipIndex);
+}
+
+void ClipLibrary::DiscardBakedClip(unsigned int clipIndex)
+{
+   ClipDescriptor& descriptor = mClipDescriptors[clipIndex];
+   if (!descriptor.bakedClip)
+   {
+      return;
+   }
+
+   size_t memoryFootprintOfBakedClip = descriptor.bakedClip->GetMemoryFootprint();
+   descriptor.memoryFootprint -= memoryFootprintOfBakedClip;
+   mMemoryUsage -= memoryFootprintOfBakedClip;
+   descriptor.bakedClip.reset();
+}
+
+void ClipLibrary::EvictLeastRecentlyUsedClips()
+{
+   // Evict clips from the back of the LRU list until we are within the budget
+   // Note that we never evict the clip at the front of the list, since it's the one that's currently in use
+   while (mMemoryUsage > mMemoryBudget && mLeastRecentlyUsedClips.size() > 1)
+   {
+      unsigned int clipIndex = mLeastRecentlyUsedClips.back();
+      mLeastRecentlyUsedClips.pop_back();
+
+      // The baked clip is evicted too, but baking stays enabled, so it's baked again the next time it's requested
+      ClipDescriptor& descriptor = mClipDescriptors[clipIndex];
+      descriptor.decodedClip.reset();
+      descriptor.bakedClip.reset();
+      mMemoryUsage -= descriptor.memoryFootprint;
+      descriptor.memoryFootprint = 0;
+   }
+}
@@ -0,0 +1,114 @@
+#ifdef __EMSCRIPTEN__
+#include <GLES3/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+#include "GLStateCache.h"
+
+namespace GLStateCacheHelpers
+{
+   // No GL object has this name, so a cached value that is equal to it never matches a real value
+   const unsigned int unknownState = ~0u;
+}
+
+GLStateCache::GLStateCache()
+   : mProgram(GLStateCacheHelpers::unknownState)
+   , mVertexArray(GLStateCacheHelpers::unknownState)
+   , mActiveTextureUnit(GLStateCacheHelpers::unknownState)
+   , mTextures()
+   , mNumIssuedCalls(0)
+   , mNumSkippedCalls(0)
+{
+   mTextures.fill(GLStateCacheHelpers::unknownState);
+}
+
+void GLStateCache::UseProgram(unsigned int programID)
+{
+   if (ChangeState(mProgram, programID))
+   {
+      glUseProgram(programID);
+   }
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArrayID)
+{
+   if (ChangeState(mVertexArray, vertexArrayID))
+   {
+      glBindVertexArray(vertexArrayID);
+   }
+}
+
+void GLStateCache::BindTexture(unsigned int textureUnit, unsigned int textureID)
+{
+   if (!ChangeState(mTextures[textureUnit], textureID))
+   {
+      return;
+   }
+
+   // The active texture unit only needs to be changed when a texture is actually bound
+   if (ChangeState(mActiveTextureUnit, textureUnit))
+   {
+      glActiveTexture(GL_TEXTURE0 + textureUnit);
+   }
+
+   glBindTexture(GL_TEXTURE_2D, textureID);
+}
+
+void GLStateCache::Invalidate()
+{
+   mProgram           = GLStateCacheHelpers::unknownState;
+   mVertexArray       = GLStateCacheHelpers::unknownState;
+   mActiveTextureUnit = GLStateCacheHelpers::unknownState;
+   mTextures.fill(GLStateCacheHelpers::unknownState);
+}
+
+void GLStateCache::RestoreDefaultState()
+{
+   // The rest of the application expects nothing to be bound and the first texture unit to be active
+   // This matters for the VAO in particular, since binding an element array buffer while a VAO is bound modifies that VAO
+   for (unsigned int textureUnit = maxNumTextureUnits; textureUnit-- > 0;)
+   {
+      if (mTextures[textureUnit] != 0 && mTextures[textureUnit] != GLStateCacheHelpers::unknownState)
+      {
+         BindTexture(textureUnit, 0);
+      }
+   }
+
+   if (ChangeState(mActiveTextureUnit, 0))
+   {
+      glActiveTexture(GL_TEXTURE0);
+   }
+
+   BindVertexArray(0);
+   UseProgram(0);
+}
+
+void GLStateCache::ResetCounters()
+{
+   mNumIssuedCalls  = 0;
+   mNumSkippedCalls = 0;
+}
+
+unsigned int GLStateCache::GetNumberOfIssuedCalls() const
+{
+   return mNumIssuedCalls;
+}
+
+unsigned int GLStateCache::GetNumberOfSkippedCalls() const
+{
+   return mNumSkippedCalls;
+}
+
+bool GLStateCache::ChangeState(unsigned int& cachedValue, unsigned int newValue)
+{
+   if (cachedValue == newValue)
+   {
+      ++mNumSkippedCalls;
+      return false;
+   }
+
+   cachedValue = newValue;
+   ++mNumIssuedCalls;
+   return true;
+}
@@ -4,6 +4,7 @@
 #include <glm/gtx/norm.hpp>
 
 #include "GLTFLoader.h"
+#include "MeshOptimizer.h"
 #include <iostream>
 #include "Transform.h"
 #include <algorithm>
@@ -98,21 +99,43 @@ namespace GLTFHelpers
    // - The index of the accessor that provides the output data,
    //   which are the values for the animated property at the respective key frames
    // - The interpolation mode (e.g. "LINEAR", "STEP" or "CUBICSPLINE")
-   // The function below creates a track from a channel
-   template<typename T, int N>
-   void GetTrackFromChannel(const cgltf_animation_channel& channel, Track<T, N>& outTrack)
+   // The function below copies the key frames of a channel out of the glTF data,
+   // so that the channel can be decoded into a track after the glTF data has been freed
+   void GetRawChannel(const cgltf_animation_channel& channel, int indexOfTargetNode, RawAnimationChannel& outRawChannel)
    {
       // Get the sampler of the channel, which summarizes the animation data
       cgltf_animation_sampler& sampler = *channel.sampler;
 
-      // Get the interpolation mode from the sampler
+      outRawChannel.targetJoint   = indexOfTargetNode;
+      outRawChannel.targetPath    = channel.target_path;
+      outRawChannel.interpolation = sampler.interpolation;
+
+      // Get the times of the key frames from the sampler
+      GetFloatsFromAccessor(*sampler.input, 1, outRawChannel.keyFrameTimes);
+
+      // Get the animated values from the sampler
+      // For a constant or linearly interpolated track,
+      // these would be a sequence of vec3s if the track animates the position or scale,
+      // or a sequence of quats (vec4s) if the track animates the rotation
+      // For a cubically interpolated track, it would be the same as above,
+      // except that input and output slopes would also be part of the sequence in this order:
+      // | inSlope | value | outSlope | inSlope | value | outSlope |
+      unsigned int numComponents = (channel.target_path == cgltf_animation_path_type_rotation) ? 4 : 3;
+      GetFloatsFromAccessor(*sampler.output, numComponents, outRawChannel.keyFrameValues);
+   }
+
+   // The function below creates a track from the key frames of a channel
+   template<typename T, int N>
+   void GetTrackFromRawChannel(const RawAnimationChannel& rawChannel, Track<T, N>& outTrack)
+   {
+      // Get the interpolation mode of the channel
       bool interpolationModeIsCubic = false;
       Interpolation interpolation = Interpolation::Constant;
-      if (channel.sampler->interpolation == cgltf_interpolation_type_linear)
+      if (rawChannel.interpolation == cgltf_interpolation_type_linear)
       {
          interpolation = Interpolation::Linear;
       }
-      else if (channel.sampler->interpolation == cgltf_interpolation_type_cubic_spline)
+      else if (rawChannel.interpolation == cgltf_interpolation_type_cubic_spline)
       {
          interpolationModeIsCubic = true;
          interpolation = Interpolation::Cubic;
@@ -121,21 +144,14 @@ namespace GLTFHelpers
       // Store the interpolation mode in the track
       outTrack.SetInterpolation(interpolation);
 
-      // Get the times of the key frames from the sampler
-      std::vector<float> keyFrameTimes;
-      GetFloatsFromAccessor(*sampler.input, 1, keyFrameTimes);
-
-      // Get the animated values from the sampler
-      // For a constant or linearly interpolated track,
-      // these would be a sequence of vec3s if the track animates the position or scale,
-      // or a sequence of quats (vec4s) if the track animates the rotation
-      // For a cubically interpolated track, it would be the same as above,
-      // except that input and output slopes would also be part of the sequence in this order:
-      // | inSlope | value | outSlope | inSlope | value | outSlope |
-      std::vector<float> keyFrameValues;
-      GetFloatsFromAccessor(*sampler.output, N, keyFrameValues);
+      const std::vector<float>& keyFrameTimes  = rawChannel.keyFrameTimes;
+      const std::vector<float>& keyFrameValues = rawChannel.keyFrameValues;
+      if (keyFrameTimes.empty())
+      {
+         return;
+      }
 
-      unsigned int numFrames = (unsigned int)sampler.input->count;
+      unsigned int numFrames = static_cast<unsigned int>(keyFrameTimes.size());
       // For a constant or linearly interpolated track that animates the position or scale, numFloatsPerFrame = 3 floats (vec3)
       // For a constant or linearly interpolated track that animates the rotation,          numFloatsPerFrame = 4 floats (quat == vec4)
       // For a cubically interpolated track that animates the position or scale,            numFloatsPerFrame = 3 floats (vec3) * 3 values (input slope, value, output slope) = 9 floats
@@ -391,6 +407,150 @@ namespace GLTFHelpers
          }
       }
    }
+
+   // The function below resizes the attributes that the primitive provides to the current number of vertices of the mesh,
+   // so that the values of the primitive are appended at the right offset even when the previous primitives didn't provide that attribute
+   void PadAttributesOfMeshBeforePrimitive(const cgltf_primitive& primitive, AnimatedMesh& mesh)
+   {
+      size_t numVertices = mesh.GetPositions().size();
+      for (unsigned int attributeIndex = 0,
+           numAttributes = static_cast<unsigned int>(primitive.attributes_count);
+           attributeIndex < numAttributes;
+           ++attributeIndex)
+      {
+         switch (primitive.attributes[attributeIndex].type)
+         {
+         case cgltf_attribute_type_normal:
+            mesh.GetNormals().resize(numVertices, glm::vec3(0.0f, 1.0f, 0.0f));
+            break;
+         case cgltf_attribute_type_texcoord:
+            mesh.GetTexCoords().resize(numVertices, glm::vec2(0.0f));
+            break;
+         case cgltf_attribute_type_weights:
+            mesh.GetWeights().resize(numVertices, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+            break;
+         case cgltf_attribute_type_joints:
+            mesh.GetInfluences().resize(numVertices, glm::ivec4(0));
+            break;
+         default:
+            break;
+         }
+      }
+   }
+
+   // The function below resizes the attributes that the last primitive didn't provide to the number of vertices of the mesh
+   // The attributes that no primitive provided are left empty
+   void PadAttributesOfMeshAfterPrimitive(AnimatedMesh& mesh)
+   {
+      size_t numVertices = mesh.GetPositions().size();
+
+      if (!mesh.GetNormals().empty())
+      {
+         mesh.GetNormals().resize(numVertices, glm::vec3(0.0f, 1.0f, 0.0f));
+      }
+
+      if (!mesh.GetTexCoords().empty())
+      {
+         mesh.GetTexCoords().resize(numVertices, glm::vec2(0.0f));
+      }
+
+      if (!mesh.GetWeights().empty())
+      {
+         mesh.GetWeights().resize(numVertices, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+      }
+
+      if (!mesh.GetInfluences().empty())
+      {
+         mesh.GetInfluences().resize(numVertices, glm::ivec4(0));
+      }
+   }
+
+   // The meshes are drawn as triangle lists, so only the primitives that are made of triangles can be merged into them
+   bool IsMadeOfTriangles(const cgltf_primitive& primitive)
+   {
+      return primitive.type == cgltf_primitive_type_triangles ||
+             primitive.type == cgltf_primitive_type_triangle_strip ||
+             primitive.type == cgltf_primitive_type_triangle_fan;
+   }
+
+   // Appends the indices of a primitive whose vertices start at baseVertex to the indices of the mesh
+   // Primitives that don't have indices are indexed sequentially, since a merged mesh must be indexed
+   // Triangle strips and fans are converted into triangle lists, following the vertex order that the glTF specification defines for them,
+   // so that they can be merged with the other primitives
+   void AppendIndicesOfPrimitive(const cgltf_primitive& primitive, unsigned int baseVertex, AnimatedMesh& mesh)
+   {
+      std::vector<unsigned int> primitiveIndices;
+      if (primitive.indices != nullptr)
+      {
+         unsigned int indexCount = static_cast<unsigned int>(primitive.indices->count);
+         primitiveIndices.reserve(indexCount);
+         for (unsigned int i = 0; i < indexCount; ++i)
+         {
+            primitiveIndices.push_back(baseVertex + static_cast<unsigned int>(cgltf_accessor_read_index(primitive.indices, i)));
+         }
+      }
+      else
+      {
+         unsigned int numVertices = static_cast<unsigned int>(mesh.GetPositions().size());
+         primitiveIndices.reserve(numVertices - baseVertex);
+         for (unsigned int vertexIndex = baseVertex; vertexIndex < numVertices; ++vertexIndex)
+         {
+            primitiveIndices.push_back(vertexIndex);
+         }
+      }
+
+      std::vector<unsigned int>& indices = mesh.GetIndices();
+      unsigned int numPrimitiveIndices = static_cast<unsigned int>(primitiveIndices.size());
+      if (primitive.type == cgltf_primitive_type_triangles)
+      {
+         // An incomplete triangle at the end is ignored
+         indices.insert(indices.end(), primitiveIndices.begin(), primitiveIndices.begin() + (numPrimitiveIndices - (numPrimitiveIndices % 3)));
+         return;
+      }
+
+      for (unsigned int i = 0; i + 2 < numPrimitiveIndices; ++i)
+      {
+         unsigned int a, b, c;
+         if (primitive.type == cgltf_primitive_type_triangle_strip)
+         {
+            // Every other triangle of a strip has its winding flipped, so the last two vertices are swapped to keep the winding consistent
+            a = primitiveIndices[i];
+            b = primitiveIndices[i + 1 + (i % 2)];
+            c = primitiveIndices[i + 2 - (i % 2)];
+         }
+         else
+         {
+            a = primitiveIndices[i + 1];
+            b = primitiveIndices[i + 2];
+            c = primitiveIndices[0];
+         }
+
+         // Strips often contain degenerate triangles that connect their parts, which would only waste time when drawn
+         if (a == b || b == c || a == c)
+         {
+            continue;
+         }
+
+         indices.push_back(a);
+         indices.push_back(b);
+         indices.push_back(c);
+      }
+   }
+
+   // The primitives that share a material are merged into a single mesh, so this returns the index of the mesh of a material,
+   // and it creates that mesh if the material hasn't been seen yet
+   unsigned int GetIndexOfMeshOfMaterial(const cgltf_material* material, std::vector<const cgltf_material*>& materialsOfMeshes, std::vector<AnimatedMesh>& meshes)
+   {
+      std::vector<const cgltf_material*>::iterator it = std::find(materialsOfMeshes.begin(), materialsOfMeshes.end(), material);
+      if (it != materialsOfMeshes.end())
+      {
+         return static_cast<unsigned int>(it - materialsOfMeshes.begin());
+      }
+
+      materialsOfMeshes.push_back(material);
+      meshes.push_back(AnimatedMesh());
+      return static_cast<unsigned int>(meshes.size() - 1);
+   }
 }
 
 cgltf_data* LoadGLTFFile(const char* path)
@@ -505,52 +665,148 @@ std::vector<std::string> LoadJointNames(cgltf_data* data)
 // - A sampler, which summarizes the animation data
 std::vector<Clip> LoadClips(cgltf_data* data)
 {
-   unsigned int numNodes = static_cast<unsigned int>(data->nodes_count);
    unsigned int numClips = static_cast<unsigned int>(data->animations_count);
 
-   std::vector<Clip> clips(numClips);
+   std::vector<Clip> clips;
+   clips.reserve(numClips);
 
    // Loop over the array of animations of the glTF file
    for (unsigned int clipIndex = 0; clipIndex < numClips; ++clipIndex)
    {
-      // Store the name of the current animation
-      clips[clipIndex].SetName(data->animations[clipIndex].name);
+      clips.push_back(LoadClip(data, clipIndex));
+   }
+
+   return clips;
+}
+
+// This function is identical to the one above, except that it only loads a single animation
+Clip LoadClip(cgltf_data* data, unsigned int clipIndex)
+{
+   return DecodeRawClip(LoadRawClip(data, clipIndex));
+}
+
+// The raw clips only store the key frames of the channels that animate the joints,
+// so they occupy much less memory than the glTF data, which also stores the meshes, the skins and the images
+// They are used to decode clips on demand after the glTF data has been freed
+RawClip LoadRawClip(cgltf_data* data, unsigned int clipIndex)
+{
+   unsigned int numNodes = static_cast<unsigned int>(data->nodes_count);
+
+   RawClip rawClip;
 
-      // Loop over the array of channels of the current animation
-      unsigned int numChannels = static_cast<unsigned int>(data->animations[clipIndex].channels_count);
-      for (unsigned int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+   // Store the name of the animation
+   if (data->animations[clipIndex].name)
+   {
+      rawClip.name = data->animations[clipIndex].name;
+   }
+
+   // Loop over the array of channels of the animation
+   unsigned int numChannels = static_cast<unsigned int>(data->animations[clipIndex].channels_count);
+   rawClip.channels.reserve(numChannels);
+   for (unsigned int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+   {
+      // Get the current channel
+      cgltf_animation_channel& channel = data->animations[clipIndex].channels[channelIndex];
+
+      // Only the channels that animate the position, scale or rotation of a node are copied
+      if (channel.target_path != cgltf_animation_path_type_translation &&
+          channel.target_path != cgltf_animation_path_type_scale &&
+          channel.target_path != cgltf_animation_path_type_rotation)
       {
-         // Get the current channel
-         cgltf_animation_channel& channel = data->animations[clipIndex].channels[channelIndex];
+         continue;
+      }
 
-         // Get the index of the node that the current channel targets
-         int indexOfTargetNode = GLTFHelpers::GetNodeIndex(channel.target_node, data->nodes, numNodes);
+      // Get the index of the node that the current channel targets
+      int indexOfTargetNode = GLTFHelpers::GetNodeIndex(channel.target_node, data->nodes, numNodes);
 
-         // Get a position, scale or rotation track from the channel depending on which of those values it animates
-         // Note how we pass the index of the target node as a joint ID to the Clip class to get a TransformTrack
-         // That's possible because all of our animation classes mirror the order of the nodes of the glTF file
-         if (channel.target_path == cgltf_animation_path_type_translation)
-         {
-            VectorTrack& positionTrack = clips[clipIndex].GetTransformTrackOfJoint(indexOfTargetNode).GetPositionTrack();
-            GLTFHelpers::GetTrackFromChannel<glm::vec3, 3>(channel, positionTrack);
-         }
-         else if (channel.target_path == cgltf_animation_path_type_scale)
-         {
-            VectorTrack& scaleTrack = clips[clipIndex].GetTransformTrackOfJoint(indexOfTargetNode).GetScaleTrack();
-            GLTFHelpers::GetTrackFromChannel<glm::vec3, 3>(channel, scaleTrack);
-         }
-         else if (channel.target_path == cgltf_animation_path_type_rotation)
-         {
-            QuaternionTrack& rotationTrack = clips[clipIndex].GetTransformTrackOfJoint(indexOfTargetNode).GetRotationTrack();
-            GLTFHelpers::GetTrackFromChannel<Q::quat, 4>(channel, rotationTrack);
-         }
+      rawClip.channels.emplace_back();
+      GLTFHelpers::GetRawChannel(channel, indexOfTargetNode, rawClip.channels.back());
+   }
+
+   return rawClip;
+}
+
+std::vector<RawClip> LoadRawClips(cgltf_data* data)
+{
+   unsigned int numClips = static_cast<unsigned int>(data->animations_count);
+
+   std::vector<RawClip> rawClips;
+   rawClips.reserve(numClips);
+
+   // Loop over the array of animations of the glTF file
+   for (unsigned int clipIndex = 0; clipIndex < numClips; ++clipIndex)
+   {
+      rawClips.push_back(LoadRawClip(data, clipIndex));
+   }
+
+   return rawClips;
+}
+
+Clip DecodeRawClip(const RawClip& rawClip)
+{
+   Clip clip;
+
+   // Store the name of the animation
+   clip.SetName(rawClip.name);
+
+   // Loop over the channels of the animation
+   for (const RawAnimationChannel& rawChannel : rawClip.channels)
+   {
+      // Get a position, scale or rotation track from the channel depending on which of those values it animates
+      // Note how we pass the index of the target node as a joint ID to the Clip class to get a TransformTrack
+      // That's possible because all of our animation classes mirror the order of the nodes of the glTF file
+      if (rawChannel.targetPath == cgltf_animation_path_type_translation)
+      {
+         VectorTrack& positionTrack = clip.GetTransformTrackOfJoint(rawChannel.targetJoint).GetPositionTrack();
+         GLTFHelpers::GetTrackFromRawChannel<glm::vec3, 3>(rawChannel, positionTrack);
+      }
+      else if (rawChannel.targetPath == cgltf_animation_path_type_scale)
+      {
+         VectorTrack& scaleTrack = clip.GetTransformTrackOfJoint(rawChannel.targetJoint).GetScaleTrack();
+         GLTFHelpers::GetTrackFromRawChannel<glm::vec3, 3>(rawChannel, scaleTrack);
       }
+      else if (rawChannel.targetPath == cgltf_animation_path_type_rotation)
+      {
+         QuaternionTrack& rotationTrack = clip.GetTransformTrackOfJoint(rawChannel.targetJoint).GetRotationTrack();
+         GLTFHelpers::GetTrackFromRawChannel<Q::quat, 4>(rawChannel, rotationTrack);
+      }
+   }
+
+   // Recalculate the duration of the clip once all of its tracks have been loaded
+   clip.RecalculateDuration();
+
+   return clip;
+}
 
-      // Recalculate the duration of the current clip once all of its tracks have been loaded
-      clips[clipIndex].RecalculateDuration();
+size_t GetMemoryFootprintOfRawClip(const RawClip& rawClip)
+{
+   size_t memoryFootprint = sizeof(RawClip) + rawClip.name.size();
+   for (const RawAnimationChannel& rawChannel : rawClip.channels)
+   {
+      memoryFootprint += sizeof(RawAnimationChannel) + ((rawChannel.keyFrameTimes.size() + rawChannel.keyFrameValues.size()) * sizeof(float));
    }
 
-   return clips;
+   return memoryFootprint;
+}
+
+// Reading the names of the animations is much cheaper than decoding them,
+// so this function can be used to list the clips of a glTF file without loading them
+std::vector<std::string> LoadClipNames(cgltf_data* data)
+{
+   unsigned int numClips = static_cast<unsigned int>(data->animations_count);
+   std::vector<std::string> clipNames(numClips, "Unnamed");
+
+   // Loop over the array of animations of the glTF file
+   for (unsigned int clipIndex = 0; clipIndex < numClips; ++clipIndex)
+   {
+      // If the current animation has a name, store it
+      if (data->animations[clipIndex].name)
+      {
+         clipNames[clipIndex] = data->animations[clipIndex].name;
+      }
+   }
+
+   return clipNames;
 }
 
 // A glTF file may contain an array of skins
@@ -664,10 +920,16 @@ Skeleton LoadSkeleton(cgltf_data* data)
 // - The material that should be used for rendering
 // This function loads the meshes of nodes that also refer to skins
 // In other words, it loads animated meshes
-std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data)
+// The meshes aren't uploaded to the GPU, since the caller may still modify them (e.g. by rearranging their joints or remapping their texture coordinates),
+// and since the caller decides which vertex format to use (see AnimatedMesh::LoadBuffers and AnimatedMesh::LoadPackedBuffers)
+std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data, bool optimizeMeshes)
 {
    std::vector<AnimatedMesh> animatedMeshes;
 
+   // The primitives that share a material are merged into a single mesh, which is drawn with a single VAO and a single draw call
+   // (or one per influence bucket), instead of creating a VAO, 5 VBOs and an EBO for each primitive
+   std::vector<const cgltf_material*> materialsOfMeshes;
+
    // Loop over the array of nodes of the glTF file
    unsigned int numNodes = static_cast<unsigned int>(data->nodes_count);
    for (unsigned int nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
@@ -686,9 +948,17 @@ std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data)
          // Get the current mesh primitive
          cgltf_primitive* currPrimitive = &currNode->mesh->primitives[primitiveIndex];
 
-         // Create an AnimatedMesh for the current mesh primitive
-         animatedMeshes.push_back(AnimatedMesh());
-         AnimatedMesh& currMesh = animatedMeshes[animatedMeshes.size() - 1];
+         // Points and lines can't be drawn as triangles, so they are skipped
+         if (!GLTFHelpers::IsMadeOfTriangles(*currPrimitive))
+         {
+            continue;
+         }
+
+         // Get the mesh that the current mesh primitive is merged into
+         unsigned int meshIndex = GLTFHelpers::GetIndexOfMeshOfMaterial(currPrimitive->material, materialsOfMeshes, animatedMeshes);
+         AnimatedMesh& currMesh = animatedMeshes[meshIndex];
+         unsigned int baseVertex = static_cast<unsigned int>(currMesh.GetPositions().size());
+         GLTFHelpers::PadAttributesOfMeshBeforePrimitive(*currPrimitive, currMesh);
 
          // Loop over the attributes of the current mesh primitive
          unsigned int numAttributes = static_cast<unsigned int>(currPrimitive->attributes_count);
@@ -696,29 +966,27 @@ std::vector<AnimatedMesh> LoadAnimatedMeshes(cgltf_data* data)
          {
             // Get the current attribute
             cgltf_attribute* attribute = &currPrimitive->attributes[attributeIndex];
-            // Read the values of the current attribute and store them in the current mesh
+            // Read the values of the current attribute and append them to the current mesh
             GLTFHelpers::StoreValuesOfAttributeInAnimatedMesh(*attribute, currNode->skin, data->nodes, numNodes, currMesh);
          }
 
-         // If the current mesh primitive has a set of indices, store them too
-         if (currPrimitive->indices != nullptr)
-         {
-            unsigned int indexCount = static_cast<unsigned int>(currPrimitive->indices->count);
+         GLTFHelpers::PadAttributesOfMeshAfterPrimitive(currMesh);
 
-            // Get the vector that will store the indices of the current mesh
-            std::vector<unsigned int>& indices = currMesh.GetIndices();
-            indices.resize(indexCount);
+         // Append the indices of the current mesh primitive, rebased to the first vertex of the primitive
+         GLTFHelpers::AppendIndicesOfPrimitive(*currPrimitive, baseVertex, currMesh);
+      }
+   }
 
-            // Loop over the indices of the current mesh primitive
-            for (unsigned int i = 0; i < indexCount; ++i)
-            {
-               indices[i] = static_cast<unsigned int>(cgltf_accessor_read_index(currPrimitive->indices, i));
-            }
-         }
+   for (AnimatedMesh& currMesh : animatedMeshes)
+   {
+      if (optimizeMeshes)
+      {
+         // Weld duplicate vertices and reorder the triangles and vertices to make the mesh cheaper to render
+         // This is done after the primitives are merged so that the influence buckets cover all of them
+         OptimizeMesh(currMesh);
 
-         // TODO: Perhaps we shouldn't do this here. The user should choose when this is done
-         // Once we are done loading the current mesh, we load its VBOs with the data that we read
-         currMesh.LoadBuffers();
+         // Generate simplified versions of the mesh that share its vertices, which are used when the character is small on the screen
+         GenerateLevelsOfDetail(currMesh);
       }
    }
 
@@ -731,6 +999,10 @@ std::vector<AnimatedMesh> LoadStaticMeshes(cgltf_data* data)
 {
    std::vector<AnimatedMesh> staticMeshes;
 
+   // The primitives that share a material are merged into a single mesh, which is drawn with a single VAO and a single draw call
+   // (or one per influence bucket), instead of creating a VAO, 5 VBOs and an EBO for each primitive
+   std::vector<const cgltf_material*> materialsOfMeshes;
+
    // Loop over the array of nodes of the glTF file
    unsigned int numNodes = static_cast<unsigned int>(data->nodes_count);
    for (unsigned int nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
@@ -749,9 +1021,17 @@ std::vector<AnimatedMesh> LoadStaticMeshes(cgltf_data* data)
          // Get the current mesh primitive
          cgltf_primitive* currPrimitive = &currNode->mesh->primitives[primitiveIndex];
 
-         // Create an AnimatedMesh for the current mesh primitive
-         staticMeshes.push_back(AnimatedMesh());
-         AnimatedMesh& currMesh = staticMeshes[staticMeshes.size() - 1];
+         // Points and lines can't be drawn as triangles, so they are skipped
+         if (!GLTFHelpers::IsMadeOfTriangles(*currPrimitive))
+         {
+            continue;
+         }
+
+         // Get the mesh that the current mesh primitive is merged into
+         unsigned int meshIndex = GLTFHelpers::GetIndexOfMeshOfMaterial(currPrimitive->material, materialsOfMeshes, staticMeshes);
+         AnimatedMesh& currMesh = staticMeshes[meshIndex];
+         unsigned int baseVertex = static_cast<unsigned int>(currMesh.GetPositions().size());
+         GLTFHelpers::PadAttributesOfMeshBeforePrimitive(*currPrimitive, currMesh);
 
          // Loop over the attributes of the current mesh primitive
          unsigned int numAttributes = static_cast<unsigned int>(currPrimitive->attributes_count);
@@ -759,31 +1039,23 @@ std::vector<AnimatedMesh> LoadStaticMeshes(cgltf_data* data)
          {
             // Get the current attribute
             cgltf_attribute* attribute = &currPrimitive->attributes[attributeIndex];
-            // Read the values of the current attribute and store them in the current mesh
+            // Read the values of the current attribute and append them to the current mesh
             GLTFHelpers::StoreValuesOfAttributeInStaticMesh(*attribute, currMesh);
          }
 
-         // If the current mesh primitive has a set of indices, store them too
-         if (currPrimitive->indices != nullptr)
-         {
-            unsigned int indexCount = static_cast<unsigned int>(currPrimitive->indices->count);
-
-            // Get the vector that will store the indices of the current mesh
-            std::vector<unsigned int>& indices = currMesh.GetIndices();
-            indices.resize(indexCount);
+         GLTFHelpers::PadAttributesOfMeshAfterPrimitive(currMesh);
 
-            // Loop over the indices of the current mesh primitive
-            for (unsigned int i = 0; i < indexCount; ++i)
-            {
-               indices[i] = static_cast<unsigned int>(cgltf_accessor_read_index(currPrimitive->indices, i));
-            }
-         }
-
-         // TODO: Perhaps we shouldn't do this here. The user should choose when this is done
-         // Once we are done loading the current mesh, we load its VBOs with the data that we read
-         currMesh.LoadBuffers();
+         // Append the indices of the current mesh primitive, rebased to the first vertex of the primitive
+         GLTFHelpers::AppendIndicesOfPrimitive(*currPrimitive, baseVertex, currMesh);
       }
    }
 
+   for (AnimatedMesh& currMesh : staticMeshes)
+   {
+      // Weld duplicate vertices and reorder the triangles and vertices to make the mesh cheaper to render
+      // This is done after the primitives are merged so that the influence buckets cover all of them
+      OptimizeMesh(currMesh);
+   }
+
    return staticMeshes;
 }
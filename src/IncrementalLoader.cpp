@@ -0,0 +1,92 @@
+#include <chrono>
+
+#include "IncrementalLoader.h"
+
+IncrementalLoader::IncrementalLoader(float timeBudgetInMilliseconds)
+   : mSteps()
+   , mIndexOfNextStep(0)
+   , mTimeBudgetInMilliseconds(timeBudgetInMilliseconds)
+{
+
+}
+
+void IncrementalLoader::AddStep(const std::string& description, const std::function<void()>& step)
+{
+   mSteps.push_back(LoadStep{description, [step]() { step(); return true; }});
+}
+
+void IncrementalLoader::AddResumableStep(const std::string& description, const std::function<bool()>& step)
+{
+   mSteps.push_back(LoadStep{description, step});
+}
+
+bool IncrementalLoader::ProcessSteps()
+{
+   std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+   while (!IsDone())
+   {
+      // Release the resources held by the step as soon as it's done
+      if (mSteps[mIndexOfNextStep].step())
+      {
+         mSteps[mIndexOfNextStep].step = nullptr;
+         ++mIndexOfNextStep;
+      }
+
+      // Stop once the time budget of the current frame has been used up
+      std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - startTime;
+      if (elapsedTime.count() >= mTimeBudgetInMilliseconds)
+      {
+         break;
+      }
+   }
+
+   return IsDone();
+}
+
+bool IncrementalLoader::IsDone() const
+{
+   return (mIndexOfNextStep >= mSteps.size());
+}
+
+float IncrementalLoader::GetProgress() const
+{
+   if (mSteps.empty())
+   {
+      return 1.0f;
+   }
+
+   return static_cast<float>(mIndexOfNextStep) / static_cast<float>(mSteps.size());
+}
+
+unsigned int IncrementalLoader::GetNumberOfSteps() const
+{
+   return static_cast<unsigned int>(mSteps.size());
+}
+
+unsigned int IncrementalLoader::GetNumberOfCompletedSteps() const
+{
+   return mIndexOfNextStep;
+}
+
+const std::string& IncrementalLoader::GetDescriptionOfNextStep() const
+{
+   static const std::string doneDescription = "Done";
+
+   if (IsDone())
+   {
+      return doneDescription;
+   }
+
+   return mSteps[mIndexOfNextStep].description;
+}
+
+float IncrementalLoader::GetTimeBudget() const
+{
+   return mTimeBudgetInMilliseconds;
+}
+
+void IncrementalLoader::SetTimeBudget(float timeBudgetInMilliseconds)
+{
+   mTimeBudgetInMilliseconds = timeBudgetInMilliseconds;
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <iostream>
+
+#include "JointHierarchy.h"
+
+JointHierarchy::JointHierarchy()
+   : mJoints()
+   , mHasContiguousSubtrees(true)
+{
+
+}
+
+JointHierarchy::JointHierarchy(const Pose& pose)
+   : mJoints()
+   , mHasContiguousSubtrees(true)
+{
+   Set(pose);
+}
+
+void JointHierarchy::Set(const Pose& pose)
+{
+   unsigned int numJoints = pose.GetNumberOfJoints();
+
+   mJoints.resize(numJoints);
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      Joint& joint     = mJoints[jointIndex];
+      joint.parent     = pose.GetParent(jointIndex);
+      joint.depth      = 0;
+      joint.firstChild = -1;
+      joint.subtreeEnd = jointIndex + 1;
+   }
+
+   // Walk up the parents of each joint to calculate its depth and to count it in the subtrees of its ancestors
+   // The size of each subtree is counted in subtreeSizes, and the subtree ends are only calculated from those sizes once every joint has been counted
+   std::vector<unsigned int> subtreeSizes(numJoints, 1);
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      Joint& joint = mJoints[jointIndex];
+      for (int ancestorIndex = joint.parent; ancestorIndex >= 0; ancestorIndex = mJoints[ancestorIndex].parent)
+      {
+         // A hierarchy can't be deeper than its number of joints, so this can only happen if the parents form a cycle
+         if (joint.depth >= numJoints)
+         {
+            std::cout << "Error - JointHierarchy::Set - The parents of joint " << jointIndex << " form a cycle" << "\n";
+            break;
+         }
+
+         ++joint.depth;
+         ++subtreeSizes[ancestorIndex];
+      }
+
+      if (joint.parent >= 0)
+      {
+         Joint& parent = mJoints[joint.parent];
+         if (parent.firstChild < 0 || static_cast<int>(jointIndex) < parent.firstChild)
+         {
+            parent.firstChild = static_cast<int>(jointIndex);
+         }
+      }
+   }
+
+   // The subtrees are contiguous if every joint is stored after its parent and within the range of its parent's subtree,
+   // since then each range contains exactly the joints of its subtree
+   mHasContiguousSubtrees = true;
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      mJoints[jointIndex].subtreeEnd = jointIndex + subtreeSizes[jointIndex];
+   }
+
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      int parentIndex = mJoints[jointIndex].parent;
+      if (parentIndex >= 0 && (parentIndex >= static_cast<int>(jointIndex) || jointIndex >= mJoints[parentIndex].subtreeEnd))
+      {
+         mHasContiguousSubtrees = false;
+         break;
+      }
+   }
+}
+
+unsigned int JointHierarchy::GetNumberOfJoints() const
+{
+   return static_cast<unsigned int>(mJoints.size());
+}
+
+const std::vector<JointHierarchy::Joint>& JointHierarchy::GetJoints() const
+{
+   return mJoints;
+}
+
+const JointHierarchy::Joint& JointHierarchy::GetJoint(unsigned int jointIndex) const
+{
+   return mJoints[jointIndex];
+}
+
+bool JointHierarchy::HasContiguousSubtrees() const
+{
+   return mHasContiguousSubtrees;
+}
+
+bool JointHierarchy::IsInSubtree(unsigned int jointIndex, unsigned int rootOfSubtree) const
+{
+   if (mHasContiguousSubtrees)
+   {
+      return (jointIndex >= rootOfSubtree) && (jointIndex < mJoints[rootOfSubtree].subtreeEnd);
+   }
+
+   // The depths limit the walk, since the root of the subtree can't be deeper than any of its descendants
+   int          ancestorIndex = static_cast<int>(jointIndex);
+   unsigned int depthOfRoot   = mJoints[rootOfSubtree].depth;
+   while (ancestorIndex >= 0 && mJoints[ancestorIndex].depth > depthOfRoot)
+   {
+      ancestorIndex = mJoints[ancestorIndex].parent;
+   }
+
+   return (ancestorIndex == static_cast<int>(rootOfSubtree));
+}
+
+void JointHierarchy::AddSubtreeToMask(unsigned int rootOfSubtree, std::vector<bool>& ioMask) const
+{
+   ioMask.resize(mJoints.size(), false);
+
+   if (mHasContiguousSubtrees)
+   {
+      std::fill(ioMask.begin() + rootOfSubtree, ioMask.begin() + mJoints[rootOfSubtree].subtreeEnd, true);
+      return;
+   }
+
+   for (unsigned int jointIndex = 0,
+        numJoints = static_cast<unsigned int>(mJoints.size());
+        jointIndex < numJoints;
+        ++jointIndex)
+   {
+      if (IsInSubtree(jointIndex, rootOfSubtree))
+      {
+         ioMask[jointIndex] = true;
+      }
+   }
+}
@@ -0,0 +1,1085 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+
+namespace MeshOptimizerHelpers
+{
+   // The function below hashes the bytes of a value using the FNV-1a algorithm
+   template<typename T>
+   void HashValue(uint64_t& hash, const T& value)
+   {
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+      for (size_t i = 0; i < sizeof(T); ++i)
+      {
+         hash ^= bytes[i];
+         hash *= 1099511628211ull;
+      }
+   }
+
+   size_t HashVertex(AnimatedMesh& mesh, unsigned int vertexIndex)
+   {
+      uint64_t hash = 14695981039346656037ull;
+
+      HashValue(hash, mesh.GetPositions()[vertexIndex]);
+      if (!mesh.GetNormals().empty())    HashValue(hash, mesh.GetNormals()[vertexIndex]);
+      if (!mesh.GetTexCoords().empty())  HashValue(hash, mesh.GetTexCoords()[vertexIndex]);
+      if (!mesh.GetWeights().empty())    HashValue(hash, mesh.GetWeights()[vertexIndex]);
+      if (!mesh.GetInfluences().empty()) HashValue(hash, mesh.GetInfluences()[vertexIndex]);
+
+      return static_cast<size_t>(hash);
+   }
+
+   // Two vertices are only welded if all of their attributes are identical
+   bool VerticesAreEqual(AnimatedMesh& mesh, unsigned int vertexIndexA, unsigned int vertexIndexB)
+   {
+      if (mesh.GetPositions()[vertexIndexA] != mesh.GetPositions()[vertexIndexB]) return false;
+      if (!mesh.GetNormals().empty()    && mesh.GetNormals()[vertexIndexA]    != mesh.GetNormals()[vertexIndexB])    return false;
+      if (!mesh.GetTexCoords().empty()  && mesh.GetTexCoords()[vertexIndexA]  != mesh.GetTexCoords()[vertexIndexB])  return false;
+      if (!mesh.GetWeights().empty()    && mesh.GetWeights()[vertexIndexA]    != mesh.GetWeights()[vertexIndexB])    return false;
+      if (!mesh.GetInfluences().empty() && mesh.GetInfluences()[vertexIndexA] != mesh.GetInfluences()[vertexIndexB]) return false;
+      return true;
+   }
+
+   // The function below rearranges the values of an attribute so that newAttribute[i] = attribute[newToOldVertexIndices[i]]
+   // Attributes that the mesh doesn't have (e.g. the weights of a static mesh) are left empty
+   template<typename T>
+   void RemapAttribute(std::vector<T>& attribute, const std::vector<unsigned int>& newToOldVertexIndices)
+   {
+      if (attribute.empty())
+      {
+         return;
+      }
+
+      std::vector<T> remappedAttribute(newToOldVertexIndices.size());
+      for (unsigned int i = 0, size = static_cast<unsigned int>(newToOldVertexIndices.size()); i < size; ++i)
+      {
+         remappedAttribute[i] = attribute[newToOldVertexIndices[i]];
+      }
+
+      attribute.swap(remappedAttribute);
+   }
+
+   void RemapVertices(AnimatedMesh& mesh, const std::vector<unsigned int>& newToOldVertexIndices)
+   {
+      RemapAttribute(mesh.GetPositions(),  newToOldVertexIndices);
+      RemapAttribute(mesh.GetNormals(),    newToOldVertexIndices);
+      RemapAttribute(mesh.GetTexCoords(),  newToOldVertexIndices);
+      RemapAttribute(mesh.GetWeights(),    newToOldVertexIndices);
+      RemapAttribute(mesh.GetInfluences(), newToOldVertexIndices);
+   }
+
+   // The function below returns the number of non-zero weights of a vertex whose weights were sorted by PruneSkinWeights
+   unsigned int GetNumberOfInfluences(const glm::vec4& weights)
+   {
+      unsigned int numInfluences = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+         if (weights[i] > 0.0f)
+         {
+            numInfluences = i + 1;
+         }
+      }
+
+      return numInfluences;
+   }
+
+   // The shader variants that are used to render the buckets can fetch 1, 2 or 4 skin matrices
+   unsigned int GetSizeOfBucket(unsigned int numInfluences)
+   {
+      return (numInfluences <= 1) ? 1 : (numInfluences <= 2) ? 2 : 4;
+   }
+
+   // The constants below are the ones proposed by Tom Forsyth in "Linear-Speed Vertex Cache Optimisation"
+   const unsigned int maxSizeOfVertexCache = 32;
+   const float        cacheDecayPower      = 1.5f;
+   const float        lastTriangleScore    = 0.75f;
+   const float        valenceBoostScale    = 2.0f;
+   const float        valenceBoostPower    = 0.5f;
+
+   // The score of a vertex is higher when it's in the cache (so that we reuse it while it's there)
+   // and when few triangles still use it (so that we get rid of lonely vertices before they become expensive)
+   float CalculateVertexScore(int positionInCache, unsigned int numRemainingTriangles)
+   {
+      if (numRemainingTriangles == 0)
+      {
+         // The vertex isn't used by any of the remaining triangles
+         return -1.0f;
+      }
+
+      float score = 0.0f;
+      if (positionInCache >= 0)
+      {
+         if (positionInCache < 3)
+         {
+            // The vertex was used by the last triangle
+            // It's given a fixed score so that we don't favor using the same edge over and over again
+            score = lastTriangleScore;
+         }
+         else
+         {
+            // The score decays the further back the vertex is in the cache
+            const float scaler = 1.0f / (maxSizeOfVertexCache - 3);
+            score = std::pow(1.0f - ((positionInCache - 3) * scaler), cacheDecayPower);
+         }
+      }
+
+      score += valenceBoostScale * std::pow(static_cast<float>(numRemainingTriangles), -valenceBoostPower);
+      return score;
+   }
+
+   // The function below sorts the triangles described by indices into buckets based on how many joints influence their vertices
+   // The sorted indices are appended to sortedIndices, and the first index of each bucket is offset by indexOffset,
+   // which is the position of the sorted indices in the index buffer of the mesh
+   void BucketTriangles(const std::vector<glm::vec4>&                weights,
+                        const std::vector<unsigned int>&             indices,
+                        unsigned int                                 indexOffset,
+                        std::vector<unsigned int>&                   sortedIndices,
+                        std::vector<AnimatedMesh::InfluenceBucket>&  buckets)
+   {
+      unsigned int numTriangles = static_cast<unsigned int>(indices.size()) / 3;
+
+      const unsigned int bucketSizes[] = { 1, 2, 4 };
+      for (unsigned int bucketSize : bucketSizes)
+      {
+         unsigned int firstIndex = static_cast<unsigned int>(sortedIndices.size());
+
+         for (unsigned int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+         {
+            unsigned int numInfluences = std::max({ GetNumberOfInfluences(weights[indices[(triangleIndex * 3) + 0]]),
+                                                    GetNumberOfInfluences(weights[indices[(triangleIndex * 3) + 1]]),
+                                                    GetNumberOfInfluences(weights[indices[(triangleIndex * 3) + 2]]) });
+
+            if (GetSizeOfBucket(numInfluences) == bucketSize)
+            {
+               sortedIndices.push_back(indices[(triangleIndex * 3) + 0]);
+               sortedIndices.push_back(indices[(triangleIndex * 3) + 1]);
+               sortedIndices.push_back(indices[(triangleIndex * 3) + 2]);
+            }
+         }
+
+         unsigned int numIndices = static_cast<unsigned int>(sortedIndices.size()) - firstIndex;
+         if (numIndices > 0)
+         {
+            buckets.push_back(AnimatedMesh::InfluenceBucket{bucketSize, indexOffset + firstIndex, numIndices});
+         }
+      }
+   }
+
+   // A quadric stores the sum of the squared distances to a set of planes as a symmetric 4x4 matrix (of which only 10 values are unique)
+   // The planes are weighted by the areas of their triangles, and the total weight is stored so that the error can be converted into a distance
+   struct Quadric
+   {
+      double a00, a01, a02, a03;
+      double      a11, a12, a13;
+      double           a22, a23;
+      double                a33;
+      double weight;
+   };
+
+   Quadric CalculateQuadricOfTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+   {
+      glm::dvec3 normal = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+      double     length = glm::length(normal);
+      Quadric    quadric = {};
+      if (length <= 0.0)
+      {
+         return quadric;
+      }
+
+      double area = length * 0.5;
+      normal /= length;
+      double d = -glm::dot(normal, glm::dvec3(p0));
+
+      quadric.a00 = area * normal.x * normal.x;
+      quadric.a01 = area * normal.x * normal.y;
+      quadric.a02 = area * normal.x * normal.z;
+      quadric.a03 = area * normal.x * d;
+      quadric.a11 = area * normal.y * normal.y;
+      quadric.a12 = area * normal.y * normal.z;
+      quadric.a13 = area * normal.y * d;
+      quadric.a22 = area * normal.z * normal.z;
+      quadric.a23 = area * normal.z * d;
+      quadric.a33 = area * d * d;
+      quadric.weight = area;
+      return quadric;
+   }
+
+   void AddQuadric(Quadric& lhs, const Quadric& rhs)
+   {
+      lhs.a00 += rhs.a00; lhs.a01 += rhs.a01; lhs.a02 += rhs.a02; lhs.a03 += rhs.a03;
+      lhs.a11 += rhs.a11; lhs.a12 += rhs.a12; lhs.a13 += rhs.a13;
+      lhs.a22 += rhs.a22; lhs.a23 += rhs.a23;
+      lhs.a33 += rhs.a33;
+      lhs.weight += rhs.weight;
+   }
+
+   // Returns the weighted sum of the squared distances from a point to the planes of a quadric
+   double EvaluateQuadric(const Quadric& q, const glm::vec3& point)
+   {
+      double x = point.x, y = point.y, z = point.z;
+      double error = (q.a00 * x * x) + (2.0 * q.a01 * x * y) + (2.0 * q.a02 * x * z) + (2.0 * q.a03 * x) +
+                     (q.a11 * y * y) + (2.0 * q.a12 * y * z) + (2.0 * q.a13 * y) +
+                     (q.a22 * z * z) + (2.0 * q.a23 * z) +
+                     q.a33;
+      return std::max(error, 0.0);
+   }
+
+   float GetWeightOfJoint(const glm::vec4& weights, const glm::ivec4& influences, int joint)
+   {
+      float weight = 0.0f;
+      for (int i = 0; i < 4; ++i)
+      {
+         if (weights[i] > 0.0f && influences[i] == joint)
+         {
+            weight += weights[i];
+         }
+      }
+
+      return weight;
+   }
+
+   // Moving a position onto another one changes the weights of the triangles around it,
+   // so positions are only collapsed onto positions whose vertices are dominated by the same joint and whose weights are similar
+   // This keeps the simplifier from collapsing across skin boundaries (e.g. between the arm and the torso), which would tear the mesh when it's animated
+   bool SkinWeightsAreCompatible(AnimatedMesh& mesh, unsigned int vertexIndexA, unsigned int vertexIndexB)
+   {
+      const std::vector<glm::vec4>&  weights    = mesh.GetWeights();
+      const std::vector<glm::ivec4>& influences = mesh.GetInfluences();
+      if (weights.empty() || influences.empty())
+      {
+         return true;
+      }
+
+      // The weights were sorted by PruneSkinWeights, so the dominant joint is always the first one
+      if (influences[vertexIndexA][0] != influences[vertexIndexB][0])
+      {
+         return false;
+      }
+
+      // Sum the absolute differences between the weights that each vertex assigns to each joint
+      // Note that the pruned influences have a weight of zero, so they are skipped
+      const float maxWeightDifference = 0.5f;
+      float weightDifference = 0.0f;
+      for (int i = 0; i < 4; ++i)
+      {
+         if (weights[vertexIndexA][i] > 0.0f)
+         {
+            weightDifference += std::abs(weights[vertexIndexA][i] - GetWeightOfJoint(weights[vertexIndexB], influences[vertexIndexB], influences[vertexIndexA][i]));
+         }
+
+         if (weights[vertexIndexB][i] > 0.0f && GetWeightOfJoint(weights[vertexIndexA], influences[vertexIndexA], influences[vertexIndexB][i]) == 0.0f)
+         {
+            weightDifference += weights[vertexIndexB][i];
+         }
+      }
+
+      return weightDifference <= maxWeightDifference;
+   }
+
+   struct Collapse
+   {
+      double       cost;
+      unsigned int fromVertex;
+      unsigned int toVertex;
+
+      bool operator<(const Collapse& rhs) const
+      {
+         // std::priority_queue is a max-heap, and we want the cheapest collapse first
+         return cost > rhs.cost;
+      }
+   };
+}
+
+/*
+   The ACMR (average cache miss ratio) of a mesh is the number of vertices that need to be transformed per triangle
+   It's calculated by simulating a FIFO post-transform vertex cache of a fixed size
+
+   Since each triangle has 3 vertices, the worst possible ACMR is 3.0
+   A regular grid has an ACMR of 0.5 when its vertices are shared perfectly, so that's a good lower bound to compare against
+*/
+float CalculateACMR(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize)
+{
+   unsigned int numTriangles = static_cast<unsigned int>(indices.size()) / 3;
+   if (numTriangles == 0)
+   {
+      return 0.0f;
+   }
+
+   // Instead of storing the contents of the cache, we store the time at which each vertex entered it
+   // A vertex is in the cache if fewer than cacheSize vertices have entered it since then
+   std::vector<unsigned int> timeWhenVertexEnteredCache(numVertices, 0);
+   unsigned int time = cacheSize + 1;
+   unsigned int numMisses = 0;
+
+   for (unsigned int index : indices)
+   {
+      if (time - timeWhenVertexEnteredCache[index] > cacheSize)
+      {
+         timeWhenVertexEnteredCache[index] = time;
+         ++time;
+         ++numMisses;
+      }
+   }
+
+   return static_cast<float>(numMisses) / static_cast<float>(numTriangles);
+}
+
+// The function below merges the vertices whose attributes are identical
+// glTF exporters often duplicate vertices, which increases both the memory footprint of a mesh and the number of vertex shader invocations
+// Meshes that don't have indices are indexed in the process
+void WeldVertices(AnimatedMesh& mesh)
+{
+   unsigned int numVertices = static_cast<unsigned int>(mesh.GetPositions().size());
+   if (numVertices == 0)
+   {
+      return;
+   }
+
+   std::vector<unsigned int>& indices = mesh.GetIndices();
+   if (indices.empty())
+   {
+      indices.resize(numVertices);
+      for (unsigned int i = 0; i < numVertices; ++i)
+      {
+         indices[i] = i;
+      }
+   }
+
+   std::vector<unsigned int> oldToNewVertexIndices(numVertices);
+   std::vector<unsigned int> newToOldVertexIndices;
+   newToOldVertexIndices.reserve(numVertices);
+
+   // The vertices are bucketed by hash, and each bucket stores the old indices of the unique vertices that fall into it
+   std::unordered_map<size_t, std::vector<unsigned int>> uniqueVertices;
+   uniqueVertices.reserve(numVertices);
+
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      std::vector<unsigned int>& bucket = uniqueVertices[MeshOptimizerHelpers::HashVertex(mesh, vertexIndex)];
+
+      bool foundDuplicate = false;
+      for (unsigned int candidateIndex : bucket)
+      {
+         if (MeshOptimizerHelpers::VerticesAreEqual(mesh, vertexIndex, candidateIndex))
+         {
+            oldToNewVertexIndices[vertexIndex] = oldToNewVertexIndices[candidateIndex];
+            foundDuplicate = true;
+            break;
+         }
+      }
+
+      if (!foundDuplicate)
+      {
+         bucket.push_back(vertexIndex);
+         oldToNewVertexIndices[vertexIndex] = static_cast<unsigned int>(newToOldVertexIndices.size());
+         newToOldVertexIndices.push_back(vertexIndex);
+      }
+   }
+
+   if (newToOldVertexIndices.size() == numVertices)
+   {
+      // There are no duplicates
+      return;
+   }
+
+   MeshOptimizerHelpers::RemapVertices(mesh, newToOldVertexIndices);
+
+   for (unsigned int& index : indices)
+   {
+      index = oldToNewVertexIndices[index];
+   }
+}
+
+/*
+   The function below reorders the triangles of a mesh so that the vertices that they share are likely to still be
+   in the post-transform vertex cache of the GPU when they are needed again, which reduces the number of vertex shader invocations
+
+   It implements the greedy algorithm described by Tom Forsyth in "Linear-Speed Vertex Cache Optimisation":
+   - Each vertex has a score that depends on its position in a simulated LRU cache and on how many triangles still use it
+   - Each triangle has a score that's equal to the sum of the scores of its vertices
+   - At each step, the triangle with the highest score is added to the draw order, its vertices are moved to the front of the cache,
+     and the scores of the vertices in the cache and of the triangles that use them are updated
+*/
+void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices)
+{
+   unsigned int numTriangles = static_cast<unsigned int>(indices.size()) / 3;
+   if (numTriangles == 0)
+   {
+      return;
+   }
+
+   // Build a vertex to triangle adjacency list
+   // The triangles that use vertex v are stored in adjacentTriangles[firstAdjacentTriangle[v]] to adjacentTriangles[firstAdjacentTriangle[v] + numRemainingTriangles[v] - 1]
+   std::vector<unsigned int> numRemainingTriangles(numVertices, 0);
+   for (unsigned int index : indices)
+   {
+      ++numRemainingTriangles[index];
+   }
+
+   std::vector<unsigned int> firstAdjacentTriangle(numVertices, 0);
+   for (unsigned int vertexIndex = 1; vertexIndex < numVertices; ++vertexIndex)
+   {
+      firstAdjacentTriangle[vertexIndex] = firstAdjacentTriangle[vertexIndex - 1] + numRemainingTriangles[vertexIndex - 1];
+   }
+
+   std::vector<unsigned int> adjacentTriangles(indices.size());
+   std::vector<unsigned int> numAdjacentTrianglesWritten(numVertices, 0);
+   for (unsigned int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+   {
+      for (unsigned int corner = 0; corner < 3; ++corner)
+      {
+         unsigned int vertexIndex = indices[(triangleIndex * 3) + corner];
+         adjacentTriangles[firstAdjacentTriangle[vertexIndex] + numAdjacentTrianglesWritten[vertexIndex]] = triangleIndex;
+         ++numAdjacentTrianglesWritten[vertexIndex];
+      }
+   }
+
+   // Calculate the initial scores of the vertices
+   // The scores of the triangles are calculated on demand from the scores of their vertices
+   std::vector<int>   positionInCache(numVertices, -1);
+   std::vector<float> vertexScores(numVertices);
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      vertexScores[vertexIndex] = MeshOptimizerHelpers::CalculateVertexScore(-1, numRemainingTriangles[vertexIndex]);
+   }
+
+   std::vector<bool> triangleWasEmitted(numTriangles, false);
+
+   std::vector<unsigned int> optimizedIndices;
+   optimizedIndices.reserve(indices.size());
+
+   std::vector<unsigned int> cache;
+   std::vector<unsigned int> newCache;
+   cache.reserve(MeshOptimizerHelpers::maxSizeOfVertexCache + 3);
+   newCache.reserve(MeshOptimizerHelpers::maxSizeOfVertexCache + 3);
+
+   int bestTriangle = -1;
+   unsigned int nextTriangleToScan = 0;
+
+   for (unsigned int numEmittedTriangles = 0; numEmittedTriangles < numTriangles; ++numEmittedTriangles)
+   {
+      // If none of the triangles that use the vertices in the cache are left, we continue with the next triangle that hasn't been emitted
+      if (bestTriangle < 0)
+      {
+         while (triangleWasEmitted[nextTriangleToScan])
+         {
+            ++nextTriangleToScan;
+         }
+
+         bestTriangle = static_cast<int>(nextTriangleToScan);
+      }
+
+      // Emit the best triangle
+      unsigned int triangleIndex = static_cast<unsigned int>(bestTriangle);
+      triangleWasEmitted[triangleIndex] = true;
+
+      newCache.clear();
+      for (unsigned int corner = 0; corner < 3; ++corner)
+      {
+         unsigned int vertexIndex = indices[(triangleIndex * 3) + corner];
+         optimizedIndices.push_back(vertexIndex);
+         newCache.push_back(vertexIndex);
+
+         // Remove the triangle from the adjacency list of the vertex by swapping it with the last remaining triangle
+         unsigned int  first     = firstAdjacentTriangle[vertexIndex];
+         unsigned int& remaining = numRemainingTriangles[vertexIndex];
+         for (unsigned int i = first; i < first + remaining; ++i)
+         {
+            if (adjacentTriangles[i] == triangleIndex)
+            {
+               std::swap(adjacentTriangles[i], adjacentTriangles[first + remaining - 1]);
+               break;
+            }
+         }
+         --remaining;
+      }
+
+      // The vertices of the emitted triangle are moved to the front of the cache, and the rest of the cache is pushed back
+      for (unsigned int vertexIndex : cache)
+      {
+         if (vertexIndex != newCache[0] && vertexIndex != newCache[1] && vertexIndex != newCache[2])
+         {
+            newCache.push_back(vertexIndex);
+         }
+      }
+
+      // The vertices that fall off the end of the cache are no longer in it
+      for (unsigned int i = MeshOptimizerHelpers::maxSizeOfVertexCache, size = static_cast<unsigned int>(newCache.size()); i < size; ++i)
+      {
+         positionInCache[newCache[i]] = -1;
+         vertexScores[newCache[i]] = MeshOptimizerHelpers::CalculateVertexScore(-1, numRemainingTriangles[newCache[i]]);
+      }
+      if (newCache.size() > MeshOptimizerHelpers::maxSizeOfVertexCache)
+      {
+         newCache.resize(MeshOptimizerHelpers::maxSizeOfVertexCache);
+      }
+      cache.swap(newCache);
+
+      // Update the scores of the vertices in the cache
+      for (unsigned int i = 0, size = static_cast<unsigned int>(cache.size()); i < size; ++i)
+      {
+         positionInCache[cache[i]] = static_cast<int>(i);
+         vertexScores[cache[i]] = MeshOptimizerHelpers::CalculateVertexScore(static_cast<int>(i), numRemainingTriangles[cache[i]]);
+      }
+
+      // Update the scores of the triangles that use the vertices in the cache, and find the best one
+      bestTriangle = -1;
+      float bestTriangleScore = -1.0f;
+      for (unsigned int vertexIndex : cache)
+      {
+         unsigned int first = firstAdjacentTriangle[vertexIndex];
+         for (unsigned int i = first, end = first + numRemainingTriangles[vertexIndex]; i < end; ++i)
+         {
+            unsigned int adjacentTriangle = adjacentTriangles[i];
+            float score = vertexScores[indices[(adjacentTriangle * 3) + 0]] +
+                          vertexScores[indices[(adjacentTriangle * 3) + 1]] +
+                          vertexScores[indices[(adjacentTriangle * 3) + 2]];
+
+            if (score > bestTriangleScore)
+            {
+               bestTriangleScore = score;
+               bestTriangle = static_cast<int>(adjacentTriangle);
+            }
+         }
+      }
+   }
+
+   indices.swap(optimizedIndices);
+}
+
+// The function below reorders the vertices of a mesh so that they appear in the same order in which the indices reference them
+// This improves the locality of the memory accesses that the GPU makes when it fetches vertices
+// It also gets rid of any vertices that aren't referenced by the indices
+void OptimizeVertexFetch(AnimatedMesh& mesh)
+{
+   std::vector<unsigned int>& indices = mesh.GetIndices();
+   unsigned int numVertices = static_cast<unsigned int>(mesh.GetPositions().size());
+   if (indices.empty() || numVertices == 0)
+   {
+      return;
+   }
+
+   const unsigned int unassigned = static_cast<unsigned int>(-1);
+   std::vector<unsigned int> oldToNewVertexIndices(numVertices, unassigned);
+   std::vector<unsigned int> newToOldVertexIndices;
+   newToOldVertexIndices.reserve(numVertices);
+
+   for (unsigned int& index : indices)
+   {
+      if (oldToNewVertexIndices[index] == unassigned)
+      {
+         oldToNewVertexIndices[index] = static_cast<unsigned int>(newToOldVertexIndices.size());
+         newToOldVertexIndices.push_back(index);
+      }
+
+      index = oldToNewVertexIndices[index];
+   }
+
+   MeshOptimizerHelpers::RemapVertices(mesh, newToOldVertexIndices);
+}
+
+/*
+   The function below gets rid of the skin weights that barely contribute to the deformation of a vertex
+   It does the following for each vertex:
+   - Sorts its influences in descending order of weight
+   - Sets the weights that are smaller than minWeight to zero
+   - Renormalizes the remaining weights so that they add up to 1
+
+   After this, the non-zero weights of each vertex are always stored first, so a vertex with N influences
+   can be skinned by only looking at the first N joints and weights
+   The joints of the pruned influences are set to the joint of the first influence so that they always refer to a valid joint
+*/
+void PruneSkinWeights(AnimatedMesh& mesh, float minWeight)
+{
+   std::vector<glm::vec4>&  weights    = mesh.GetWeights();
+   std::vector<glm::ivec4>& influences = mesh.GetInfluences();
+   if (weights.empty() || weights.size() != influences.size())
+   {
+      return;
+   }
+
+   for (unsigned int vertexIndex = 0,
+        numVertices = static_cast<unsigned int>(weights.size());
+        vertexIndex < numVertices;
+        ++vertexIndex)
+   {
+      std::pair<float, int> sortedInfluences[4];
+      for (int i = 0; i < 4; ++i)
+      {
+         sortedInfluences[i] = std::make_pair(weights[vertexIndex][i], influences[vertexIndex][i]);
+      }
+
+      std::stable_sort(std::begin(sortedInfluences), std::end(sortedInfluences),
+                       [](const std::pair<float, int>& lhs, const std::pair<float, int>& rhs) { return lhs.first > rhs.first; });
+
+      // The largest weight is never pruned, so every vertex keeps at least one influence
+      float sumOfWeights = 0.0f;
+      for (int i = 0; i < 4; ++i)
+      {
+         if (i > 0 && sortedInfluences[i].first < minWeight)
+         {
+            sortedInfluences[i].first  = 0.0f;
+            sortedInfluences[i].second = sortedInfluences[0].second;
+         }
+
+         sumOfWeights += sortedInfluences[i].first;
+      }
+
+      for (int i = 0; i < 4; ++i)
+      {
+         weights[vertexIndex][i]    = (sumOfWeights > 0.0f) ? (sortedInfluences[i].first / sumOfWeights) : ((i == 0) ? 1.0f : 0.0f);
+         influences[vertexIndex][i] = sortedInfluences[i].second;
+      }
+   }
+}
+
+/*
+   The function below sorts the triangles of a mesh into buckets based on how many joints influence their vertices,
+   so that each bucket can be rendered with a shader variant that only fetches as many skin matrices as it needs
+
+   The number of influences of a triangle is the largest number of influences of its vertices, rounded up to 1, 2 or 4
+   The triangles are partitioned in a stable way, so the vertex cache order of the triangles within each bucket is preserved
+
+   Note that this function expects the weights to have been sorted by PruneSkinWeights
+*/
+void BucketTrianglesByInfluenceCount(AnimatedMesh& mesh)
+{
+   std::vector<glm::vec4>&                     weights = mesh.GetWeights();
+   std::vector<unsigned int>&                  indices = mesh.GetIndices();
+   std::vector<AnimatedMesh::InfluenceBucket>& buckets = mesh.GetInfluenceBuckets();
+   buckets.clear();
+
+   if (weights.empty() || indices.empty())
+   {
+      return;
+   }
+
+   std::vector<unsigned int> sortedIndices;
+   sortedIndices.reserve(indices.size());
+   MeshOptimizerHelpers::BucketTriangles(weights, indices, 0, sortedIndices, buckets);
+
+   indices.swap(sortedIndices);
+}
+
+// The function below runs all the optimizations above in the order in which they should be run:
+// - The skin weights must be pruned before the vertices are welded, since pruning can make vertices identical
+// - The vertices must be welded before the triangles are reordered
+// - The triangles must be bucketed after they are reordered, and the vertices must be reordered after the triangles
+MeshOptimizationStatistics OptimizeMesh(AnimatedMesh& mesh)
+{
+   MeshOptimizationStatistics statistics = {};
+   statistics.numVerticesBefore = static_cast<unsigned int>(mesh.GetPositions().size());
+   if (statistics.numVerticesBefore == 0)
+   {
+      return statistics;
+   }
+
+   statistics.acmrBefore = CalculateACMR(mesh.GetIndices(), statistics.numVerticesBefore);
+   if (mesh.GetIndices().empty())
+   {
+      // A mesh without indices transforms every vertex of every triangle
+      statistics.acmrBefore = 3.0f;
+   }
+
+   PruneSkinWeights(mesh);
+   WeldVertices(mesh);
+   OptimizeVertexCache(mesh.GetIndices(), static_cast<unsigned int>(mesh.GetPositions().size()));
+   BucketTrianglesByInfluenceCount(mesh);
+   OptimizeVertexFetch(mesh);
+
+   statistics.numVerticesAfter = static_cast<unsigned int>(mesh.GetPositions().size());
+   statistics.numTriangles     = static_cast<unsigned int>(mesh.GetIndices().size() / 3);
+   statistics.acmrAfter        = CalculateACMR(mesh.GetIndices(), statistics.numVerticesAfter);
+   return statistics;
+}
+
+/*
+   The function below simplifies the triangles of a mesh with quadric error metrics (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics"),
+   and it returns the indices of the simplified triangles, which refer to the same vertices as the original ones
+
+   The simplification works on the positions of the vertices, so the vertices that share a position (i.e. UV and normal seams,
+   which are everywhere in flat-shaded meshes) are treated as a single vertex and they are moved together
+   Each position has a quadric that measures the squared distance to the planes of the triangles around it
+   At each step, the cheapest edge collapse is performed, which moves one position onto the other end of one of its edges
+
+   Positions are only moved onto existing positions, so the simplified mesh can share the vertex buffer of the original one
+   When a corner of a triangle is moved, it's replaced by the vertex at its new position whose attributes are the closest to the ones it had,
+   which keeps the texture coordinates (and therefore the colors of the palettes) and the normals as similar as possible
+
+   The positions on the boundaries of the mesh are never moved, so that holes don't grow
+   In addition, collapses that would flip a triangle or that would cross a skin boundary (see SkinWeightsAreCompatible) are rejected
+
+   The simplification stops when the number of indices reaches targetNumIndices or when no more collapses are possible
+   outError is set to the largest distance that a position was moved away from the surface of the original mesh, in the units of the mesh
+*/
+std::vector<unsigned int> SimplifyMesh(AnimatedMesh& mesh, const std::vector<unsigned int>& indices, unsigned int targetNumIndices, float& outError)
+{
+   outError = 0.0f;
+
+   const std::vector<glm::vec3>& positions = mesh.GetPositions();
+   unsigned int numVertices  = static_cast<unsigned int>(positions.size());
+   unsigned int numTriangles = static_cast<unsigned int>(indices.size()) / 3;
+   if (numVertices == 0 || numTriangles == 0)
+   {
+      return indices;
+   }
+
+   // Map each vertex to the first vertex that has the same position, which represents that position during the simplification
+   std::vector<unsigned int>              representativeVertices(numVertices);
+   std::vector<std::vector<unsigned int>> verticesOfPositions(numVertices);
+   std::unordered_map<size_t, std::vector<unsigned int>> representativesByHash;
+   representativesByHash.reserve(numVertices);
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      uint64_t hash = 14695981039346656037ull;
+      MeshOptimizerHelpers::HashValue(hash, positions[vertexIndex]);
+
+      std::vector<unsigned int>& bucket = representativesByHash[static_cast<size_t>(hash)];
+      representativeVertices[vertexIndex] = vertexIndex;
+      for (unsigned int candidateIndex : bucket)
+      {
+         if (positions[candidateIndex] == positions[vertexIndex])
+         {
+            representativeVertices[vertexIndex] = candidateIndex;
+            break;
+         }
+      }
+
+      if (representativeVertices[vertexIndex] == vertexIndex)
+      {
+         bucket.push_back(vertexIndex);
+      }
+      verticesOfPositions[representativeVertices[vertexIndex]].push_back(vertexIndex);
+   }
+
+   std::vector<unsigned int>              triangles(numTriangles * 3);
+   std::vector<bool>                      triangleIsAlive(numTriangles, true);
+   std::vector<std::vector<unsigned int>> trianglesOfPositions(numVertices);
+   std::vector<MeshOptimizerHelpers::Quadric> quadrics(numVertices, MeshOptimizerHelpers::Quadric());
+
+   unsigned int numAliveTriangles = numTriangles;
+   for (unsigned int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+   {
+      unsigned int* triangle = &triangles[triangleIndex * 3];
+      for (int i = 0; i < 3; ++i)
+      {
+         triangle[i] = representativeVertices[indices[(triangleIndex * 3) + i]];
+      }
+
+      if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+      {
+         // The triangle was already degenerate, so it's dropped
+         triangleIsAlive[triangleIndex] = false;
+         --numAliveTriangles;
+         continue;
+      }
+
+      MeshOptimizerHelpers::Quadric quadric = MeshOptimizerHelpers::CalculateQuadricOfTriangle(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+      for (int i = 0; i < 3; ++i)
+      {
+         trianglesOfPositions[triangle[i]].push_back(triangleIndex);
+         MeshOptimizerHelpers::AddQuadric(quadrics[triangle[i]], quadric);
+      }
+   }
+
+   // Lock the positions on the boundaries, which are the ones on the edges that are only used by one triangle
+   std::vector<bool> positionIsLocked(numVertices, false);
+   std::unordered_map<uint64_t, unsigned int> edgeCounts;
+   edgeCounts.reserve(numTriangles * 3);
+   for (unsigned int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+   {
+      if (!triangleIsAlive[triangleIndex])
+      {
+         continue;
+      }
+
+      for (int i = 0; i < 3; ++i)
+      {
+         unsigned int positionA = triangles[(triangleIndex * 3) + i];
+         unsigned int positionB = triangles[(triangleIndex * 3) + ((i + 1) % 3)];
+         ++edgeCounts[(static_cast<uint64_t>(std::min(positionA, positionB)) << 32) | std::max(positionA, positionB)];
+      }
+   }
+
+   for (const std::pair<const uint64_t, unsigned int>& edgeCount : edgeCounts)
+   {
+      if (edgeCount.second == 1)
+      {
+         positionIsLocked[static_cast<unsigned int>(edgeCount.first >> 32)]         = true;
+         positionIsLocked[static_cast<unsigned int>(edgeCount.first & 0xFFFFFFFF)] = true;
+      }
+   }
+
+   std::vector<bool> positionIsCollapsed(numVertices, false);
+
+   std::function<bool(unsigned int, unsigned int)> collapseIsAllowed = [&](unsigned int fromPosition, unsigned int toPosition)
+   {
+      return !positionIsLocked[fromPosition] && !positionIsCollapsed[fromPosition] && !positionIsCollapsed[toPosition] &&
+             MeshOptimizerHelpers::SkinWeightsAreCompatible(mesh, fromPosition, toPosition);
+   };
+
+   std::function<double(unsigned int, unsigned int)> calculateCostOfCollapse = [&](unsigned int fromPosition, unsigned int toPosition)
+   {
+      MeshOptimizerHelpers::Quadric quadric = quadrics[fromPosition];
+      MeshOptimizerHelpers::AddQuadric(quadric, quadrics[toPosition]);
+      return MeshOptimizerHelpers::EvaluateQuadric(quadric, positions[toPosition]);
+   };
+
+   std::priority_queue<MeshOptimizerHelpers::Collapse> collapses;
+   std::function<void(unsigned int)> addCollapsesOfPosition = [&](unsigned int position)
+   {
+      for (unsigned int triangleIndex : trianglesOfPositions[position])
+      {
+         if (!triangleIsAlive[triangleIndex])
+         {
+            continue;
+         }
+
+         for (int i = 0; i < 3; ++i)
+         {
+            unsigned int otherPosition = triangles[(triangleIndex * 3) + i];
+            if (otherPosition == position)
+            {
+               continue;
+            }
+
+            if (collapseIsAllowed(position, otherPosition))
+            {
+               collapses.push(MeshOptimizerHelpers::Collapse{calculateCostOfCollapse(position, otherPosition), position, otherPosition});
+            }
+
+            if (collapseIsAllowed(otherPosition, position))
+            {
+               collapses.push(MeshOptimizerHelpers::Collapse{calculateCostOfCollapse(otherPosition, position), otherPosition, position});
+            }
+         }
+      }
+   };
+
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      if (representativeVertices[vertexIndex] == vertexIndex && !positionIsLocked[vertexIndex])
+      {
+         addCollapsesOfPosition(vertexIndex);
+      }
+   }
+
+   double maxError = 0.0;
+   while ((numAliveTriangles * 3) > targetNumIndices && !collapses.empty())
+   {
+      MeshOptimizerHelpers::Collapse collapse = collapses.top();
+      collapses.pop();
+
+      unsigned int fromPosition = collapse.fromVertex;
+      unsigned int toPosition   = collapse.toVertex;
+      if (!collapseIsAllowed(fromPosition, toPosition))
+      {
+         continue;
+      }
+
+      // The quadrics change as positions are collapsed, so the costs in the queue can be out of date
+      // Instead of updating them, collapses whose cost went up are pushed back with their new cost
+      double cost = calculateCostOfCollapse(fromPosition, toPosition);
+      if (cost > collapse.cost * 1.0001 + 1e-12)
+      {
+         collapses.push(MeshOptimizerHelpers::Collapse{cost, fromPosition, toPosition});
+         continue;
+      }
+
+      // The positions must still be connected by an edge, and none of the triangles that move can flip
+      bool positionsAreConnected = false;
+      bool triangleWouldFlip     = false;
+      for (unsigned int triangleIndex : trianglesOfPositions[fromPosition])
+      {
+         if (!triangleIsAlive[triangleIndex])
+         {
+            continue;
+         }
+
+         const unsigned int* triangle = &triangles[triangleIndex * 3];
+         if (triangle[0] == toPosition || triangle[1] == toPosition || triangle[2] == toPosition)
+         {
+            positionsAreConnected = true;
+            continue;
+         }
+
+         glm::vec3 movedPositions[3];
+         for (int i = 0; i < 3; ++i)
+         {
+            movedPositions[i] = (triangle[i] == fromPosition) ? positions[toPosition] : positions[triangle[i]];
+         }
+
+         glm::vec3 normalBefore = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+         glm::vec3 normalAfter  = glm::cross(movedPositions[1] - movedPositions[0], movedPositions[2] - movedPositions[0]);
+         if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+         {
+            triangleWouldFlip = true;
+            break;
+         }
+      }
+
+      if (!positionsAreConnected || triangleWouldFlip)
+      {
+         continue;
+      }
+
+      // Move the triangles of fromPosition onto toPosition, and get rid of the ones that become degenerate
+      for (unsigned int triangleIndex : trianglesOfPositions[fromPosition])
+      {
+         if (!triangleIsAlive[triangleIndex])
+         {
+            continue;
+         }
+
+         unsigned int* triangle = &triangles[triangleIndex * 3];
+         if (triangle[0] == toPosition || triangle[1] == toPosition || triangle[2] == toPosition)
+         {
+            triangleIsAlive[triangleIndex] = false;
+            --numAliveTriangles;
+            continue;
+         }
+
+         for (int i = 0; i < 3; ++i)
+         {
+            if (triangle[i] == fromPosition)
+            {
+               triangle[i] = toPosition;
+            }
+         }
+         trianglesOfPositions[toPosition].push_back(triangleIndex);
+      }
+
+      MeshOptimizerHelpers::AddQuadric(quadrics[toPosition], quadrics[fromPosition]);
+      positionIsCollapsed[fromPosition] = true;
+      trianglesOfPositions[fromPosition].clear();
+
+      if (quadrics[toPosition].weight > 0.0)
+      {
+         maxError = std::max(maxError, std::sqrt(cost / quadrics[toPosition].weight));
+      }
+
+      addCollapsesOfPosition(toPosition);
+   }
+
+   outError = static_cast<float>(maxError);
+
+   // Convert the positions of the remaining triangles back into vertices
+   const std::vector<glm::vec3>& normals   = mesh.GetNormals();
+   const std::vector<glm::vec2>& texCoords = mesh.GetTexCoords();
+   std::vector<unsigned int> simplifiedIndices;
+   simplifiedIndices.reserve(numAliveTriangles * 3);
+   for (unsigned int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+   {
+      if (!triangleIsAlive[triangleIndex])
+      {
+         continue;
+      }
+
+      for (int i = 0; i < 3; ++i)
+      {
+         unsigned int originalVertex = indices[(triangleIndex * 3) + i];
+         unsigned int position       = triangles[(triangleIndex * 3) + i];
+         if (representativeVertices[originalVertex] == position)
+         {
+            simplifiedIndices.push_back(originalVertex);
+            continue;
+         }
+
+         // Find the vertex at the new position whose texture coordinates and normal are the closest to the ones of the original vertex
+         // The texture coordinates are favored, since a different texture coordinate can change the color of a whole triangle
+         unsigned int closestVertex    = position;
+         float        lowestDifference = std::numeric_limits<float>::max();
+         for (unsigned int candidateVertex : verticesOfPositions[position])
+         {
+            float difference = 0.0f;
+            if (!texCoords.empty())
+            {
+               difference += 10.0f * glm::length(texCoords[candidateVertex] - texCoords[originalVertex]);
+            }
+
+            if (!normals.empty())
+            {
+               difference += 1.0f - glm::dot(normals[candidateVertex], normals[originalVertex]);
+            }
+
+            if (difference < lowestDifference)
+            {
+               lowestDifference = difference;
+               closestVertex    = candidateVertex;
+            }
+         }
+
+         simplifiedIndices.push_back(closestVertex);
+      }
+   }
+
+   return simplifiedIndices;
+}
+
+/*
+   The function below generates up to maxNumLevels simplified versions of a mesh whose vertices have already been optimized
+   Each level targets half the triangles of the previous one, and it's simplified from the full-detail triangles so that its error isn't compounded
+
+   The indices of each level are optimized for the vertex cache, bucketed by influence count and appended to the indices of the mesh,
+   so all the levels share the vertex and index buffers of the mesh and selecting a level is just a matter of drawing a different range of indices
+   Levels that barely remove any triangles (e.g. because most vertices are locked) are discarded, since they aren't worth drawing
+*/
+void GenerateLevelsOfDetail(AnimatedMesh& mesh, unsigned int maxNumLevels)
+{
+   std::vector<unsigned int>&                 indices        = mesh.GetIndices();
+   std::vector<AnimatedMesh::LevelOfDetail>&  levelsOfDetail = mesh.GetLevelsOfDetail();
+   levelsOfDetail.clear();
+
+   unsigned int numVertices = static_cast<unsigned int>(mesh.GetPositions().size());
+   if (numVertices == 0 || indices.empty())
+   {
+      return;
+   }
+
+   const std::vector<unsigned int> fullDetailIndices = indices;
+
+   // A level is discarded if it doesn't remove at least this fraction of the triangles of the previous one
+   const float minReduction = 0.1f;
+
+   unsigned int numIndicesOfPreviousLevel = static_cast<unsigned int>(fullDetailIndices.size());
+   for (unsigned int levelIndex = 1; levelIndex <= maxNumLevels; ++levelIndex)
+   {
+      unsigned int targetNumIndices = (static_cast<unsigned int>(fullDetailIndices.size() / 3) >> levelIndex) * 3;
+
+      float error;
+      std::vector<unsigned int> simplifiedIndices = SimplifyMesh(mesh, fullDetailIndices, targetNumIndices, error);
+      if (simplifiedIndices.empty() || simplifiedIndices.size() > numIndicesOfPreviousLevel * (1.0f - minReduction))
+      {
+         break;
+      }
+
+      OptimizeVertexCache(simplifiedIndices, numVertices);
+
+      AnimatedMesh::LevelOfDetail levelOfDetail;
+      levelOfDetail.firstIndex = static_cast<unsigned int>(indices.size());
+      levelOfDetail.numIndices = static_cast<unsigned int>(simplifiedIndices.size());
+      levelOfDetail.error      = error;
+
+      if (mesh.GetWeights().empty())
+      {
+         indices.insert(indices.end(), simplifiedIndices.begin(), simplifiedIndices.end());
+      }
+      else
+      {
+         std::vector<unsigned int> sortedIndices;
+         sortedIndices.reserve(simplifiedIndices.size());
+         MeshOptimizerHelpers::BucketTriangles(mesh.GetWeights(), simplifiedIndices, levelOfDetail.firstIndex, sortedIndices, levelOfDetail.influenceBuckets);
+         indices.insert(indices.end(), sortedIndices.begin(), sortedIndices.end());
+      }
+
+      levelsOfDetail.push_back(levelOfDetail);
+      numIndicesOfPreviousLevel = levelOfDetail.numIndices;
+   }
+}
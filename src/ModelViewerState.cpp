@@ -1,5 +1,7 @@
 #ifdef __EMSCRIPTEN__
 #include <emscripten/html5.h>
+#else
+#include <chrono>
 #endif
 
 #include "imgui/imgui.h"
@@ -10,27 +12,236 @@
 #include "shader_loader.h"
 #include "texture_loader.h"
 #include "GLTFLoader.h"
+#include "MeshOptimizer.h"
 #include "RearrangeBones.h"
+#include "CPUSkinning.h"
+#include "ProgramBinaryCache.h"
 #include "ModelViewerState.h"
 
+// The character that's displayed when the viewer starts
+// It's loaded before every other character so that the viewer can be displayed as soon as possible
+static const unsigned int initialCharacterIndex = 5; // Zombie
+
 ModelViewerState::ModelViewerState(const std::shared_ptr<FiniteStateMachine>& finiteStateMachine,
-                                   const std::shared_ptr<Window>&             window)
+                                   const std::shared_ptr<Window>&             window,
+                                   float                                      loadingTimeBudgetInMilliseconds)
    : mFSM(finiteStateMachine)
    , mWindow(window)
    , mCamera3(7.5f, 25.0f, glm::vec3(0.0f), Q::quat(), glm::vec3(0.0f, 2.5f, 0.0f), 2.0f, 20.0f, 0.0f, 90.0f, 45.0f, 1280.0f / 720.0f, 0.1f, 130.0f, 0.25f)
+   , mGroundIsLoaded(false)
+   , mLoader(loadingTimeBudgetInMilliseconds)
+   , mStateIsInitialized(false)
+   , mCurrentSkinMatrices(&mSkinMatrices)
+   , mShaderManager()
+   , mTextureManager()
+   , mThreadPool()
+   , mSkeletonViewer(mShaderManager)
+   , mTrackVisualizer(mShaderManager)
+{
+#ifndef __EMSCRIPTEN__
+   mStartTime = std::chrono::steady_clock::now();
+   mTimeToFirstFrameWasLogged = false;
+#endif
+
+   // The textures that are only referenced by the manager are evicted when they occupy more memory than this
+   mTextureManager.setMemoryBudget(128 * 1024 * 1024);
+
+   // Loading all the characters up front blocks the main thread for several seconds, which freezes the browser tab
+   // Instead, we split the work into steps that are executed a few at a time in each frame
+   enqueueLoadSteps();
+}
+
+ModelViewerState::~ModelViewerState()
+{
+   // Free the glTF data of the characters whose load steps were interrupted
+   for (cgltf_data* data : mCharacterGLTFData)
+   {
+      if (data)
+      {
+         FreeGLTFFile(data);
+      }
+   }
+}
+
+void ModelViewerState::enqueueLoadSteps()
+{
+   mCharacterTextureFilePaths = { "resources/models/woman/woman.png",
+                                  "resources/models/man/man.png",
+                                  //"resources/models/animals/alpaca.png",
+                                  //"resources/models/animals/deer.png",
+                                  //"resources/models/animals/fox.png",
+                                  //"resources/models/animals/horse.png",
+                                  //"resources/models/animals/husky.png",
+                                  "resources/models/animals/stag.png",
+                                  //"resources/models/animals/wolf.png",
+                                  "resources/models/mechs/george.png",
+                                  "resources/models/mechs/leela.png",
+                                  "resources/models/zombie/zombie.png",
+                                  "resources/models/pistol/pistol.png" };
+
+   mCharacterModelFilePaths = { "resources/models/woman/woman.glb",
+                                "resources/models/man/man.glb",
+                                //"resources/models/animals/alpaca.glb",
+                                //"resources/models/animals/deer.glb",
+                                //"resources/models/animals/fox.glb",
+                                //"resources/models/animals/horse.glb",
+                                //"resources/models/animals/husky.glb",
+                                "resources/models/animals/stag.glb",
+                                //"resources/models/animals/wolf.glb",
+                                "resources/models/mechs/george.glb",
+                                "resources/models/mechs/leela.glb",
+                                "resources/models/zombie/zombie.glb",
+                                "resources/models/pistol/pistol.glb" };
+
+   mCharacterDisplayNames = { "Woman", "Man", "Stag", "Robot 1", "Robot 2", "Zombie", "Pistol" };
+
+   // Create a slot for each character so that they can be loaded in any order
+   size_t numCharacters = mCharacterModelFilePaths.size();
+   mCharacterTextures.resize(numCharacters);
+   mCharacterTextureHandles.resize(numCharacters);
+   mCharacterBaseSkeletons.resize(numCharacters);
+   mCharacterMeshes.resize(numCharacters);
+   mCharacterClips.resize(numCharacters);
+   mCharacterClipNames.resize(numCharacters);
+   mCharacterGLTFData.assign(numCharacters, nullptr);
+   mCharacterJointMaps.resize(numCharacters);
+   mCharacterNumOptimizedMeshes.assign(numCharacters, 0);
+   mCharacterIsLoaded.assign(numCharacters, false);
+   mCharacterUsesPackedVertices.assign(numCharacters, false);
+   mCharacterMeshStatistics.assign(numCharacters, MeshOptimizationStatistics{});
+   updateCharacterNames();
+
+   // The characters whose texture is a small color palette share the palette atlas, so that they can be drawn without rebinding textures
+   // Only the headers of the images are read here, and the palettes themselves are copied into the atlas when their characters are loaded
+   mCharacterPaletteCells.assign(numCharacters, -1);
+   unsigned int numPaletteCells = 0;
+   for (unsigned int characterIndex = 0,
+        numChars = static_cast<unsigned int>(numCharacters);
+        characterIndex < numChars;
+        ++characterIndex)
+   {
+      int textureWidth, textureHeight;
+      if (TextureLoader::readImageSize(mCharacterTextureFilePaths[characterIndex], textureWidth, textureHeight) &&
+          PaletteAtlas::CanHoldImage(textureWidth, textureHeight))
+      {
+         mCharacterPaletteCells[characterIndex] = static_cast<int>(numPaletteCells++);
+      }
+   }
+
+   if (numPaletteCells > 0)
+   {
+      mPaletteAtlas.Initialize(numPaletteCells);
+   }
+
+   // Start decoding the other textures on the worker threads right away, so that they are ready by the time their characters are loaded
+   // The initial character is requested first so that its texture is decoded first
+   std::vector<unsigned int> characterLoadOrder(1, initialCharacterIndex);
+   for (unsigned int characterIndex = 0,
+        numChars = static_cast<unsigned int>(numCharacters);
+        characterIndex < numChars;
+        ++characterIndex)
+   {
+      if (characterIndex != initialCharacterIndex)
+      {
+         characterLoadOrder.push_back(characterIndex);
+      }
+   }
+
+   for (unsigned int characterIndex : characterLoadOrder)
+   {
+      if (mCharacterPaletteCells[characterIndex] < 0)
+      {
+         mCharacterTextureHandles[characterIndex] = mTextureManager.loadResourceAsync<TextureLoader>(TextureLoader::getResourceID(mCharacterTextureFilePaths[characterIndex]),
+                                                                                                   mThreadPool,
+                                                                                                   mCharacterTextureFilePaths[characterIndex]);
+      }
+   }
+
+   mGroundTextureHandle = mTextureManager.loadResourceAsync<TextureLoader>(TextureLoader::getResourceID("resources/models/table/wooden_floor.jpg"),
+                                                                          mThreadPool,
+                                                                          std::string("resources/models/table/wooden_floor.jpg"));
+
+   mLoader.AddStep("Compiling shaders", [this]() { loadShaders(); });
+
+   // Load the initial character first, and then the rest of them in the order in which they are displayed
+   enqueueCharacterLoadSteps(initialCharacterIndex);
+   for (unsigned int characterIndex = 0,
+        numChars = static_cast<unsigned int>(numCharacters);
+        characterIndex < numChars;
+        ++characterIndex)
+   {
+      if (characterIndex != initialCharacterIndex)
+      {
+         enqueueCharacterLoadSteps(characterIndex);
+      }
+   }
+
+   mLoader.AddStep("Loading ground", [this]() { loadGround(); });
+}
+
+void ModelViewerState::loadShaders()
 {
    // Initialize the animated mesh shader
-   mAnimatedMeshShader = ResourceManager<Shader>().loadUnmanagedResource<ShaderLoader>("resources/shaders/animated_mesh_with_pregenerated_skin_matrices.vert",
-                                                                                       "resources/shaders/diffuse_illumination.frag");
-   configureLights(mAnimatedMeshShader);
+   mAnimatedMeshShader = mShaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/animated_mesh_with_pregenerated_skin_matrices.vert", "resources/shaders/diffuse_illumination.frag"),
+                                                                        "resources/shaders/animated_mesh_with_pregenerated_skin_matrices.vert",
+                                                                        "resources/shaders/diffuse_illumination.frag");
+   mAnimatedMeshShaderUniforms = resolveSkinnedMeshUniforms(mAnimatedMeshShader);
+
+   // Initialize the variants of the animated mesh shader that decodes the packed vertex format
+   // Each variant only fetches the skin matrices of the number of influences it supports
+   for (unsigned int numInfluences : { 1u, 2u, 4u })
+   {
+      std::vector<std::string> defines { "NUM_INFLUENCES " + std::to_string(numInfluences) };
+      mPackedAnimatedMeshShaders[numInfluences] = mShaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/animated_mesh_with_packed_vertices.vert", "resources/shaders/diffuse_illumination.frag", defines),
+                                                                                                 "resources/shaders/animated_mesh_with_packed_vertices.vert",
+                                                                                                 "resources/shaders/diffuse_illumination.frag",
+                                                                                                 defines);
+      mPackedAnimatedMeshShaderUniforms[numInfluences] = resolveSkinnedMeshUniforms(mPackedAnimatedMeshShaders[numInfluences]);
+   }
+
+   // Initialize the shaders of the transform feedback skinning
+   // The skinning shader reads the packed vertex format, so it can only skin the characters that use it
+   std::vector<std::string> skinnedVaryings { "skinnedPosition", "skinnedNormal" };
+   mSkinningShader = mShaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/skinning_transform_feedback.vert", "resources/shaders/skinning_transform_feedback.frag", std::vector<std::string>(), skinnedVaryings),
+                                                                    "resources/shaders/skinning_transform_feedback.vert",
+                                                                    "resources/shaders/skinning_transform_feedback.frag",
+                                                                    std::vector<std::string>(),
+                                                                    skinnedVaryings);
+   if (mSkinningShader)
+   {
+      mSkinningShaderSkinMatrices = mSkinningShader->getUniform<std::vector<glm::mat4>>("animated[0]");
+   }
+
+   mPreSkinnedMeshShader = mShaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/static_mesh.vert", "resources/shaders/diffuse_illumination.frag"),
+                                                                          "resources/shaders/static_mesh.vert",
+                                                                          "resources/shaders/diffuse_illumination.frag");
+   mPreSkinnedMeshShader->use(true);
+   mPreSkinnedMeshShader->setUniformInt("diffuseTex", 0);
+   mPreSkinnedMeshShader->use(false);
+   mPreSkinnedMeshShaderModel = mPreSkinnedMeshShader->getUniform<glm::mat4>("model");
 
    // Initialize the ground shader
-   mGroundShader = ResourceManager<Shader>().loadUnmanagedResource<ShaderLoader>("resources/shaders/static_mesh.vert",
-                                                                                 "resources/shaders/ambient_diffuse_illumination.frag");
-   configureLights(mGroundShader);
+   // The ground never moves and the lights are stored in the per-frame uniform buffer, so its uniforms only need to be set once
+   mGroundShader = mShaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/static_mesh.vert", "resources/shaders/ambient_diffuse_illumination.frag"),
+                                                                  "resources/shaders/static_mesh.vert",
+                                                                  "resources/shaders/ambient_diffuse_illumination.frag");
+   mGroundShader->use(true);
+   mGroundShader->setUniformMat4("model", glm::scale(glm::mat4(1.0f), glm::vec3(0.10f)));
+   mGroundShader->setUniformInt("diffuseTex", 0);
+   mGroundShader->use(false);
+}
 
-   loadCharacters();
-   loadGround();
+ModelViewerState::SkinnedMeshUniforms ModelViewerState::resolveSkinnedMeshUniforms(const std::shared_ptr<Shader>& shader)
+{
+   // The diffuse texture is always bound to the first texture unit
+   shader->use(true);
+   shader->setUniformInt("diffuseTex", 0);
+   shader->use(false);
+
+   SkinnedMeshUniforms uniforms;
+   uniforms.model        = shader->getUniform<glm::mat4>("model");
+   uniforms.skinMatrices = shader->getUniform<std::vector<glm::mat4>>("animated[0]");
+   return uniforms;
 }
 
 void ModelViewerState::initializeState()
@@ -40,8 +251,8 @@ void ModelViewerState::initializeState()
 #endif
 
    // Set the initial character
-   mSelectedCharacter = 5;     // Zombie
-   mCurrentCharacterIndex = 5; // Zombie
+   mSelectedCharacter = initialCharacterIndex;
+   mCurrentCharacterIndex = initialCharacterIndex;
 
    // Set the initial clip
    mSelectedClip = 5;         // Zombie - Walk
@@ -63,12 +274,40 @@ void ModelViewerState::initializeState()
    mDisplayMesh   = true;
    mDisplayBones  = true;
    mDisplayJoints = true;
+   mSkinWithTransformFeedback = false;
 #ifndef __EMSCRIPTEN__
+   mVerifyTransformFeedbackSkinning      = false;
+   mTransformFeedbackSkinningWasVerified = false;
+   mMaxPositionDifferenceOfTransformFeedbackSkinning = 0.0f;
+   mMaxNormalDifferenceOfTransformFeedbackSkinning   = 0.0f;
    mWireframeModeForCharacter = false;
    mWireframeModeForJoints    = false;
    mPerformDepthTesting       = false;
 #endif
    mFillEmptyTilesWithRepeatedGraphs = true;
+   mEvaluateCurvesOnGPU = true;
+   mNumSamplesPerCurve  = 600;
+#ifndef __EMSCRIPTEN__
+   mCurvesWereVerified          = false;
+   mMaxSampleDifferenceOfCurves = 0.0f;
+#endif
+   mSelectedGraphPage   = 0;
+   mSelectedLevelOfDetail = -1;
+   mCurrentLevelOfDetail  = 0;
+   // The time isn't quantized by default, so the animations look exactly the same as without the pose cache
+   mSelectedPoseCacheTimeStepInMilliseconds = 0.0f;
+   mPoseCache.Clear();
+   mSelectedBakingFramesPerSecond = 30.0f;
+   mSelectedBakedContent          = 0;
+   mSelectedBakedPlayback         = 0;
+#ifndef __EMSCRIPTEN__
+   mPoseUpdateTimeInMicroseconds  = 0.0f;
+   mStressTestGraphs    = false;
+   mStressTestTracks.clear();
+   mGraphBuildTimeInMilliseconds = 0.0f;
+#endif
+   mTrackVisualizer.setEvaluateCurvesOnGPU(mEvaluateCurvesOnGPU);
+   mTrackVisualizer.setNumberOfSamplesPerCurve(mNumSamplesPerCurve);
 
    mCharacterSkeleton = mCharacterBaseSkeletons[mCurrentCharacterIndex];
 
@@ -96,7 +335,7 @@ void ModelViewerState::initializeState()
    mSkeletonViewer.InitializeBones(mPose);
 
    // Sample the clip to get the animated pose
-   FastClip& currClip = mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]];
+   FastClip& currClip = mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]);
    mPlaybackTime = currClip.Sample(mPose, mPlaybackTime);
 
    // Get the palette of the animated pose
@@ -113,17 +352,25 @@ void ModelViewerState::initializeState()
    {
       mSkinMatrices[i] = mPosePalette[i] * inverseBindPose[i];
    }
+   mCurrentSkinMatrices = &mSkinMatrices;
 
    // Update the skeleton viewer
-   mSkeletonViewer.UpdateBones(mPose, mPosePalette);
+   mSkeletonViewer.UpdateBones(mPosePalette);
 
    // Reset the track visualizer
-   mTrackVisualizer.setTracks(mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]].GetTransformTracks());
+   resetTrackVisualizer();
 }
 
 void ModelViewerState::enter()
 {
-   initializeState();
+   // The state can only be initialized once the initial character has been loaded
+   // If it hasn't been loaded yet, the state is initialized by render() as soon as it is
+   mStateIsInitialized = mCharacterIsLoaded[initialCharacterIndex];
+   if (mStateIsInitialized)
+   {
+      initializeState();
+   }
+
    resetCamera();
    resetScene();
 }
@@ -192,6 +439,11 @@ void ModelViewerState::processInput()
 
 void ModelViewerState::update(float deltaTime)
 {
+   if (!mStateIsInitialized)
+   {
+      return;
+   }
+
 #ifndef __EMSCRIPTEN__
    if (mPause)
    {
@@ -199,6 +451,12 @@ void ModelViewerState::update(float deltaTime)
    }
 #endif
 
+   // Characters that are still being loaded can't be selected
+   if (!mCharacterIsLoaded[mSelectedCharacter])
+   {
+      mSelectedCharacter = mCurrentCharacterIndex;
+   }
+
    if (mCurrentCharacterIndex != mSelectedCharacter)
    {
       mCurrentCharacterIndex = mSelectedCharacter;
@@ -206,13 +464,19 @@ void ModelViewerState::update(float deltaTime)
       mPose = mCharacterSkeleton.GetRestPose();
       mPlaybackTime = 0.0f;
 
+      // The clips of the previous character can be evicted from now on, and the poses of the cache point to them
+      mPoseCache.Clear();
+
       mSelectedClip = mCurrentClipIndex[mCurrentCharacterIndex];
 
+      // Decode the clips next to the selected one in the background, since the user is likely to select them next
+      mCharacterClips[mCurrentCharacterIndex].RequestPrefetchOfNeighbors(mCurrentClipIndex[mCurrentCharacterIndex]);
+
       // Reset the skeleton viewer
       mSkeletonViewer.InitializeBones(mPose);
 
       // Reset the track visualizer
-      mTrackVisualizer.setTracks(mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]].GetTransformTracks());
+      resetTrackVisualizer();
 
       // Reset the camera
       resetCamera();
@@ -224,42 +488,158 @@ void ModelViewerState::update(float deltaTime)
       mPose = mCharacterSkeleton.GetRestPose();
       mPlaybackTime = 0.0f;
 
+      // The previous clip can be evicted from now on, and the poses of the cache point to it
+      mPoseCache.Clear();
+
+      // Decode the clips next to the selected one in the background, since the user is likely to select them next
+      mCharacterClips[mCurrentCharacterIndex].RequestPrefetchOfNeighbors(mCurrentClipIndex[mCurrentCharacterIndex]);
+
       // Reset the track visualizer
-      mTrackVisualizer.setTracks(mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]].GetTransformTracks());
+      resetTrackVisualizer();
    }
 
-   // Sample the clip to get the animated pose
-   FastClip& currClip = mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]];
-   mPlaybackTime = currClip.Sample(mPose, mPlaybackTime + (deltaTime * mSelectedPlaybackSpeed));
+   if (mTrackVisualizer.getEvaluateCurvesOnGPU() != mEvaluateCurvesOnGPU)
+   {
+      // Switching between the GPU and CPU evaluation of the curves requires rebuilding the graphs
+      mTrackVisualizer.setEvaluateCurvesOnGPU(mEvaluateCurvesOnGPU);
+      mTrackVisualizer.setNumberOfSamplesPerCurve(mNumSamplesPerCurve);
+      resetTrackVisualizer();
+   }
+   else if (mEvaluateCurvesOnGPU)
+   {
+      // When the curves are evaluated on the GPU, changing their resolution doesn't require rebuilding the graphs
+      mTrackVisualizer.setNumberOfSamplesPerCurve(mNumSamplesPerCurve);
+   }
 
-   // Get the palette of the animated pose
-   mPose.GetMatrixPalette(mPosePalette);
+#ifndef __EMSCRIPTEN__
+   if (mStressTestGraphs == mStressTestTracks.empty())
+   {
+      if (mStressTestGraphs)
+      {
+         generateStressTestTracks(500);
+      }
+      else
+      {
+         mStressTestTracks.clear();
+      }
 
-   std::vector<glm::mat4>& inverseBindPose = mCharacterSkeleton.GetInvBindPose();
+      resetTrackVisualizer();
+   }
+#endif
 
-   // Generate the skin matrices
-   mSkinMatrices.resize(mPosePalette.size());
-   for (unsigned int i = 0,
-        size = static_cast<unsigned int>(mPosePalette.size());
-        i < size;
-        ++i)
+   if (mSelectedGraphPage != static_cast<int>(mTrackVisualizer.getPage()))
    {
-      mSkinMatrices[i] = mPosePalette[i] * inverseBindPose[i];
+#ifndef __EMSCRIPTEN__
+      auto start = std::chrono::steady_clock::now();
+#endif
+      mTrackVisualizer.setPage(static_cast<unsigned int>(mSelectedGraphPage));
+#ifndef __EMSCRIPTEN__
+      mGraphBuildTimeInMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+#endif
    }
 
+   // Decode a prefetched clip, if there are any
+   mCharacterClips[mCurrentCharacterIndex].ProcessPrefetchQueue();
+
+   mPoseCache.SetTimeStep(mSelectedPoseCacheTimeStepInMilliseconds / 1000.0f);
+   mPoseCache.BeginFrame();
+
+   FastClip& currClip = mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]);
+   mPlaybackTime = currClip.AdjustTimeToBeWithinClip(mPlaybackTime + (deltaTime * mSelectedPlaybackSpeed));
+
+#ifndef __EMSCRIPTEN__
+   auto startOfPoseUpdate = std::chrono::steady_clock::now();
+#endif
+
+   // The entries of the pose cache are used by reference instead of being copied,
+   // so these only point to the vectors of the viewer when the viewer calculates the pose itself
+   const std::vector<glm::mat4>* posePalette = &mPosePalette;
+   mCurrentSkinMatrices = &mSkinMatrices;
+
+   const BakedClip* bakedClip = mCharacterClips[mCurrentCharacterIndex].GetBakedClip(mCurrentClipIndex[mCurrentCharacterIndex], mCharacterSkeleton);
+   BakedClip::Playback bakedPlayback = (mSelectedBakedPlayback == 0) ? BakedClip::Playback::Blend : BakedClip::Playback::Nearest;
+   if (bakedClip && bakedClip->GetContent() == BakedClip::Content::SkinMatrices)
+   {
+      // The skin matrices are used as they are, and the palette is only recovered from them to display the skeleton
+      bakedClip->SampleSkinMatrices(mPlaybackTime, bakedPlayback, mSkinMatrices);
+      bakedClip->GetPosePaletteFromSkinMatrices(mSkinMatrices, mPosePalette);
+   }
+   else if (bakedClip)
+   {
+      bakedClip->SamplePose(mPlaybackTime, bakedPlayback, mPose);
+
+      // Get the palette of the baked pose
+      mPose.GetMatrixPalette(mPosePalette);
+
+      std::vector<glm::mat4>& inverseBindPose = mCharacterSkeleton.GetInvBindPose();
+
+      // Generate the skin matrices
+      mSkinMatrices.resize(mPosePalette.size());
+      for (unsigned int i = 0,
+           size = static_cast<unsigned int>(mPosePalette.size());
+           i < size;
+           ++i)
+      {
+         mSkinMatrices[i] = mPosePalette[i] * inverseBindPose[i];
+      }
+   }
+   else
+   {
+      // Get the animated pose, its palette and its skin matrices from the pose cache, which only samples the clip if no other instance
+      // has sampled it at the same time during this update
+      const PoseCache::Entry& cachedPose = mPoseCache.GetPose(currClip, mPlaybackTime, mCharacterSkeleton);
+      posePalette          = &cachedPose.posePalette;
+      mCurrentSkinMatrices = &cachedPose.skinMatrices;
+   }
+
+#ifndef __EMSCRIPTEN__
+   mPoseUpdateTimeInMicroseconds = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startOfPoseUpdate).count();
+#endif
+
    // Update the skeleton viewer
-   mSkeletonViewer.UpdateBones(mPose, mPosePalette);
+   mSkeletonViewer.UpdateBones(*posePalette);
 
    // Update the track visualizer
-   mTrackVisualizer.update(deltaTime, mSelectedPlaybackSpeed, mWindow, mFillEmptyTilesWithRepeatedGraphs, mDisplayGraphs);
+   mTrackVisualizer.update(deltaTime, mSelectedPlaybackSpeed, mWindow, mWindow->isMouseButtonPressed(GLFW_MOUSE_BUTTON_RIGHT), mFillEmptyTilesWithRepeatedGraphs, mDisplayGraphs);
 }
 
 void ModelViewerState::render()
 {
+   // Execute as many load steps as the time budget allows
+   // This is done here instead of in update() because update() can be called multiple times per frame
+   if (!mLoader.IsDone())
+   {
+      // Upload the textures that the worker threads have finished decoding
+      mTextureManager.processUploads();
+
+      mLoader.ProcessSteps();
+
+      if (!mStateIsInitialized && mCharacterIsLoaded[initialCharacterIndex])
+      {
+         initializeState();
+         mStateIsInitialized = true;
+      }
+   }
+
    ImGui_ImplOpenGL3_NewFrame();
    ImGui_ImplGlfw_NewFrame();
    ImGui::NewFrame();
 
+   // Display a loading screen until the initial character is ready
+   if (!mStateIsInitialized)
+   {
+      loadingScreen();
+
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      ImGui::Render();
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+      mWindow->swapBuffers();
+      mWindow->pollEvents();
+      return;
+   }
+
    userInterface();
 
 #ifndef __EMSCRIPTEN__
@@ -278,28 +658,29 @@ void ModelViewerState::render()
 
    glClear(GL_DEPTH_BUFFER_BIT);
 
-   if (mDisplayGround)
-   {
-      mGroundShader->use(true);
+   // Everything but the graphs is drawn through the render queue, which sorts the draw items of each pass by shader, texture and VAO,
+   // and which doesn't set the state that consecutive draw items share more than once
+   mRenderQueue.BeginFrame();
 
-      glm::mat4 modelMatrix(1.0f);
-      modelMatrix = glm::scale(modelMatrix, glm::vec3(0.10f));
-      mGroundShader->setUniformMat4("model",      modelMatrix);
-      mGroundShader->setUniformMat4("view",       mCamera3.getViewMatrix());
-      mGroundShader->setUniformMat4("projection", mCamera3.getPerspectiveProjectionMatrix());
-      mGroundTexture->bind(0, mGroundShader->getUniformLocation("diffuseTex"));
+   // The camera and the lights are uploaded once for all the programs
+   updatePerFrameUniforms();
 
-      // Loop over the ground meshes and render each one
+   if (mDisplayGround && mGroundIsLoaded)
+   {
+      // Loop over the ground meshes and submit each one
       for (unsigned int i = 0,
          size = static_cast<unsigned int>(mGroundMeshes.size());
          i < size;
          ++i)
       {
-         mGroundMeshes[i].Render();
+         const AnimatedMesh& groundMesh = mGroundMeshes[i];
+         mRenderQueue.Submit(RenderQueue::DrawItem{mGroundShader, groundMesh.GetVAO(), {mGroundTexture->getID(), 0}, [&groundMesh]()
+         {
+            groundMesh.Draw();
+         }});
       }
 
-      mGroundTexture->unbind(0);
-      mGroundShader->use(false);
+      mRenderQueue.Execute();
    }
 
 #ifndef __EMSCRIPTEN__
@@ -312,24 +693,118 @@ void ModelViewerState::render()
    // Render the animated meshes
    if (mDisplayMesh)
    {
-      mAnimatedMeshShader->use(true);
-      mAnimatedMeshShader->setUniformMat4("model",      transformToMat4(mModelTransform[mCurrentCharacterIndex]));
-      mAnimatedMeshShader->setUniformMat4("view",       mCamera3.getViewMatrix());
-      mAnimatedMeshShader->setUniformMat4("projection", mCamera3.getPerspectiveProjectionMatrix());
-      mAnimatedMeshShader->setUniformMat4Array("animated[0]", mSkinMatrices);
-      mCharacterTextures[mCurrentCharacterIndex]->bind(0, mAnimatedMeshShader->getUniformLocation("diffuseTex"));
+      const glm::mat4               modelMatrix        = transformToMat4(mModelTransform[mCurrentCharacterIndex]);
+      const std::vector<glm::mat4>& skinMatrices       = *mCurrentSkinMatrices;
+      const unsigned int            characterTextureID = mCharacterTextures[mCurrentCharacterIndex]->getID();
+      std::vector<AnimatedMesh>&    characterMeshes    = mCharacterMeshes[mCurrentCharacterIndex];
 
-      // Loop over the meshes and render each one
-      for (unsigned int i = 0,
-           size = static_cast<unsigned int>(mCharacterMeshes[mCurrentCharacterIndex].size());
-           i < size;
-           ++i)
+      std::function<void(const std::shared_ptr<Shader>&, const SkinnedMeshUniforms&)> setCharacterUniforms = [&](const std::shared_ptr<Shader>& animatedMeshShader, const SkinnedMeshUniforms& uniforms)
+      {
+         mRenderQueue.SetShaderUniforms(animatedMeshShader, [uniforms, modelMatrix, &skinMatrices]()
+         {
+            uniforms.model.set(modelMatrix);
+            uniforms.skinMatrices.set(skinMatrices);
+         });
+      };
+
+      mCurrentLevelOfDetail = 0;
+
+      if (mSkinWithTransformFeedback && mSkinningShader && mCharacterUsesPackedVertices[mCurrentCharacterIndex])
+      {
+         // Skin the vertices of each mesh once, no matter how many times they are drawn afterwards
+         const Uniform<std::vector<glm::mat4>>& skinningShaderSkinMatrices = mSkinningShaderSkinMatrices;
+         mRenderQueue.SetShaderUniforms(mSkinningShader, [skinningShaderSkinMatrices, &skinMatrices]()
+         {
+            skinningShaderSkinMatrices.set(skinMatrices);
+         });
+
+         for (const AnimatedMesh& characterMesh : characterMeshes)
+         {
+            mRenderQueue.Submit(RenderQueue::DrawItem{mSkinningShader, characterMesh.GetVAO(), {0, 0}, [&characterMesh]()
+            {
+               characterMesh.CaptureSkinnedVertices();
+            }});
+         }
+
+         mRenderQueue.Execute();
+
+#ifndef __EMSCRIPTEN__
+         if (mVerifyTransformFeedbackSkinning)
+         {
+            verifyTransformFeedbackSkinning();
+            mVerifyTransformFeedbackSkinning = false;
+         }
+#endif
+
+         // Render the skinned vertices with the static mesh shader
+         const Uniform<glm::mat4>& preSkinnedMeshShaderModel = mPreSkinnedMeshShaderModel;
+         mRenderQueue.SetShaderUniforms(mPreSkinnedMeshShader, [preSkinnedMeshShaderModel, modelMatrix]()
+         {
+            preSkinnedMeshShaderModel.set(modelMatrix);
+         });
+
+         for (const AnimatedMesh& characterMesh : characterMeshes)
+         {
+            unsigned int levelOfDetail = selectLevelOfDetail(characterMesh);
+            mCurrentLevelOfDetail = std::max(mCurrentLevelOfDetail, levelOfDetail);
+            mRenderQueue.Submit(RenderQueue::DrawItem{mPreSkinnedMeshShader, characterMesh.GetSkinnedVAO(), {characterTextureID, 0}, [&characterMesh, levelOfDetail]()
+            {
+               characterMesh.DrawLevelOfDetail(levelOfDetail);
+            }});
+         }
+      }
+      else if (mCharacterUsesPackedVertices[mCurrentCharacterIndex])
+      {
+         for (const std::pair<const unsigned int, std::shared_ptr<Shader>>& variant : mPackedAnimatedMeshShaders)
+         {
+            setCharacterUniforms(variant.second, mPackedAnimatedMeshShaderUniforms[variant.first]);
+         }
+
+         // Submit the triangles of each influence bucket with the shader variant that matches it
+         for (unsigned int i = 0,
+              size = static_cast<unsigned int>(characterMeshes.size());
+              i < size;
+              ++i)
+         {
+            const AnimatedMesh& characterMesh = characterMeshes[i];
+            unsigned int        levelOfDetail = selectLevelOfDetail(characterMesh);
+            mCurrentLevelOfDetail = std::max(mCurrentLevelOfDetail, levelOfDetail);
+            for (const AnimatedMesh::InfluenceBucket& bucket : characterMesh.GetInfluenceBucketsOfLevelOfDetail(levelOfDetail))
+            {
+               std::map<unsigned int, std::shared_ptr<Shader>>::iterator variantIt = mPackedAnimatedMeshShaders.find(bucket.numInfluences);
+               if (variantIt == mPackedAnimatedMeshShaders.end())
+               {
+                  continue;
+               }
+
+               mRenderQueue.Submit(RenderQueue::DrawItem{variantIt->second, characterMesh.GetVAO(), {characterTextureID, 0}, [&characterMesh, &bucket]()
+               {
+                  characterMesh.DrawInfluenceBucket(bucket);
+               }});
+            }
+         }
+      }
+      else
       {
-         mCharacterMeshes[mCurrentCharacterIndex][i].Render();
+         setCharacterUniforms(mAnimatedMeshShader, mAnimatedMeshShaderUniforms);
+
+         // Loop over the meshes and submit each one
+         for (unsigned int i = 0,
+              size = static_cast<unsigned int>(characterMeshes.size());
+              i < size;
+              ++i)
+         {
+            const AnimatedMesh& characterMesh = characterMeshes[i];
+            unsigned int        levelOfDetail = selectLevelOfDetail(characterMesh);
+            mCurrentLevelOfDetail = std::max(mCurrentLevelOfDetail, levelOfDetail);
+            mRenderQueue.Submit(RenderQueue::DrawItem{mAnimatedMeshShader, characterMesh.GetVAO(), {characterTextureID, 0}, [&characterMesh, levelOfDetail]()
+            {
+               characterMesh.DrawLevelOfDetail(levelOfDetail);
+            }});
+         }
       }
 
-      mCharacterTextures[mCurrentCharacterIndex]->unbind(0);
-      mAnimatedMeshShader->use(false);
+      mRenderQueue.Execute();
    }
 
 #ifdef __EMSCRIPTEN__
@@ -346,7 +821,8 @@ void ModelViewerState::render()
    // Render the bones
    if (mDisplayBones)
    {
-      mSkeletonViewer.RenderBones(mModelTransform[mCurrentCharacterIndex], mCamera3.getPerspectiveProjectionViewMatrix());
+      mSkeletonViewer.SubmitBones(mRenderQueue, mModelTransform[mCurrentCharacterIndex]);
+      mRenderQueue.Execute();
    }
 
 #ifndef __EMSCRIPTEN__
@@ -360,15 +836,33 @@ void ModelViewerState::render()
    if (mDisplayJoints)
    {
       int indexOfGlowingJoint = -1;
+      int endOfGlowingSubtree = -1;
       int indexOfSelectedGraph = mTrackVisualizer.getIndexOfSelectedGraph();
+#ifndef __EMSCRIPTEN__
+      // The synthetic tracks of the stress test don't belong to the joints of the character
+      if (mStressTestGraphs)
+      {
+         indexOfSelectedGraph = -1;
+      }
+#endif
       if (indexOfSelectedGraph != -1)
       {
-         indexOfGlowingJoint = mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]].GetJointIDOfTransformTrack(indexOfSelectedGraph);
+         indexOfGlowingJoint = mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]).GetJointIDOfTransformTrack(indexOfSelectedGraph);
       }
 
-      mSkeletonViewer.RenderJoints(mModelTransform[mCurrentCharacterIndex], mCamera3.getPerspectiveProjectionViewMatrix(), mPosePalette, mJointScaleFactors[mCurrentCharacterIndex], indexOfGlowingJoint);
+      // The skeleton is rearranged depth first, so the whole subtree of the selected joint glows with it
+      const JointHierarchy& jointHierarchy = mCharacterSkeleton.GetJointHierarchy();
+      if (indexOfGlowingJoint >= 0 && jointHierarchy.HasContiguousSubtrees())
+      {
+         endOfGlowingSubtree = static_cast<int>(jointHierarchy.GetJoint(indexOfGlowingJoint).subtreeEnd);
+      }
+
+      mSkeletonViewer.SubmitJoints(mRenderQueue, mModelTransform[mCurrentCharacterIndex], mJointScaleFactors[mCurrentCharacterIndex], indexOfGlowingJoint, endOfGlowingSubtree);
+      mRenderQueue.Execute();
    }
 
+   mRenderQueue.EndFrame();
+
 #ifndef __EMSCRIPTEN__
    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
@@ -383,6 +877,20 @@ void ModelViewerState::render()
 
    mWindow->swapBuffers();
    mWindow->pollEvents();
+
+#ifndef __EMSCRIPTEN__
+   // The first frame is the first one that displays the initial character, not the first frame of the loading screen
+   if (!mTimeToFirstFrameWasLogged)
+   {
+      // This measures the time it takes to submit the first frame without waiting for the GPU, which would stall the render loop
+      // The work that the driver defers is measured by the program binary cache benchmark in the tools directory
+      float timeToFirstFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+      std::cout << "Time to first frame: " << timeToFirstFrame << " ms ("
+                << ProgramBinaryCache::GetNumberOfLoadedPrograms() << " programs loaded from the binary cache, "
+                << ProgramBinaryCache::GetNumberOfCompiledPrograms() << " programs compiled)" << "\n";
+      mTimeToFirstFrameWasLogged = true;
+   }
+#endif
 }
 
 void ModelViewerState::exit()
@@ -390,125 +898,237 @@ void ModelViewerState::exit()
 
 }
 
-void ModelViewerState::loadCharacters()
+void ModelViewerState::enqueueCharacterLoadSteps(unsigned int characterIndex)
 {
-   std::vector<std::string> characterTextureFilePaths { "resources/models/woman/woman.png",
-                                                        "resources/models/man/man.png",
-                                                        //"resources/models/animals/alpaca.png",
-                                                        //"resources/models/animals/deer.png",
-                                                        //"resources/models/animals/fox.png",
-                                                        //"resources/models/animals/horse.png",
-                                                        //"resources/models/animals/husky.png",
-                                                        "resources/models/animals/stag.png",
-                                                        //"resources/models/animals/wolf.png",
-                                                        "resources/models/mechs/george.png",
-                                                        "resources/models/mechs/leela.png",
-                                                        "resources/models/zombie/zombie.png",
-                                                        "resources/models/pistol/pistol.png" };
-
-   std::vector<std::string> characterModelFilePaths { "resources/models/woman/woman.glb",
-                                                      "resources/models/man/man.glb",
-                                                      //"resources/models/animals/alpaca.glb",
-                                                      //"resources/models/animals/deer.glb",
-                                                      //"resources/models/animals/fox.glb",
-                                                      //"resources/models/animals/horse.glb",
-                                                      //"resources/models/animals/husky.glb",
-                                                      "resources/models/animals/stag.glb",
-                                                      //"resources/models/animals/wolf.glb",
-                                                      "resources/models/mechs/george.glb",
-                                                      "resources/models/mechs/leela.glb",
-                                                      "resources/models/zombie/zombie.glb",
-                                                      "resources/models/pistol/pistol.glb" };
-
-   std::vector<std::string> characterNames { "Woman", "Man", "Stag", "Robot 1", "Robot 2", "Zombie", "Pistol" };
-   for (const std::string& characterName : characterNames)
-   {
-      mCharacterNames += characterName + '\0';
-   }
-
-   // Load the textures of the animated characters
-   mCharacterTextures.reserve(characterTextureFilePaths.size());
-   for (const std::string& characterTextureFilePath : characterTextureFilePaths)
-   {
-      mCharacterTextures.emplace_back(ResourceManager<Texture>().loadUnmanagedResource<TextureLoader>(characterTextureFilePath));
-   }
-
-   // Load the animated characters
-   size_t numModels = characterModelFilePaths.size();
-   mCharacterBaseSkeletons.reserve(numModels);
-   mCharacterMeshes.reserve(numModels);
-   mCharacterClips.reserve(numModels);
-   unsigned int modelIndex = 0;
-   for (const std::string& characterModelFilePath : characterModelFilePaths)
-   {
-      // Load the animated character
-      cgltf_data* data = LoadGLTFFile(characterModelFilePath.c_str());
-      mCharacterBaseSkeletons.emplace_back(LoadSkeleton(data));
-      mCharacterMeshes.emplace_back(LoadAnimatedMeshes(data));
-      std::vector<Clip> characterClips = LoadClips(data);
-      FreeGLTFFile(data);
-
-      // Rearrange the skeleton
-      JointMap characterJointMap = RearrangeSkeleton(mCharacterBaseSkeletons[modelIndex]);
-
-      // Rearrange the meshes
-      for (unsigned int meshIndex = 0,
-           numMeshes = static_cast<unsigned int>(mCharacterMeshes[modelIndex].size());
-           meshIndex < numMeshes;
-           ++meshIndex)
-      {
-         RearrangeMesh(mCharacterMeshes[modelIndex][meshIndex], characterJointMap);
-         mCharacterMeshes[modelIndex][meshIndex].ClearMeshData();
-      }
-
-      // Optimize the clips, rearrange them and store them
-      mCharacterClips.emplace_back(std::vector<FastClip>());
-      std::string characterClipNames;
-      for (unsigned int clipIndex = 0,
-           numClips = static_cast<unsigned int>(characterClips.size());
-           clipIndex < numClips;
-           ++clipIndex)
-      {
-         FastClip currClip = OptimizeClip(characterClips[clipIndex]);
-         RearrangeFastClip(currClip, characterJointMap);
-         mCharacterClips[modelIndex].push_back(currClip);
-         characterClipNames += currClip.GetName() + '\0';
-      }
-      mCharacterClipNames.push_back(characterClipNames);
-
-      // Configure the VAOs of the animated meshes
-      int positionsAttribLocOfAnimatedShader  = mAnimatedMeshShader->getAttributeLocation("position");
-      int normalsAttribLocOfAnimatedShader    = mAnimatedMeshShader->getAttributeLocation("normal");
-      int texCoordsAttribLocOfAnimatedShader  = mAnimatedMeshShader->getAttributeLocation("texCoord");
-      int weightsAttribLocOfAnimatedShader    = mAnimatedMeshShader->getAttributeLocation("weights");
-      int influencesAttribLocOfAnimatedShader = mAnimatedMeshShader->getAttributeLocation("joints");
+   // Loading a character takes much longer than the time budget of a frame, so it's split into steps that take a few milliseconds each
+   const std::string& displayName = mCharacterDisplayNames[characterIndex];
+   mLoader.AddStep("Parsing " + displayName, [this, characterIndex]() { parseCharacter(characterIndex); });
+   mLoader.AddStep("Loading the clips of " + displayName, [this, characterIndex]() { loadCharacterClips(characterIndex); });
+   mLoader.AddStep("Loading the texture of " + displayName, [this, characterIndex]() { loadCharacterTexture(characterIndex); });
+   mLoader.AddResumableStep("Optimizing the meshes of " + displayName, [this, characterIndex]() { return optimizeNextCharacterMesh(characterIndex); });
+   mLoader.AddStep("Uploading the meshes of " + displayName, [this, characterIndex]() { uploadCharacterMeshes(characterIndex); });
+}
 
-      for (unsigned int i = 0,
-           size = static_cast<unsigned int>(mCharacterMeshes[modelIndex].size());
-           i < size;
-           ++i)
+void ModelViewerState::parseCharacter(unsigned int characterIndex)
+{
+   // Load the animated character
+   // The meshes are optimized by later steps, one mesh per step
+   cgltf_data* data = LoadGLTFFile(mCharacterModelFilePaths[characterIndex].c_str());
+   mCharacterGLTFData[characterIndex] = data;
+   mCharacterBaseSkeletons[characterIndex] = LoadSkeleton(data);
+   mCharacterMeshes[characterIndex] = LoadAnimatedMeshes(data, false);
+   mCharacterNumOptimizedMeshes[characterIndex] = 0;
+   mCharacterMeshStatistics[characterIndex] = MeshOptimizationStatistics{};
+}
+
+void ModelViewerState::loadCharacterClips(unsigned int characterIndex)
+{
+   // The decoded clips of each character are evicted in LRU order when they occupy more memory than this
+   const size_t clipMemoryBudgetPerCharacter = 4 * 1024 * 1024;
+
+   // Rearrange the skeleton
+   // The joints are ordered depth first, so that the subtree of each joint is a contiguous range of joints
+   // The joint map is kept until the meshes have been rearranged too
+   mCharacterJointMaps[characterIndex] = RearrangeSkeleton(mCharacterBaseSkeletons[characterIndex], JointOrdering::DepthFirst);
+
+   // Register the clips
+   // Only their raw key frames are copied out of the glTF data, and they are decoded, optimized and rearranged the first time they are selected
+   mCharacterClips[characterIndex] = ClipLibrary(mCharacterGLTFData[characterIndex], mCharacterJointMaps[characterIndex]);
+   mCharacterClips[characterIndex].SetMemoryBudget(clipMemoryBudgetPerCharacter);
+   FreeGLTFFile(mCharacterGLTFData[characterIndex]);
+   mCharacterGLTFData[characterIndex] = nullptr;
+
+   std::string characterClipNames;
+   for (unsigned int clipIndex = 0,
+        numClips = mCharacterClips[characterIndex].GetNumberOfClips();
+        clipIndex < numClips;
+        ++clipIndex)
+   {
+      characterClipNames += mCharacterClips[characterIndex].GetClipName(clipIndex) + '\0';
+   }
+   mCharacterClipNames[characterIndex] = characterClipNames;
+}
+
+bool ModelViewerState::optimizeNextCharacterMesh(unsigned int characterIndex)
+{
+   std::vector<AnimatedMesh>& meshes = mCharacterMeshes[characterIndex];
+   unsigned int meshIndex = mCharacterNumOptimizedMeshes[characterIndex];
+   if (meshIndex < meshes.size())
+   {
+      // Weld duplicate vertices and reorder the triangles and vertices to make the mesh cheaper to render,
+      // generate its levels of detail, and make its joint indices match the rearranged skeleton
+      MeshOptimizationStatistics meshStatistics = OptimizeMesh(meshes[meshIndex]);
+      GenerateLevelsOfDetail(meshes[meshIndex]);
+      RearrangeMesh(meshes[meshIndex], mCharacterJointMaps[characterIndex]);
+
+      // The ACMR of the character is the average number of vertices transformed per triangle over all of its meshes
+      MeshOptimizationStatistics& characterStatistics = mCharacterMeshStatistics[characterIndex];
+      unsigned int numTriangles = characterStatistics.numTriangles + meshStatistics.numTriangles;
+      if (numTriangles > 0)
+      {
+         characterStatistics.acmrBefore = ((characterStatistics.acmrBefore * characterStatistics.numTriangles) + (meshStatistics.acmrBefore * meshStatistics.numTriangles)) / numTriangles;
+         characterStatistics.acmrAfter  = ((characterStatistics.acmrAfter * characterStatistics.numTriangles) + (meshStatistics.acmrAfter * meshStatistics.numTriangles)) / numTriangles;
+      }
+      characterStatistics.numVerticesBefore += meshStatistics.numVerticesBefore;
+      characterStatistics.numVerticesAfter  += meshStatistics.numVerticesAfter;
+      characterStatistics.numTriangles       = numTriangles;
+
+      // Return to the loader after each mesh, so that it can check the time budget
+      ++mCharacterNumOptimizedMeshes[characterIndex];
+      if (mCharacterNumOptimizedMeshes[characterIndex] < meshes.size())
+      {
+         return false;
+      }
+   }
+
+   // The joint map is no longer needed once every mesh has been rearranged
+   mCharacterJointMaps[characterIndex] = JointMap();
+   return true;
+}
+
+void ModelViewerState::uploadCharacterMeshes(unsigned int characterIndex)
+{
+   // Use the packed vertex format if every mesh of the character supports it, and the unpacked one otherwise
+   // The same format is used for all the meshes of a character so that they can all be rendered with the same shader
+   bool usePackedVertices = true;
+   for (const AnimatedMesh& mesh : mCharacterMeshes[characterIndex])
+   {
+      usePackedVertices = usePackedVertices && mesh.CanPackVertices();
+   }
+   mCharacterUsesPackedVertices[characterIndex] = usePackedVertices;
+
+   for (AnimatedMesh& mesh : mCharacterMeshes[characterIndex])
+   {
+      // This is the only time the vertices are uploaded, since the meshes aren't modified after they are rearranged
+      if (usePackedVertices)
+      {
+         mesh.LoadPackedBuffers();
+      }
+      else
+      {
+         mesh.LoadBuffers();
+      }
+
+      // Natively, the data is kept so that the vertices that are skinned with transform feedback can be verified against the CPU skinning
+#ifdef __EMSCRIPTEN__
+      mesh.ClearMeshData();
+#endif
+   }
+
+   // Configure the VAOs of the animated meshes
+   // Note that the attributes of the packed shader variants have explicit locations, so the VAOs work with all of them
+   const std::shared_ptr<Shader>& animatedMeshShader = usePackedVertices ? mPackedAnimatedMeshShaders[4] : mAnimatedMeshShader;
+   int positionsAttribLocOfAnimatedShader  = animatedMeshShader->getAttributeLocation("position");
+   int normalsAttribLocOfAnimatedShader    = animatedMeshShader->getAttributeLocation("normal");
+   int texCoordsAttribLocOfAnimatedShader  = animatedMeshShader->getAttributeLocation("texCoord");
+   int weightsAttribLocOfAnimatedShader    = animatedMeshShader->getAttributeLocation("weights");
+   int influencesAttribLocOfAnimatedShader = animatedMeshShader->getAttributeLocation("joints");
+
+   for (unsigned int i = 0,
+        size = static_cast<unsigned int>(mCharacterMeshes[characterIndex].size());
+        i < size;
+        ++i)
+   {
+      if (usePackedVertices)
       {
-         mCharacterMeshes[modelIndex][i].ConfigureVAO(positionsAttribLocOfAnimatedShader,
-                                                      normalsAttribLocOfAnimatedShader,
-                                                      texCoordsAttribLocOfAnimatedShader,
-                                                      weightsAttribLocOfAnimatedShader,
-                                                      influencesAttribLocOfAnimatedShader);
+         mCharacterMeshes[characterIndex][i].ConfigurePackedVAO(positionsAttribLocOfAnimatedShader,
+                                                                normalsAttribLocOfAnimatedShader,
+                                                                texCoordsAttribLocOfAnimatedShader,
+                                                                weightsAttribLocOfAnimatedShader,
+                                                                influencesAttribLocOfAnimatedShader);
+
+         mCharacterMeshes[characterIndex][i].ConfigureSkinnedVAO(mPreSkinnedMeshShader->getAttributeLocation("position"),
+                                                                 mPreSkinnedMeshShader->getAttributeLocation("normal"),
+                                                                 mPreSkinnedMeshShader->getAttributeLocation("texCoord"));
       }
+      else
+      {
+         mCharacterMeshes[characterIndex][i].ConfigureVAO(positionsAttribLocOfAnimatedShader,
+                                                          normalsAttribLocOfAnimatedShader,
+                                                          texCoordsAttribLocOfAnimatedShader,
+                                                          weightsAttribLocOfAnimatedShader,
+                                                          influencesAttribLocOfAnimatedShader);
+      }
+   }
+
+   mCharacterIsLoaded[characterIndex] = true;
+   updateCharacterNames();
+}
+
+void ModelViewerState::loadCharacterTexture(unsigned int characterIndex)
+{
+   if (mCharacterPaletteCells[characterIndex] < 0)
+   {
+      // Get the texture of the animated character, which is usually decoded by now
+      mCharacterTextures[characterIndex] = mTextureManager.finishLoading(mCharacterTextureHandles[characterIndex]);
+      mCharacterTextureHandles[characterIndex] = ResourceHandle<Texture>();
+      return;
+   }
+
+   // Palettes are tiny, so they are decoded on the main thread
+   std::shared_ptr<TextureLoader::DecodedResource> palette = TextureLoader().decodeResource(mCharacterTextureFilePaths[characterIndex]);
+   if (!palette)
+   {
+      return;
+   }
 
-      ++modelIndex;
+   bool canUseAtlas = true;
+   for (AnimatedMesh& mesh : mCharacterMeshes[characterIndex])
+   {
+      canUseAtlas = canUseAtlas && PaletteAtlas::CanRemapTexCoords(mesh.GetTexCoords());
+   }
+
+   // Characters whose texture coordinates wrap around need a texture that repeats, so they keep their own
+   if (!canUseAtlas)
+   {
+      mCharacterTextures[characterIndex] = TextureLoader().uploadResource(*palette);
+      return;
+   }
+
+   unsigned int paletteCell = static_cast<unsigned int>(mCharacterPaletteCells[characterIndex]);
+   mPaletteAtlas.SetCell(paletteCell, *palette);
+   for (AnimatedMesh& mesh : mCharacterMeshes[characterIndex])
+   {
+      mPaletteAtlas.RemapTexCoords(paletteCell, palette->width, palette->height, mesh.GetTexCoords());
+   }
+
+   mCharacterTextures[characterIndex] = mPaletteAtlas.GetTexture();
+}
+
+void ModelViewerState::updateCharacterNames()
+{
+   // Characters that are still being loaded are marked as such in the character combo box
+   mCharacterNames.clear();
+   for (unsigned int characterIndex = 0,
+        numCharacters = static_cast<unsigned int>(mCharacterDisplayNames.size());
+        characterIndex < numCharacters;
+        ++characterIndex)
+   {
+      mCharacterNames += mCharacterDisplayNames[characterIndex];
+      if (!mCharacterIsLoaded[characterIndex])
+      {
+         mCharacterNames += " (Loading...)";
+      }
+      mCharacterNames += '\0';
    }
 }
 
 void ModelViewerState::loadGround()
 {
-   // Load the texture of the ground
-   mGroundTexture = ResourceManager<Texture>().loadUnmanagedResource<TextureLoader>("resources/models/table/wooden_floor.jpg");
+   // Get the texture of the ground, which is usually decoded by now
+   mGroundTexture = mTextureManager.finishLoading(mGroundTextureHandle);
+   mGroundTextureHandle = ResourceHandle<Texture>();
 
    // Load the ground
    cgltf_data* data = LoadGLTFFile("resources/models/table/wooden_floor.glb");
    mGroundMeshes = LoadStaticMeshes(data);
    FreeGLTFFile(data);
 
+   for (AnimatedMesh& mesh : mGroundMeshes)
+   {
+      mesh.LoadBuffers();
+   }
+
    int positionsAttribLocOfStaticShader = mGroundShader->getAttributeLocation("position");
    int normalsAttribLocOfStaticShader   = mGroundShader->getAttributeLocation("normal");
    int texCoordsAttribLocOfStaticShader = mGroundShader->getAttributeLocation("texCoord");
@@ -523,23 +1143,23 @@ void ModelViewerState::loadGround()
                                     -1,
                                     -1);
    }
+
+   mGroundIsLoaded = true;
 }
 
-void ModelViewerState::configureLights(const std::shared_ptr<Shader>& shader)
+void ModelViewerState::updatePerFrameUniforms()
 {
-   shader->use(true);
-   shader->setUniformVec3("pointLights[0].worldPos", glm::vec3(0.0f, 2.0f, 10.0f));
-   shader->setUniformVec3("pointLights[0].color", glm::vec3(1.0f, 0.95f, 0.9f));
-   shader->setUniformFloat("pointLights[0].constantAtt", 1.0f);
-   shader->setUniformFloat("pointLights[0].linearAtt", 0.01f);
-   shader->setUniformFloat("pointLights[0].quadraticAtt", 0.0f);
-   shader->setUniformVec3("pointLights[1].worldPos", glm::vec3(0.0f, 2.0f, -10.0f));
-   shader->setUniformVec3("pointLights[1].color", glm::vec3(1.0f, 0.95f, 0.9f));
-   shader->setUniformFloat("pointLights[1].constantAtt", 1.0f);
-   shader->setUniformFloat("pointLights[1].linearAtt", 0.01f);
-   shader->setUniformFloat("pointLights[1].quadraticAtt", 0.0f);
-   shader->setUniformInt("numPointLightsInScene", 2);
-   shader->use(false);
+   PerFrameUniformBuffer::Data data{};
+   data.view           = mCamera3.getViewMatrix();
+   data.projection     = mCamera3.getPerspectiveProjectionMatrix();
+   data.projectionView = data.projection * data.view;
+   data.cameraPos      = mCamera3.getPosition();
+
+   data.numPointLightsInScene = 2;
+   data.pointLights[0] = PerFrameUniformBuffer::PointLight{glm::vec3(0.0f, 2.0f, 10.0f),  0.0f, glm::vec3(1.0f, 0.95f, 0.9f), 1.0f, 0.01f, 0.0f, {0.0f, 0.0f}};
+   data.pointLights[1] = PerFrameUniformBuffer::PointLight{glm::vec3(0.0f, 2.0f, -10.0f), 0.0f, glm::vec3(1.0f, 0.95f, 0.9f), 1.0f, 0.01f, 0.0f, {0.0f, 0.0f}};
+
+   mPerFrameUniformBuffer.Upload(data);
 }
 
 #ifdef __EMSCRIPTEN__
@@ -548,6 +1168,82 @@ EM_JS(void, openReadme, (), {
 });
 #endif
 
+void ModelViewerState::resetTrackVisualizer()
+{
+   // The graphs of each clip are cached by the track visualizer, so switching back to a clip is almost free
+   unsigned long long cacheKey = (static_cast<unsigned long long>(mCurrentCharacterIndex) << 32) | static_cast<unsigned long long>(mCurrentClipIndex[mCurrentCharacterIndex]);
+
+#ifndef __EMSCRIPTEN__
+   auto start = std::chrono::steady_clock::now();
+
+   if (!mStressTestTracks.empty())
+   {
+      mTrackVisualizer.setTracks(mStressTestTracks);
+   }
+   else
+   {
+      mTrackVisualizer.setTracks(mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]).GetTransformTracks(), cacheKey);
+   }
+
+   mGraphBuildTimeInMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+#else
+   mTrackVisualizer.setTracks(mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]).GetTransformTracks(), cacheKey);
+#endif
+
+   // The graphs of a cached clip are displayed on the page they were left on
+   mSelectedGraphPage = static_cast<int>(mTrackVisualizer.getPage());
+}
+
+#ifndef __EMSCRIPTEN__
+void ModelViewerState::generateStressTestTracks(unsigned int numTracks)
+{
+   // Each synthetic track rotates around its own axis with a cubic oscillation,
+   // which makes the graphs as expensive to evaluate as the ones of a real clip
+   const unsigned int numFrames = 30;
+   const float        duration  = 2.0f;
+   const float        amplitude = glm::half_pi<float>();
+
+   mStressTestTracks.clear();
+   mStressTestTracks.resize(numTracks);
+   for (unsigned int trackIndex = 0; trackIndex < numTracks; ++trackIndex)
+   {
+      float     trackIndexAsFloat = static_cast<float>(trackIndex);
+      glm::vec3 axis              = glm::normalize(glm::vec3(glm::sin(trackIndexAsFloat * 1.3f), glm::cos(trackIndexAsFloat * 0.7f), glm::sin(trackIndexAsFloat * 0.3f) + 1.5f));
+      float     angularFrequency  = glm::two_pi<float>() * static_cast<float>(1 + (trackIndex % 5)) / duration;
+
+      mStressTestTracks[trackIndex].SetJointID(trackIndex);
+
+      FastQuaternionTrack& rotationTrack = mStressTestTracks[trackIndex].GetRotationTrack();
+      rotationTrack.SetInterpolation(Interpolation::Cubic);
+      rotationTrack.SetNumberOfFrames(numFrames);
+      for (unsigned int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+      {
+         float time       = duration * static_cast<float>(frameIndex) / static_cast<float>(numFrames - 1);
+         float angle      = amplitude * glm::sin(angularFrequency * time);
+         float angleSpeed = amplitude * angularFrequency * glm::cos(angularFrequency * time);
+
+         // The derivative of angleAxis(angle(t), axis) with respect to time
+         Q::quat value = Q::angleAxis(angle, axis);
+         glm::vec3 slopeOfVector = axis * (glm::cos(angle * 0.5f) * 0.5f * angleSpeed);
+         float     slopeOfScalar = -glm::sin(angle * 0.5f) * 0.5f * angleSpeed;
+
+         QuaternionFrame& frame = rotationTrack.GetFrame(frameIndex);
+         frame.mTime = time;
+         frame.mValue[0] = value.x;
+         frame.mValue[1] = value.y;
+         frame.mValue[2] = value.z;
+         frame.mValue[3] = value.w;
+         frame.mInSlope[0] = frame.mOutSlope[0] = slopeOfVector.x;
+         frame.mInSlope[1] = frame.mOutSlope[1] = slopeOfVector.y;
+         frame.mInSlope[2] = frame.mOutSlope[2] = slopeOfVector.z;
+         frame.mInSlope[3] = frame.mOutSlope[3] = slopeOfScalar;
+      }
+
+      rotationTrack.GenerateSampleToFrameIndexMap();
+   }
+}
+#endif
+
 void ModelViewerState::userInterface()
 {
    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Appearing);
@@ -583,11 +1279,21 @@ void ModelViewerState::userInterface()
    {
       ImGui::Combo("Character", &mSelectedCharacter, mCharacterNames.c_str());
 
+      // The other characters keep loading in the background while the viewer is displayed
+      if (!mLoader.IsDone())
+      {
+         float loadingTimeBudget = mLoader.GetTimeBudget();
+         if (ImGui::SliderFloat("Loading Time Budget", &loadingTimeBudget, 1.0f, 100.0f, "%.0f ms"))
+         {
+            mLoader.SetTimeBudget(loadingTimeBudget);
+         }
+      }
+
       ImGui::Combo("Clip", &mSelectedClip, mCharacterClipNames[mCurrentCharacterIndex].c_str());
 
       ImGui::SliderFloat("Playback Speed", &mSelectedPlaybackSpeed, 0.0f, 2.0f, "%.3f");
 
-      float durationOfCurrClip = mCharacterClips[mCurrentCharacterIndex][mCurrentClipIndex[mCurrentCharacterIndex]].GetDuration();
+      float durationOfCurrClip = mCharacterClips[mCurrentCharacterIndex].GetClip(mCurrentClipIndex[mCurrentCharacterIndex]).GetDuration();
       char progress[32];
       snprintf(progress, 32, "%.3f / %.3f", mPlaybackTime, durationOfCurrClip);
       ImGui::ProgressBar(mPlaybackTime / durationOfCurrClip, ImVec2(0.0f, 0.0f), progress);
@@ -613,12 +1319,297 @@ void ModelViewerState::userInterface()
       ImGui::Checkbox("Perform Depth Testing", &mPerformDepthTesting);
 #endif
 
+      ImGui::Checkbox("Skin Once With Transform Feedback", &mSkinWithTransformFeedback);
+
+      if (mSkinWithTransformFeedback && !mCharacterUsesPackedVertices[mCurrentCharacterIndex])
+      {
+         ImGui::Text("This character doesn't use the packed vertex format,\n"
+                     "so it's skinned by the regular shaders.");
+      }
+
+#ifndef __EMSCRIPTEN__
+      if (mSkinWithTransformFeedback && mCharacterUsesPackedVertices[mCurrentCharacterIndex])
+      {
+         if (ImGui::Button("Verify Against CPU Skinning"))
+         {
+            mVerifyTransformFeedbackSkinning = true;
+         }
+
+         if (mTransformFeedbackSkinningWasVerified)
+         {
+            ImGui::Text("Max Position Difference: %.6f", mMaxPositionDifferenceOfTransformFeedbackSkinning);
+            ImGui::Text("Max Normal Difference: %.3f Degrees", mMaxNormalDifferenceOfTransformFeedbackSkinning);
+         }
+      }
+#endif
+
       ImGui::Checkbox("Fill Empty Tiles With Repeated Graphs", &mFillEmptyTilesWithRepeatedGraphs);
+
+      ImGui::Checkbox("Evaluate Curves on GPU", &mEvaluateCurvesOnGPU);
+
+      if (mEvaluateCurvesOnGPU)
+      {
+         ImGui::SliderInt("Samples per Curve", &mNumSamplesPerCurve, 2, 1200);
+
+#ifndef __EMSCRIPTEN__
+         if (ImGui::Button("Verify Against CPU Sampling"))
+         {
+            mMaxSampleDifferenceOfCurves = mTrackVisualizer.verifyCurvesAgainstCPU();
+            mCurvesWereVerified          = true;
+         }
+
+         if (mCurvesWereVerified)
+         {
+            if (mMaxSampleDifferenceOfCurves >= 0.0f)
+            {
+               ImGui::Text("Max Sample Difference: %.6f", mMaxSampleDifferenceOfCurves);
+            }
+            else
+            {
+               ImGui::Text("The curves aren't evaluated on the GPU yet");
+            }
+         }
+#endif
+      }
+
+      int numGraphPages = static_cast<int>(mTrackVisualizer.getNumberOfPages());
+      if (numGraphPages > 1)
+      {
+         ImGui::SliderInt("Graph Page", &mSelectedGraphPage, 0, numGraphPages - 1);
+      }
+
+#ifndef __EMSCRIPTEN__
+      ImGui::Checkbox("Stress Test Graphs (500 Tracks)", &mStressTestGraphs);
+
+      if (mStressTestGraphs)
+      {
+         ImGui::Text("Frame Time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+         ImGui::Text("Graph Build Time: %.3f ms", mGraphBuildTimeInMilliseconds);
+      }
+#endif
+   }
+
+   if (ImGui::CollapsingHeader("Mesh Optimization"))
+   {
+      // The vertices are welded and the triangles are reordered for the post-transform vertex cache when the character is loaded
+      const MeshOptimizationStatistics& characterStatistics = mCharacterMeshStatistics[mCurrentCharacterIndex];
+      ImGui::Text("Triangles: %u", characterStatistics.numTriangles);
+      ImGui::Text("Vertices Before / After: %u / %u", characterStatistics.numVerticesBefore, characterStatistics.numVerticesAfter);
+      ImGui::Text("ACMR Before / After: %.3f / %.3f", characterStatistics.acmrBefore, characterStatistics.acmrAfter);
+   }
+
+   if (ImGui::CollapsingHeader("Level of Detail"))
+   {
+      const std::vector<AnimatedMesh>& characterMeshes = mCharacterMeshes[mCurrentCharacterIndex];
+
+      unsigned int numLevelsOfDetail = 1;
+      for (const AnimatedMesh& characterMesh : characterMeshes)
+      {
+         numLevelsOfDetail = std::max(numLevelsOfDetail, characterMesh.GetNumberOfLevelsOfDetail());
+      }
+
+      bool selectLevelOfDetailAutomatically = (mSelectedLevelOfDetail < 0);
+      if (ImGui::Checkbox("Select Level of Detail Automatically", &selectLevelOfDetailAutomatically))
+      {
+         mSelectedLevelOfDetail = selectLevelOfDetailAutomatically ? -1 : static_cast<int>(mCurrentLevelOfDetail);
+      }
+
+      if (!selectLevelOfDetailAutomatically)
+      {
+         ImGui::SliderInt("Level of Detail", &mSelectedLevelOfDetail, 0, static_cast<int>(numLevelsOfDetail) - 1);
+      }
+
+      ImGui::Text("Current Level of Detail: %u", mCurrentLevelOfDetail);
+
+      for (unsigned int levelOfDetail = 0; levelOfDetail < numLevelsOfDetail; ++levelOfDetail)
+      {
+         unsigned int numTriangles = 0;
+         float        error        = 0.0f;
+         for (const AnimatedMesh& characterMesh : characterMeshes)
+         {
+            unsigned int levelOfDetailOfMesh = std::min(levelOfDetail, characterMesh.GetNumberOfLevelsOfDetail() - 1);
+            numTriangles += characterMesh.GetNumberOfIndicesOfLevelOfDetail(levelOfDetailOfMesh) / 3;
+            error         = std::max(error, characterMesh.GetErrorOfLevelOfDetail(levelOfDetailOfMesh));
+         }
+
+         ImGui::BulletText("LOD %u: %u Triangles, Error: %.4f", levelOfDetail, numTriangles, error);
+      }
+   }
+
+   if (ImGui::CollapsingHeader("Pose Cache"))
+   {
+      ImGui::SliderFloat("Time Step (ms)", &mSelectedPoseCacheTimeStepInMilliseconds, 0.0f, 50.0f, "%.1f");
+
+      const PoseCache::Statistics& lastFrameStatistics = mPoseCache.GetStatisticsOfLastFrame();
+      const PoseCache::Statistics& totalStatistics     = mPoseCache.GetTotalStatistics();
+      unsigned int numTotalLookups = totalStatistics.numHits + totalStatistics.numMisses;
+      float        totalHitRate    = (numTotalLookups > 0) ? (100.0f * totalStatistics.numHits / numTotalLookups) : 0.0f;
+
+      ImGui::Text("Cached Poses: %u", mPoseCache.GetNumberOfCachedPoses());
+      ImGui::Text("Hits / Misses (Last Update): %u / %u", lastFrameStatistics.numHits, lastFrameStatistics.numMisses);
+      ImGui::Text("Hits / Misses (Total): %u / %u", totalStatistics.numHits, totalStatistics.numMisses);
+      ImGui::Text("Hit Rate (Total): %.1f%%", totalHitRate);
+   }
+
+   if (ImGui::CollapsingHeader("Baked Poses"))
+   {
+      ClipLibrary& characterClips = mCharacterClips[mCurrentCharacterIndex];
+      unsigned int currClipIndex  = mCurrentClipIndex[mCurrentCharacterIndex];
+
+      ImGui::SliderFloat("Frames per Second", &mSelectedBakingFramesPerSecond, 5.0f, 120.0f, "%.0f");
+
+      ImGui::Combo("Baked Content", &mSelectedBakedContent, "Local Poses\0Skin Matrices\0");
+
+      ImGui::Combo("Baked Playback", &mSelectedBakedPlayback, "Blend Two Frames\0Nearest Frame\0");
+
+      // The memory is estimated before baking, so that the options can be adjusted without having to bake the clip
+      BakedClip::Content selectedBakedContent = (mSelectedBakedContent == 0) ? BakedClip::Content::LocalPoses : BakedClip::Content::SkinMatrices;
+      float        durationOfCurrClip = characterClips.GetClip(currClipIndex).GetDuration();
+      unsigned int numJoints          = mCharacterSkeleton.GetRestPose().GetNumberOfJoints();
+      ImGui::Text("Estimated Memory: %.1f KB (%u Frames)",
+                  BakedClip::EstimateMemoryFootprint(durationOfCurrClip, numJoints, mSelectedBakingFramesPerSecond, selectedBakedContent) / 1024.0f,
+                  BakedClip::CalculateNumberOfFrames(durationOfCurrClip, mSelectedBakingFramesPerSecond));
+
+      if (ImGui::Button("Bake Current Clip"))
+      {
+         characterClips.EnableBakingOfClip(currClipIndex, mSelectedBakingFramesPerSecond, selectedBakedContent);
+      }
+
+      if (characterClips.IsBakingOfClipEnabled(currClipIndex))
+      {
+         ImGui::SameLine();
+         if (ImGui::Button("Stop Baking Current Clip"))
+         {
+            characterClips.DisableBakingOfClip(currClipIndex);
+         }
+      }
+
+      const BakedClip* bakedClip = characterClips.GetBakedClip(currClipIndex, mCharacterSkeleton);
+      if (bakedClip)
+      {
+         ImGui::Text("Current Clip: Baked (%s, %.0f FPS, %.1f KB)",
+                     (bakedClip->GetContent() == BakedClip::Content::LocalPoses) ? "Local Poses" : "Skin Matrices",
+                     bakedClip->GetFramesPerSecond(),
+                     bakedClip->GetMemoryFootprint() / 1024.0f);
+      }
+      else
+      {
+         ImGui::Text("Current Clip: Not Baked");
+      }
+
+      ImGui::Text("Clip Memory: %.1f KB", characterClips.GetMemoryUsage() / 1024.0f);
+      ImGui::Text("Raw Key Frame Memory: %.1f KB", characterClips.GetMemoryUsageOfRawClips() / 1024.0f);
+
+#ifndef __EMSCRIPTEN__
+      ImGui::Text("Pose Update Time: %.2f us", mPoseUpdateTimeInMicroseconds);
+#endif
+   }
+
+   if (ImGui::CollapsingHeader("Render Statistics"))
+   {
+      const RenderQueue::Statistics& statistics = mRenderQueue.GetStatisticsOfLastFrame();
+      ImGui::Text("Draw Calls: %u", statistics.numDrawCalls);
+      ImGui::Text("State Calls Issued: %u", statistics.numIssuedStateCalls);
+      ImGui::Text("Redundant State Calls Skipped: %u", statistics.numSkippedStateCalls);
+      ImGui::Text("State Calls Without Render Queue: %u", statistics.numStateCallsWithoutQueue);
    }
 
    ImGui::End();
 }
 
+void ModelViewerState::loadingScreen()
+{
+   ImGuiIO& io = ImGui::GetIO();
+   ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+   ImGui::SetNextWindowSize(ImVec2(320.0f, 0.0f), ImGuiCond_Always);
+   ImGui::Begin("Animation Magic###Loading", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
+
+   char progress[32];
+   snprintf(progress, 32, "%u / %u", mLoader.GetNumberOfCompletedSteps(), mLoader.GetNumberOfSteps());
+   ImGui::ProgressBar(mLoader.GetProgress(), ImVec2(-1.0f, 0.0f), progress);
+
+   ImGui::Text("%s...", mLoader.GetDescriptionOfNextStep().c_str());
+
+   float loadingTimeBudget = mLoader.GetTimeBudget();
+   if (ImGui::SliderFloat("Time Budget", &loadingTimeBudget, 1.0f, 100.0f, "%.0f ms"))
+   {
+      mLoader.SetTimeBudget(loadingTimeBudget);
+   }
+
+   ImGui::End();
+}
+
+unsigned int ModelViewerState::selectLevelOfDetail(const AnimatedMesh& mesh)
+{
+   unsigned int numLevelsOfDetail = mesh.GetNumberOfLevelsOfDetail();
+   if (mSelectedLevelOfDetail >= 0)
+   {
+      return std::min(static_cast<unsigned int>(mSelectedLevelOfDetail), numLevelsOfDetail - 1);
+   }
+
+   // The largest error that a level of detail can have on screen, in pixels
+   const float maxErrorInPixels = 1.0f;
+
+   // Project the errors of the levels of detail onto the screen using the distance between the camera and the character
+   const Transform& modelTransform = mModelTransform[mCurrentCharacterIndex];
+   float scale           = std::max(modelTransform.scale.x, std::max(modelTransform.scale.y, modelTransform.scale.z));
+   float distance        = std::max(glm::length(mCamera3.getPosition() - modelTransform.position), 0.001f);
+   float pixelsPerUnit   = (mCamera3.getPerspectiveProjectionMatrix()[1][1] * mWindow->getHeightOfViewportInPix() * 0.5f) / distance;
+
+   // The errors grow with the levels of detail, so the last one whose error is small enough is selected
+   unsigned int levelOfDetail = 0;
+   for (unsigned int i = 1; i < numLevelsOfDetail; ++i)
+   {
+      if (mesh.GetErrorOfLevelOfDetail(i) * scale * pixelsPerUnit > maxErrorInPixels)
+      {
+         break;
+      }
+
+      levelOfDetail = i;
+   }
+
+   return levelOfDetail;
+}
+
+#ifndef __EMSCRIPTEN__
+void ModelViewerState::verifyTransformFeedbackSkinning()
+{
+   // The GPU skins the quantized vertices of the packed format, so small differences are expected
+   float maxPositionDifference = 0.0f;
+   float maxNormalDifference   = 0.0f;
+
+   std::vector<glm::vec3> gpuPositions, gpuNormals, cpuPositions, cpuNormals;
+   for (AnimatedMesh& characterMesh : mCharacterMeshes[mCurrentCharacterIndex])
+   {
+      characterMesh.ReadSkinnedVertices(gpuPositions, gpuNormals);
+      SkinMesh(characterMesh, *mCurrentSkinMatrices, cpuPositions, cpuNormals, mThreadPool);
+
+      if (gpuPositions.size() != cpuPositions.size() || gpuNormals.size() != cpuNormals.size())
+      {
+         std::cout << "Error - ModelViewerState::verifyTransformFeedbackSkinning - The number of skinned vertices doesn't match" << "\n";
+         continue;
+      }
+
+      for (unsigned int i = 0,
+           size = static_cast<unsigned int>(gpuPositions.size());
+           i < size;
+           ++i)
+      {
+         maxPositionDifference = std::max(maxPositionDifference, glm::length(gpuPositions[i] - cpuPositions[i]));
+         float cosOfAngle      = glm::clamp(glm::dot(gpuNormals[i], cpuNormals[i]), -1.0f, 1.0f);
+         maxNormalDifference   = std::max(maxNormalDifference, glm::degrees(std::acos(cosOfAngle)));
+      }
+   }
+
+   mMaxPositionDifferenceOfTransformFeedbackSkinning = maxPositionDifference;
+   mMaxNormalDifferenceOfTransformFeedbackSkinning   = maxNormalDifference;
+   mTransformFeedbackSkinningWasVerified             = true;
+
+   std::cout << "ModelViewerState::verifyTransformFeedbackSkinning - Max position difference: " << maxPositionDifference
+             << ", Max normal difference: " << maxNormalDifference << " degrees" << "\n";
+}
+#endif
+
 void ModelViewerState::resetScene()
 {
 
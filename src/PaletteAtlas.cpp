@@ -0,0 +1,117 @@
+#include <iostream>
+
+#include "PaletteAtlas.h"
+
+namespace PaletteAtlasHelpers
+{
+   // log2(cellSize), which is the last mipmap level in which each cell still occupies whole texels
+   const int maxMipmapLevel = 6;
+
+   static_assert((1 << maxMipmapLevel) == PaletteAtlas::cellSize, "The maximum mipmap level of the atlas must match its cell size");
+}
+
+PaletteAtlas::PaletteAtlas()
+   : mNumCells(0)
+   , mTexture()
+{
+
+}
+
+bool PaletteAtlas::CanHoldImage(int width, int height)
+{
+   return (width > 0) && (height > 0) && (width <= cellSize) && (height <= cellSize);
+}
+
+bool PaletteAtlas::CanRemapTexCoords(const std::vector<glm::vec2>& texCoords)
+{
+   for (const glm::vec2& texCoord : texCoords)
+   {
+      if (texCoord.x < 0.0f || texCoord.x > 1.0f || texCoord.y < 0.0f || texCoord.y > 1.0f)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+void PaletteAtlas::Initialize(unsigned int numCells)
+{
+   mNumCells = numCells;
+
+   unsigned int texID;
+   glGenTextures(1, &texID);
+   glBindTexture(GL_TEXTURE_2D, texID);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cellSize * numCells, cellSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, PaletteAtlasHelpers::maxMipmapLevel);
+
+   glBindTexture(GL_TEXTURE_2D, 0);
+
+   mTexture = std::make_shared<Texture>(texID);
+}
+
+void PaletteAtlas::SetCell(unsigned int cellIndex, const TextureLoader::DecodedResource& palette)
+{
+   if (cellIndex >= mNumCells || !CanHoldImage(palette.width, palette.height))
+   {
+      std::cout << "Error - PaletteAtlas::SetCell - The palette doesn't fit in cell " << cellIndex << "\n";
+      return;
+   }
+
+   // Expand the palette to RGBA and repeat its last row and column until the cell is full
+   std::vector<unsigned char> cell(cellSize * cellSize * 4);
+   for (int y = 0; y < cellSize; ++y)
+   {
+      int srcY = (y < palette.height) ? y : (palette.height - 1);
+      for (int x = 0; x < cellSize; ++x)
+      {
+         int srcX = (x < palette.width) ? x : (palette.width - 1);
+         const unsigned char* srcTexel = &palette.texData[((srcY * palette.width) + srcX) * palette.numComponents];
+         unsigned char*       dstTexel = &cell[((y * cellSize) + x) * 4];
+
+         dstTexel[0] = srcTexel[0];
+         dstTexel[1] = (palette.numComponents > 1) ? srcTexel[1] : srcTexel[0];
+         dstTexel[2] = (palette.numComponents > 2) ? srcTexel[2] : srcTexel[0];
+         dstTexel[3] = (palette.numComponents > 3) ? srcTexel[3] : 255;
+      }
+   }
+
+   glBindTexture(GL_TEXTURE_2D, mTexture->getID());
+   glTexSubImage2D(GL_TEXTURE_2D, 0, cellSize * cellIndex, 0, cellSize, cellSize, GL_RGBA, GL_UNSIGNED_BYTE, cell.data());
+
+   // Regenerating the mipmaps of the whole atlas is cheap, since it's tiny
+   glGenerateMipmap(GL_TEXTURE_2D);
+   glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void PaletteAtlas::RemapTexCoords(unsigned int cellIndex, int paletteWidth, int paletteHeight, std::vector<glm::vec2>& texCoords) const
+{
+   const glm::vec2 atlasSize   = glm::vec2(static_cast<float>(cellSize * mNumCells), static_cast<float>(cellSize));
+   const glm::vec2 paletteSize = glm::vec2(static_cast<float>(paletteWidth), static_cast<float>(paletteHeight));
+   const glm::vec2 cellOrigin  = glm::vec2(static_cast<float>(cellSize * cellIndex), 0.0f);
+
+   // The coordinates are clamped to the centers of the edge texels of the palette, which is what GL_CLAMP_TO_EDGE would do with its own texture,
+   // so that bilinear filtering never reads the previous cell when a coordinate is on the left or top edge of the palette
+   const glm::vec2 minTexCoord = (cellOrigin + glm::vec2(0.5f)) / atlasSize;
+   const glm::vec2 maxTexCoord = (cellOrigin + paletteSize - glm::vec2(0.5f)) / atlasSize;
+
+   for (glm::vec2& texCoord : texCoords)
+   {
+      texCoord = glm::clamp((cellOrigin + (texCoord * paletteSize)) / atlasSize, minTexCoord, maxTexCoord);
+   }
+}
+
+unsigned int PaletteAtlas::GetNumberOfCells() const
+{
+   return mNumCells;
+}
+
+std::shared_ptr<Texture> PaletteAtlas::GetTexture() const
+{
+   return mTexture;
+}
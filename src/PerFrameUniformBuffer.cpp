@@ -0,0 +1,45 @@
+#ifdef __EMSCRIPTEN__
+#include <GLES3/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+#include <utility>
+
+#include "PerFrameUniformBuffer.h"
+
+PerFrameUniformBuffer::PerFrameUniformBuffer()
+   : mUBO(0)
+{
+   glGenBuffers(1, &mUBO);
+   glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+   glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+   glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+   // The buffer stays bound to its binding point, which is shared by all the programs
+   glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, mUBO);
+}
+
+PerFrameUniformBuffer::~PerFrameUniformBuffer()
+{
+   glDeleteBuffers(1, &mUBO);
+}
+
+PerFrameUniformBuffer::PerFrameUniformBuffer(PerFrameUniformBuffer&& rhs) noexcept
+   : mUBO(std::exchange(rhs.mUBO, 0))
+{
+
+}
+
+PerFrameUniformBuffer& PerFrameUniformBuffer::operator=(PerFrameUniformBuffer&& rhs) noexcept
+{
+   mUBO = std::exchange(rhs.mUBO, 0);
+   return *this;
+}
+
+void PerFrameUniformBuffer::Upload(const Data& data) const
+{
+   glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+   glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &data);
+   glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
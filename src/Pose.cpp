@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "Pose.h"
 
 Pose::Pose(unsigned int numJoints)
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "PoseCache.h"
+
+PoseCache::PoseCache()
+   : mCachedPoses()
+   , mTimeStep(0.0f)
+   , mCurrentFrame(0)
+   , mStatisticsOfCurrentFrame()
+   , mStatisticsOfLastFrame()
+   , mTotalStatistics()
+{
+
+}
+
+float PoseCache::GetTimeStep() const
+{
+   return mTimeStep;
+}
+
+void PoseCache::SetTimeStep(float timeStep)
+{
+   timeStep = std::max(timeStep, 0.0f);
+   if (timeStep != mTimeStep)
+   {
+      mTimeStep = timeStep;
+      Clear();
+   }
+}
+
+void PoseCache::BeginFrame()
+{
+   mStatisticsOfLastFrame = mStatisticsOfCurrentFrame;
+   mStatisticsOfCurrentFrame = Statistics();
+
+   // Evict the poses that weren't used during the last frame
+   for (std::map<Key, CachedPose>::iterator it = mCachedPoses.begin(); it != mCachedPoses.end();)
+   {
+      if (it->second.lastUsedFrame != mCurrentFrame)
+      {
+         it = mCachedPoses.erase(it);
+      }
+      else
+      {
+         ++it;
+      }
+   }
+
+   ++mCurrentFrame;
+}
+
+void PoseCache::Clear()
+{
+   mCachedPoses.clear();
+   mStatisticsOfCurrentFrame = Statistics();
+   mStatisticsOfLastFrame    = Statistics();
+   mTotalStatistics          = Statistics();
+}
+
+const PoseCache::Entry& PoseCache::GetPose(const FastClip& clip, float time, Skeleton& skeleton)
+{
+   // Quantize the time relative to the start of the clip, so that the quantized time is always within the range of the clip
+   long long timeKey;
+   float     quantizedTime;
+   if (mTimeStep > 0.0f)
+   {
+      timeKey       = static_cast<long long>(std::floor((time - clip.GetStartTime()) / mTimeStep));
+      quantizedTime = clip.GetStartTime() + (static_cast<float>(timeKey) * mTimeStep);
+   }
+   else
+   {
+      int timeBits;
+      std::memcpy(&timeBits, &time, sizeof(timeBits));
+      timeKey       = timeBits;
+      quantizedTime = time;
+   }
+
+   std::pair<std::map<Key, CachedPose>::iterator, bool> insertion = mCachedPoses.insert(std::make_pair(Key(&clip, timeKey), CachedPose()));
+   CachedPose& cachedPose = insertion.first->second;
+   cachedPose.lastUsedFrame = mCurrentFrame;
+
+   if (!insertion.second)
+   {
+      ++mStatisticsOfCurrentFrame.numHits;
+      ++mTotalStatistics.numHits;
+      return cachedPose.entry;
+   }
+
+   ++mStatisticsOfCurrentFrame.numMisses;
+   ++mTotalStatistics.numMisses;
+
+   // Sample the clip, starting from the rest pose so that the joints that the clip doesn't animate keep their rest transforms
+   Entry& entry = cachedPose.entry;
+   entry.pose = skeleton.GetRestPose();
+   clip.Sample(entry.pose, quantizedTime);
+
+   // Get the palette of the pose
+   entry.pose.GetMatrixPalette(entry.posePalette);
+
+   std::vector<glm::mat4>& inverseBindPose = skeleton.GetInvBindPose();
+
+   // Generate the skin matrices
+   entry.skinMatrices.resize(entry.posePalette.size());
+   for (unsigned int i = 0,
+        size = static_cast<unsigned int>(entry.posePalette.size());
+        i < size;
+        ++i)
+   {
+      entry.skinMatrices[i] = entry.posePalette[i] * inverseBindPose[i];
+   }
+
+   return entry;
+}
+
+unsigned int PoseCache::GetNumberOfCachedPoses() const
+{
+   return static_cast<unsigned int>(mCachedPoses.size());
+}
+
+const PoseCache::Statistics& PoseCache::GetStatisticsOfLastFrame() const
+{
+   return mStatisticsOfLastFrame;
+}
+
+const PoseCache::Statistics& PoseCache::GetTotalStatistics() const
+{
+   return mTotalStatistics;
+}
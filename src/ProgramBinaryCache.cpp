@@ -0,0 +1,298 @@
+#ifndef __EMSCRIPTEN__
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "ProgramBinaryCache.h"
+
+namespace ProgramBinaryCacheHelpers
+{
+   // These aren't part of OpenGL 3.3, so they aren't declared by glad
+   const GLenum programBinaryRetrievableHint = 0x8257;
+   const GLenum programBinaryLength          = 0x8741;
+   const GLenum numProgramBinaryFormats      = 0x87FE;
+
+   typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+   typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+   typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+   // The cache directory is created in the working directory the first time a binary is stored, and it's ignored by git
+   const char* cacheDirectoryPath = "cache";
+   const char* cacheFilePath      = "cache/program_binary_cache.bin";
+
+   // No program of this application comes close to this size, so a larger size means that the file is corrupted
+   const unsigned int maxBinarySize = 64 * 1024 * 1024;
+
+   // Written at the start of the cache file so that files from an incompatible version of the cache are ignored
+   const unsigned int cacheFileMagic = 0x414D5043; // AMPC
+
+   struct ProgramBinary
+   {
+      GLenum            format;
+      std::vector<char> data;
+   };
+
+   struct CacheState
+   {
+      bool                                          initialized          = false;
+      bool                                          supported            = false;
+      GetProgramBinaryProc                          getProgramBinary     = nullptr;
+      ProgramBinaryProc                             programBinary        = nullptr;
+      ProgramParameteriProc                         programParameteri    = nullptr;
+      std::map<unsigned long long, ProgramBinary>   binaries;
+      unsigned int                                  numLoadedPrograms    = 0;
+      unsigned int                                  numCompiledPrograms  = 0;
+   };
+
+   CacheState& GetState()
+   {
+      static CacheState state;
+      return state;
+   }
+
+   unsigned long long HashFNV1a(const std::string& str, unsigned long long hash)
+   {
+      for (unsigned char c : str)
+      {
+         hash ^= c;
+         hash *= 1099511628211ull;
+      }
+
+      return hash;
+   }
+
+   std::string GetGLString(GLenum name)
+   {
+      const GLubyte* str = glGetString(name);
+      return str ? reinterpret_cast<const char*>(str) : "";
+   }
+
+   void CreateCacheDirectory()
+   {
+      // This fails harmlessly when the directory already exists
+#ifdef _WIN32
+      _mkdir(cacheDirectoryPath);
+#else
+      mkdir(cacheDirectoryPath, 0755);
+#endif
+   }
+
+   void ReadCacheFile(CacheState& state)
+   {
+      std::ifstream cacheFile(cacheFilePath, std::ios::binary | std::ios::ate);
+      if (!cacheFile)
+      {
+         // This is expected the first time the application is run
+         return;
+      }
+
+      // The size of the file is used to validate the sizes of the entries before anything is allocated for them
+      std::streamoff fileSize = cacheFile.tellg();
+      cacheFile.seekg(0, std::ios::beg);
+
+      unsigned int magic = 0;
+      cacheFile.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+      if (!cacheFile || magic != cacheFileMagic)
+      {
+         std::cout << "Warning - ProgramBinaryCache - The program binary cache file is invalid, so it will be rebuilt" << "\n";
+         return;
+      }
+
+      // Each entry is stored as its key, its binary format, the size of its binary and its binary
+      while (cacheFile)
+      {
+         unsigned long long key = 0;
+         GLenum format = 0;
+         unsigned int size = 0;
+         cacheFile.read(reinterpret_cast<char*>(&key), sizeof(key));
+         cacheFile.read(reinterpret_cast<char*>(&format), sizeof(format));
+         cacheFile.read(reinterpret_cast<char*>(&size), sizeof(size));
+         if (!cacheFile)
+         {
+            break;
+         }
+
+         std::streamoff remainingSize = fileSize - cacheFile.tellg();
+         if (size == 0 || size > maxBinarySize || static_cast<std::streamoff>(size) > remainingSize)
+         {
+            std::cout << "Warning - ProgramBinaryCache - The program binary cache file is corrupted, so the rest of it will be rebuilt" << "\n";
+            break;
+         }
+
+         ProgramBinary binary{format, std::vector<char>(size)};
+         cacheFile.read(binary.data.data(), size);
+         if (!cacheFile)
+         {
+            break;
+         }
+
+         state.binaries[key] = std::move(binary);
+      }
+   }
+
+   void WriteCacheFile(const CacheState& state)
+   {
+      CreateCacheDirectory();
+
+      std::ofstream cacheFile(cacheFilePath, std::ios::binary | std::ios::trunc);
+      if (!cacheFile)
+      {
+         std::cout << "Error - ProgramBinaryCache - The following file could not be written: " << cacheFilePath << "\n";
+         return;
+      }
+
+      cacheFile.write(reinterpret_cast<const char*>(&cacheFileMagic), sizeof(cacheFileMagic));
+      for (const std::pair<const unsigned long long, ProgramBinary>& entry : state.binaries)
+      {
+         unsigned int size = static_cast<unsigned int>(entry.second.data.size());
+         cacheFile.write(reinterpret_cast<const char*>(&entry.first), sizeof(entry.first));
+         cacheFile.write(reinterpret_cast<const char*>(&entry.second.format), sizeof(entry.second.format));
+         cacheFile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+         cacheFile.write(entry.second.data.data(), size);
+      }
+   }
+
+   CacheState& GetInitializedState()
+   {
+      CacheState& state = GetState();
+      if (state.initialized)
+      {
+         return state;
+      }
+
+      state.initialized = true;
+
+      state.getProgramBinary  = reinterpret_cast<GetProgramBinaryProc>(glfwGetProcAddress("glGetProgramBinary"));
+      state.programBinary     = reinterpret_cast<ProgramBinaryProc>(glfwGetProcAddress("glProgramBinary"));
+      state.programParameteri = reinterpret_cast<ProgramParameteriProc>(glfwGetProcAddress("glProgramParameteri"));
+
+      // Some drivers expose the functions without supporting a single binary format
+      GLint numFormats = 0;
+      if (state.getProgramBinary && state.programBinary)
+      {
+         glGetIntegerv(numProgramBinaryFormats, &numFormats);
+         // Clear the error that old drivers generate for the unknown enum
+         while (glGetError() != GL_NO_ERROR) {}
+      }
+
+      state.supported = (numFormats > 0);
+      if (state.supported)
+      {
+         ReadCacheFile(state);
+      }
+
+      return state;
+   }
+}
+
+unsigned long long ProgramBinaryCache::CalculateKey(const std::string& vShaderCode, const std::string& fShaderCode)
+{
+   // The separators prevent different sources from producing the same concatenated string
+   unsigned long long hash = 14695981039346656037ull;
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(vShaderCode, hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(std::string(1, '\0'), hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(fShaderCode, hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(std::string(1, '\0'), hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(ProgramBinaryCacheHelpers::GetGLString(GL_VENDOR), hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(ProgramBinaryCacheHelpers::GetGLString(GL_RENDERER), hash);
+   hash = ProgramBinaryCacheHelpers::HashFNV1a(ProgramBinaryCacheHelpers::GetGLString(GL_VERSION), hash);
+   return hash;
+}
+
+unsigned int ProgramBinaryCache::LoadProgram(unsigned long long key)
+{
+   ProgramBinaryCacheHelpers::CacheState& state = ProgramBinaryCacheHelpers::GetInitializedState();
+   if (!state.supported)
+   {
+      return 0;
+   }
+
+   std::map<unsigned long long, ProgramBinaryCacheHelpers::ProgramBinary>::iterator it = state.binaries.find(key);
+   if (it == state.binaries.end())
+   {
+      return 0;
+   }
+
+   unsigned int shaderProgID = glCreateProgram();
+   state.programBinary(shaderProgID, it->second.format, it->second.data.data(), static_cast<GLsizei>(it->second.data.size()));
+
+   int linkingStatus = 0;
+   glGetProgramiv(shaderProgID, GL_LINK_STATUS, &linkingStatus);
+   if (!linkingStatus)
+   {
+      // The driver rejected the binary, so we forget it and let the caller compile the program from source
+      glDeleteProgram(shaderProgID);
+      state.binaries.erase(it);
+      return 0;
+   }
+
+   ++state.numLoadedPrograms;
+   return shaderProgID;
+}
+
+void ProgramBinaryCache::PrepareProgramForStorage(unsigned int shaderProgID)
+{
+   ProgramBinaryCacheHelpers::CacheState& state = ProgramBinaryCacheHelpers::GetInitializedState();
+   if (state.supported && state.programParameteri)
+   {
+      state.programParameteri(shaderProgID, ProgramBinaryCacheHelpers::programBinaryRetrievableHint, GL_TRUE);
+   }
+}
+
+void ProgramBinaryCache::StoreProgram(unsigned long long key, unsigned int shaderProgID)
+{
+   ProgramBinaryCacheHelpers::CacheState& state = ProgramBinaryCacheHelpers::GetInitializedState();
+   ++state.numCompiledPrograms;
+   if (!state.supported)
+   {
+      return;
+   }
+
+   GLint binaryLength = 0;
+   glGetProgramiv(shaderProgID, ProgramBinaryCacheHelpers::programBinaryLength, &binaryLength);
+   if (binaryLength <= 0)
+   {
+      return;
+   }
+
+   ProgramBinaryCacheHelpers::ProgramBinary binary{0, std::vector<char>(binaryLength)};
+   GLsizei writtenLength = 0;
+   state.getProgramBinary(shaderProgID, binaryLength, &writtenLength, &binary.format, binary.data.data());
+   if (writtenLength <= 0)
+   {
+      return;
+   }
+
+   binary.data.resize(writtenLength);
+   state.binaries[key] = std::move(binary);
+
+   // The whole file is rewritten, which is fine because this only happens when a program isn't in the cache yet
+   ProgramBinaryCacheHelpers::WriteCacheFile(state);
+}
+
+unsigned int ProgramBinaryCache::GetNumberOfLoadedPrograms()
+{
+   return ProgramBinaryCacheHelpers::GetState().numLoadedPrograms;
+}
+
+unsigned int ProgramBinaryCache::GetNumberOfCompiledPrograms()
+{
+   return ProgramBinaryCacheHelpers::GetState().numCompiledPrograms;
+}
+
+const char* ProgramBinaryCache::GetCacheFilePath()
+{
+   return ProgramBinaryCacheHelpers::cacheFilePath;
+}
+
+#endif
@@ -1,5 +1,37 @@
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
 #include "RearrangeBones.h"
-#include <list>
+
+namespace RearrangeBonesHelpers
+{
+   int GetNewJointIndex(const JointMap& jointMap, int oldJointIndex)
+   {
+      return (oldJointIndex >= 0 && oldJointIndex < static_cast<int>(jointMap.size())) ? jointMap[oldJointIndex] : oldJointIndex;
+   }
+
+   void RemapJointIndices(int* ioJointIndices, unsigned int numJointIndices, const JointMap& jointMap)
+   {
+      if (jointMap.empty())
+      {
+         return;
+      }
+
+      // This is a single flat loop without any function calls or branches in its body, so the compiler can vectorize it
+      // (on targets that have gather instructions) or at least unroll it
+      // The joints that aren't mapped read the first entry of the map instead of their own one, so that all the reads are valid,
+      // and then they keep their old index
+      const int* newJointIndices = jointMap.data();
+      int        numMappedJoints = static_cast<int>(jointMap.size());
+      for (unsigned int i = 0; i < numJointIndices; ++i)
+      {
+         int oldJointIndex = ioJointIndices[i];
+         bool isMapped = (oldJointIndex >= 0) & (oldJointIndex < numMappedJoints);
+         ioJointIndices[i] = isMapped ? newJointIndices[isMapped ? oldJointIndex : 0] : oldJointIndex;
+      }
+   }
+}
 
 /*
    The RearrangeSkeleton function rearranges the array of joints of a skeleton so that the parent joints
@@ -34,8 +66,18 @@
               +----+----+----+----+
 
    Where the parent joints always come first in the array of joints
+
+   The joints can be ordered breadth first, which stores the joints level by level, or depth first, which stores each subtree contiguously
+   For the pose above, both orderings are the same, but for a pose like this one:
+
+   (root) 0 ---- 1 ---- 2
+          |
+          |
+          3 ---- 4
+
+   Breadth first ordering produces 0, 1, 3, 2, 4, while depth first ordering produces 0, 1, 2, 3, 4
 */
-JointMap RearrangeSkeleton(Skeleton& skeleton)
+JointMap RearrangeSkeleton(Skeleton& skeleton, JointOrdering ordering)
 {
    Pose& restPose = skeleton.GetRestPose();
    Pose& bindPose = skeleton.GetBindPose();
@@ -49,13 +91,10 @@ JointMap RearrangeSkeleton(Skeleton& skeleton)
    }
 
    /*
-      The jointHierarchy vector of vectors is a two-dimensional array
-      whose first dimension corresponds to the index of each joint in the rest pose,
-      and whose second dimension corresponds to the indices of the direct children of each joint in the rest pose:
+      The children and firstChildOffsets vectors store the direct children of each joint in a flat array:
+      the direct children of the joint with index i are stored in children[firstChildOffsets[i]] to children[firstChildOffsets[i + 1] - 1]
 
-      jointHierarchy[indices of joints][indices of the direct children of joints]
-
-      The loop below simply fills the jointHierarchy with the appropriate values
+      The loops below simply fill them with the appropriate values
 
       For example, for a pose like this one:
 
@@ -67,87 +106,112 @@ JointMap RearrangeSkeleton(Skeleton& skeleton)
                     |
                     0
 
-      The jointHierarchy would look like this:
+      The vectors would look like this:
+
+                                 +---+---+---+---+---+---+
+      Indices of Joints          | 0 | 1 | 2 | 3 | 4 |   |
+                                 +---+---+---+---+---+---+
+      First Child Offsets        | 0 | 0 | 2 | 3 | 4 | 4 |
+                                 +---+---+---+---+---+---+
 
-                                 +---+---+---+---+---+
-      Indices of Joints          | 0 | 1 | 2 | 3 | 4 |
-                                 +---+---+---+---+---+
-      Indices of Direct Children |   | 0 | 1 | 2 |   |
-                                 |   | 4 |   |   |   |
-                                 +---+---+---+---+---+
+                                 +---+---+---+---+
+      Children                   | 0 | 4 | 1 | 2 |
+                                 +---+---+---+---+
 
-      Also note how the loop below adds the roots to the jointsToBeMapped list,
-      which we will use to process the jointHierarchy later
+      Also note how the first loop below adds the roots to the jointsToBeMapped vector,
+      which we will use to process the hierarchy later
    */
-   std::vector<std::vector<int>> jointHierarchy(numJoints);
-   std::list<int> jointsToBeMapped;
+   std::vector<unsigned int> firstChildOffsets(numJoints + 1, 0);
+   std::vector<int>          jointsToBeMapped;
+   jointsToBeMapped.reserve(numJoints);
    for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
    {
       // Get the parent of the current joint
       int parentIndex = restPose.GetParent(jointIndex);
       if (parentIndex >= 0)
       {
-         // If the joint has a parent, then add it under its parent in the jointHierarchy
-         jointHierarchy[parentIndex].push_back(static_cast<int>(jointIndex));
+         // If the joint has a parent, then count it as one of the children of its parent
+         ++firstChildOffsets[parentIndex + 1];
       }
       else
       {
-         // If the joint is a root, add it to the jointsToBeMapped list
+         // If the joint is a root, add it to the jointsToBeMapped vector
          jointsToBeMapped.push_back(static_cast<int>(jointIndex));
       }
    }
 
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      firstChildOffsets[jointIndex + 1] += firstChildOffsets[jointIndex];
+   }
+
+   std::vector<int>          children(firstChildOffsets[numJoints]);
+   std::vector<unsigned int> numStoredChildren(numJoints, 0);
+   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   {
+      int parentIndex = restPose.GetParent(jointIndex);
+      if (parentIndex >= 0)
+      {
+         children[firstChildOffsets[parentIndex] + numStoredChildren[parentIndex]++] = static_cast<int>(jointIndex);
+      }
+   }
+
    /*
       The loop below fills the two JointMaps that we will use to rearrange
       the array of joints so that the parent joints always have a lower index than their child joints in the array of joints
 
-      For example, for the pose from the previous example:
-
-      (root) 3 ---- 2
-                    |
-                    |
-                    1 ---- 4
-                    |
-                    |
-                    0
-
-                                 +---+---+---+---+---+
-      Indices of Joints          | 0 | 1 | 2 | 3 | 4 |
-                                 +---+---+---+---+---+
-      Indices of Direct Children |   | 0 | 1 | 2 |   |
-                                 |   | 4 |   |   |   |
-                                 +---+---+---+---+---+
+      When ordering the joints breadth first, jointsToBeMapped is used as a queue, so the loop would do this for the pose from the previous example:
 
-      The loop below would do this:
+      Iteration 0: Map the root (joint 3) - Add its direct child (joint 2) to the back of jointsToBeMapped
+      Iteration 1: Map joint 2            - Add its direct child (joint 1) to the back of jointsToBeMapped
+      Iteration 2: Map joint 1            - Add its direct children (joints 0 and 4) to the back of jointsToBeMapped
+      Iteration 3: Map joint 0            - Add nothing to jointsToBeMapped
+      Iteration 4: Map joint 4            - Add nothing to jointsToBeMapped
 
-      Iteration 0: Map the root (joint 3) - Add its direct child (joint 2) to the jointsToBeMapped list
-      Iteration 1: Map joint 2            - Add its direct child (joint 1) to the jointsToBeMapped list
-      Iteration 2: Map joint 1            - Add its direct children (joints 0 and 4) to the jointsToBeMapped list
-      Iteration 3: Map joint 0            - Add nothing to the jointsToBeMapped list
-      Iteration 4: Map joint 4            - Add nothing to the jointsToBeMapped list
+      When ordering the joints depth first, jointsToBeMapped is used as a stack instead,
+      and the children are added in reverse order so that the first child is mapped first
+      Since the last joint that was added is always mapped next, the entire subtree of a joint is mapped before any of its siblings
    */
 
+   // The roots are processed in the order in which they are stored, so they are reversed when they are used as a stack
+   if (ordering == JointOrdering::DepthFirst)
+   {
+      std::reverse(jointsToBeMapped.begin(), jointsToBeMapped.end());
+   }
+
    // The JointMaps below can be used to map new (rearranged) joint indices
    // to old joint indices and vice versa
-   JointMap mapNewToOld;
-   JointMap mapOldToNew;
+   JointMap mapNewToOld(numJoints, -1);
+   JointMap mapOldToNew(numJoints, -1);
    int newIndexOfCurrJoint = 0;
-   while (jointsToBeMapped.size() > 0)
+   unsigned int frontOfQueue = 0;
+   while ((ordering == JointOrdering::BreadthFirst) ? (frontOfQueue < jointsToBeMapped.size()) : !jointsToBeMapped.empty())
    {
       // In the first iteration we start with the root, and if there's more than one,
       // the next iterations process the other ones
-      int oldIndexOfCurrJoint = *jointsToBeMapped.begin();
-      jointsToBeMapped.pop_front();
+      int oldIndexOfCurrJoint;
+      if (ordering == JointOrdering::BreadthFirst)
+      {
+         oldIndexOfCurrJoint = jointsToBeMapped[frontOfQueue++];
+      }
+      else
+      {
+         oldIndexOfCurrJoint = jointsToBeMapped.back();
+         jointsToBeMapped.pop_back();
+      }
 
-      // Below we get the indices of the direct children of the current joint
-      // and add them at the back of the process list
+      // Below we add the direct children of the current joint to the joints that still have to be mapped
       // By doing this we ensure that we will process the entire joint hierarchy and in the correct order:
       // parents first, then children
-      std::vector<int>& children = jointHierarchy[oldIndexOfCurrJoint];
-      unsigned int numChildren = static_cast<unsigned int>(children.size());
-      for (unsigned int i = 0; i < numChildren; ++i)
+      unsigned int firstChildOffset = firstChildOffsets[oldIndexOfCurrJoint];
+      unsigned int lastChildOffset  = firstChildOffsets[oldIndexOfCurrJoint + 1];
+      if (ordering == JointOrdering::BreadthFirst)
+      {
+         jointsToBeMapped.insert(jointsToBeMapped.end(), children.begin() + firstChildOffset, children.begin() + lastChildOffset);
+      }
+      else
       {
-         jointsToBeMapped.push_back(children[i]);
+         jointsToBeMapped.insert(jointsToBeMapped.end(), children.rbegin() + (children.size() - lastChildOffset), children.rbegin() + (children.size() - firstChildOffset));
       }
 
       // Map the new index of the current joint to the old one and vice versa
@@ -158,10 +222,6 @@ JointMap RearrangeSkeleton(Skeleton& skeleton)
       newIndexOfCurrJoint += 1;
    }
 
-   // TODO: Not sure why this is necessary
-   mapNewToOld[-1] = -1;
-   mapOldToNew[-1] = -1;
-
    // Use the JointMaps that were filled in the previous loop to create the rearranged rest pose, bind pose and list of names
    Pose newRestPose(numJoints);
    Pose newBindPose(numJoints);
@@ -178,7 +238,8 @@ JointMap RearrangeSkeleton(Skeleton& skeleton)
       // Store the joint name of the old joint index at the new joint index
       newNames[newJointIndex] = skeleton.GetJointName(oldJointIndex);
 
-      int newParentIndex = mapOldToNew[bindPose.GetParent(oldJointIndex)];
+      // The roots don't have a parent, so their parent index of -1 is kept as it is
+      int newParentIndex = RearrangeBonesHelpers::GetNewJointIndex(mapOldToNew, bindPose.GetParent(oldJointIndex));
       newRestPose.SetParent(newJointIndex, newParentIndex);
       newBindPose.SetParent(newJointIndex, newParentIndex);
    }
@@ -189,7 +250,7 @@ JointMap RearrangeSkeleton(Skeleton& skeleton)
    return mapOldToNew;
 }
 
-void RearrangeClip(Clip& clip, JointMap& jointMap)
+void RearrangeClip(Clip& clip, const JointMap& jointMap)
 {
    // Loop over all the transform tracks of the clip and update the indices of the joints that they target
    for (unsigned int transfTrackIndex = 0,
@@ -198,12 +259,12 @@ void RearrangeClip(Clip& clip, JointMap& jointMap)
         ++transfTrackIndex)
    {
       int oldJointIndex = static_cast<int>(clip.GetJointIDOfTransformTrack(transfTrackIndex));
-      unsigned int newJointIndex = static_cast<unsigned int>(jointMap[oldJointIndex]);
+      unsigned int newJointIndex = static_cast<unsigned int>(RearrangeBonesHelpers::GetNewJointIndex(jointMap, oldJointIndex));
       clip.SetJointIDOfTransformTrack(transfTrackIndex, newJointIndex);
    }
 }
 
-void RearrangeFastClip(FastClip& fastClip, JointMap& jointMap)
+void RearrangeFastClip(FastClip& fastClip, const JointMap& jointMap)
 {
    // Loop over all the transform tracks of the fast clip and update the indices of the joints that they target
    for (unsigned int transfTrackIndex = 0,
@@ -212,29 +273,19 @@ void RearrangeFastClip(FastClip& fastClip, JointMap& jointMap)
         ++transfTrackIndex)
    {
       int oldJointIndex = static_cast<int>(fastClip.GetJointIDOfTransformTrack(transfTrackIndex));
-      unsigned int newJointIndex = static_cast<unsigned int>(jointMap[oldJointIndex]);
+      unsigned int newJointIndex = static_cast<unsigned int>(RearrangeBonesHelpers::GetNewJointIndex(jointMap, oldJointIndex));
       fastClip.SetJointIDOfTransformTrack(transfTrackIndex, newJointIndex);
    }
 }
 
-void RearrangeMesh(AnimatedMesh& mesh, JointMap& jointMap)
+void RearrangeMesh(AnimatedMesh& mesh, const JointMap& jointMap)
 {
    std::vector<glm::ivec4>& influences = mesh.GetInfluences();
 
-   // Loop over all the influences of the mesh
-   for (unsigned int influenceIndex = 0,
-        numInfluences = static_cast<unsigned int>(influences.size());
-        influenceIndex < numInfluences;
-        ++influenceIndex)
+   // Update the indices of the influencing joints
+   // The components of the influences are stored contiguously, so they are remapped as a single flat array
+   if (!influences.empty())
    {
-      // Update the indices of the influencing joints
-      influences[influenceIndex].x = jointMap[influences[influenceIndex].x];
-      influences[influenceIndex].y = jointMap[influences[influenceIndex].y];
-      influences[influenceIndex].z = jointMap[influences[influenceIndex].z];
-      influences[influenceIndex].w = jointMap[influences[influenceIndex].w];
+      RearrangeBonesHelpers::RemapJointIndices(glm::value_ptr(influences[0]), static_cast<unsigned int>(influences.size() * 4), jointMap);
    }
-
-   // TODO: This is inefficient. We only need to load the influences.
-   //       To fix this, create functions like LoadPositions, LoadNormals, etc.
-   mesh.LoadBuffers();
 }
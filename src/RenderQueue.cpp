@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include "RenderQueue.h"
+
+namespace RenderQueueHelpers
+{
+   // The sort key is made of 16 bits for the shader, 24 bits for the first texture and 24 bits for the VAO
+   // Changing the program is the most expensive state change, so it's stored in the most significant bits
+   unsigned long long CalculateSortKey(const RenderQueue::DrawItem& item)
+   {
+      const unsigned long long shaderBits  = item.shader->getID() & 0xFFFF;
+      const unsigned long long textureBits = item.textures[0] & 0xFFFFFF;
+      const unsigned long long vaoBits     = item.vertexArray & 0xFFFFFF;
+      return (shaderBits << 48) | (textureBits << 24) | vaoBits;
+   }
+}
+
+RenderQueue::RenderQueue()
+   : mItems()
+   , mShaderUniforms()
+   , mStateCache()
+   , mStatisticsOfCurrentFrame()
+   , mStatisticsOfLastFrame()
+{
+
+}
+
+void RenderQueue::BeginFrame()
+{
+   // Anything could have been bound since the last frame (e.g. by the loaders, the track visualizer or ImGui)
+   mStateCache.Invalidate();
+   mStateCache.ResetCounters();
+   mStatisticsOfCurrentFrame = Statistics();
+}
+
+void RenderQueue::EndFrame()
+{
+   mStateCache.RestoreDefaultState();
+
+   mStatisticsOfCurrentFrame.numIssuedStateCalls  = mStateCache.GetNumberOfIssuedCalls();
+   mStatisticsOfCurrentFrame.numSkippedStateCalls = mStateCache.GetNumberOfSkippedCalls();
+   mStatisticsOfLastFrame = mStatisticsOfCurrentFrame;
+}
+
+void RenderQueue::SetShaderUniforms(const std::shared_ptr<Shader>& shader, const std::function<void()>& setUniforms)
+{
+   mShaderUniforms[shader->getID()] = setUniforms;
+}
+
+void RenderQueue::Submit(const DrawItem& item)
+{
+   mItems.push_back(SortedDrawItem{RenderQueueHelpers::CalculateSortKey(item), item});
+}
+
+void RenderQueue::Execute()
+{
+   std::stable_sort(mItems.begin(), mItems.end(), [](const SortedDrawItem& lhs, const SortedDrawItem& rhs)
+   {
+      return lhs.sortKey < rhs.sortKey;
+   });
+
+   unsigned int programOfPreviousItem = 0;
+   for (unsigned int i = 0, size = static_cast<unsigned int>(mItems.size()); i < size; ++i)
+   {
+      const DrawItem& item = mItems[i].item;
+      unsigned int programID = item.shader->getID();
+
+      mStateCache.UseProgram(programID);
+      if (programID != programOfPreviousItem)
+      {
+         std::map<unsigned int, std::function<void()>>::iterator shaderUniformsIt = mShaderUniforms.find(programID);
+         if (shaderUniformsIt != mShaderUniforms.end())
+         {
+            shaderUniformsIt->second();
+         }
+
+         programOfPreviousItem = programID;
+      }
+
+      // Without the queue, each item would have used and unused its program and bound and unbound its VAO
+      mStatisticsOfCurrentFrame.numStateCallsWithoutQueue += 4;
+
+      for (unsigned int textureUnit = 0; textureUnit < maxNumTexturesPerItem; ++textureUnit)
+      {
+         if (item.textures[textureUnit] != 0)
+         {
+            mStateCache.BindTexture(textureUnit, item.textures[textureUnit]);
+            // The same goes for its textures, and each bind and unbind also changed the active texture unit
+            mStatisticsOfCurrentFrame.numStateCallsWithoutQueue += 4;
+         }
+      }
+
+      mStateCache.BindVertexArray(item.vertexArray);
+
+      item.draw();
+      ++mStatisticsOfCurrentFrame.numDrawCalls;
+   }
+
+   mItems.clear();
+   mShaderUniforms.clear();
+}
+
+const RenderQueue::Statistics& RenderQueue::GetStatisticsOfLastFrame() const
+{
+   return mStatisticsOfLastFrame;
+}
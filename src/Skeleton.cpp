@@ -4,6 +4,7 @@ Skeleton::Skeleton(const Pose& restPose, const Pose& bindPose, const std::vector
    : mRestPose(restPose)
    , mBindPose(bindPose)
    , mJointNames(jointNames)
+   , mJointHierarchy(restPose)
 {
    UpdateInverseBindPose();
 }
@@ -13,6 +14,7 @@ void Skeleton::Set(const Pose& restPose, const Pose& bindPose, const std::vector
    mRestPose   = restPose;
    mBindPose   = bindPose;
    mJointNames = jointNames;
+   mJointHierarchy.Set(mRestPose);
    UpdateInverseBindPose();
 }
 
@@ -41,6 +43,11 @@ std::string& Skeleton::GetJointName(unsigned int jointIndex)
    return mJointNames[jointIndex];
 }
 
+const JointHierarchy& Skeleton::GetJointHierarchy() const
+{
+   return mJointHierarchy;
+}
+
 void Skeleton::UpdateInverseBindPose()
 {
    unsigned int numJoints = mBindPose.GetNumberOfJoints();
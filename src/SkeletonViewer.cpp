@@ -4,48 +4,62 @@
 #include <glad/glad.h>
 #endif
 
+#include <utility>
+
 #include "resource_manager.h"
 #include "shader_loader.h"
 #include "SkeletonViewer.h"
 
-SkeletonViewer::SkeletonViewer()
+SkeletonViewer::SkeletonViewer(ResourceManager<Shader>& shaderManager)
    : mBonesVAO(0)
-   , mBonesVBO(0)
    , mJointsVAO(0)
    , mJointsVBO(0)
    , mJointsEBO(0)
+   , mPoseTexture(0)
+   , mJointInfoTexture(0)
+   , mNumJoints(0)
    , mBoneShader()
    , mJointShader()
+   , mBoneModelUniform()
+   , mJointModelUniform()
+   , mJointScaleFactorUniform()
+   , mJointIndexOfGlowingJointUniform()
+   , mJointEndOfGlowingSubtreeUniform()
    , mBoneColorPalette{glm::vec3(244.0f, 255.0f, 97.0f) / 255.0f, glm::vec3(168.0f, 255.0f, 62.0f) / 255.0f, glm::vec3(50.0f, 255.0f, 106.0f) / 255.0f}
-   , mBonePositions()
-   , mBoneColors()
    , mInitialized(false)
 {
    glGenVertexArrays(1, &mBonesVAO);
-   glGenBuffers(1, &mBonesVBO);
+
+   glGenTextures(1, &mPoseTexture);
+   glGenTextures(1, &mJointInfoTexture);
 
    glGenVertexArrays(1, &mJointsVAO);
    glGenBuffers(1, &mJointsVBO);
    glGenBuffers(1, &mJointsEBO);
 
-   mBoneShader = ResourceManager<Shader>().loadUnmanagedResource<ShaderLoader>("resources/shaders/bone.vert",
-                                                                               "resources/shaders/bone.frag");
+   mBoneShader = shaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/bone.vert", "resources/shaders/bone.frag"),
+                                                               "resources/shaders/bone.vert",
+                                                               "resources/shaders/bone.frag");
+   mBoneShader->use(true);
+   for (int i = 0; i < 3; ++i)
+   {
+      mBoneShader->setUniformVec3("colorPalette[" + std::to_string(i) + "]", mBoneColorPalette[i]);
+   }
+   mBoneShader->setUniformInt("poseTexture", 0);
+   mBoneShader->setUniformInt("jointInfoTexture", 1);
+   mBoneShader->use(false);
+   mBoneModelUniform = mBoneShader->getUniform<glm::mat4>("model");
 
-   mJointShader = ResourceManager<Shader>().loadUnmanagedResource<ShaderLoader>("resources/shaders/joint.vert",
-                                                                                "resources/shaders/joint.frag");
+   mJointShader = shaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/joint.vert", "resources/shaders/joint.frag"),
+                                                                "resources/shaders/joint.vert",
+                                                                "resources/shaders/joint.frag");
    mJointShader->use(true);
-   mJointShader->setUniformVec3("pointLights[0].worldPos", glm::vec3(0.0f, 2.0f, 10.0f));
-   mJointShader->setUniformVec3("pointLights[0].color", glm::vec3(1.0f, 1.0f, 1.0f));
-   mJointShader->setUniformFloat("pointLights[0].constantAtt", 1.0f);
-   mJointShader->setUniformFloat("pointLights[0].linearAtt", 0.01f);
-   mJointShader->setUniformFloat("pointLights[0].quadraticAtt", 0.0f);
-   mJointShader->setUniformVec3("pointLights[1].worldPos", glm::vec3(0.0f, 2.0f, -10.0f));
-   mJointShader->setUniformVec3("pointLights[1].color", glm::vec3(1.0f, 1.0f, 1.0f));
-   mJointShader->setUniformFloat("pointLights[1].constantAtt", 1.0f);
-   mJointShader->setUniformFloat("pointLights[1].linearAtt", 0.01f);
-   mJointShader->setUniformFloat("pointLights[1].quadraticAtt", 0.0f);
-   mJointShader->setUniformInt("numPointLightsInScene", 2);
+   mJointShader->setUniformInt("poseTexture", 0);
    mJointShader->use(false);
+   mJointModelUniform               = mJointShader->getUniform<glm::mat4>("model");
+   mJointScaleFactorUniform         = mJointShader->getUniform<float>("scaleFactor");
+   mJointIndexOfGlowingJointUniform = mJointShader->getUniform<int>("indexOfGlowingJoint");
+   mJointEndOfGlowingSubtreeUniform = mJointShader->getUniform<int>("endOfGlowingSubtree");
 
    LoadJointBuffers();
    ConfigureJointsVAO(mJointShader->getAttributeLocation("inPos"), mJointShader->getAttributeLocation("inNormal"));
@@ -54,107 +68,116 @@ SkeletonViewer::SkeletonViewer()
 SkeletonViewer::~SkeletonViewer()
 {
    glDeleteVertexArrays(1, &mBonesVAO);
-   glDeleteBuffers(1, &mBonesVBO);
 
    glDeleteVertexArrays(1, &mJointsVAO);
    glDeleteBuffers(1, &mJointsVBO);
    glDeleteBuffers(1, &mJointsEBO);
+
+   glDeleteTextures(1, &mPoseTexture);
+   glDeleteTextures(1, &mJointInfoTexture);
 }
 
 SkeletonViewer::SkeletonViewer(SkeletonViewer&& rhs) noexcept
    : mBonesVAO(std::exchange(rhs.mBonesVAO, 0))
-   , mBonesVBO(std::exchange(rhs.mBonesVBO, 0))
    , mJointsVAO(std::exchange(rhs.mJointsVAO, 0))
    , mJointsVBO(std::exchange(rhs.mJointsVBO, 0))
    , mJointsEBO(std::exchange(rhs.mJointsEBO, 0))
+   , mPoseTexture(std::exchange(rhs.mPoseTexture, 0))
+   , mJointInfoTexture(std::exchange(rhs.mJointInfoTexture, 0))
+   , mNumJoints(rhs.mNumJoints)
    , mBoneShader(std::move(rhs.mBoneShader))
    , mJointShader(std::move(rhs.mJointShader))
+   , mBoneModelUniform(rhs.mBoneModelUniform)
+   , mJointModelUniform(rhs.mJointModelUniform)
+   , mJointScaleFactorUniform(rhs.mJointScaleFactorUniform)
+   , mJointIndexOfGlowingJointUniform(rhs.mJointIndexOfGlowingJointUniform)
+   , mJointEndOfGlowingSubtreeUniform(rhs.mJointEndOfGlowingSubtreeUniform)
    , mBoneColorPalette(std::move(rhs.mBoneColorPalette))
-   , mBonePositions(std::move(rhs.mBonePositions))
-   , mBoneColors(std::move(rhs.mBoneColors))
+   , mInitialized(rhs.mInitialized)
 {
 
 }
 
 SkeletonViewer& SkeletonViewer::operator=(SkeletonViewer&& rhs) noexcept
 {
-   mBonesVAO         = std::exchange(rhs.mBonesVAO, 0);
-   mBonesVBO         = std::exchange(rhs.mBonesVBO, 0);
-   mJointsVAO        = std::exchange(rhs.mJointsVAO, 0);
-   mJointsVBO        = std::exchange(rhs.mJointsVBO, 0);
-   mJointsEBO        = std::exchange(rhs.mJointsEBO, 0);
-   mBoneShader       = std::move(rhs.mBoneShader);
-   mJointShader      = std::move(rhs.mJointShader);
-   mBoneColorPalette = std::move(rhs.mBoneColorPalette);
-   mBonePositions    = std::move(rhs.mBonePositions);
-   mBoneColors       = std::move(rhs.mBoneColors);
+   mBonesVAO                        = std::exchange(rhs.mBonesVAO, 0);
+   mJointsVAO                       = std::exchange(rhs.mJointsVAO, 0);
+   mJointsVBO                       = std::exchange(rhs.mJointsVBO, 0);
+   mJointsEBO                       = std::exchange(rhs.mJointsEBO, 0);
+   mPoseTexture                     = std::exchange(rhs.mPoseTexture, 0);
+   mJointInfoTexture                = std::exchange(rhs.mJointInfoTexture, 0);
+   mNumJoints                       = rhs.mNumJoints;
+   mBoneShader                      = std::move(rhs.mBoneShader);
+   mJointShader                     = std::move(rhs.mJointShader);
+   mBoneModelUniform                = rhs.mBoneModelUniform;
+   mJointModelUniform               = rhs.mJointModelUniform;
+   mJointScaleFactorUniform         = rhs.mJointScaleFactorUniform;
+   mJointIndexOfGlowingJointUniform = rhs.mJointIndexOfGlowingJointUniform;
+   mJointEndOfGlowingSubtreeUniform = rhs.mJointEndOfGlowingSubtreeUniform;
+   mBoneColorPalette                = std::move(rhs.mBoneColorPalette);
+   mInitialized                     = rhs.mInitialized;
    return *this;
 }
 
 void SkeletonViewer::InitializeBones(const Pose& pose)
 {
-   if (mInitialized)
-   {
-      // Reset
-      glDeleteVertexArrays(1, &mBonesVAO);
-      glDeleteBuffers(1, &mBonesVBO);
+   // The textures are simply reallocated when the skeleton changes, so there's nothing to reset here
+   mNumJoints = pose.GetNumberOfJoints();
 
-      glGenVertexArrays(1, &mBonesVAO);
-      glGenBuffers(1, &mBonesVBO);
+   LoadJointInfoTexture(pose);
+   AllocatePoseTexture();
+   mInitialized = true;
+}
 
-      mBonePositions.clear();
-      mBoneColors.clear();
+void SkeletonViewer::UpdateBones(const std::vector<glm::mat4>& animatedPosePalette)
+{
+   if (mNumJoints == 0)
+   {
+      return;
    }
 
-   ResizeBoneContainers(pose);
-   ConfigureBonesVAO(mBoneShader->getAttributeLocation("inPos"), mBoneShader->getAttributeLocation("inCol"));
-   mInitialized = true;
+   // A glm::mat4 is stored as 4 contiguous columns, so the palette can be uploaded as is,
+   // and the shaders do all the per-joint work
+   glBindTexture(GL_TEXTURE_2D, mPoseTexture);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, mNumJoints, GL_RGBA, GL_FLOAT, &animatedPosePalette[0]);
+   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void SkeletonViewer::UpdateBones(const Pose& animatedPose, const std::vector<glm::mat4>& animatedPosePalette)
+void SkeletonViewer::LoadJointInfoTexture(const Pose& pose)
 {
-   int posIndex = 0;
-   int colorIndex = 0;
+   // Each bone connects a joint to its parent, and the bones are colored in order with the colors of the palette
+   // The joints that don't have a parent use themselves as their parent, so they produce lines with zero length
+   std::vector<glm::ivec2> jointInfo(mNumJoints);
    int colorPaletteIndex = 0;
-   int parentJointIndex = -1;
-   unsigned int numJoints = animatedPose.GetNumberOfJoints();
-   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   for (unsigned int jointIndex = 0; jointIndex < mNumJoints; ++jointIndex)
    {
-      parentJointIndex = animatedPose.GetParent(jointIndex);
+      int parentJointIndex = pose.GetParent(jointIndex);
       if (parentJointIndex < 0)
       {
+         jointInfo[jointIndex] = glm::ivec2(jointIndex, 0);
          continue;
       }
 
-      // Store the position of the child joint followed by the position of its parent joint
-      // That way, they will be rendered as a line
-      mBonePositions[posIndex++] = animatedPosePalette[jointIndex][3];
-      mBonePositions[posIndex++] = animatedPosePalette[parentJointIndex][3];
-
-      colorPaletteIndex %= 3;
-      mBoneColors[colorIndex++] = mBoneColorPalette[colorPaletteIndex];
-      mBoneColors[colorIndex++] = mBoneColorPalette[colorPaletteIndex];
-      ++colorPaletteIndex;
+      jointInfo[jointIndex] = glm::ivec2(parentJointIndex, colorPaletteIndex);
+      colorPaletteIndex = (colorPaletteIndex + 1) % 3;
    }
 
-   LoadBoneBuffers();
+   glBindTexture(GL_TEXTURE_2D, mJointInfoTexture);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32I, mNumJoints, 1, 0, GL_RG_INTEGER, GL_INT, mNumJoints > 0 ? &jointInfo[0] : nullptr);
+   // Integer textures can't be filtered, and the textures are only read with texelFetch anyway
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-// TODO: Experiment with GL_STATIC_DRAW, GL_STREAM_DRAW and GL_DYNAMIC_DRAW to see which is faster
-void SkeletonViewer::LoadBoneBuffers()
+void SkeletonViewer::AllocatePoseTexture()
 {
-   glBindVertexArray(mBonesVAO);
-
-   glBindBuffer(GL_ARRAY_BUFFER, mBonesVBO);
-   // Set the size of the buffer that contains the positions and the colors
-   glBufferData(GL_ARRAY_BUFFER, (mBonePositions.size() + mBoneColors.size()) * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW); // TODO: GL_DYNAMIC?
-   // Positions
-   glBufferSubData(GL_ARRAY_BUFFER, 0, mBonePositions.size() * sizeof(glm::vec3), &mBonePositions[0]);
-   // Colors
-   glBufferSubData(GL_ARRAY_BUFFER, mBonePositions.size() * sizeof(glm::vec3), mBoneColors.size() * sizeof(glm::vec3), &mBoneColors[0]);
-   glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-   glBindVertexArray(0);
+   glBindTexture(GL_TEXTURE_2D, mPoseTexture);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, mNumJoints, 0, GL_RGBA, GL_FLOAT, nullptr);
+   // Float textures aren't filterable in WebGL 2
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 // TODO: Experiment with GL_STATIC_DRAW, GL_STREAM_DRAW and GL_DYNAMIC_DRAW to see which is faster
@@ -199,31 +222,6 @@ void SkeletonViewer::LoadJointBuffers()
    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void SkeletonViewer::ConfigureBonesVAO(int posAttribLocation, int colorAttribLocation)
-{
-   glBindVertexArray(mBonesVAO);
-
-   // Set the vertex attribute pointers
-
-   if (posAttribLocation >= 0)
-   {
-      glBindBuffer(GL_ARRAY_BUFFER, mBonesVBO);
-      glEnableVertexAttribArray(posAttribLocation);
-      glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-   }
-
-   if (colorAttribLocation >= 0)
-   {
-      glBindBuffer(GL_ARRAY_BUFFER, mBonesVBO);
-      glEnableVertexAttribArray(colorAttribLocation);
-      glVertexAttribPointer(colorAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)(mBonePositions.size() * sizeof(glm::vec3)));
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-   }
-
-   glBindVertexArray(0);
-}
-
 void SkeletonViewer::ConfigureJointsVAO(int posAttribLocation, int normalAttribLocation)
 {
    glBindVertexArray(mJointsVAO);
@@ -249,81 +247,55 @@ void SkeletonViewer::ConfigureJointsVAO(int posAttribLocation, int normalAttribL
    glBindVertexArray(0);
 }
 
-void SkeletonViewer::RenderBones(const Transform& model, const glm::mat4& projectionView)
-{
-   mBoneShader->use(true);
-   mBoneShader->setUniformMat4("model", transformToMat4(model));
-   mBoneShader->setUniformMat4("projectionView", projectionView);
-   glBindVertexArray(mBonesVAO);
-   glDrawArrays(GL_LINES, 0, static_cast<unsigned int>(mBonePositions.size()));
-   glBindVertexArray(0);
-   mBoneShader->use(false);
-}
-
-void SkeletonViewer::RenderJoints(const Transform& model, const glm::mat4& projectionView, const std::vector<glm::mat4>& animatedPosePalette, float scaleFactor, int indexOfGlowingJoint)
+void SkeletonViewer::SubmitBones(RenderQueue& renderQueue, const Transform& model)
 {
-   // We need to combine 3 transforms:
-   // - The model transform of the entire 3D character
-   // - The transform of each joint
-   // - The scale transform that increases the size of the little pyramids
-   // The order is simple:
-   // - The model transform is applied first
-   // - The transform of each joint is applied second as a child of the model transform
-   // - The scale transform is applied third as a child of the previous two transforms
-   // What does this look like?
-   // 1) Place the pyramids in the right place with the right orientation/scale
-   // 2) Place the pyramids at the right joints with the right orientations/scales
-   // 3) Scale the pyramids in place at their joints
-
-   // Scale transform to increase the size of the little pyramids that represent the joints
-   Transform jointScale(glm::vec3(0.0f, 0.0f, 0.0f), Q::quat(), glm::vec3(scaleFactor));
-
-   // Loop over all the transforms of the pose
-   std::vector<glm::mat4> combinedTransforms(animatedPosePalette.size());
-   for (unsigned int i = 0; i < static_cast<unsigned int>(combinedTransforms.size()); ++i)
+   if (!mInitialized || mNumJoints == 0)
    {
-      // Combine the transforms and store the result
-      Transform modelFirstThenPose = combine(model, mat4ToTransform(animatedPosePalette[i]));
-      Transform modelFirstThenPoseThenScale;
-      if (i == indexOfGlowingJoint)
-      {
-         modelFirstThenPoseThenScale = combine(modelFirstThenPose, Transform(glm::vec3(0.0f, 0.0f, 0.0f), Q::quat(), glm::vec3(scaleFactor * 3.5f)));
-      }
-      else
-      {
-         modelFirstThenPoseThenScale = combine(modelFirstThenPose, jointScale);
-      }
-      combinedTransforms[i] = transformToMat4(modelFirstThenPoseThenScale);
+      return;
    }
 
-   // Render the joints
-   mJointShader->use(true);
-   mJointShader->setUniformMat4("projectionView", projectionView);
-   mJointShader->setUniformMat4Array("modelMatrices[0]", combinedTransforms);
-   mJointShader->setUniformInt("indexOfGlowingJoint", indexOfGlowingJoint);
-   glBindVertexArray(mJointsVAO);
-   glDrawElementsInstanced(GL_TRIANGLES, 24, GL_UNSIGNED_INT, 0, static_cast<unsigned int>(animatedPosePalette.size()));
-   glBindVertexArray(0);
-   mJointShader->use(false);
+   glm::mat4 modelMatrix = transformToMat4(model);
+   Uniform<glm::mat4> modelUniform = mBoneModelUniform;
+   renderQueue.SetShaderUniforms(mBoneShader, [modelUniform, modelMatrix]()
+   {
+      modelUniform.set(modelMatrix);
+   });
+
+   // Each joint is expanded into 2 vertices by bone.vert
+   unsigned int numVertices = mNumJoints * 2;
+   renderQueue.Submit(RenderQueue::DrawItem{mBoneShader, mBonesVAO, {mPoseTexture, mJointInfoTexture}, [numVertices]()
+   {
+      glDrawArrays(GL_LINES, 0, numVertices);
+   }});
 }
 
-void SkeletonViewer::ResizeBoneContainers(const Pose& animatedPose)
+void SkeletonViewer::SubmitJoints(RenderQueue& renderQueue, const Transform& model, float scaleFactor, int indexOfGlowingJoint, int endOfGlowingSubtree)
 {
-   unsigned int numPointsOfSkeleton = 0;
-   unsigned int numJoints = animatedPose.GetNumberOfJoints();
-   for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+   if (!mInitialized || mNumJoints == 0)
    {
-      // If the current joint doesn't have a parent, we can't create a line that connects it to its parent,
-      // so we don't increase the number of points of the skeleton
-      if (animatedPose.GetParent(jointIndex) < 0)
-      {
-         continue;
-      }
-
-      // Increase the number of points of the skeleton by two (one for the child joint and one for its parent joint)
-      numPointsOfSkeleton += 2;
+      return;
    }
 
-   mBonePositions.resize(numPointsOfSkeleton);
-   mBoneColors.resize(numPointsOfSkeleton);
+   // joint.vert combines 3 transforms for each instance:
+   // - The model transform of the entire 3D character
+   // - The transform of the joint, which is fetched from the pose texture
+   // - The scale transform that increases the size of the little pyramids
+   glm::mat4 modelMatrix = transformToMat4(model);
+   Uniform<glm::mat4> modelUniform               = mJointModelUniform;
+   Uniform<float>     scaleFactorUniform         = mJointScaleFactorUniform;
+   Uniform<int>       indexOfGlowingJointUniform = mJointIndexOfGlowingJointUniform;
+   Uniform<int>       endOfGlowingSubtreeUniform = mJointEndOfGlowingSubtreeUniform;
+   renderQueue.SetShaderUniforms(mJointShader, [=]()
+   {
+      modelUniform.set(modelMatrix);
+      scaleFactorUniform.set(scaleFactor);
+      indexOfGlowingJointUniform.set(indexOfGlowingJoint);
+      endOfGlowingSubtreeUniform.set(endOfGlowingSubtree);
+   });
+
+   unsigned int numInstances = mNumJoints;
+   renderQueue.Submit(RenderQueue::DrawItem{mJointShader, mJointsVAO, {mPoseTexture, 0}, [numInstances]()
+   {
+      glDrawElementsInstanced(GL_TRIANGLES, 24, GL_UNSIGNED_INT, 0, numInstances);
+   }});
 }
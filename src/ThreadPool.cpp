@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+
+#ifdef __EMSCRIPTEN__
+ThreadPool::ThreadPool(unsigned int /*numThreads*/)
+{
+
+}
+
+ThreadPool::~ThreadPool()
+{
+
+}
+
+void ThreadPool::Submit(const std::function<void()>& job)
+{
+   job();
+}
+
+unsigned int ThreadPool::GetNumberOfThreads() const
+{
+   return 0;
+}
+#else
+ThreadPool::ThreadPool(unsigned int numThreads)
+   : mThreads()
+   , mJobs()
+   , mMutex()
+   , mJobsAvailable()
+   , mStopping(false)
+{
+   if (numThreads == 0)
+   {
+      // hardware_concurrency can return 0 when the number of hardware threads can't be determined
+      unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+      numThreads = (numHardwareThreads > 1) ? (numHardwareThreads - 1) : 1;
+   }
+
+   mThreads.reserve(numThreads);
+   for (unsigned int i = 0; i < numThreads; ++i)
+   {
+      mThreads.emplace_back(&ThreadPool::ExecuteJobs, this);
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   // The jobs that are still queued are executed before the threads exit
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+   }
+   mJobsAvailable.notify_all();
+
+   for (std::thread& thread : mThreads)
+   {
+      thread.join();
+   }
+}
+
+void ThreadPool::Submit(const std::function<void()>& job)
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mJobs.push_back(job);
+   }
+   mJobsAvailable.notify_one();
+}
+
+unsigned int ThreadPool::GetNumberOfThreads() const
+{
+   return static_cast<unsigned int>(mThreads.size());
+}
+
+void ThreadPool::ExecuteJobs()
+{
+   while (true)
+   {
+      std::function<void()> job;
+
+      {
+         std::unique_lock<std::mutex> lock(mMutex);
+         mJobsAvailable.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+
+         if (mJobs.empty())
+         {
+            // We only get here when the pool is stopping
+            return;
+         }
+
+         job = std::move(mJobs.front());
+         mJobs.pop_front();
+      }
+
+      job();
+   }
+}
+#endif
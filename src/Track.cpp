@@ -1,5 +1,8 @@
 #include <glm/gtx/compatibility.hpp>
 
+#include <cstring>
+#include <limits>
+
 #include "Track.h"
 
 namespace TrackHelpers
@@ -17,6 +20,144 @@ namespace TrackHelpers
    void      NeighborhoodCheck(const float& a, float& b)         { }
    void      NeighborhoodCheck(const glm::vec3& a, glm::vec3& b) { }
    void      NeighborhoodCheck(const Q::quat& a, Q::quat& b)     { if (Q::dot(a, b) < 0) b = -b; }
+
+   // Appends the roots of a * t^2 + b * t + c that are inside (0, 1)
+   void AddQuadraticRootsInUnitInterval(float a, float b, float c, std::vector<float>& ioRoots)
+   {
+      const float epsilon = 1e-8f;
+
+      if (glm::abs(a) < epsilon)
+      {
+         if (glm::abs(b) >= epsilon)
+         {
+            float root = -c / b;
+            if (root > 0.0f && root < 1.0f) ioRoots.push_back(root);
+         }
+         return;
+      }
+
+      float discriminant = (b * b) - (4.0f * a * c);
+      if (discriminant < 0.0f)
+      {
+         return;
+      }
+
+      float squareRootOfDiscriminant = glm::sqrt(discriminant);
+      float firstRoot  = (-b - squareRootOfDiscriminant) / (2.0f * a);
+      float secondRoot = (-b + squareRootOfDiscriminant) / (2.0f * a);
+      if (firstRoot > 0.0f && firstRoot < 1.0f)   ioRoots.push_back(firstRoot);
+      if (secondRoot > 0.0f && secondRoot < 1.0f) ioRoots.push_back(secondRoot);
+   }
+
+   // Each of the functions below appends the interpolation factors inside (0, 1) at which a component of an interpolated value
+   // can reach an extremum, which are the only places other than the endpoints of a segment where its bounds can be found
+
+   // Linear interpolation is monotonic for floats and vectors
+   void AddCriticalPointsOfInterpolation(const float&, const float&, std::vector<float>&)         { }
+   void AddCriticalPointsOfInterpolation(const glm::vec3&, const glm::vec3&, std::vector<float>&) { }
+
+   // nlerp normalizes the result of a linear interpolation, so each component is (a_k + t * d_k) / |a + t * d|
+   // Setting the derivative of that to zero produces a linear equation in t:
+   // (d_k * A - a_k * B) + t * (d_k * B - a_k * C) = 0, where A = a.a, B = a.d and C = d.d
+   void AddCriticalPointsOfInterpolation(const Q::quat& a, const Q::quat& b, std::vector<float>& ioCriticalPoints)
+   {
+      Q::quat adjustedB = b;
+      NeighborhoodCheck(a, adjustedB);
+
+      glm::vec4 start = glm::vec4(a.x, a.y, a.z, a.w);
+      glm::vec4 delta = glm::vec4(adjustedB.x, adjustedB.y, adjustedB.z, adjustedB.w) - start;
+      float A = glm::dot(start, start);
+      float B = glm::dot(start, delta);
+      float C = glm::dot(delta, delta);
+      for (int k = 0; k < 4; ++k)
+      {
+         AddQuadraticRootsInUnitInterval(0.0f, (delta[k] * B) - (start[k] * C), (delta[k] * A) - (start[k] * B), ioCriticalPoints);
+      }
+   }
+
+   // A cubic Hermite spline can be written as a3 * t^3 + a2 * t^2 + a1 * t + a0, so the roots of its derivative
+   // are the roots of 3 * a3 * t^2 + 2 * a2 * t + a1
+   void AddCriticalPointsOfCubicHermiteSpline(const float& p1, const float& m1, const float& p2, const float& m2, std::vector<float>& ioCriticalPoints)
+   {
+      float a3 = (2.0f * p1) + m1 - (2.0f * p2) + m2;
+      float a2 = (-3.0f * p1) - (2.0f * m1) + (3.0f * p2) - m2;
+      float a1 = m1;
+      AddQuadraticRootsInUnitInterval(3.0f * a3, 2.0f * a2, a1, ioCriticalPoints);
+   }
+
+   void AddCriticalPointsOfCubicHermiteSpline(const glm::vec3& p1, const glm::vec3& m1, const glm::vec3& p2, const glm::vec3& m2, std::vector<float>& ioCriticalPoints)
+   {
+      for (int k = 0; k < 3; ++k)
+      {
+         AddCriticalPointsOfCubicHermiteSpline(p1[k], m1[k], p2[k], m2[k], ioCriticalPoints);
+      }
+   }
+
+   // The result of the spline is normalized for quaternions, so each component is H_k(t) / |H(t)|
+   // The roots of its derivative are the roots of H'_k(t) * |H(t)|^2 - H_k(t) * (H(t) . H'(t)), which is a polynomial of degree 5,
+   // so instead of solving it we look for sign changes over small intervals and refine them with bisection
+   void AddCriticalPointsOfCubicHermiteSpline(const Q::quat& p1, const Q::quat& m1, const Q::quat& p2, const Q::quat& m2, std::vector<float>& ioCriticalPoints)
+   {
+      Q::quat adjustedP2 = p2;
+      NeighborhoodCheck(p1, adjustedP2);
+
+      glm::vec4 vP1 = glm::vec4(p1.x, p1.y, p1.z, p1.w);
+      glm::vec4 vM1 = glm::vec4(m1.x, m1.y, m1.z, m1.w);
+      glm::vec4 vP2 = glm::vec4(adjustedP2.x, adjustedP2.y, adjustedP2.z, adjustedP2.w);
+      glm::vec4 vM2 = glm::vec4(m2.x, m2.y, m2.z, m2.w);
+
+      glm::vec4 a3 = (2.0f * vP1) + vM1 - (2.0f * vP2) + vM2;
+      glm::vec4 a2 = (-3.0f * vP1) - (2.0f * vM1) + (3.0f * vP2) - vM2;
+      glm::vec4 a1 = vM1;
+      glm::vec4 a0 = vP1;
+
+      auto derivativeOfComponent = [&](int k, float t)
+      {
+         glm::vec4 h           = (((a3 * t) + a2) * t + a1) * t + a0;
+         glm::vec4 hDerivative = ((3.0f * a3 * t) + (2.0f * a2)) * t + a1;
+         return (hDerivative[k] * glm::dot(h, h)) - (h[k] * glm::dot(h, hDerivative));
+      };
+
+      const int numIntervals      = 32;
+      const int numBisectionSteps = 24;
+      for (int k = 0; k < 4; ++k)
+      {
+         float startOfInterval = 0.0f;
+         float derivativeAtStartOfInterval = derivativeOfComponent(k, startOfInterval);
+         for (int intervalIndex = 1; intervalIndex <= numIntervals; ++intervalIndex)
+         {
+            float endOfInterval = static_cast<float>(intervalIndex) / static_cast<float>(numIntervals);
+            float derivativeAtEndOfInterval = derivativeOfComponent(k, endOfInterval);
+
+            if ((derivativeAtStartOfInterval < 0.0f) != (derivativeAtEndOfInterval < 0.0f))
+            {
+               float low  = startOfInterval;
+               float high = endOfInterval;
+               float derivativeAtLow = derivativeAtStartOfInterval;
+               for (int step = 0; step < numBisectionSteps; ++step)
+               {
+                  float middle = (low + high) * 0.5f;
+                  float derivativeAtMiddle = derivativeOfComponent(k, middle);
+                  if ((derivativeAtLow < 0.0f) == (derivativeAtMiddle < 0.0f))
+                  {
+                     low = middle;
+                     derivativeAtLow = derivativeAtMiddle;
+                  }
+                  else
+                  {
+                     high = middle;
+                  }
+               }
+
+               float root = (low + high) * 0.5f;
+               if (root > 0.0f && root < 1.0f) ioCriticalPoints.push_back(root);
+            }
+
+            startOfInterval = endOfInterval;
+            derivativeAtStartOfInterval = derivativeAtEndOfInterval;
+         }
+      }
+   }
 };
 
 // Track
@@ -24,12 +165,22 @@ namespace TrackHelpers
 template<typename T, unsigned int N>
 Track<T, N>::Track()
    : mInterpolation(Interpolation::Linear)
+   , mBoundsAreValid(false)
+   , mMinValues()
+   , mMaxValues()
 {
 
 }
 
 template<typename T, unsigned int N>
 Frame<N>& Track<T, N>::GetFrame(unsigned int frameIndex)
+{
+   mBoundsAreValid = false;
+   return mFrames[frameIndex];
+}
+
+template<typename T, unsigned int N>
+const Frame<N>& Track<T, N>::GetFrame(unsigned int frameIndex) const
 {
    return mFrames[frameIndex];
 }
@@ -38,6 +189,7 @@ template<typename T, unsigned int N>
 void Track<T, N>::SetFrame(unsigned int frameIndex, const Frame<N>& frame)
 {
    mFrames[frameIndex] = frame;
+   mBoundsAreValid = false;
 }
 
 template<typename T, unsigned int N>
@@ -50,6 +202,7 @@ template<typename T, unsigned int N>
 void Track<T, N>::SetNumberOfFrames(unsigned int numFrames)
 {
    mFrames.resize(numFrames);
+   mBoundsAreValid = false;
 }
 
 template<typename T, unsigned int N>
@@ -62,6 +215,7 @@ template<typename T, unsigned int N>
 void Track<T, N>::SetInterpolation(Interpolation interpolation)
 {
    mInterpolation = interpolation;
+   mBoundsAreValid = false;
 }
 
 template<typename T, unsigned int N>
@@ -344,6 +498,114 @@ T Track<T, N>::SampleCubic(float time, bool looping) const
    return InterpolateUsingCubicHermiteSpline(t, p1, outTangentOfP1, p2, inTangentOfP2);
 }
 
+template<typename T, unsigned int N>
+void Track<T, N>::GetBounds(T& outMin, T& outMax) const
+{
+   if (!mBoundsAreValid)
+   {
+      CalculateBounds();
+      mBoundsAreValid = true;
+   }
+
+   memcpy(&outMin, mMinValues, N * sizeof(float));
+   memcpy(&outMax, mMaxValues, N * sizeof(float));
+}
+
+template<typename T, unsigned int N>
+void Track<T, N>::CalculateBounds() const
+{
+   for (unsigned int k = 0; k < N; ++k)
+   {
+      mMinValues[k] = std::numeric_limits<float>::max();
+      mMaxValues[k] = std::numeric_limits<float>::lowest();
+   }
+
+   unsigned int numFrames = static_cast<unsigned int>(mFrames.size());
+   if (numFrames <= 1)
+   {
+      // Sampling an invalid track always returns a zero float, zero vector or unit quaternion
+      ExpandBounds(T());
+      return;
+   }
+
+   if (mInterpolation == Interpolation::Constant)
+   {
+      // The value of the last frame is never returned, since there isn't a frame after it to interpolate with
+      for (unsigned int frameIndex = 0; frameIndex < numFrames - 1; ++frameIndex)
+      {
+         ExpandBounds(Cast(&mFrames[frameIndex].mValue[0]));
+      }
+      return;
+   }
+
+   // Each segment can only reach its extrema at its endpoints or at the critical points of its components
+   std::vector<float> interpolationFactors;
+   for (unsigned int thisFrame = 0; thisFrame < numFrames - 1; ++thisFrame)
+   {
+      unsigned int nextFrame = thisFrame + 1;
+      float timeBetweenFrames = mFrames[nextFrame].mTime - mFrames[thisFrame].mTime;
+      if (timeBetweenFrames <= 0.0f)
+      {
+         // Segments with no duration can't be sampled
+         continue;
+      }
+
+      T p1 = Cast(&mFrames[thisFrame].mValue[0]);
+      T p2 = Cast(&mFrames[nextFrame].mValue[0]);
+
+      interpolationFactors.clear();
+      interpolationFactors.push_back(0.0f);
+      interpolationFactors.push_back(1.0f);
+
+      if (mInterpolation == Interpolation::Linear)
+      {
+         TrackHelpers::AddCriticalPointsOfInterpolation(p1, p2, interpolationFactors);
+
+         for (float t : interpolationFactors)
+         {
+            ExpandBounds(TrackHelpers::Interpolate(p1, p2, t));
+         }
+      }
+      else
+      {
+         // See SampleCubic for an explanation of why we use memcpy here
+         T outSlopeOfP1;
+         memcpy(&outSlopeOfP1, mFrames[thisFrame].mOutSlope, N * sizeof(float));
+         T outTangentOfP1 = outSlopeOfP1 * timeBetweenFrames;
+
+         T inSlopeOfP2;
+         memcpy(&inSlopeOfP2, mFrames[nextFrame].mInSlope, N * sizeof(float));
+         T inTangentOfP2 = inSlopeOfP2 * timeBetweenFrames;
+
+         TrackHelpers::AddCriticalPointsOfCubicHermiteSpline(p1, outTangentOfP1, p2, inTangentOfP2, interpolationFactors);
+
+         for (float t : interpolationFactors)
+         {
+            ExpandBounds(InterpolateUsingCubicHermiteSpline(t, p1, outTangentOfP1, p2, inTangentOfP2));
+         }
+      }
+   }
+
+   if (mMinValues[0] > mMaxValues[0])
+   {
+      // None of the segments could be sampled
+      ExpandBounds(T());
+   }
+}
+
+template<typename T, unsigned int N>
+void Track<T, N>::ExpandBounds(const T& value) const
+{
+   float components[N];
+   memcpy(components, &value, N * sizeof(float));
+
+   for (unsigned int k = 0; k < N; ++k)
+   {
+      if (components[k] < mMinValues[k]) mMinValues[k] = components[k];
+      if (components[k] > mMaxValues[k]) mMaxValues[k] = components[k];
+   }
+}
+
 // FastTrack
 
 template<typename T, unsigned int N>
@@ -465,6 +727,12 @@ void FastTrack<T, N>::GenerateSampleToFrameIndexMap()
    }
 }
 
+template<typename T, unsigned int N>
+unsigned int FastTrack<T, N>::GetSizeOfSampleToFrameIndexMap() const
+{
+   return static_cast<unsigned int>(mSampleToFrameIndexMap.size());
+}
+
 template<typename T, unsigned int N>
 FastTrack<T, N> OptimizeTrack(Track<T, N>& track)
 {
@@ -6,11 +6,50 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstddef>
+#include <cmath>
+
 #include "resource_manager.h"
 #include "shader_loader.h"
 #include "TrackVisualizer.h"
 
-TrackVisualizer::TrackVisualizer()
+namespace TrackVisualizerHelpers
+{
+   // Returns true if all the samples of the track are the same, which only requires looking at its keyframes
+   bool IsTrackConstant(const FastQuaternionTrack& track)
+   {
+      unsigned int numFrames = track.GetNumberOfFrames();
+      if (numFrames <= 1)
+      {
+         // Tracks with one frame or less are invalid, and sampling them always returns the identity quaternion
+         return true;
+      }
+
+      const QuaternionFrame& firstFrame = track.GetFrame(0);
+      bool isCubic = (track.GetInterpolation() == Interpolation::Cubic);
+      for (unsigned int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+      {
+         const QuaternionFrame& frame = track.GetFrame(frameIndex);
+         for (int k = 0; k < 4; ++k)
+         {
+            if (frame.mValue[k] != firstFrame.mValue[k])
+            {
+               return false;
+            }
+
+            // Cubic tracks with identical keyframes can still change between them if their slopes aren't zero
+            if (isCubic && (frame.mInSlope[k] != 0.0f || frame.mOutSlope[k] != 0.0f))
+            {
+               return false;
+            }
+         }
+      }
+
+      return true;
+   }
+}
+
+TrackVisualizer::TrackVisualizer(ResourceManager<Shader>& shaderManager)
    : mWidthOfGraphSpace(100.0f)
    , mHeightOfGraphSpace(100.0f)
    , mNumGraphs(0)
@@ -24,18 +63,29 @@ TrackVisualizer::TrackVisualizer()
    , mTileVerticalOffset(0.0f)
    , mGraphWidth(0.0f)
    , mGraphHeight(0.0f)
-   , mReferenceLinesVAO(0)
-   , mReferenceLinesVBO(0)
-   , mEmptyLinesVAO{0, 0, 0, 0}
-   , mEmptyLinesVBO{0, 0, 0, 0}
-   , mTrackLinesVAOs()
-   , mTrackLinesVBOs()
+   , mLinesVAO(0)
+   , mLinesVBO(0)
+   , mIndexOfFirstReferenceLineVertex(0)
+   , mIndexOfFirstRepeatedCurveVertex(0)
+   , mNumLineVertices(0)
+   , mEvaluateCurvesOnGPU(true)
+   , mNumSamplesPerCurve(600)
+   , mKeyframeCurvesVAO(0)
+   , mKeyframeTexture()
+   , mKeyframeTextureSizeInBytes(0)
+   , mMaxNumGraphsPerPage(36)
+   , mNumPages(1)
+   , mPage(0)
+   , mTracksOfAllPages()
+   , mTrackIndicesOfAllPages()
    , mTracks()
+   , mTrackIndices()
    , mMinSamples()
    , mInverseSampleRanges()
    , mReferenceLines()
    , mEmptyLines()
    , mTrackLines()
+   , mTimeOffset(0.0f)
    , mTrackLinesColorPalette{glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.65f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)}
    //, mSelectedTrackLinesColorPalette{glm::vec3(244.0f, 255.0f, 97.0f) / 255.0f, glm::vec3(168.0f, 255.0f, 62.0f) / 255.0f, glm::vec3(50.0f, 255.0f, 106.0f) / 255.0f, glm::vec3(50.0f, 255.0f, 106.0f) / 255.0f}
    , mSelectedTrackLinesColorPalette{glm::vec3(111, 231, 221) / 255.0f, glm::vec3(52, 144, 222) / 255.0f, glm::vec3(102, 57, 166) / 255.0f, glm::vec3(82, 18, 98) / 255.0f}
@@ -44,9 +94,67 @@ TrackVisualizer::TrackVisualizer()
    , mGraphUpperRightCorners()
    , mIndexOfSelectedGraph(-1)
    , mRightMouseButtonWasPressed(false)
+   , mCurrentCacheKey(0)
+   , mCurrentGraphSetIsCacheable(false)
+   , mCachedGraphSets()
+   , mLeastRecentlyUsedGraphSets()
+   , mCacheMemoryBudget(64 * 1024 * 1024)
+   , mCacheMemoryUsage(0)
 {
-   mTrackShader = ResourceManager<Shader>().loadUnmanagedResource<ShaderLoader>("resources/shaders/graph.vert",
-                                                                                "resources/shaders/graph.frag");
+   mTrackShader = shaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/graph.vert", "resources/shaders/graph.frag"),
+                                                                "resources/shaders/graph.vert",
+                                                                "resources/shaders/graph.frag");
+
+   // The palettes never change, so we only set them once
+   // The first 4 colors are used for the curves, and the last one is used for the reference lines
+   mTrackShader->use(true);
+   for (int i = 0; i < 4; ++i)
+   {
+      mTrackShader->setUniformVec3("colorPalette[" + std::to_string(i) + "]", mTrackLinesColorPalette[i]);
+      mTrackShader->setUniformVec3("selectedColorPalette[" + std::to_string(i) + "]", mSelectedTrackLinesColorPalette[i]);
+   }
+   mTrackShader->setUniformVec3("colorPalette[4]", glm::vec3(1.0f, 1.0f, 1.0f));
+   mTrackShader->setUniformVec3("selectedColorPalette[4]", glm::vec3(1.0f, 1.0f, 1.0f));
+   mTrackShader->use(false);
+
+   mTrackShaderUniforms.projectionView       = mTrackShader->getUniform<glm::mat4>("projectionView");
+   mTrackShaderUniforms.timeOffset           = mTrackShader->getUniform<float>("timeOffset");
+   mTrackShaderUniforms.graphWidth           = mTrackShader->getUniform<float>("graphWidth");
+   mTrackShaderUniforms.indexOfSelectedGraph = mTrackShader->getUniform<int>("indexOfSelectedGraph");
+
+   mKeyframeShader = shaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/graph_keyframes.vert", "resources/shaders/graph.frag"),
+                                                                   "resources/shaders/graph_keyframes.vert",
+                                                                   "resources/shaders/graph.frag");
+
+   mKeyframeShader->use(true);
+   for (int i = 0; i < 4; ++i)
+   {
+      mKeyframeShader->setUniformVec3("colorPalette[" + std::to_string(i) + "]", mTrackLinesColorPalette[i]);
+      mKeyframeShader->setUniformVec3("selectedColorPalette[" + std::to_string(i) + "]", mSelectedTrackLinesColorPalette[i]);
+   }
+   mKeyframeShader->use(false);
+
+   mKeyframeShaderUniforms.projectionView       = mKeyframeShader->getUniform<glm::mat4>("projectionView");
+   mKeyframeShaderUniforms.timeOffset           = mKeyframeShader->getUniform<float>("timeOffset");
+   mKeyframeShaderUniforms.graphWidth           = mKeyframeShader->getUniform<float>("graphWidth");
+   mKeyframeShaderUniforms.graphHeight          = mKeyframeShader->getUniform<float>("graphHeight");
+   mKeyframeShaderUniforms.numSamplesPerCurve   = mKeyframeShader->getUniform<int>("numSamplesPerCurve");
+   mKeyframeShaderUniforms.indexOfSelectedGraph = mKeyframeShader->getUniform<int>("indexOfSelectedGraph");
+   mKeyframeShaderUniforms.keyframes            = mKeyframeShader->getUniform<int>("keyframes");
+
+#ifndef __EMSCRIPTEN__
+   std::vector<std::string> capturedVaryings { "sampledRotation" };
+   mKeyframeCaptureShader = shaderManager.getOrLoadResource<ShaderLoader>(ShaderLoader::getResourceID("resources/shaders/graph_keyframes.vert", "resources/shaders/graph.frag", std::vector<std::string>(), capturedVaryings),
+                                                                          "resources/shaders/graph_keyframes.vert",
+                                                                          "resources/shaders/graph.frag",
+                                                                          std::vector<std::string>(),
+                                                                          capturedVaryings);
+   if (mKeyframeCaptureShader)
+   {
+      mKeyframeCaptureShaderUniforms.numSamplesPerCurve = mKeyframeCaptureShader->getUniform<int>("numSamplesPerCurve");
+      mKeyframeCaptureShaderUniforms.keyframes          = mKeyframeCaptureShader->getUniform<int>("keyframes");
+   }
+#endif
 
    glm::vec3 eye    = glm::vec3(0.0f, 0.0f, 5.0f);
    glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -67,59 +175,279 @@ TrackVisualizer::TrackVisualizer()
 
 TrackVisualizer::~TrackVisualizer()
 {
+   clearCache();
    deleteBuffers();
 }
 
 void TrackVisualizer::setTracks(std::vector<FastTransformTrack>& tracks)
+{
+   buildGraphSet(tracks);
+   mCurrentGraphSetIsCacheable = false;
+}
+
+void TrackVisualizer::setTracks(std::vector<FastTransformTrack>& tracks, unsigned long long cacheKey)
+{
+   if (mCurrentGraphSetIsCacheable && mCurrentCacheKey == cacheKey)
+   {
+      return;
+   }
+
+   std::map<unsigned long long, GraphSet>::iterator cachedGraphSetIt = mCachedGraphSets.find(cacheKey);
+   if (cachedGraphSetIt == mCachedGraphSets.end())
+   {
+      buildGraphSet(tracks);
+   }
+   else
+   {
+      // Take the cached graph set out of the cache and display it
+      // After the swap, the cache entry holds the graph set that was being displayed
+      GraphSet graphSet = std::move(cachedGraphSetIt->second);
+      mCacheMemoryUsage -= graphSet.memoryFootprint;
+      mCachedGraphSets.erase(cachedGraphSetIt);
+      mLeastRecentlyUsedGraphSets.remove(cacheKey);
+
+      size_t memoryFootprintOfCurrentGraphSet = calculateMemoryFootprintOfGraphSet();
+      swapGraphSet(graphSet);
+      graphSet.memoryFootprint = memoryFootprintOfCurrentGraphSet;
+
+      if (mCurrentGraphSetIsCacheable)
+      {
+         mCacheMemoryUsage += graphSet.memoryFootprint;
+         mLeastRecentlyUsedGraphSets.push_front(mCurrentCacheKey);
+         mCachedGraphSets[mCurrentCacheKey] = std::move(graphSet);
+      }
+      else
+      {
+         deleteGraphSet(graphSet);
+      }
+
+      mIndexOfSelectedGraph = -1;
+      mTimeOffset = 0.0f;
+   }
+
+   mCurrentCacheKey = cacheKey;
+   mCurrentGraphSetIsCacheable = true;
+
+   evictLeastRecentlyUsedGraphSets();
+}
+
+size_t TrackVisualizer::getCacheMemoryBudget() const
+{
+   return mCacheMemoryBudget;
+}
+
+void TrackVisualizer::setCacheMemoryBudget(size_t memoryBudgetInBytes)
+{
+   mCacheMemoryBudget = memoryBudgetInBytes;
+   evictLeastRecentlyUsedGraphSets();
+}
+
+size_t TrackVisualizer::getCacheMemoryUsage() const
+{
+   return mCacheMemoryUsage;
+}
+
+void TrackVisualizer::clearCache()
+{
+   for (std::pair<const unsigned long long, GraphSet>& cachedGraphSet : mCachedGraphSets)
+   {
+      deleteGraphSet(cachedGraphSet.second);
+   }
+
+   mCachedGraphSets.clear();
+   mLeastRecentlyUsedGraphSets.clear();
+   mCacheMemoryUsage = 0;
+}
+
+void TrackVisualizer::buildGraphSet(std::vector<FastTransformTrack>& tracks)
+{
+   if (mInitialized && mCurrentGraphSetIsCacheable)
+   {
+      // Move the graph set that is being displayed into the cache before building the new one
+      // Swapping with an empty graph set leaves the members of the TrackVisualizer empty, so initializePage won't delete anything
+      GraphSet graphSet;
+      graphSet.memoryFootprint = calculateMemoryFootprintOfGraphSet();
+      swapGraphSet(graphSet);
+
+      mCacheMemoryUsage += graphSet.memoryFootprint;
+      mLeastRecentlyUsedGraphSets.push_front(mCurrentCacheKey);
+      mCachedGraphSets[mCurrentCacheKey] = std::move(graphSet);
+   }
+
+   mTracksOfAllPages.clear();
+   mTrackIndicesOfAllPages.clear();
+
+   // Determine which tracks are valid
+   // This only looks at the keyframes of the tracks so that the tracks that aren't on the current page cost almost nothing
+   for (unsigned int trackIndex = 0, size = static_cast<unsigned int>(tracks.size()); trackIndex < size; ++trackIndex)
+   {
+      FastQuaternionTrack& rotationTrack = tracks[trackIndex].GetRotationTrack();
+
+      if (TrackVisualizerHelpers::IsTrackConstant(rotationTrack))
+      {
+         //std::cout << "Graph " << trackIndex << " is invisible!" << '\n';
+         continue;
+      }
+
+      mTracksOfAllPages.push_back(rotationTrack);
+      mTrackIndicesOfAllPages.push_back(trackIndex);
+   }
+
+   unsigned int numValidTracks = static_cast<unsigned int>(mTracksOfAllPages.size());
+   mNumPages = glm::max((numValidTracks + mMaxNumGraphsPerPage - 1) / mMaxNumGraphsPerPage, 1u);
+   mPage     = 0;
+
+   initializePage();
+}
+
+void TrackVisualizer::swapGraphSet(GraphSet& graphSet)
+{
+   std::swap(mNumPages, graphSet.numPages);
+   std::swap(mPage, graphSet.page);
+   std::swap(mTracksOfAllPages, graphSet.tracksOfAllPages);
+   std::swap(mTrackIndicesOfAllPages, graphSet.trackIndicesOfAllPages);
+
+   std::swap(mNumGraphs, graphSet.numGraphs);
+   std::swap(mNumCurves, graphSet.numCurves);
+   std::swap(mNumTiles, graphSet.numTiles);
+   std::swap(mNumEmptyRows, graphSet.numEmptyRows);
+   std::swap(mNumEmptyTilesInIncompleteRow, graphSet.numEmptyTilesInIncompleteRow);
+   std::swap(mTileWidth, graphSet.tileWidth);
+   std::swap(mTileHeight, graphSet.tileHeight);
+   std::swap(mTileHorizontalOffset, graphSet.tileHorizontalOffset);
+   std::swap(mTileVerticalOffset, graphSet.tileVerticalOffset);
+   std::swap(mGraphWidth, graphSet.graphWidth);
+   std::swap(mGraphHeight, graphSet.graphHeight);
+
+   std::swap(mLinesVAO, graphSet.linesVAO);
+   std::swap(mLinesVBO, graphSet.linesVBO);
+   std::swap(mIndexOfFirstReferenceLineVertex, graphSet.indexOfFirstReferenceLineVertex);
+   std::swap(mIndexOfFirstRepeatedCurveVertex, graphSet.indexOfFirstRepeatedCurveVertex);
+   std::swap(mNumLineVertices, graphSet.numLineVertices);
+   std::swap(mKeyframeCurvesVAO, graphSet.keyframeCurvesVAO);
+   std::swap(mKeyframeTexture, graphSet.keyframeTexture);
+   std::swap(mKeyframeTextureSizeInBytes, graphSet.keyframeTextureSizeInBytes);
+
+   std::swap(mTracks, graphSet.tracks);
+   std::swap(mTrackIndices, graphSet.trackIndices);
+   std::swap(mMinSamples, graphSet.minSamples);
+   std::swap(mInverseSampleRanges, graphSet.inverseSampleRanges);
+   std::swap(mGraphLowerLeftCorners, graphSet.graphLowerLeftCorners);
+   std::swap(mGraphUpperRightCorners, graphSet.graphUpperRightCorners);
+}
+
+void TrackVisualizer::deleteGraphSet(GraphSet& graphSet)
+{
+   glDeleteVertexArrays(1, &graphSet.linesVAO);
+   glDeleteBuffers(1, &graphSet.linesVBO);
+   glDeleteVertexArrays(1, &graphSet.keyframeCurvesVAO);
+   graphSet.linesVAO = 0;
+   graphSet.linesVBO = 0;
+   graphSet.keyframeCurvesVAO = 0;
+   graphSet.keyframeTexture.reset();
+}
+
+size_t TrackVisualizer::calculateMemoryFootprintOfGraphSet() const
+{
+   // The tracks of the current page are counted twice because they are copies of some of the tracks of all pages
+   size_t memoryFootprint = 0;
+   for (const FastQuaternionTrack& track : mTracksOfAllPages)
+   {
+      memoryFootprint += sizeof(FastQuaternionTrack) + (track.GetNumberOfFrames() * sizeof(QuaternionFrame)) + (track.GetSizeOfSampleToFrameIndexMap() * sizeof(unsigned int));
+   }
+   for (const FastQuaternionTrack& track : mTracks)
+   {
+      memoryFootprint += sizeof(FastQuaternionTrack) + (track.GetNumberOfFrames() * sizeof(QuaternionFrame)) + (track.GetSizeOfSampleToFrameIndexMap() * sizeof(unsigned int));
+   }
+
+   memoryFootprint += mTrackIndicesOfAllPages.size() * sizeof(unsigned int);
+   memoryFootprint += mTrackIndices.size() * sizeof(unsigned int);
+   memoryFootprint += (mMinSamples.size() + mInverseSampleRanges.size()) * sizeof(glm::vec4);
+   memoryFootprint += (mGraphLowerLeftCorners.size() + mGraphUpperRightCorners.size()) * sizeof(glm::vec2);
+
+   // GPU memory
+   memoryFootprint += mNumLineVertices * sizeof(LineVertex);
+   memoryFootprint += mKeyframeTextureSizeInBytes;
+
+   return memoryFootprint;
+}
+
+void TrackVisualizer::evictLeastRecentlyUsedGraphSets()
+{
+   // Evict graph sets from the back of the LRU list until we are within the budget
+   while (mCacheMemoryUsage > mCacheMemoryBudget && !mLeastRecentlyUsedGraphSets.empty())
+   {
+      unsigned long long cacheKey = mLeastRecentlyUsedGraphSets.back();
+      mLeastRecentlyUsedGraphSets.pop_back();
+
+      std::map<unsigned long long, GraphSet>::iterator cachedGraphSetIt = mCachedGraphSets.find(cacheKey);
+      mCacheMemoryUsage -= cachedGraphSetIt->second.memoryFootprint;
+      deleteGraphSet(cachedGraphSetIt->second);
+      mCachedGraphSets.erase(cachedGraphSetIt);
+   }
+}
+
+unsigned int TrackVisualizer::getNumberOfPages() const
+{
+   return mNumPages;
+}
+
+unsigned int TrackVisualizer::getPage() const
+{
+   return mPage;
+}
+
+void TrackVisualizer::setPage(unsigned int page)
+{
+   page = glm::min(page, mNumPages - 1);
+   if (page == mPage)
+   {
+      return;
+   }
+
+   mPage = page;
+   initializePage();
+}
+
+void TrackVisualizer::initializePage()
 {
    if (mInitialized)
    {
       // Reset
       mTracks.clear();
+      mTrackIndices.clear();
       mMinSamples.clear();
       mInverseSampleRanges.clear();
       mReferenceLines.clear();
       mEmptyLines.clear();
       mTrackLines.clear();
       deleteBuffers();
-      mReferenceLinesVAO = 0;
-      mReferenceLinesVBO = 0;
-      for (int i = 0; i < 4; ++i)
-      {
-         mEmptyLinesVAO[i] = 0;
-         mEmptyLinesVBO[i] = 0;
-      }
-      mTrackLinesVAOs.clear();
-      mTrackLinesVBOs.clear();
+      mLinesVAO = 0;
+      mLinesVBO = 0;
+      mKeyframeCurvesVAO = 0;
+      mKeyframeTexture.reset();
+      mKeyframeTextureSizeInBytes = 0;
       mGraphLowerLeftCorners.clear();
       mGraphUpperRightCorners.clear();
       mIndexOfSelectedGraph = -1;
+      mTimeOffset = 0.0f;
    }
 
-   // Determine which tracks are valid and store their min samples and inverse sample ranges
-   for (int trackIndex = 0; trackIndex < tracks.size(); ++trackIndex)
+   // Only the tracks on the current page are sampled and get geometry
+   unsigned int numValidTracks = static_cast<unsigned int>(mTracksOfAllPages.size());
+   unsigned int firstTrack     = glm::min(mPage * mMaxNumGraphsPerPage, numValidTracks);
+   unsigned int lastTrack      = glm::min(firstTrack + mMaxNumGraphsPerPage, numValidTracks);
+
+   // Store the min samples and inverse sample ranges of the tracks on the current page
+   for (unsigned int trackIndex = firstTrack; trackIndex < lastTrack; ++trackIndex)
    {
-      FastQuaternionTrack& rotationTrack = tracks[trackIndex].GetRotationTrack();
+      FastQuaternionTrack& rotationTrack = mTracksOfAllPages[trackIndex];
 
-      float trackDuration = rotationTrack.GetEndTime() - rotationTrack.GetStartTime();
-
-      glm::vec4 minSamples = glm::vec4(std::numeric_limits<float>::max());
-      glm::vec4 maxSamples = glm::vec4(std::numeric_limits<float>::lowest());
-      for (int sampleIndex = 0; sampleIndex < 600; ++sampleIndex)
-      {
-         float sampleIndexNormalized = static_cast<float>(sampleIndex) / 599.0f;
-
-         Q::quat sample = rotationTrack.Sample(sampleIndexNormalized * trackDuration, false);
-
-         if (sample.x < minSamples.x) minSamples.x = sample.x;
-         if (sample.y < minSamples.y) minSamples.y = sample.y;
-         if (sample.z < minSamples.z) minSamples.z = sample.z;
-         if (sample.w < minSamples.w) minSamples.w = sample.w;
-         if (sample.x > maxSamples.x) maxSamples.x = sample.x;
-         if (sample.y > maxSamples.y) maxSamples.y = sample.y;
-         if (sample.z > maxSamples.z) maxSamples.z = sample.z;
-         if (sample.w > maxSamples.w) maxSamples.w = sample.w;
-      }
+      // The bounds are calculated analytically and cached by the track, so flipping back to a page is cheap
+      Q::quat minQuat, maxQuat;
+      rotationTrack.GetBounds(minQuat, maxQuat);
+      glm::vec4 minSamples = glm::vec4(minQuat.x, minQuat.y, minQuat.z, minQuat.w);
+      glm::vec4 maxSamples = glm::vec4(maxQuat.x, maxQuat.y, maxQuat.z, maxQuat.w);
 
       glm::vec4 inverseSampleRange;
       inverseSampleRange.x = 1.0f / (maxSamples.x - minSamples.x);
@@ -127,27 +455,26 @@ void TrackVisualizer::setTracks(std::vector<FastTransformTrack>& tracks)
       inverseSampleRange.z = 1.0f / (maxSamples.z - minSamples.z);
       inverseSampleRange.w = 1.0f / (maxSamples.w - minSamples.w);
 
-      if (std::isinf(inverseSampleRange.x) && std::isinf(inverseSampleRange.y) && std::isinf(inverseSampleRange.z) && std::isinf(inverseSampleRange.w))
-      {
-         //std::cout << "Graph " << trackIndex << " is invisible!" << '\n';
-      }
-      else
-      {
-         if (std::isinf(inverseSampleRange.x)) inverseSampleRange.x = 1.0f;
-         if (std::isinf(inverseSampleRange.y)) inverseSampleRange.y = 1.0f;
-         if (std::isinf(inverseSampleRange.z)) inverseSampleRange.z = 1.0f;
-         if (std::isinf(inverseSampleRange.w)) inverseSampleRange.w = 1.0f;
-
-         mTracks.push_back(rotationTrack);
-         mMinSamples.push_back(minSamples);
-         mInverseSampleRanges.push_back(inverseSampleRange);
-      }
+      // A track can have different keyframes and still be constant (e.g. when its keyframes are q and -q),
+      // so we still need to handle the components that don't change here
+      if (std::isinf(inverseSampleRange.x)) inverseSampleRange.x = 1.0f;
+      if (std::isinf(inverseSampleRange.y)) inverseSampleRange.y = 1.0f;
+      if (std::isinf(inverseSampleRange.z)) inverseSampleRange.z = 1.0f;
+      if (std::isinf(inverseSampleRange.w)) inverseSampleRange.w = 1.0f;
+
+      mTracks.push_back(rotationTrack);
+      mTrackIndices.push_back(mTrackIndicesOfAllPages[trackIndex]);
+      mMinSamples.push_back(minSamples);
+      mInverseSampleRanges.push_back(inverseSampleRange);
    }
 
+   // When there are multiple pages, all of them use the layout of a full page so that the size of the tiles doesn't change between pages
+   unsigned int numGraphsInLayout = (mNumPages > 1) ? mMaxNumGraphsPerPage : static_cast<unsigned int>(mTracks.size());
+
    mNumGraphs = static_cast<unsigned int>(mTracks.size());
    mNumCurves = mNumGraphs * 4;
-   mNumTiles  = static_cast<unsigned int>(glm::sqrt(mNumGraphs));
-   while (mNumGraphs > (mNumTiles * mNumTiles))
+   mNumTiles  = static_cast<unsigned int>(glm::sqrt(static_cast<float>(numGraphsInLayout)));
+   while (numGraphsInLayout > (mNumTiles * mNumTiles))
    {
       ++mNumTiles;
    }
@@ -177,158 +504,77 @@ void TrackVisualizer::setTracks(std::vector<FastTransformTrack>& tracks)
    mGraphHeight = mTileHeight - mTileVerticalOffset;
 
    initializeReferenceLines();
-   initializeTrackLines();
-
-   // Create buffers
-
-   glGenVertexArrays(1, &mReferenceLinesVAO);
-   glGenBuffers(1, &mReferenceLinesVBO);
-
-   glGenVertexArrays(4, mEmptyLinesVAO);
-   glGenBuffers(4, mEmptyLinesVBO);
-
-   mTrackLinesVAOs.resize(mNumCurves);
-   mTrackLinesVBOs.resize(mNumCurves);
-   glGenVertexArrays(mNumCurves, &(mTrackLinesVAOs[0]));
-   glGenBuffers(mNumCurves, &(mTrackLinesVBOs[0]));
-
-   // Load buffers
-
-   glBindVertexArray(mReferenceLinesVAO);
-   glBindBuffer(GL_ARRAY_BUFFER, mReferenceLinesVBO);
-   glBufferData(GL_ARRAY_BUFFER, mReferenceLines.size() * sizeof(glm::vec3), &mReferenceLines[0], GL_STATIC_DRAW);
-   glBindBuffer(GL_ARRAY_BUFFER, 0);
-   glBindVertexArray(0);
-
-   for (int i = 0; i < 4; ++i)
+   if (mEvaluateCurvesOnGPU)
    {
-      if (mEmptyLines[i].size() != 0)
-      {
-         glBindVertexArray(mEmptyLinesVAO[i]);
-         glBindBuffer(GL_ARRAY_BUFFER, mEmptyLinesVBO[i]);
-         glBufferData(GL_ARRAY_BUFFER, mEmptyLines[i].size() * sizeof(glm::vec3), &mEmptyLines[i][0], GL_STATIC_DRAW);
-         glBindBuffer(GL_ARRAY_BUFFER, 0);
-         glBindVertexArray(0);
-      }
+      initializeKeyframeTexture();
+   }
+   else
+   {
+      initializeTrackLines();
    }
 
-   for (int i = 0; i < mNumCurves; ++i)
+   // Store all the lines in a single buffer (see the layout described in TrackVisualizer.h)
+   std::vector<LineVertex> lineVertices;
+   lineVertices.reserve(mEmptyLines.size() + mReferenceLines.size() + mTrackLines.size());
+   lineVertices.insert(lineVertices.end(), mEmptyLines.begin(), mEmptyLines.end());
+   mIndexOfFirstReferenceLineVertex = static_cast<unsigned int>(lineVertices.size());
+   lineVertices.insert(lineVertices.end(), mReferenceLines.begin(), mReferenceLines.end());
+   lineVertices.insert(lineVertices.end(), mTrackLines.begin(), mTrackLines.end());
+   mNumLineVertices = static_cast<unsigned int>(lineVertices.size());
+
+   // The repeated graphs are the last ones in the layout, so their curves are at the end of the buffer
+   // Each graph has 4 curves, and each curve has 2 vertices per sample segment
+   // Note that the buffer doesn't contain any curves when they are evaluated on the GPU
+   unsigned int numVerticesPerGraph = mEvaluateCurvesOnGPU ? 0 : 4 * 2 * (mNumSamplesPerCurve - 1);
+   mIndexOfFirstRepeatedCurveVertex = mNumLineVertices - (mNumEmptyTilesInIncompleteRow * numVerticesPerGraph);
+
+   // The CPU copies of the lines are no longer needed once they are in the buffer
+   mEmptyLines.clear();
+   mReferenceLines.clear();
+   mTrackLines.clear();
+
+   // Create and load the buffer
+
+   glGenVertexArrays(1, &mLinesVAO);
+   glGenBuffers(1, &mLinesVBO);
+
+   glBindVertexArray(mLinesVAO);
+   glBindBuffer(GL_ARRAY_BUFFER, mLinesVBO);
+   if (mNumLineVertices > 0)
    {
-      glBindVertexArray(mTrackLinesVAOs[i]);
-      glBindBuffer(GL_ARRAY_BUFFER, mTrackLinesVBOs[i]);
-      glBufferData(GL_ARRAY_BUFFER, mTrackLines[i].size() * sizeof(glm::vec3), &(mTrackLines[i][0]), GL_DYNAMIC_DRAW);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
+      glBufferData(GL_ARRAY_BUFFER, lineVertices.size() * sizeof(LineVertex), &lineVertices[0], GL_STATIC_DRAW);
    }
 
-   // Configure VAOs
+   // Configure the VAO
 
-   int posAttribLocation = mTrackShader->getAttributeLocation("position");
+   int posAttribLocation     = mTrackShader->getAttributeLocation("position");
+   int phaseAttribLocation   = mTrackShader->getAttributeLocation("phase");
+   int indicesAttribLocation = mTrackShader->getAttributeLocation("colorAndGraphIndices");
 
-   glBindVertexArray(mReferenceLinesVAO);
-   glBindBuffer(GL_ARRAY_BUFFER, mReferenceLinesVBO);
    glEnableVertexAttribArray(posAttribLocation);
-   glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+   glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, position));
+   glEnableVertexAttribArray(phaseAttribLocation);
+   glVertexAttribPointer(phaseAttribLocation, 2, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, phase));
+   glEnableVertexAttribArray(indicesAttribLocation);
+   glVertexAttribIPointer(indicesAttribLocation, 2, GL_INT, sizeof(LineVertex), (void*)offsetof(LineVertex, colorAndGraphIndices));
+
    glBindBuffer(GL_ARRAY_BUFFER, 0);
    glBindVertexArray(0);
 
-   for (int i = 0; i < 4; ++i)
-   {
-      glBindVertexArray(mEmptyLinesVAO[i]);
-      glBindBuffer(GL_ARRAY_BUFFER, mEmptyLinesVBO[i]);
-      glEnableVertexAttribArray(posAttribLocation);
-      glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
-   }
-
-   for (int i = 0; i < mNumCurves; ++i)
-   {
-      glBindVertexArray(mTrackLinesVAOs[i]);
-      glBindBuffer(GL_ARRAY_BUFFER, mTrackLinesVBOs[i]);
-      glEnableVertexAttribArray(posAttribLocation);
-      glVertexAttribPointer(posAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
-   }
+   glGenVertexArrays(1, &mKeyframeCurvesVAO);
 
    mInitialized = true;
 }
 
-void TrackVisualizer::update(float deltaTime, float playbackSpeed, const std::shared_ptr<Window>& window, bool fillEmptyTilesWithRepeatedGraphs, bool graphsAreVisible)
+void TrackVisualizer::update(float deltaTime, float playbackSpeed, const std::shared_ptr<Window>& window, bool rightMouseButtonIsPressed, bool fillEmptyTilesWithRepeatedGraphs, bool graphsAreVisible)
 {
+   // The curves are scrolled by graph.vert, so all we need to do here is advance the time offset
+   // The offset is normalized by the width of the graphs and wrapped to [0, 1) to avoid losing precision over time
    float speedFactor = (playbackSpeed == 0.0f) ? 0.0f : 1.0f + (4.0f * playbackSpeed);
    float xOffset = deltaTime * speedFactor;
-   unsigned int trackIndex = 0;
-   unsigned int curveIndex = 0;
-   for (int j = 0; j < mNumTiles; ++j)
+   if (mGraphWidth > 0.0f)
    {
-      if (j > (mNumTiles - mNumEmptyRows - 1))
-      {
-         // Skip empty rows
-         break;
-      }
-
-      for (int i = 0; i < mNumTiles; ++i)
-      {
-         float xPosOfOriginOfGraph = (mTileWidth * i) + (mTileHorizontalOffset / 2.0f);
-
-         for (int k = 0; k < 4; ++k)
-         {
-            std::vector<glm::vec3>& curve = mTrackLines[curveIndex + k];
-            unsigned int indexOfFirstSampleAfterReferenceLine = 0;
-            bool foundFirstSampleAfterReferenceLine = false;
-            // Move the entire curve to the left by xOffset
-            for (int l = 0; l < curve.size(); ++l)
-            {
-               curve[l].x = curve[l].x - xOffset;
-               if (!foundFirstSampleAfterReferenceLine && (curve[l].x > xPosOfOriginOfGraph))
-               {
-                  // Store the index of the first sample that's after the vertical reference line
-                  indexOfFirstSampleAfterReferenceLine = l;
-                  foundFirstSampleAfterReferenceLine = true;
-               }
-            }
-
-            // If the first sample that's after the vertical reference line is sample 0, then we don't have to shift any samples to the right,
-            // so we continue here
-            if (indexOfFirstSampleAfterReferenceLine == 0)
-            {
-               continue;
-            }
-
-            // If the first sample that's after the vertical reference line is odd, then we use to the next one, since odd samples are always the
-            // end points of all the little line segments
-            if (indexOfFirstSampleAfterReferenceLine % 2 != 0)
-            {
-               ++indexOfFirstSampleAfterReferenceLine;
-            }
-
-            // Extract all the samples that are to the left of the vertical reference line into a separate vector
-            std::vector<glm::vec3> frontOfCurve(curve.begin(), curve.begin() + indexOfFirstSampleAfterReferenceLine);
-            curve.erase(curve.begin(), curve.begin() + indexOfFirstSampleAfterReferenceLine);
-
-            // Shift all the samples that are to the left of the vertical reference line to the tail of the curve
-            float xOffsetOfLastSample = curve[curve.size() - 1].x - frontOfCurve[0].x;
-            for (int l = 0; l < frontOfCurve.size(); ++l)
-            {
-               frontOfCurve[l].x = frontOfCurve[l].x + xOffsetOfLastSample;
-            }
-
-            // Add the tail to the curve
-            curve.insert(curve.end(), frontOfCurve.begin(), frontOfCurve.end());
-
-            // Upload the updated curve to the GPU
-            glBindVertexArray(mTrackLinesVAOs[curveIndex + k]);
-            glBindBuffer(GL_ARRAY_BUFFER, mTrackLinesVBOs[curveIndex + k]);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, mTrackLines[curveIndex + k].size() * sizeof(glm::vec3), &(mTrackLines[curveIndex + k][0]));
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glBindVertexArray(0);
-         }
-
-         ++trackIndex;
-         curveIndex += 4;
-      }
+      mTimeOffset = glm::fract(mTimeOffset + (xOffset / mGraphWidth));
    }
 
    if (!graphsAreVisible)
@@ -336,7 +582,6 @@ void TrackVisualizer::update(float deltaTime, float playbackSpeed, const std::sh
       return;
    }
 
-   bool rightMouseButtonIsPressed = window->isMouseButtonPressed(GLFW_MOUSE_BUTTON_RIGHT);
    if (!mRightMouseButtonWasPressed && rightMouseButtonIsPressed)
    {
       float  devicePixelRatio = window->getDevicePixelRatio();
@@ -396,44 +641,150 @@ void TrackVisualizer::render(bool fillEmptyTilesWithRepeatedGraphs)
 {
    mTrackShader->use(true);
 
-   mTrackShader->setUniformMat4("projectionView", mProjectionViewMatrix);
+   mTrackShaderUniforms.projectionView.set(mProjectionViewMatrix);
+   mTrackShaderUniforms.timeOffset.set(mTimeOffset);
+   mTrackShaderUniforms.graphWidth.set(mGraphWidth);
+   mTrackShaderUniforms.indexOfSelectedGraph.set(mIndexOfSelectedGraph);
 
-   mTrackShader->setUniformVec3("color", glm::vec3(1.0f, 1.0f, 1.0f));
-   glBindVertexArray(mReferenceLinesVAO);
-   glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(mReferenceLines.size()));
+   // Render all the lines with a single draw call (see the layout described in TrackVisualizer.h)
+   glBindVertexArray(mLinesVAO);
+   if (fillEmptyTilesWithRepeatedGraphs)
+   {
+      glDrawArrays(GL_LINES, mIndexOfFirstReferenceLineVertex, mNumLineVertices - mIndexOfFirstReferenceLineVertex);
+   }
+   else
+   {
+      glDrawArrays(GL_LINES, 0, mIndexOfFirstRepeatedCurveVertex);
+   }
    glBindVertexArray(0);
 
-   if (!fillEmptyTilesWithRepeatedGraphs)
+   mTrackShader->use(false);
+
+   if (mEvaluateCurvesOnGPU && mKeyframeTexture)
    {
-      for (int i = 0; i < 4; ++i)
-      {
-         mTrackShader->setUniformVec3("color", mTrackLinesColorPalette[3 - (i % 4)]);
-         glBindVertexArray(mEmptyLinesVAO[i]);
-         glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(mEmptyLines[i].size()));
-         glBindVertexArray(0);
-      }
+      mKeyframeShader->use(true);
+
+      mKeyframeShaderUniforms.projectionView.set(mProjectionViewMatrix);
+      mKeyframeShaderUniforms.timeOffset.set(mTimeOffset);
+      mKeyframeShaderUniforms.graphWidth.set(mGraphWidth);
+      mKeyframeShaderUniforms.graphHeight.set(mGraphHeight);
+      mKeyframeShaderUniforms.numSamplesPerCurve.set(static_cast<int>(mNumSamplesPerCurve));
+      mKeyframeShaderUniforms.indexOfSelectedGraph.set(mIndexOfSelectedGraph);
+      mKeyframeTexture->bind(0, mKeyframeShaderUniforms.keyframes.getLocation());
+
+      // The repeated graphs are the last ones in the keyframe texture, so we can skip them by rendering fewer vertices
+      unsigned int numGraphsToRender   = fillEmptyTilesWithRepeatedGraphs ? mNumGraphs : (mNumGraphs - mNumEmptyTilesInIncompleteRow);
+      unsigned int numVerticesPerGraph = 4 * 2 * (mNumSamplesPerCurve - 1);
+
+      glBindVertexArray(mKeyframeCurvesVAO);
+      glDrawArrays(GL_LINES, 0, numGraphsToRender * numVerticesPerGraph);
+      glBindVertexArray(0);
+
+      mKeyframeTexture->unbind(0);
+      mKeyframeShader->use(false);
    }
+}
+
+bool TrackVisualizer::getEvaluateCurvesOnGPU() const
+{
+   return mEvaluateCurvesOnGPU;
+}
 
-   int numCurvesToRender = fillEmptyTilesWithRepeatedGraphs ? mNumCurves : mNumCurves - (mNumEmptyTilesInIncompleteRow * 4);
-   int indexOfFirstSelectedCurve = mIndexOfSelectedGraph * 4;
-   for (int i = 0; i < numCurvesToRender; ++i)
+void TrackVisualizer::setEvaluateCurvesOnGPU(bool evaluateCurvesOnGPU)
+{
+   if (mEvaluateCurvesOnGPU != evaluateCurvesOnGPU)
    {
-      if ((i >= indexOfFirstSelectedCurve) && (i < (indexOfFirstSelectedCurve + 4)))
-      {
-         mTrackShader->setUniformVec3("color", mSelectedTrackLinesColorPalette[i % 4]);
-      }
-      else
-      {
-         mTrackShader->setUniformVec3("color", mTrackLinesColorPalette[i % 4]);
-      }
+      // The cached graph sets were built for the other evaluation mode
+      clearCache();
+      mCurrentGraphSetIsCacheable = false;
+   }
 
-      glBindVertexArray(mTrackLinesVAOs[i]);
-      glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(mTrackLines[i].size()));
-      glBindVertexArray(0);
+   mEvaluateCurvesOnGPU = evaluateCurvesOnGPU;
+}
+
+unsigned int TrackVisualizer::getNumberOfSamplesPerCurve() const
+{
+   return mNumSamplesPerCurve;
+}
+
+void TrackVisualizer::setNumberOfSamplesPerCurve(unsigned int numSamplesPerCurve)
+{
+   // We need at least two samples to form a line segment
+   numSamplesPerCurve = glm::max(numSamplesPerCurve, 2u);
+
+   if (!mEvaluateCurvesOnGPU && mNumSamplesPerCurve != numSamplesPerCurve)
+   {
+      // The curves of the cached graph sets were sampled on the CPU with the old number of samples
+      clearCache();
+      mCurrentGraphSetIsCacheable = false;
    }
 
-   mTrackShader->use(false);
+   mNumSamplesPerCurve = numSamplesPerCurve;
+}
+
+#ifndef __EMSCRIPTEN__
+float TrackVisualizer::verifyCurvesAgainstCPU()
+{
+   if (!mEvaluateCurvesOnGPU || !mKeyframeTexture || !mKeyframeCaptureShader || mTracks.empty())
+   {
+      return -1.0f;
+   }
+
+   // Each vertex of the curves is captured as a single point, in the same order in which the curves are rendered
+   unsigned int numSegmentsPerCurve = mNumSamplesPerCurve - 1;
+   unsigned int numVerticesPerCurve = numSegmentsPerCurve * 2;
+   unsigned int numVerticesPerGraph = numVerticesPerCurve * 4;
+   unsigned int numVertices         = mNumGraphs * numVerticesPerGraph;
+
+   unsigned int capturedSamplesVBO;
+   glGenBuffers(1, &capturedSamplesVBO);
+   glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, capturedSamplesVBO);
+   glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, numVertices * sizeof(glm::vec4), nullptr, GL_STREAM_READ);
+   glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, capturedSamplesVBO);
+
+   mKeyframeCaptureShader->use(true);
+   mKeyframeCaptureShaderUniforms.numSamplesPerCurve.set(static_cast<int>(mNumSamplesPerCurve));
+   mKeyframeTexture->bind(0, mKeyframeCaptureShaderUniforms.keyframes.getLocation());
+
+   glEnable(GL_RASTERIZER_DISCARD);
+   glBindVertexArray(mKeyframeCurvesVAO);
+   glBeginTransformFeedback(GL_POINTS);
+   glDrawArrays(GL_POINTS, 0, numVertices);
+   glEndTransformFeedback();
+   glBindVertexArray(0);
+   glDisable(GL_RASTERIZER_DISCARD);
+
+   mKeyframeTexture->unbind(0);
+   mKeyframeCaptureShader->use(false);
+
+   std::vector<glm::vec4> gpuSamples(numVertices);
+   glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, gpuSamples.size() * sizeof(glm::vec4), &gpuSamples[0]);
+   glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+   glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+   glDeleteBuffers(1, &capturedSamplesVBO);
+
+   // Sample the tracks on the CPU at the same times as graph_keyframes.vert, which are the same ones as initializeTrackLines
+   // The shader searches the frames like Track::GetIndexOfLastFrameBeforeTime, so the tracks are sampled as regular tracks
+   // The lookup table of a FastTrack only approximates that search, so it can pick a different pair of frames near a keyframe
+   std::vector<QuaternionTrack> regularTracks(mTracks.begin(), mTracks.end());
+   float maxDifference = 0.0f;
+   for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+   {
+      unsigned int graphIndex         = vertexIndex / numVerticesPerGraph;
+      unsigned int vertexIndexInCurve = (vertexIndex % numVerticesPerGraph) % numVerticesPerCurve;
+      unsigned int sampleIndex        = (vertexIndexInCurve / 2) + (vertexIndexInCurve % 2);
+
+      const QuaternionTrack& track = regularTracks[graphIndex % regularTracks.size()];
+      float sampleIndexNormalized = static_cast<float>(sampleIndex) / static_cast<float>(numSegmentsPerCurve);
+      Q::quat cpuSample = track.Sample(sampleIndexNormalized * (track.GetEndTime() - track.GetStartTime()), false);
+
+      glm::vec4 difference = glm::abs(gpuSamples[vertexIndex] - glm::vec4(cpuSample.x, cpuSample.y, cpuSample.z, cpuSample.w));
+      maxDifference = glm::max(maxDifference, glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w)));
+   }
+
+   return maxDifference;
 }
+#endif
 
 int TrackVisualizer::getIndexOfSelectedGraph() const
 {
@@ -442,12 +793,15 @@ int TrackVisualizer::getIndexOfSelectedGraph() const
       return mIndexOfSelectedGraph;
    }
 
-   return (mIndexOfSelectedGraph % (mNumGraphs - mNumEmptyTilesInIncompleteRow));
+   // Map the selected tile to the index of the transform track it displays
+   return static_cast<int>(mTrackIndices[mIndexOfSelectedGraph % (mNumGraphs - mNumEmptyTilesInIncompleteRow)]);
 }
 
 void TrackVisualizer::initializeReferenceLines()
 {
-   mEmptyLines.resize(4);
+   // The reference lines use the last color of the palettes, which is white
+   const int referenceLineColorIndex = 4;
+
    unsigned int trackIndex = 0;
    unsigned int emptyLineIndex = 0;
    for (int j = 0; j < mNumTiles; ++j)
@@ -468,28 +822,29 @@ void TrackVisualizer::initializeReferenceLines()
          if (trackIndex >= (mNumGraphs - mNumEmptyTilesInIncompleteRow))
          {
             // Horizontal line
-            mEmptyLines[emptyLineIndex].push_back(glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight * 0.5f, 4.0f));
-            mEmptyLines[emptyLineIndex].push_back(glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight * 0.5f, 4.0f));
+            int colorIndex = 3 - emptyLineIndex;
+            mEmptyLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight * 0.5f, 4.0f), glm::vec2(0.0f), glm::ivec2(colorIndex, -1)});
+            mEmptyLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight * 0.5f, 4.0f), glm::vec2(0.0f), glm::ivec2(colorIndex, -1)});
             emptyLineIndex = (emptyLineIndex + 1) % 4;
          }
 
          // Y axis (left)
-         mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph, 4.0f));
-         mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight, 4.0f));
+         mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
+         mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
 
          // X axis (bottom)
-         mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph, 4.0f));
-         mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph, 4.0f));
+         mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
+         mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
 
          // Uncomment these lines if you want each graph to be inside a box
 
          // Y axis (right)
-         //mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph, 4.0f));
-         //mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight, 4.0f));
+         //mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
+         //mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
 
          // X axis (top)
-         //mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight, 4.0f));
-         //mReferenceLines.push_back(glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight, 4.0f));
+         //mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, yPosOfOriginOfGraph + mGraphHeight, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
+         //mReferenceLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph + mGraphWidth, yPosOfOriginOfGraph + mGraphHeight, 4.0f), glm::vec2(0.0f), glm::ivec2(referenceLineColorIndex, -1)});
 
          // The corners are used to determine which graph the mouse is hovering over
          mGraphLowerLeftCorners.push_back(glm::vec2(xPosOfOriginOfGraph, yPosOfOriginOfGraph));
@@ -502,9 +857,8 @@ void TrackVisualizer::initializeReferenceLines()
 
 void TrackVisualizer::initializeTrackLines()
 {
-   mTrackLines.resize(mNumCurves);
+   mTrackLines.reserve(mNumCurves * 2 * (mNumSamplesPerCurve - 1));
    unsigned int trackIndex = 0;
-   unsigned int curveIndex = 0;
    for (int j = 0; j < mNumTiles; ++j)
    {
       if (j > (mNumTiles - mNumEmptyRows - 1))
@@ -525,13 +879,15 @@ void TrackVisualizer::initializeTrackLines()
 
          float trackDuration = mTracks[wrappedTrackIndex].GetEndTime() - mTracks[wrappedTrackIndex].GetStartTime();
 
-         for (int sampleIndex = 1; sampleIndex < 600; ++sampleIndex)
+         float numSegmentsPerCurve = static_cast<float>(mNumSamplesPerCurve - 1);
+         for (unsigned int sampleIndex = 1; sampleIndex < mNumSamplesPerCurve; ++sampleIndex)
          {
-            float currSampleIndexNormalized = static_cast<float>(sampleIndex - 1) / 599.0f;
-            float nextSampleIndexNormalized = static_cast<float>(sampleIndex) / 599.0f;
+            float currSampleIndexNormalized = static_cast<float>(sampleIndex - 1) / numSegmentsPerCurve;
+            float nextSampleIndexNormalized = static_cast<float>(sampleIndex) / numSegmentsPerCurve;
 
-            float currX = xPosOfOriginOfGraph + (currSampleIndexNormalized * mGraphWidth);
-            float nextX = xPosOfOriginOfGraph + (nextSampleIndexNormalized * mGraphWidth);
+            // The X coordinates of the vertices are calculated by graph.vert from their phases (see the comments in that shader)
+            glm::vec2 currPhase = glm::vec2(currSampleIndexNormalized, 0.0f);
+            glm::vec2 nextPhase = glm::vec2(currSampleIndexNormalized, nextSampleIndexNormalized - currSampleIndexNormalized);
 
             Q::quat currSampleQuat = mTracks[wrappedTrackIndex].Sample(currSampleIndexNormalized * trackDuration, false);
             Q::quat nextSampleQuat = mTracks[wrappedTrackIndex].Sample(nextSampleIndexNormalized * trackDuration, false);
@@ -546,40 +902,131 @@ void TrackVisualizer::initializeTrackLines()
                nextSampleNormalized[k] = yPosOfOriginOfGraph + (((nextSample[k] - mMinSamples[wrappedTrackIndex][k]) * mInverseSampleRanges[wrappedTrackIndex][k]) * mGraphHeight);
             }
 
-            mTrackLines[curveIndex].push_back(glm::vec3(currX, currSampleNormalized.x, 3.0f));
-            mTrackLines[curveIndex].push_back(glm::vec3(nextX, nextSampleNormalized.x, 3.0f));
-
-            mTrackLines[curveIndex + 1].push_back(glm::vec3(currX, currSampleNormalized.y, 2.0f));
-            mTrackLines[curveIndex + 1].push_back(glm::vec3(nextX, nextSampleNormalized.y, 2.0f));
-
-            mTrackLines[curveIndex + 2].push_back(glm::vec3(currX, currSampleNormalized.z, 1.0f));
-            mTrackLines[curveIndex + 2].push_back(glm::vec3(nextX, nextSampleNormalized.z, 1.0f));
-
-            mTrackLines[curveIndex + 3].push_back(glm::vec3(currX, currSampleNormalized.w, 0.0f));
-            mTrackLines[curveIndex + 3].push_back(glm::vec3(nextX, nextSampleNormalized.w, 0.0f));
+            // Each vertex stores the index of its color and the index of the graph it belongs to
+            // Note that the curves are interleaved here, which doesn't matter since they are all rendered with the same draw call
+            int graphIndex = static_cast<int>(trackIndex);
+            for (int k = 0; k < 4; ++k)
+            {
+               mTrackLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, currSampleNormalized[k], 3.0f - k), currPhase, glm::ivec2(k, graphIndex)});
+               mTrackLines.push_back(LineVertex{glm::vec3(xPosOfOriginOfGraph, nextSampleNormalized[k], 3.0f - k), nextPhase, glm::ivec2(k, graphIndex)});
+            }
          }
 
          ++trackIndex;
-         curveIndex += 4;
       }
    }
 }
 
-void TrackVisualizer::deleteBuffers()
+void TrackVisualizer::initializeKeyframeTexture()
 {
-   glDeleteVertexArrays(1, &mReferenceLinesVAO);
-   glDeleteBuffers(1, &mReferenceLinesVBO);
+   /*
+      The keyframe texture is an RGBA32F texture that is indexed as if it were a 1D array of texels
+      We use a 2D texture instead of a texture buffer because WebGL 2 doesn't support texture buffers
+
+      +---------------+---------------+-----+---------+---------+-----+
+      | Graph headers (1 per graph)   | ... | Track 0 | Track 1 | ... |
+      +---------------+---------------+-----+---------+---------+-----+
+
+      Graph header: (X origin, Y origin, index of the first texel of the track, unused)
+      The repeated graphs are the last ones, and their headers point to the tracks they repeat
 
-   glDeleteVertexArrays(4, mEmptyLinesVAO);
-   glDeleteBuffers(4, mEmptyLinesVBO);
+      Track: 3 header texels followed by 4 texels per frame
+      - (number of frames, interpolation, start time, end time)
+      - Min samples
+      - Inverse sample ranges
+      - For each frame: value, in slope, out slope, (time, unused, unused, unused)
+   */
 
-   if (mTrackLinesVAOs.size() > 0)
+   const unsigned int textureWidth = 1024;
+
+   unsigned int numUniqueTracks = static_cast<unsigned int>(mTracks.size());
+   if (numUniqueTracks == 0)
    {
-      glDeleteVertexArrays(static_cast<GLsizei>(mTrackLinesVAOs.size()), &(mTrackLinesVAOs[0]));
+      return;
    }
 
-   if (mTrackLinesVBOs.size() > 0)
+   std::vector<unsigned int> firstTexelOfTracks(numUniqueTracks);
+   unsigned int numTexels = mNumGraphs;
+   for (unsigned int trackIndex = 0; trackIndex < numUniqueTracks; ++trackIndex)
    {
-      glDeleteBuffers(static_cast<GLsizei>(mTrackLinesVBOs.size()), &(mTrackLinesVBOs[0]));
+      firstTexelOfTracks[trackIndex] = numTexels;
+      numTexels += 3 + (4 * mTracks[trackIndex].GetNumberOfFrames());
    }
+
+   unsigned int textureHeight = (numTexels + textureWidth - 1) / textureWidth;
+   std::vector<glm::vec4> texels(textureWidth * textureHeight, glm::vec4(0.0f));
+
+   // Graph headers
+   unsigned int graphIndex = 0;
+   for (int j = 0; j < mNumTiles; ++j)
+   {
+      if (j > (mNumTiles - mNumEmptyRows - 1))
+      {
+         // Skip empty rows
+         break;
+      }
+
+      float emptyRowOffset = (mNumEmptyRows * mTileHeight * 0.5f);
+      float yPosOfOriginOfGraph = (mTileHeight * j) + (mTileVerticalOffset / 2.0f) + emptyRowOffset;
+
+      for (int i = 0; i < mNumTiles; ++i)
+      {
+         // We wrap the track index to point the repeated graphs that fill the incomplete row to the tracks they repeat
+         unsigned int wrappedTrackIndex = graphIndex % numUniqueTracks;
+
+         float xPosOfOriginOfGraph = (mTileWidth * i) + (mTileHorizontalOffset / 2.0f);
+
+         texels[graphIndex] = glm::vec4(xPosOfOriginOfGraph, yPosOfOriginOfGraph, static_cast<float>(firstTexelOfTracks[wrappedTrackIndex]), 0.0f);
+
+         ++graphIndex;
+      }
+   }
+
+   // Tracks
+   for (unsigned int trackIndex = 0; trackIndex < numUniqueTracks; ++trackIndex)
+   {
+      const FastQuaternionTrack& track = mTracks[trackIndex];
+      unsigned int numFrames = track.GetNumberOfFrames();
+      unsigned int texelIndex = firstTexelOfTracks[trackIndex];
+
+      texels[texelIndex++] = glm::vec4(static_cast<float>(numFrames), static_cast<float>(track.GetInterpolation()), track.GetStartTime(), track.GetEndTime());
+      texels[texelIndex++] = mMinSamples[trackIndex];
+      texels[texelIndex++] = mInverseSampleRanges[trackIndex];
+
+      for (unsigned int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+      {
+         const QuaternionFrame& frame = track.GetFrame(frameIndex);
+
+         // The values are normalized here so that the shader doesn't have to do it (see Track::Cast)
+         // The slopes must not be normalized
+         glm::vec4 value = glm::vec4(frame.mValue[0], frame.mValue[1], frame.mValue[2], frame.mValue[3]);
+         float lengthOfValue = glm::length(value);
+         texels[texelIndex++] = (lengthOfValue > 0.0f) ? (value / lengthOfValue) : value;
+         texels[texelIndex++] = glm::vec4(frame.mInSlope[0], frame.mInSlope[1], frame.mInSlope[2], frame.mInSlope[3]);
+         texels[texelIndex++] = glm::vec4(frame.mOutSlope[0], frame.mOutSlope[1], frame.mOutSlope[2], frame.mOutSlope[3]);
+         texels[texelIndex++] = glm::vec4(frame.mTime, 0.0f, 0.0f, 0.0f);
+      }
+   }
+
+   unsigned int keyframeTexID;
+   glGenTextures(1, &keyframeTexID);
+   glBindTexture(GL_TEXTURE_2D, keyframeTexID);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, textureWidth, textureHeight, 0, GL_RGBA, GL_FLOAT, &texels[0]);
+   // The texture is only read with texelFetch, but float textures aren't filterable in WebGL 2,
+   // so we disable filtering and mipmapping to make sure that the texture is complete
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glBindTexture(GL_TEXTURE_2D, 0);
+
+   mKeyframeTexture = std::make_shared<Texture>(keyframeTexID);
+   mKeyframeTextureSizeInBytes = texels.size() * sizeof(glm::vec4);
+}
+
+void TrackVisualizer::deleteBuffers()
+{
+   glDeleteVertexArrays(1, &mLinesVAO);
+   glDeleteBuffers(1, &mLinesVBO);
+   glDeleteVertexArrays(1, &mKeyframeCurvesVAO);
 }
@@ -156,9 +156,10 @@ glm::vec3 Q::operator*(const Q::quat& q, const glm::vec3& v)
 
    // Also note that this assumes that the inverse of the quaterion q is its conjugate,
    // which in other words means that it assumes that the quaternion q is normalized, unlike the commented code above
-   return q.vector * 2.0f * glm::dot(q.vector, v) +
-          v * (q.scalar * q.scalar - glm::dot(q.vector, q.vector)) +
-          glm::cross(q.vector, v) * 2.0f * q.scalar;
+   glm::vec3 vectorPart = glm::vec3(q.x, q.y, q.z);
+   return vectorPart * 2.0f * glm::dot(vectorPart, v) +
+          v * (q.w * q.w - glm::dot(vectorPart, vectorPart)) +
+          glm::cross(vectorPart, v) * 2.0f * q.w;
 }
 
 // The multiplication operator below doesn't reverse the order of the arguments it receives
@@ -190,8 +191,8 @@ Q::quat Q::operator^(const Q::quat& q, float exponent)
    // Raising a quaternion to some power simply means scaling its angle
    // Here we decompose the quaternion into its axis and angle,
    // we scale its angle, and then we put it back together
-   float halfAngle = glm::acos(q.scalar);
-   glm::vec3 axisOfRot = normalizeWithZeroLengthCheck(q.vector);
+   float halfAngle = glm::acos(q.w);
+   glm::vec3 axisOfRot = normalizeWithZeroLengthCheck(glm::vec3(q.x, q.y, q.z));
 
    float halfCos = glm::cos(exponent * halfAngle);
    float halfSin = glm::sin(exponent * halfAngle);
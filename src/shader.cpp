@@ -1,9 +1,70 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <utility>
 
 #include "shader.h"
 
+template<>
+void Uniform<bool>::set(const bool& value) const
+{
+   glUniform1i(mLocation, static_cast<int>(value));
+}
+
+template<>
+void Uniform<int>::set(const int& value) const
+{
+   glUniform1i(mLocation, value);
+}
+
+template<>
+void Uniform<float>::set(const float& value) const
+{
+   glUniform1f(mLocation, value);
+}
+
+template<>
+void Uniform<glm::vec2>::set(const glm::vec2& value) const
+{
+   glUniform2fv(mLocation, 1, &value[0]);
+}
+
+template<>
+void Uniform<glm::vec3>::set(const glm::vec3& value) const
+{
+   glUniform3fv(mLocation, 1, &value[0]);
+}
+
+template<>
+void Uniform<glm::vec4>::set(const glm::vec4& value) const
+{
+   glUniform4fv(mLocation, 1, &value[0]);
+}
+
+template<>
+void Uniform<glm::mat2>::set(const glm::mat2& value) const
+{
+   glUniformMatrix2fv(mLocation, 1, GL_FALSE, &value[0][0]);
+}
+
+template<>
+void Uniform<glm::mat3>::set(const glm::mat3& value) const
+{
+   glUniformMatrix3fv(mLocation, 1, GL_FALSE, &value[0][0]);
+}
+
+template<>
+void Uniform<glm::mat4>::set(const glm::mat4& value) const
+{
+   glUniformMatrix4fv(mLocation, 1, GL_FALSE, &value[0][0]);
+}
+
+template<>
+void Uniform<std::vector<glm::mat4>>::set(const std::vector<glm::mat4>& values) const
+{
+   glUniformMatrix4fv(mLocation, static_cast<GLsizei>(values.size()), GL_FALSE, glm::value_ptr(values[0]));
+}
+
 Shader::Shader(unsigned int shaderProgID,
                std::map<std::string, unsigned int>&& attributes,
                std::map<std::string, unsigned int>&& uniforms)
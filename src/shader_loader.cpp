@@ -4,15 +4,33 @@
 #include <glad/glad.h>
 #endif
 
+#include <cstring>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
 #include "shader_loader.h"
+#include "PerFrameUniformBuffer.h"
+#include "ProgramBinaryCache.h"
 
 std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFilePath,
                                                    const std::string& fShaderFilePath) const
+{
+   return loadResource(vShaderFilePath, fShaderFilePath, std::vector<std::string>());
+}
+
+std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string&              vShaderFilePath,
+                                                   const std::string&              fShaderFilePath,
+                                                   const std::vector<std::string>& defines) const
+{
+   return loadResource(vShaderFilePath, fShaderFilePath, defines, std::vector<std::string>());
+}
+
+std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string&              vShaderFilePath,
+                                                   const std::string&              fShaderFilePath,
+                                                   const std::vector<std::string>& defines,
+                                                   const std::vector<std::string>& transformFeedbackVaryings) const
 {
    // Read the vertex and fragment shaders
    std::string vShaderCode, fShaderCode;
@@ -22,9 +40,32 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
       return nullptr;
    }
 
+   addPerFrameUniformsToShaderCode(vShaderCode);
+   addPerFrameUniformsToShaderCode(fShaderCode);
+
+   // Note that the defines must be added before the version, since the version is prepended to the code
+   addDefinesToShaderCode(vShaderCode, defines);
+   addDefinesToShaderCode(fShaderCode, defines);
+
    addVersionToShaderCode(vShaderCode, GL_VERTEX_SHADER);
    addVersionToShaderCode(fShaderCode, GL_FRAGMENT_SHADER);
 
+#ifndef __EMSCRIPTEN__
+   // Load the program from the binary cache if it was linked by a previous run
+   // The transform feedback varyings are part of the linked program, so they are part of its key too
+   std::string transformFeedbackVaryingsKey;
+   for (const std::string& varying : transformFeedbackVaryings)
+   {
+      transformFeedbackVaryingsKey += "|" + varying;
+   }
+   unsigned long long programBinaryKey = ProgramBinaryCache::CalculateKey(vShaderCode + transformFeedbackVaryingsKey, fShaderCode);
+   unsigned int cachedShaderProgID = ProgramBinaryCache::LoadProgram(programBinaryKey);
+   if (cachedShaderProgID != 0)
+   {
+      return createShader(cachedShaderProgID);
+   }
+#endif
+
    // Compile the vertex shader
    unsigned int vShaderID = createAndCompileShader(vShaderCode, GL_VERTEX_SHADER);
    if (!shaderCompilationSucceeded(vShaderID))
@@ -45,7 +86,7 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
    }
 
    // Link the shader program
-   unsigned int shaderProgID = createAndLinkShaderProgram(vShaderID, fShaderID);
+   unsigned int shaderProgID = createAndLinkShaderProgram(vShaderID, fShaderID, transformFeedbackVaryings);
    if (!shaderProgramLinkingSucceeded(shaderProgID))
    {
       logShaderProgramLinkingErrors(shaderProgID);
@@ -63,15 +104,11 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
    glDeleteShader(vShaderID);
    glDeleteShader(fShaderID);
 
-   // Read the attributes from the shader program
-   std::map<std::string, unsigned int> attributes;
-   readAttributes(shaderProgID, attributes);
-
-   // Read the uniforms from the shader program
-   std::map<std::string, unsigned int> uniforms;
-   readUniforms(shaderProgID, uniforms);
+#ifndef __EMSCRIPTEN__
+   ProgramBinaryCache::StoreProgram(programBinaryKey, shaderProgID);
+#endif
 
-   return std::make_shared<Shader>(shaderProgID, std::move(attributes), std::move(uniforms));
+   return createShader(shaderProgID);
 }
 
 #ifndef __EMSCRIPTEN__
@@ -88,6 +125,10 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
       return nullptr;
    }
 
+   addPerFrameUniformsToShaderCode(vShaderCode);
+   addPerFrameUniformsToShaderCode(fShaderCode);
+   addPerFrameUniformsToShaderCode(gShaderCode);
+
    addVersionToShaderCode(vShaderCode, GL_VERTEX_SHADER);
    addVersionToShaderCode(fShaderCode, GL_FRAGMENT_SHADER);
    addVersionToShaderCode(gShaderCode, GL_GEOMETRY_SHADER);
@@ -145,6 +186,31 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
    glDeleteShader(fShaderID);
    glDeleteShader(gShaderID);
 
+   return createShader(shaderProgID);
+}
+#endif
+
+std::string ShaderLoader::getResourceID(const std::string&              vShaderFilePath,
+                                        const std::string&              fShaderFilePath,
+                                        const std::vector<std::string>& defines,
+                                        const std::vector<std::string>& transformFeedbackVaryings)
+{
+   std::string resourceID = vShaderFilePath + "|" + fShaderFilePath;
+   for (const std::string& define : defines)
+   {
+      resourceID += "|" + define;
+   }
+
+   for (const std::string& varying : transformFeedbackVaryings)
+   {
+      resourceID += "|out " + varying;
+   }
+
+   return resourceID;
+}
+
+std::shared_ptr<Shader> ShaderLoader::createShader(unsigned int shaderProgID) const
+{
    // Read the attributes from the shader program
    std::map<std::string, unsigned int> attributes;
    readAttributes(shaderProgID, attributes);
@@ -153,9 +219,11 @@ std::shared_ptr<Shader> ShaderLoader::loadResource(const std::string& vShaderFil
    std::map<std::string, unsigned int> uniforms;
    readUniforms(shaderProgID, uniforms);
 
+   // Connect the uniform blocks that are shared by all the programs to their binding points
+   bindUniformBlocks(shaderProgID);
+
    return std::make_shared<Shader>(shaderProgID, std::move(attributes), std::move(uniforms));
 }
-#endif
 
 bool ShaderLoader::readShaderFile(const std::string& shaderFilePath, std::string& outShaderCode) const
 {
@@ -192,6 +260,32 @@ void ShaderLoader::addVersionToShaderCode(std::string& ioShaderCode, GLenum shad
    ioShaderCode = shaderVersion + ioShaderCode;
 }
 
+void ShaderLoader::addDefinesToShaderCode(std::string& ioShaderCode, const std::vector<std::string>& defines) const
+{
+   std::string shaderDefines;
+   for (const std::string& define : defines)
+   {
+      shaderDefines += "#define " + define + "\n";
+   }
+
+   ioShaderCode = shaderDefines + ioShaderCode;
+}
+
+void ShaderLoader::addPerFrameUniformsToShaderCode(std::string& ioShaderCode) const
+{
+   // The shaders that use the uniforms that are shared by all the programs include them with a directive,
+   // which is replaced by the single declaration of the PerFrame block
+   std::size_t indexOfDirective = ioShaderCode.find(PerFrameUniformBuffer::glslIncludeDirective);
+   if (indexOfDirective == std::string::npos)
+   {
+      return;
+   }
+
+   std::string perFrameUniforms = "#define MAX_NUMBER_OF_POINT_LIGHTS " + std::to_string(PerFrameUniformBuffer::maxNumberOfPointLights) + "\n" +
+                                  PerFrameUniformBuffer::glslDeclaration;
+   ioShaderCode.replace(indexOfDirective, std::strlen(PerFrameUniformBuffer::glslIncludeDirective), perFrameUniforms);
+}
+
 unsigned int ShaderLoader::createAndCompileShader(const std::string& shaderCode, GLenum shaderType) const
 {
    // Create and compile the shader
@@ -202,13 +296,30 @@ unsigned int ShaderLoader::createAndCompileShader(const std::string& shaderCode,
    return shaderID;
 }
 
-unsigned int ShaderLoader::createAndLinkShaderProgram(unsigned int vShaderID, unsigned int fShaderID) const
+unsigned int ShaderLoader::createAndLinkShaderProgram(unsigned int vShaderID, unsigned int fShaderID, const std::vector<std::string>& transformFeedbackVaryings) const
 {
    unsigned int shaderProgID = glCreateProgram();
 
    glAttachShader(shaderProgID, vShaderID);
    glAttachShader(shaderProgID, fShaderID);
 
+   // The varyings that are captured by transform feedback must be specified before the program is linked
+   if (!transformFeedbackVaryings.empty())
+   {
+      std::vector<const char*> varyingNames;
+      varyingNames.reserve(transformFeedbackVaryings.size());
+      for (const std::string& varying : transformFeedbackVaryings)
+      {
+         varyingNames.push_back(varying.c_str());
+      }
+
+      glTransformFeedbackVaryings(shaderProgID, static_cast<GLsizei>(varyingNames.size()), &varyingNames[0], GL_INTERLEAVED_ATTRIBS);
+   }
+
+#ifndef __EMSCRIPTEN__
+   ProgramBinaryCache::PrepareProgramForStorage(shaderProgID);
+#endif
+
    glLinkProgram(shaderProgID);
 
    return shaderProgID;
@@ -429,3 +540,13 @@ void ShaderLoader::readUniforms(unsigned int shaderProgID, std::map<std::string,
 
    glUseProgram(0);
 }
+
+void ShaderLoader::bindUniformBlocks(unsigned int shaderProgID) const
+{
+   // WebGL 2 doesn't support layout(binding = N), so the binding point of each block must be set here
+   unsigned int perFrameBlockIndex = glGetUniformBlockIndex(shaderProgID, PerFrameUniformBuffer::blockName);
+   if (perFrameBlockIndex != GL_INVALID_INDEX)
+   {
+      glUniformBlockBinding(shaderProgID, perFrameBlockIndex, PerFrameUniformBuffer::bindingPoint);
+   }
+}
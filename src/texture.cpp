@@ -44,3 +44,8 @@ void Texture::unbind(unsigned int textureUnit) const
    // Disactivate the texture unit
    glActiveTexture(GL_TEXTURE0);
 }
+
+unsigned int Texture::getID() const
+{
+   return mTexID;
+}
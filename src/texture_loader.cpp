@@ -1,8 +1,241 @@
 #include <stb_image/stb_image.h>
 
 #include <iostream>
+#ifndef __EMSCRIPTEN__
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#endif
 
 #include "texture_loader.h"
+#include "resource_manager.h"
+
+namespace TextureLoaderHelpers
+{
+   // Halves the dimensions of a level by averaging blocks of 2x2 texels
+   // When a dimension is odd, the last row or column of the source level is repeated
+   void GenerateNextLevel(const unsigned char* srcLevel, int srcWidth, int srcHeight, int numComponents, unsigned char* dstLevel)
+   {
+      int dstWidth  = (srcWidth > 1) ? (srcWidth / 2) : 1;
+      int dstHeight = (srcHeight > 1) ? (srcHeight / 2) : 1;
+
+      for (int y = 0; y < dstHeight; ++y)
+      {
+         int y0 = (y * 2 < srcHeight) ? (y * 2) : (srcHeight - 1);
+         int y1 = (y * 2 + 1 < srcHeight) ? (y * 2 + 1) : (srcHeight - 1);
+
+         for (int x = 0; x < dstWidth; ++x)
+         {
+            int x0 = (x * 2 < srcWidth) ? (x * 2) : (srcWidth - 1);
+            int x1 = (x * 2 + 1 < srcWidth) ? (x * 2 + 1) : (srcWidth - 1);
+
+            for (int c = 0; c < numComponents; ++c)
+            {
+               unsigned int sum = srcLevel[((y0 * srcWidth) + x0) * numComponents + c] +
+                                  srcLevel[((y0 * srcWidth) + x1) * numComponents + c] +
+                                  srcLevel[((y1 * srcWidth) + x0) * numComponents + c] +
+                                  srcLevel[((y1 * srcWidth) + x1) * numComponents + c];
+               dstLevel[((y * dstWidth) + x) * numComponents + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+         }
+      }
+   }
+
+   // Calculates the offsets of all the levels of a texture, down to 1x1, and returns the total size of the levels
+   size_t CalculateLevelOffsets(int width, int height, int numComponents, std::vector<size_t>& levelOffsets)
+   {
+      levelOffsets.clear();
+
+      size_t offset = 0;
+      while (true)
+      {
+         levelOffsets.push_back(offset);
+         offset += static_cast<size_t>(width) * height * numComponents;
+
+         if (width == 1 && height == 1)
+         {
+            break;
+         }
+
+         width  = (width > 1) ? (width / 2) : 1;
+         height = (height > 1) ? (height / 2) : 1;
+      }
+
+      return offset;
+   }
+
+   void GenerateMipChain(TextureLoader::DecodedResource& decodedTexture)
+   {
+      size_t totalSize = CalculateLevelOffsets(decodedTexture.width, decodedTexture.height, decodedTexture.numComponents, decodedTexture.levelOffsets);
+      decodedTexture.texData.resize(totalSize);
+
+      int levelWidth  = decodedTexture.width;
+      int levelHeight = decodedTexture.height;
+      for (size_t level = 1, numLevels = decodedTexture.levelOffsets.size(); level < numLevels; ++level)
+      {
+         GenerateNextLevel(&decodedTexture.texData[decodedTexture.levelOffsets[level - 1]],
+                           levelWidth,
+                           levelHeight,
+                           decodedTexture.numComponents,
+                           &decodedTexture.texData[decodedTexture.levelOffsets[level]]);
+
+         levelWidth  = (levelWidth > 1) ? (levelWidth / 2) : 1;
+         levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+      }
+   }
+
+#ifndef __EMSCRIPTEN__
+   // Written at the start of each cache file so that files from an incompatible version of the cache are ignored
+   const unsigned int cacheFileMagic = 0x414D5443; // AMTC
+
+   // The header of a cache file, which is followed by all the levels of the texture, tightly packed one after the other
+   // The levels are stored exactly as they are uploaded, so a cache file can be read directly into the memory of the texture
+   struct CacheFileHeader
+   {
+      unsigned int       magic;
+      unsigned int       numComponents;
+      unsigned long long sourceHash;
+      int                width;
+      int                height;
+      unsigned int       numLevels;
+      unsigned int       padding;
+   };
+
+   unsigned long long HashFNV1a(const std::vector<unsigned char>& bytes)
+   {
+      unsigned long long hash = 14695981039346656037ull;
+      for (unsigned char byte : bytes)
+      {
+         hash ^= byte;
+         hash *= 1099511628211ull;
+      }
+
+      return hash;
+   }
+
+   bool ReadFile(const std::string& filePath, std::vector<unsigned char>& bytes)
+   {
+      std::ifstream file(filePath, std::ios::binary);
+      if (!file)
+      {
+         return false;
+      }
+
+      bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      return true;
+   }
+
+   // The cache files are stored in the same cache directory as the program binary cache, which is ignored by git,
+   // so that they are never preloaded into the web build with the rest of the resources
+   const char* cacheDirectoryPath = "cache";
+
+   void CreateCacheDirectory()
+   {
+      // This fails harmlessly when the directory already exists
+#ifdef _WIN32
+      _mkdir(cacheDirectoryPath);
+#else
+      mkdir(cacheDirectoryPath, 0755);
+#endif
+   }
+
+   // The parameters are part of the name, so that the loads of the same image with different parameters never share a file
+   std::string GetCacheFilePath(const std::string& texFilePath,
+                                unsigned int       wrapS,
+                                unsigned int       wrapT,
+                                unsigned int       minFilter,
+                                unsigned int       magFilter,
+                                bool               genMipmap)
+   {
+      std::string canonicalPath = canonicalizeResourcePath(texFilePath);
+      unsigned long long pathHash = HashFNV1a(std::vector<unsigned char>(canonicalPath.begin(), canonicalPath.end()));
+
+      char fileName[128];
+      std::snprintf(fileName, sizeof(fileName), "%s/texture_%016llx_%04x_%04x_%04x_%04x_%d.bin",
+                    cacheDirectoryPath, pathHash, wrapS, wrapT, minFilter, magFilter, genMipmap ? 1 : 0);
+      return fileName;
+   }
+
+   // Returns false when the cache file doesn't exist or when it was generated from a different version of the image
+   bool ReadCacheFile(const std::string& cacheFilePath, unsigned long long sourceHash, TextureLoader::DecodedResource& decodedTexture)
+   {
+      std::ifstream cacheFile(cacheFilePath, std::ios::binary);
+      if (!cacheFile)
+      {
+         return false;
+      }
+
+      CacheFileHeader header;
+      cacheFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+      if (!cacheFile || header.magic != cacheFileMagic || header.sourceHash != sourceHash)
+      {
+         return false;
+      }
+
+      decodedTexture.width         = header.width;
+      decodedTexture.height        = header.height;
+      decodedTexture.numComponents = static_cast<int>(header.numComponents);
+
+      // The file stores either the full chain of levels or only the base level
+      size_t totalSize = CalculateLevelOffsets(decodedTexture.width, decodedTexture.height, decodedTexture.numComponents, decodedTexture.levelOffsets);
+      if (header.numLevels == 1)
+      {
+         decodedTexture.levelOffsets.resize(1);
+         totalSize = static_cast<size_t>(decodedTexture.width) * decodedTexture.height * decodedTexture.numComponents;
+      }
+      else if (decodedTexture.levelOffsets.size() != header.numLevels)
+      {
+         return false;
+      }
+
+      decodedTexture.texData.resize(totalSize);
+      cacheFile.read(reinterpret_cast<char*>(decodedTexture.texData.data()), totalSize);
+      return static_cast<bool>(cacheFile);
+   }
+
+   void WriteCacheFile(const std::string& cacheFilePath, unsigned long long sourceHash, const TextureLoader::DecodedResource& decodedTexture)
+   {
+      CreateCacheDirectory();
+
+      // The file is written under a temporary name and then renamed, so that a partially written file is never read
+      // The name of the thread is part of the temporary name, so that two threads that write the same file don't write into each other
+      std::ostringstream temporaryFilePath;
+      temporaryFilePath << cacheFilePath << "." << std::this_thread::get_id() << ".tmp";
+
+      {
+         std::ofstream cacheFile(temporaryFilePath.str(), std::ios::binary | std::ios::trunc);
+         if (!cacheFile)
+         {
+            std::cout << "Warning - TextureLoader::decodeResource - The following cache file could not be written: " << cacheFilePath << "\n";
+            return;
+         }
+
+         CacheFileHeader header;
+         header.magic         = cacheFileMagic;
+         header.numComponents = static_cast<unsigned int>(decodedTexture.numComponents);
+         header.sourceHash    = sourceHash;
+         header.width         = decodedTexture.width;
+         header.height        = decodedTexture.height;
+         header.numLevels     = static_cast<unsigned int>(decodedTexture.levelOffsets.size());
+         header.padding       = 0;
+
+         cacheFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+         cacheFile.write(reinterpret_cast<const char*>(decodedTexture.texData.data()), decodedTexture.texData.size());
+      }
+
+      // std::rename fails on Windows when the destination exists
+      std::remove(cacheFilePath.c_str());
+      std::rename(temporaryFilePath.str().c_str(), cacheFilePath.c_str());
+   }
+#endif
+}
 
 std::shared_ptr<Texture> TextureLoader::loadResource(const std::string& texFilePath,
                                                      unsigned int       wrapS,
@@ -11,32 +244,128 @@ std::shared_ptr<Texture> TextureLoader::loadResource(const std::string& texFileP
                                                      unsigned int       magFilter,
                                                      bool               genMipmap) const
 {
-   int width, height, numComponents;
-   std::unique_ptr<unsigned char, void(*)(void*)> texData(stbi_load(texFilePath.c_str(), &width, &height, &numComponents, 0), stbi_image_free);
+   std::shared_ptr<DecodedResource> decodedTexture = decodeResource(texFilePath, wrapS, wrapT, minFilter, magFilter, genMipmap);
+
+   if (!decodedTexture)
+   {
+      return nullptr;
+   }
+
+   return uploadResource(*decodedTexture);
+}
+
+std::shared_ptr<TextureLoader::DecodedResource> TextureLoader::decodeResource(const std::string& texFilePath,
+                                                                              unsigned int       wrapS,
+                                                                              unsigned int       wrapT,
+                                                                              unsigned int       minFilter,
+                                                                              unsigned int       magFilter,
+                                                                              bool               genMipmap) const
+{
+   std::shared_ptr<DecodedResource> decodedTexture = std::make_shared<DecodedResource>();
+   decodedTexture->wrapS     = wrapS;
+   decodedTexture->wrapT     = wrapT;
+   decodedTexture->minFilter = minFilter;
+   decodedTexture->magFilter = magFilter;
+   decodedTexture->genMipmap = genMipmap;
+
+#ifdef __EMSCRIPTEN__
+   // The web build doesn't have a persistent cache, and its jobs run on the main thread,
+   // so there we only decode the base level and let the GPU generate the mipmaps
+   std::unique_ptr<unsigned char, void(*)(void*)> texData(stbi_load(texFilePath.c_str(), &decodedTexture->width, &decodedTexture->height, &decodedTexture->numComponents, 0), stbi_image_free);
+
+   if (!texData)
+   {
+      std::cout << "Error - TextureLoader::decodeResource - The following texture could not be loaded: " << texFilePath << "\n";
+      return nullptr;
+   }
+
+   size_t baseLevelSize = static_cast<size_t>(decodedTexture->width) * decodedTexture->height * decodedTexture->numComponents;
+   decodedTexture->texData.assign(texData.get(), texData.get() + baseLevelSize);
+   decodedTexture->levelOffsets.assign(1, 0);
+#else
+   // The encoded image is hashed to detect when the cache file is out of date, which is much cheaper than decoding it
+   std::vector<unsigned char> encodedImage;
+   if (!TextureLoaderHelpers::ReadFile(texFilePath, encodedImage) || encodedImage.empty())
+   {
+      std::cout << "Error - TextureLoader::decodeResource - The following texture could not be loaded: " << texFilePath << "\n";
+      return nullptr;
+   }
+
+   unsigned long long sourceHash    = TextureLoaderHelpers::HashFNV1a(encodedImage);
+   std::string        cacheFilePath = TextureLoaderHelpers::GetCacheFilePath(texFilePath, wrapS, wrapT, minFilter, magFilter, genMipmap);
+   if (TextureLoaderHelpers::ReadCacheFile(cacheFilePath, sourceHash, *decodedTexture))
+   {
+      return decodedTexture;
+   }
+
+   std::unique_ptr<unsigned char, void(*)(void*)> texData(stbi_load_from_memory(encodedImage.data(),
+                                                                                static_cast<int>(encodedImage.size()),
+                                                                                &decodedTexture->width,
+                                                                                &decodedTexture->height,
+                                                                                &decodedTexture->numComponents,
+                                                                                0),
+                                                          stbi_image_free);
 
    if (!texData)
    {
-      std::cout << "Error - TextureLoader::loadResource - The following texture could not be loaded: " << texFilePath << "\n";
+      std::cout << "Error - TextureLoader::decodeResource - The following texture could not be loaded: " << texFilePath << "\n";
       return nullptr;
    }
 
-   unsigned int texID = generateTexture(texData, width, height, numComponents, wrapS, wrapT, minFilter, magFilter, genMipmap);
+   size_t baseLevelSize = static_cast<size_t>(decodedTexture->width) * decodedTexture->height * decodedTexture->numComponents;
+   decodedTexture->texData.assign(texData.get(), texData.get() + baseLevelSize);
+
+   // Each set of parameters has its own cache file, so the mipmaps are only generated and stored when they are used
+   if (genMipmap)
+   {
+      TextureLoaderHelpers::GenerateMipChain(*decodedTexture);
+   }
+   else
+   {
+      decodedTexture->levelOffsets.assign(1, 0);
+   }
+   TextureLoaderHelpers::WriteCacheFile(cacheFilePath, sourceHash, *decodedTexture);
+#endif
+
+   return decodedTexture;
+}
+
+std::shared_ptr<Texture> TextureLoader::uploadResource(const DecodedResource& decodedTexture) const
+{
+   unsigned int texID = generateTexture(decodedTexture);
 
    return std::make_shared<Texture>(texID);
 }
 
-unsigned int TextureLoader::generateTexture(const std::unique_ptr<unsigned char, void(*)(void*)>& texData,
-                                            int          width,
-                                            int          height,
-                                            int          numComponents,
-                                            unsigned int wrapS,
-                                            unsigned int wrapT,
-                                            unsigned int minFilter,
-                                            unsigned int magFilter,
-                                            bool         genMipmap) const
+size_t TextureLoader::getSizeInBytes(const DecodedResource& decodedTexture)
+{
+   size_t baseLevelSize = static_cast<size_t>(decodedTexture.width) * decodedTexture.height * decodedTexture.numComponents;
+
+   // A full chain of mipmaps adds a third of the size of the base level
+   return decodedTexture.genMipmap ? (baseLevelSize + (baseLevelSize / 3)) : baseLevelSize;
+}
+
+std::string TextureLoader::getResourceID(const std::string& texFilePath,
+                                         unsigned int       wrapS,
+                                         unsigned int       wrapT,
+                                         unsigned int       minFilter,
+                                         unsigned int       magFilter,
+                                         bool               genMipmap)
+{
+   return canonicalizeResourcePath(texFilePath) + "|" + std::to_string(wrapS) + "|" + std::to_string(wrapT) + "|" +
+          std::to_string(minFilter) + "|" + std::to_string(magFilter) + "|" + (genMipmap ? "1" : "0");
+}
+
+bool TextureLoader::readImageSize(const std::string& texFilePath, int& width, int& height)
+{
+   int numComponents;
+   return stbi_info(texFilePath.c_str(), &width, &height, &numComponents) != 0;
+}
+
+unsigned int TextureLoader::generateTexture(const DecodedResource& decodedTexture) const
 {
    GLenum format;
-   switch (numComponents)
+   switch (decodedTexture.numComponents)
    {
    case 3:
       format = GL_RGB;
@@ -45,23 +374,40 @@ unsigned int TextureLoader::generateTexture(const std::unique_ptr<unsigned char,
       format = GL_RGBA;
       break;
    default:
-      std::cout << "Error - TextureLoader::generateTexture - The texture has an invalid number of components: " << numComponents << "\n";
+      std::cout << "Error - TextureLoader::generateTexture - The texture has an invalid number of components: " << decodedTexture.numComponents << "\n";
    }
 
    unsigned int texID;
    glGenTextures(1, &texID);
    glBindTexture(GL_TEXTURE_2D, texID);
-   glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, texData.get());
 
-   if (genMipmap)
+   // The rows of the smaller levels of RGB textures aren't aligned to 4 bytes
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+   // When the decoded texture contains the precomputed levels, each one is uploaded as is
+   // Otherwise, the mipmaps are generated by the GPU
+   unsigned int numLevelsToUpload = decodedTexture.genMipmap ? static_cast<unsigned int>(decodedTexture.levelOffsets.size()) : 1;
+   int          levelWidth        = decodedTexture.width;
+   int          levelHeight       = decodedTexture.height;
+   for (unsigned int level = 0; level < numLevelsToUpload; ++level)
+   {
+      glTexImage2D(GL_TEXTURE_2D, level, format, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE, &decodedTexture.texData[decodedTexture.levelOffsets[level]]);
+
+      levelWidth  = (levelWidth > 1) ? (levelWidth / 2) : 1;
+      levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+   }
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+   if (decodedTexture.genMipmap && decodedTexture.levelOffsets.size() == 1)
    {
       glGenerateMipmap(GL_TEXTURE_2D);
    }
 
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, decodedTexture.wrapS);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, decodedTexture.wrapT);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, decodedTexture.minFilter);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, decodedTexture.magFilter);
 
    glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "BakedClip.h"
+#include "GLTFLoader.h"
+
+/*
+   Bakes the first clip of the glTF files that are passed as arguments, both as local poses and as skin matrices, and checks that:
+   - At the times of the frames, SamplePose and SampleSkinMatrices match the poses that FastClip::Sample samples directly
+   - Between the frames, the frames are blended in the right proportions, and the blended poses are at least as close to the poses that are sampled directly as the frames that surround them
+   - Nearest playback picks the frame that is closest to the playback time
+   - EstimateMemoryFootprint predicts the memory that the baked clip occupies
+
+   Usage: BakedClipCheck <glTF file>...
+
+   The differences are measured between the skin matrices, and the differences between their translations are relative to the size of the skeleton
+*/
+
+namespace BakedClipCheckHelpers
+{
+   const float framesPerSecond       = 30.0f;
+   const float maxDifferenceAtFrames = 1e-4f;
+
+   float CalculateSizeOfSkeleton(Skeleton& skeleton)
+   {
+      std::vector<glm::mat4> restPosePalette;
+      skeleton.GetRestPose().GetMatrixPalette(restPosePalette);
+
+      glm::vec3 minPosition = glm::vec3(restPosePalette[0][3]);
+      glm::vec3 maxPosition = minPosition;
+      for (const glm::mat4& jointMatrix : restPosePalette)
+      {
+         minPosition = glm::min(minPosition, glm::vec3(jointMatrix[3]));
+         maxPosition = glm::max(maxPosition, glm::vec3(jointMatrix[3]));
+      }
+
+      return std::max(glm::length(maxPosition - minPosition), 1e-6f);
+   }
+
+   void CalculateSkinMatrices(Skeleton& skeleton, const Pose& pose, std::vector<glm::mat4>& outSkinMatrices)
+   {
+      pose.GetMatrixPalette(outSkinMatrices);
+      std::vector<glm::mat4>& inverseBindPose = skeleton.GetInvBindPose();
+      for (unsigned int i = 0, size = static_cast<unsigned int>(outSkinMatrices.size()); i < size; ++i)
+      {
+         outSkinMatrices[i] = outSkinMatrices[i] * inverseBindPose[i];
+      }
+   }
+
+   // The first 3 columns of the skin matrices are compared as they are, and the translations relative to the size of the skeleton
+   float CalculateMaxDifference(const std::vector<glm::mat4>& lhs, const std::vector<glm::mat4>& rhs, float sizeOfSkeleton)
+   {
+      if (lhs.size() != rhs.size())
+      {
+         return 1.0f;
+      }
+
+      float maxDifference = 0.0f;
+      for (unsigned int i = 0, size = static_cast<unsigned int>(lhs.size()); i < size; ++i)
+      {
+         for (int column = 0; column < 3; ++column)
+         {
+            maxDifference = std::max(maxDifference, glm::length(lhs[i][column] - rhs[i][column]));
+         }
+         maxDifference = std::max(maxDifference, glm::length(lhs[i][3] - rhs[i][3]) / sizeOfSkeleton);
+      }
+
+      return maxDifference;
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: BakedClipCheck <glTF file>..." << "\n";
+      return 1;
+   }
+
+   bool allClipsMatch = true;
+
+   for (int argIndex = 1; argIndex < argc; ++argIndex)
+   {
+      cgltf_data* data = LoadGLTFFile(argv[argIndex]);
+      if (data == nullptr)
+      {
+         return 1;
+      }
+
+      Skeleton skeleton = LoadSkeleton(data);
+      Clip     clip     = LoadClip(data, 0);
+      FastClip fastClip = OptimizeClip(clip);
+      FreeGLTFFile(data);
+
+      unsigned int numJoints      = skeleton.GetRestPose().GetNumberOfJoints();
+      float        sizeOfSkeleton = BakedClipCheckHelpers::CalculateSizeOfSkeleton(skeleton);
+
+      BakedClip bakedPoses(fastClip, skeleton, BakedClipCheckHelpers::framesPerSecond, BakedClip::Content::LocalPoses);
+      BakedClip bakedSkinMatrices(fastClip, skeleton, BakedClipCheckHelpers::framesPerSecond, BakedClip::Content::SkinMatrices);
+
+      bool footprintsMatch =
+         (BakedClip::EstimateMemoryFootprint(fastClip.GetDuration(), numJoints, BakedClipCheckHelpers::framesPerSecond, BakedClip::Content::LocalPoses) == bakedPoses.GetMemoryFootprint()) &&
+         (BakedClip::EstimateMemoryFootprint(fastClip.GetDuration(), numJoints, BakedClipCheckHelpers::framesPerSecond, BakedClip::Content::SkinMatrices) == bakedSkinMatrices.GetMemoryFootprint());
+
+      float maxDifferenceAtFrames          = 0.0f;
+      float maxDifferenceBetweenFrames     = 0.0f;
+      float maxDifferenceFromBlendedFrames = 0.0f;
+      bool  blendStaysBetweenFrames        = true;
+      bool  nearestPicksClosestFrame       = true;
+
+      Pose                   directPose, bakedPose;
+      std::vector<glm::mat4> directSkinMatrices, bakedSkinMatricesOfPose, sampledSkinMatrices, skinMatricesOfFrame, skinMatricesOfNextFrame, blendedSkinMatrices;
+      unsigned int           numFrames = bakedPoses.GetNumberOfFrames();
+      for (unsigned int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+      {
+         float timeOfFrame = fastClip.GetStartTime() + std::min(frameIndex / BakedClipCheckHelpers::framesPerSecond, fastClip.GetDuration());
+
+         // At the time of a frame, both contents must match the pose that's sampled directly
+         directPose = skeleton.GetRestPose();
+         fastClip.Sample(directPose, timeOfFrame);
+         BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, directPose, directSkinMatrices);
+
+         bakedPose = skeleton.GetRestPose();
+         bakedPoses.SamplePose(timeOfFrame, BakedClip::Playback::Blend, bakedPose);
+         BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, bakedPose, bakedSkinMatricesOfPose);
+         bakedSkinMatrices.SampleSkinMatrices(timeOfFrame, BakedClip::Playback::Blend, sampledSkinMatrices);
+
+         maxDifferenceAtFrames = std::max(maxDifferenceAtFrames, BakedClipCheckHelpers::CalculateMaxDifference(bakedSkinMatricesOfPose, directSkinMatrices, sizeOfSkeleton));
+         maxDifferenceAtFrames = std::max(maxDifferenceAtFrames, BakedClipCheckHelpers::CalculateMaxDifference(sampledSkinMatrices, directSkinMatrices, sizeOfSkeleton));
+
+         if (frameIndex + 1 == numFrames)
+         {
+            break;
+         }
+
+         // Halfway between two frames, the blended poses must be at least as close to the pose that's sampled directly
+         // as the farthest of the two frames, which is what Nearest playback would pick in the worst case
+         float timeOfNextFrame   = fastClip.GetStartTime() + std::min((frameIndex + 1) / BakedClipCheckHelpers::framesPerSecond, fastClip.GetDuration());
+         float timeBetweenFrames = 0.5f * (timeOfFrame + timeOfNextFrame);
+
+         directPose = skeleton.GetRestPose();
+         fastClip.Sample(directPose, timeBetweenFrames);
+         BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, directPose, directSkinMatrices);
+
+         bakedSkinMatrices.SampleSkinMatrices(timeOfFrame, BakedClip::Playback::Nearest, skinMatricesOfFrame);
+         bakedSkinMatrices.SampleSkinMatrices(timeOfNextFrame, BakedClip::Playback::Nearest, skinMatricesOfNextFrame);
+         float maxDifferenceOfFrames = std::max(BakedClipCheckHelpers::CalculateMaxDifference(skinMatricesOfFrame, directSkinMatrices, sizeOfSkeleton),
+                                                BakedClipCheckHelpers::CalculateMaxDifference(skinMatricesOfNextFrame, directSkinMatrices, sizeOfSkeleton));
+
+         bakedPose = skeleton.GetRestPose();
+         bakedPoses.SamplePose(timeBetweenFrames, BakedClip::Playback::Blend, bakedPose);
+         BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, bakedPose, bakedSkinMatricesOfPose);
+         bakedSkinMatrices.SampleSkinMatrices(timeBetweenFrames, BakedClip::Playback::Blend, sampledSkinMatrices);
+
+         // Halfway between two frames, the frames must also be blended in equal parts
+         Pose framePose     = skeleton.GetRestPose();
+         Pose nextFramePose = skeleton.GetRestPose();
+         bakedPoses.SamplePose(timeOfFrame, BakedClip::Playback::Nearest, framePose);
+         bakedPoses.SamplePose(timeOfNextFrame, BakedClip::Playback::Nearest, nextFramePose);
+         for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+         {
+            framePose.SetLocalTransform(jointIndex, mix(framePose.GetLocalTransform(jointIndex), nextFramePose.GetLocalTransform(jointIndex), 0.5f));
+         }
+         BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, framePose, blendedSkinMatrices);
+         maxDifferenceFromBlendedFrames = std::max(maxDifferenceFromBlendedFrames, BakedClipCheckHelpers::CalculateMaxDifference(bakedSkinMatricesOfPose, blendedSkinMatrices, sizeOfSkeleton));
+
+         for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+         {
+            blendedSkinMatrices[jointIndex] = (skinMatricesOfFrame[jointIndex] * 0.5f) + (skinMatricesOfNextFrame[jointIndex] * 0.5f);
+         }
+         maxDifferenceFromBlendedFrames = std::max(maxDifferenceFromBlendedFrames, BakedClipCheckHelpers::CalculateMaxDifference(sampledSkinMatrices, blendedSkinMatrices, sizeOfSkeleton));
+
+         float differenceBetweenFrames = std::max(BakedClipCheckHelpers::CalculateMaxDifference(bakedSkinMatricesOfPose, directSkinMatrices, sizeOfSkeleton),
+                                                  BakedClipCheckHelpers::CalculateMaxDifference(sampledSkinMatrices, directSkinMatrices, sizeOfSkeleton));
+         maxDifferenceBetweenFrames = std::max(maxDifferenceBetweenFrames, differenceBetweenFrames);
+         blendStaysBetweenFrames    &= (differenceBetweenFrames <= maxDifferenceOfFrames + BakedClipCheckHelpers::maxDifferenceAtFrames);
+
+         // A time that's closer to a frame than to the other one must pick that frame
+         for (float fractionOfInterval : { 0.25f, 0.75f })
+         {
+            float                         nearestTime           = timeOfFrame + (fractionOfInterval * (timeOfNextFrame - timeOfFrame));
+            const std::vector<glm::mat4>& expectedSkinMatrices = (fractionOfInterval < 0.5f) ? skinMatricesOfFrame : skinMatricesOfNextFrame;
+
+            bakedSkinMatrices.SampleSkinMatrices(nearestTime, BakedClip::Playback::Nearest, sampledSkinMatrices);
+            nearestPicksClosestFrame &= (sampledSkinMatrices == expectedSkinMatrices);
+
+            bakedPose = skeleton.GetRestPose();
+            bakedPoses.SamplePose(nearestTime, BakedClip::Playback::Nearest, bakedPose);
+            BakedClipCheckHelpers::CalculateSkinMatrices(skeleton, bakedPose, bakedSkinMatricesOfPose);
+            nearestPicksClosestFrame &= (BakedClipCheckHelpers::CalculateMaxDifference(bakedSkinMatricesOfPose, expectedSkinMatrices, sizeOfSkeleton) <= BakedClipCheckHelpers::maxDifferenceAtFrames);
+         }
+      }
+
+      std::cout << argv[argIndex] << " - Frames: " << numFrames
+                << ", Max difference at the frames: " << maxDifferenceAtFrames
+                << ", Max difference between the frames: " << maxDifferenceBetweenFrames
+                << ", Max difference from the blended frames: " << maxDifferenceFromBlendedFrames
+                << ", Blend stays within the frames: " << (blendStaysBetweenFrames ? "yes" : "no")
+                << ", Nearest picks the closest frame: " << (nearestPicksClosestFrame ? "yes" : "no")
+                << ", Estimated footprints match: " << (footprintsMatch ? "yes" : "no") << "\n";
+
+      allClipsMatch &= (maxDifferenceAtFrames <= BakedClipCheckHelpers::maxDifferenceAtFrames) &&
+                       (maxDifferenceFromBlendedFrames <= BakedClipCheckHelpers::maxDifferenceAtFrames) &&
+                       blendStaysBetweenFrames &&
+                       nearestPicksClosestFrame &&
+                       footprintsMatch;
+   }
+
+   if (!allClipsMatch)
+   {
+      std::cout << "Error - BakedClipCheck - The baked clips don't match the clips that are sampled directly" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
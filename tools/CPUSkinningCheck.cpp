@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CPUSkinning.h"
+#include "GLTFLoader.h"
+#include "HeadlessContext.h"
+#include "ThreadPool.h"
+
+/*
+   Checks the CPU skinning of the meshes of the glTF files that are passed as arguments, and of a large random mesh
+   that's split into several chunks by the parallel SkinMesh:
+   - The SSE code of SkinVertices must match the scalar code of SkinVerticesWithScalarCode up to rounding errors
+   - The parallel SkinMesh must produce exactly the same vertices as the serial SkinMesh
+
+   Usage: CPUSkinningCheck <glTF file>...
+
+   An AnimatedMesh creates its VAO when it's constructed, so this needs a GL context even though nothing is drawn
+*/
+
+namespace CPUSkinningCheckHelpers
+{
+   // The SSE code adds the terms of the blended matrices in a different order, so the results can differ in their last bits
+   const float maxRelativePositionDifference = 1e-5f;
+   const float maxNormalDifference           = 1e-5f;
+
+   std::vector<glm::mat4> GenerateSkinMatrices(unsigned int numMatrices, std::mt19937& randomEngine)
+   {
+      std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+      std::vector<glm::mat4> skinMatrices(numMatrices);
+      for (glm::mat4& skinMatrix : skinMatrices)
+      {
+         skinMatrix = glm::mat4(1.0f);
+         for (int column = 0; column < 3; ++column)
+         {
+            for (int row = 0; row < 3; ++row)
+            {
+               skinMatrix[column][row] += 0.3f * distribution(randomEngine);
+            }
+         }
+         skinMatrix[3] = glm::vec4(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine), 1.0f);
+      }
+
+      return skinMatrices;
+   }
+
+   void GenerateRandomMesh(unsigned int numVertices, unsigned int numJoints, std::mt19937& randomEngine, AnimatedMesh& mesh)
+   {
+      std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+      std::uniform_int_distribution<int>    jointDistribution(0, static_cast<int>(numJoints) - 1);
+
+      for (unsigned int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+      {
+         mesh.GetPositions().push_back(glm::vec3(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine)) * 100.0f);
+         mesh.GetNormals().push_back(glm::normalize(glm::vec3(distribution(randomEngine), distribution(randomEngine), 1.5f)));
+
+         glm::vec4 weights = glm::abs(glm::vec4(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine), distribution(randomEngine)));
+         mesh.GetWeights().push_back(weights / (weights.x + weights.y + weights.z + weights.w + 1e-6f));
+         mesh.GetInfluences().push_back(glm::ivec4(jointDistribution(randomEngine), jointDistribution(randomEngine), jointDistribution(randomEngine), jointDistribution(randomEngine)));
+      }
+   }
+
+   bool CheckMesh(const std::string& name, const AnimatedMesh& mesh, const std::vector<glm::mat4>& skinMatrices, ThreadPool& threadPool)
+   {
+      std::vector<glm::vec3> serialPositions, serialNormals, parallelPositions, parallelNormals;
+      SkinMesh(mesh, skinMatrices, serialPositions, serialNormals);
+      SkinMesh(mesh, skinMatrices, parallelPositions, parallelNormals, threadPool);
+
+      unsigned int numVertices = static_cast<unsigned int>(mesh.GetPositions().size());
+      std::vector<glm::vec3> scalarPositions(numVertices), scalarNormals(mesh.GetNormals().size());
+      SkinVerticesWithScalarCode(mesh.GetPositions().data(),
+                                 mesh.GetNormals().empty() ? nullptr : mesh.GetNormals().data(),
+                                 mesh.GetWeights().data(),
+                                 mesh.GetInfluences().data(),
+                                 numVertices,
+                                 skinMatrices,
+                                 scalarPositions.data(),
+                                 mesh.GetNormals().empty() ? nullptr : scalarNormals.data());
+
+      bool parallelMatchesSerial = (parallelPositions == serialPositions) && (parallelNormals == serialNormals);
+
+      float maxPositionDifference = 0.0f;
+      float maxNormalDifference   = 0.0f;
+      for (unsigned int i = 0; i < numVertices; ++i)
+      {
+         float positionDifference = glm::length(serialPositions[i] - scalarPositions[i]) / std::max(glm::length(scalarPositions[i]), 1.0f);
+         maxPositionDifference = std::max(maxPositionDifference, positionDifference);
+      }
+      for (unsigned int i = 0, size = static_cast<unsigned int>(scalarNormals.size()); i < size; ++i)
+      {
+         maxNormalDifference = std::max(maxNormalDifference, glm::length(serialNormals[i] - scalarNormals[i]));
+      }
+
+      std::cout << name << " - Vertices: " << numVertices
+                << ", Max relative position difference: " << maxPositionDifference
+                << ", Max normal difference: " << maxNormalDifference
+                << ", Parallel matches serial: " << (parallelMatchesSerial ? "yes" : "no") << "\n";
+
+      return parallelMatchesSerial &&
+             (maxPositionDifference <= maxRelativePositionDifference) &&
+             (maxNormalDifference <= CPUSkinningCheckHelpers::maxNormalDifference);
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   HeadlessContext context;
+   if (!context.IsValid())
+   {
+      return HeadlessContext::skipReturnCode;
+   }
+
+   std::mt19937 randomEngine(3);
+   ThreadPool   threadPool(3);
+   bool         allMeshesMatch = true;
+
+   for (int argIndex = 1; argIndex < argc; ++argIndex)
+   {
+      cgltf_data* data = LoadGLTFFile(argv[argIndex]);
+      if (data == nullptr)
+      {
+         return 1;
+      }
+
+      unsigned int              numJoints    = LoadSkeleton(data).GetRestPose().GetNumberOfJoints();
+      std::vector<AnimatedMesh> meshes       = LoadAnimatedMeshes(data, false);
+      std::vector<glm::mat4>    skinMatrices = CPUSkinningCheckHelpers::GenerateSkinMatrices(numJoints, randomEngine);
+      FreeGLTFFile(data);
+
+      for (const AnimatedMesh& mesh : meshes)
+      {
+         allMeshesMatch &= CPUSkinningCheckHelpers::CheckMesh(argv[argIndex], mesh, skinMatrices, threadPool);
+      }
+   }
+
+   // The meshes of the models are small, so this one makes sure that the vertices are split into several chunks
+   const unsigned int numJointsOfRandomMesh = 64;
+   AnimatedMesh randomMesh;
+   CPUSkinningCheckHelpers::GenerateRandomMesh(100000, numJointsOfRandomMesh, randomEngine, randomMesh);
+   allMeshesMatch &= CPUSkinningCheckHelpers::CheckMesh("Random mesh", randomMesh, CPUSkinningCheckHelpers::GenerateSkinMatrices(numJointsOfRandomMesh, randomEngine), threadPool);
+
+   if (!allMeshesMatch)
+   {
+      std::cout << "Error - CPUSkinningCheck - The skinned vertices don't match" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
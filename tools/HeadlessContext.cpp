@@ -0,0 +1,85 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+#include "HeadlessContext.h"
+
+extern "C" GLFWglproc glfwGetProcAddress(const char* procname)
+{
+   return reinterpret_cast<GLFWglproc>(eglGetProcAddress(procname));
+}
+
+HeadlessContext::HeadlessContext()
+   : mDisplay(EGL_NO_DISPLAY)
+   , mSurface(EGL_NO_SURFACE)
+   , mContext(EGL_NO_CONTEXT)
+   , mIsValid(false)
+{
+   mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+   if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, nullptr, nullptr))
+   {
+      std::cout << "Error - HeadlessContext::HeadlessContext - The EGL display could not be initialized" << "\n";
+      return;
+   }
+
+   EGLint configAttributes[] = { EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+                                 EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                 EGL_NONE };
+   EGLConfig config;
+   EGLint    numConfigs = 0;
+   if (!eglChooseConfig(mDisplay, configAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+   {
+      std::cout << "Error - HeadlessContext::HeadlessContext - No EGL config supports OpenGL and pbuffers" << "\n";
+      return;
+   }
+
+   EGLint surfaceAttributes[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+   mSurface = eglCreatePbufferSurface(mDisplay, config, surfaceAttributes);
+
+   eglBindAPI(EGL_OPENGL_API);
+   EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION,       3,
+                                  EGL_CONTEXT_MINOR_VERSION,       3,
+                                  EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                  EGL_NONE };
+   mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+   if (mSurface == EGL_NO_SURFACE || mContext == EGL_NO_CONTEXT || !eglMakeCurrent(mDisplay, mSurface, mSurface, mContext))
+   {
+      std::cout << "Error - HeadlessContext::HeadlessContext - An OpenGL 3.3 core context could not be created" << "\n";
+      return;
+   }
+
+   if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+   {
+      std::cout << "Error - HeadlessContext::HeadlessContext - Failed to initialize GLAD" << "\n";
+      return;
+   }
+
+   mIsValid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+   if (mDisplay == EGL_NO_DISPLAY)
+   {
+      return;
+   }
+
+   eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   if (mContext != EGL_NO_CONTEXT)
+   {
+      eglDestroyContext(mDisplay, mContext);
+   }
+
+   if (mSurface != EGL_NO_SURFACE)
+   {
+      eglDestroySurface(mDisplay, mSurface);
+   }
+
+   eglTerminate(mDisplay);
+}
+
+bool HeadlessContext::IsValid() const
+{
+   return mIsValid;
+}
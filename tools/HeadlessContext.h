@@ -0,0 +1,37 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <EGL/egl.h>
+
+/*
+   A HeadlessContext creates an OpenGL 3.3 core context that renders into a small pbuffer instead of a window,
+   and loads the OpenGL functions with glad, so that the tools can use the rendering code of the engine without a display
+
+   The engine loads the functions that aren't part of OpenGL 3.3 with glfwGetProcAddress (see ProgramBinaryCache),
+   so HeadlessContext.cpp defines that function on top of eglGetProcAddress instead of linking GLFW
+*/
+
+class HeadlessContext
+{
+public:
+
+   // The exit code of the tools that need a context and can't create one, which CTest reports as a skipped test
+   static constexpr int skipReturnCode = 77;
+
+   HeadlessContext();
+   ~HeadlessContext();
+
+   HeadlessContext(const HeadlessContext&) = delete;
+   HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+   bool IsValid() const;
+
+private:
+
+   EGLDisplay mDisplay;
+   EGLSurface mSurface;
+   EGLContext mContext;
+   bool       mIsValid;
+};
+
+#endif
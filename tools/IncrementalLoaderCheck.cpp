@@ -0,0 +1,182 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "IncrementalLoader.h"
+
+/*
+   Checks the IncrementalLoader with steps that sleep instead of loading anything:
+   - A call to ProcessSteps stops executing steps once its time budget has been used up
+   - A call to ProcessSteps always executes at least one step, even when that step exceeds the time budget
+   - A resumable step is called again until it returns true, and only then does the loader move on to the next step
+   - GetProgress, IsDone and GetDescriptionOfNextStep reflect the steps that have been completed
+
+   Usage: IncrementalLoaderCheck
+
+   A step can only take longer than it sleeps, so the checks below hold no matter how loaded the machine is
+*/
+
+namespace IncrementalLoaderCheckHelpers
+{
+   const float        timeBudgetInMilliseconds   = 20.0f;
+   const unsigned int stepDurationInMilliseconds = 5;
+   const unsigned int numSteps                   = 10;
+   const unsigned int numCallsOfResumableStep    = 5;
+
+   void Sleep(unsigned int durationInMilliseconds)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(durationInMilliseconds));
+   }
+
+   void Check(bool condition, const std::string& description, bool& ioAllChecksPass)
+   {
+      if (!condition)
+      {
+         std::cout << "Error - IncrementalLoaderCheck - " << description << "\n";
+         ioAllChecksPass = false;
+      }
+   }
+
+   bool CheckTimeBudget()
+   {
+      bool allChecksPass = true;
+
+      IncrementalLoader loader(timeBudgetInMilliseconds);
+      for (unsigned int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+      {
+         loader.AddStep("Sleeping " + std::to_string(stepIndex), []() { Sleep(stepDurationInMilliseconds); });
+      }
+
+      // The budget is checked after each step, so a call can't execute more steps than fit in the budget
+      const unsigned int maxNumStepsPerCall = static_cast<unsigned int>(timeBudgetInMilliseconds) / stepDurationInMilliseconds;
+
+      unsigned int numCalls = 0;
+      while (!loader.IsDone() && numCalls < numSteps)
+      {
+         unsigned int numCompletedStepsBefore = loader.GetNumberOfCompletedSteps();
+
+         std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+         bool isDone = loader.ProcessSteps();
+         float durationOfCall = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+         ++numCalls;
+
+         unsigned int numStepsOfCall = loader.GetNumberOfCompletedSteps() - numCompletedStepsBefore;
+         std::cout << "Time budget - Call " << numCalls << ": " << numStepsOfCall << " steps in " << durationOfCall << " ms" << "\n";
+
+         Check(numStepsOfCall >= 1, "A call to ProcessSteps didn't execute any steps", allChecksPass);
+         Check(numStepsOfCall <= maxNumStepsPerCall, "A call to ProcessSteps executed more steps than fit in its time budget", allChecksPass);
+         Check(isDone || durationOfCall >= timeBudgetInMilliseconds, "A call to ProcessSteps stopped before its time budget was used up", allChecksPass);
+         Check(isDone == loader.IsDone(), "ProcessSteps and IsDone disagree", allChecksPass);
+      }
+
+      Check(loader.IsDone(), "The steps weren't completed", allChecksPass);
+      Check(numCalls > 1, "The steps weren't spread over several calls to ProcessSteps", allChecksPass);
+      return allChecksPass;
+   }
+
+   bool CheckProgressWhenStepsExceedTheBudget()
+   {
+      bool allChecksPass = true;
+
+      // Every step takes longer than the budget, so each call must execute exactly one of them
+      IncrementalLoader loader(1.0f);
+      for (unsigned int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+      {
+         loader.AddStep("Sleeping " + std::to_string(stepIndex), []() { Sleep(stepDurationInMilliseconds); });
+      }
+
+      for (unsigned int callIndex = 0; callIndex < numSteps; ++callIndex)
+      {
+         loader.ProcessSteps();
+         Check(loader.GetNumberOfCompletedSteps() == callIndex + 1, "A call to ProcessSteps didn't execute exactly one step that exceeds the budget", allChecksPass);
+      }
+
+      Check(loader.IsDone(), "The steps that exceed the budget weren't completed", allChecksPass);
+      std::cout << "Steps that exceed the budget - " << loader.GetNumberOfCompletedSteps() << " steps in " << numSteps << " calls" << "\n";
+      return allChecksPass;
+   }
+
+   bool CheckResumableStep()
+   {
+      bool allChecksPass = true;
+
+      unsigned int numCalls    = 0;
+      bool         lastStepRan = false;
+      IncrementalLoader loader(1.0f);
+      loader.AddResumableStep("Resuming", [&numCalls]()
+      {
+         Sleep(stepDurationInMilliseconds);
+         return (++numCalls == numCallsOfResumableStep);
+      });
+      loader.AddStep("Finishing", [&lastStepRan]() { lastStepRan = true; });
+
+      // The resumable step exceeds the budget, so each call to ProcessSteps calls it once
+      for (unsigned int callIndex = 1; callIndex < numCallsOfResumableStep; ++callIndex)
+      {
+         loader.ProcessSteps();
+         Check(numCalls == callIndex, "The resumable step wasn't called once per call to ProcessSteps", allChecksPass);
+         Check(loader.GetNumberOfCompletedSteps() == 0, "The loader moved on before the resumable step returned true", allChecksPass);
+         Check(loader.GetDescriptionOfNextStep() == "Resuming", "The next step isn't the resumable step", allChecksPass);
+      }
+
+      loader.ProcessSteps();
+      Check(numCalls == numCallsOfResumableStep && loader.GetNumberOfCompletedSteps() == 1, "The resumable step wasn't completed once it returned true", allChecksPass);
+      Check(loader.GetDescriptionOfNextStep() == "Finishing", "The loader didn't move on to the step after the resumable step", allChecksPass);
+
+      loader.ProcessSteps();
+      Check(lastStepRan && loader.IsDone(), "The step after the resumable step wasn't completed", allChecksPass);
+      Check(numCalls == numCallsOfResumableStep, "The resumable step was called again after it returned true", allChecksPass);
+
+      std::cout << "Resumable step - Called " << numCalls << " times" << "\n";
+      return allChecksPass;
+   }
+
+   bool CheckProgress()
+   {
+      bool allChecksPass = true;
+
+      IncrementalLoader emptyLoader;
+      Check(emptyLoader.IsDone() && emptyLoader.GetProgress() == 1.0f, "An empty loader isn't done", allChecksPass);
+      Check(emptyLoader.GetDescriptionOfNextStep() == "Done", "An empty loader doesn't describe itself as done", allChecksPass);
+      Check(emptyLoader.ProcessSteps(), "ProcessSteps doesn't return true for an empty loader", allChecksPass);
+
+      // Every step exceeds the budget, so the progress advances by one step per call
+      IncrementalLoader loader(0.0f);
+      const unsigned int numStepsOfLoader = 4;
+      for (unsigned int stepIndex = 0; stepIndex < numStepsOfLoader; ++stepIndex)
+      {
+         loader.AddStep("Step " + std::to_string(stepIndex), []() { Sleep(1); });
+      }
+
+      Check(!loader.IsDone() && loader.GetProgress() == 0.0f, "A loader whose steps haven't been executed has made progress", allChecksPass);
+      Check(loader.GetNumberOfSteps() == numStepsOfLoader, "The number of steps is wrong", allChecksPass);
+      for (unsigned int stepIndex = 1; stepIndex <= numStepsOfLoader; ++stepIndex)
+      {
+         bool isDone = loader.ProcessSteps();
+         Check(loader.GetProgress() == static_cast<float>(stepIndex) / numStepsOfLoader, "The progress doesn't match the number of completed steps", allChecksPass);
+         Check(isDone == (stepIndex == numStepsOfLoader) && isDone == loader.IsDone(), "The loader is done too early or too late", allChecksPass);
+      }
+
+      Check(loader.GetDescriptionOfNextStep() == "Done", "A finished loader doesn't describe itself as done", allChecksPass);
+      std::cout << "Progress - " << loader.GetNumberOfCompletedSteps() << " / " << loader.GetNumberOfSteps() << " steps, " << (100.0f * loader.GetProgress()) << "%" << "\n";
+      return allChecksPass;
+   }
+}
+
+int main()
+{
+   bool allChecksPass = true;
+   allChecksPass &= IncrementalLoaderCheckHelpers::CheckTimeBudget();
+   allChecksPass &= IncrementalLoaderCheckHelpers::CheckProgressWhenStepsExceedTheBudget();
+   allChecksPass &= IncrementalLoaderCheckHelpers::CheckResumableStep();
+   allChecksPass &= IncrementalLoaderCheckHelpers::CheckProgress();
+
+   if (!allChecksPass)
+   {
+      std::cout << "Error - IncrementalLoaderCheck - The loader doesn't respect its time budget or doesn't make progress" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
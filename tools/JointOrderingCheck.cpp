@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "GLTFLoader.h"
+#include "RearrangeBones.h"
+
+/*
+   Rearranges the skeletons of the glTF files that are passed as arguments both breadth first and depth first, and checks that:
+   - The skin matrices of the first clip are the same in both orderings once the joint maps are taken into account
+   - The depth first ordering stores every subtree contiguously
+   - IsInSubtree and AddSubtreeToMask agree with a walk up the parents of the joints for every pair of joints, in both orderings
+
+   Usage: JointOrderingCheck <glTF file>...
+*/
+
+namespace JointOrderingCheckHelpers
+{
+   const float sampleTime = 0.3f;
+
+   std::vector<glm::mat4> SampleSkinMatrices(Skeleton& skeleton, FastClip& clip)
+   {
+      Pose pose = skeleton.GetRestPose();
+      clip.Sample(pose, clip.AdjustTimeToBeWithinClip(sampleTime));
+
+      std::vector<glm::mat4> skinMatrices;
+      pose.GetMatrixPalette(skinMatrices);
+      std::vector<glm::mat4>& inverseBindPose = skeleton.GetInvBindPose();
+      for (unsigned int i = 0, size = static_cast<unsigned int>(skinMatrices.size()); i < size; ++i)
+      {
+         skinMatrices[i] = skinMatrices[i] * inverseBindPose[i];
+      }
+
+      return skinMatrices;
+   }
+
+   bool IsInSubtreeAccordingToParents(const JointHierarchy& jointHierarchy, unsigned int jointIndex, unsigned int rootOfSubtree)
+   {
+      int ancestorIndex = static_cast<int>(jointIndex);
+      while (ancestorIndex >= 0 && ancestorIndex != static_cast<int>(rootOfSubtree))
+      {
+         ancestorIndex = jointHierarchy.GetJoint(ancestorIndex).parent;
+      }
+
+      return (ancestorIndex == static_cast<int>(rootOfSubtree));
+   }
+
+   bool CheckSubtrees(const JointHierarchy& jointHierarchy)
+   {
+      unsigned int      numJoints = jointHierarchy.GetNumberOfJoints();
+      std::vector<bool> mask;
+      for (unsigned int rootOfSubtree = 0; rootOfSubtree < numJoints; ++rootOfSubtree)
+      {
+         mask.assign(numJoints, false);
+         jointHierarchy.AddSubtreeToMask(rootOfSubtree, mask);
+
+         for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+         {
+            bool isInSubtree = IsInSubtreeAccordingToParents(jointHierarchy, jointIndex, rootOfSubtree);
+            if (jointHierarchy.IsInSubtree(jointIndex, rootOfSubtree) != isInSubtree || mask[jointIndex] != isInSubtree)
+            {
+               return false;
+            }
+         }
+      }
+
+      return true;
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: JointOrderingCheck <glTF file>..." << "\n";
+      return 1;
+   }
+
+   bool allSkeletonsMatch = true;
+
+   for (int argIndex = 1; argIndex < argc; ++argIndex)
+   {
+      cgltf_data* data = LoadGLTFFile(argv[argIndex]);
+      if (data == nullptr)
+      {
+         return 1;
+      }
+
+      Skeleton breadthFirstSkeleton = LoadSkeleton(data);
+      Skeleton depthFirstSkeleton   = breadthFirstSkeleton;
+      Clip     clip                 = LoadClip(data, 0);
+      FastClip breadthFirstClip     = OptimizeClip(clip);
+      FastClip depthFirstClip       = breadthFirstClip;
+      FreeGLTFFile(data);
+
+      JointMap breadthFirstJointMap = RearrangeSkeleton(breadthFirstSkeleton, JointOrdering::BreadthFirst);
+      JointMap depthFirstJointMap   = RearrangeSkeleton(depthFirstSkeleton, JointOrdering::DepthFirst);
+      RearrangeFastClip(breadthFirstClip, breadthFirstJointMap);
+      RearrangeFastClip(depthFirstClip, depthFirstJointMap);
+
+      // The joint maps are indexed by the original index of each joint
+      std::vector<glm::mat4> breadthFirstSkinMatrices = JointOrderingCheckHelpers::SampleSkinMatrices(breadthFirstSkeleton, breadthFirstClip);
+      std::vector<glm::mat4> depthFirstSkinMatrices   = JointOrderingCheckHelpers::SampleSkinMatrices(depthFirstSkeleton, depthFirstClip);
+      float maxDifference = 0.0f;
+      for (unsigned int i = 0, size = static_cast<unsigned int>(breadthFirstJointMap.size()); i < size; ++i)
+      {
+         for (int column = 0; column < 4; ++column)
+         {
+            maxDifference = std::max(maxDifference, glm::length(breadthFirstSkinMatrices[breadthFirstJointMap[i]][column] - depthFirstSkinMatrices[depthFirstJointMap[i]][column]));
+         }
+      }
+
+      const JointHierarchy& breadthFirstHierarchy = breadthFirstSkeleton.GetJointHierarchy();
+      const JointHierarchy& depthFirstHierarchy   = depthFirstSkeleton.GetJointHierarchy();
+      bool breadthFirstSubtreesMatch = JointOrderingCheckHelpers::CheckSubtrees(breadthFirstHierarchy);
+      bool depthFirstSubtreesMatch   = JointOrderingCheckHelpers::CheckSubtrees(depthFirstHierarchy);
+
+      std::cout << argv[argIndex] << " - Joints: " << depthFirstHierarchy.GetNumberOfJoints()
+                << ", Max skin matrix difference: " << maxDifference
+                << ", Contiguous subtrees (breadth first / depth first): " << (breadthFirstHierarchy.HasContiguousSubtrees() ? "yes" : "no")
+                << " / " << (depthFirstHierarchy.HasContiguousSubtrees() ? "yes" : "no")
+                << ", Subtrees match the parents: " << ((breadthFirstSubtreesMatch && depthFirstSubtreesMatch) ? "yes" : "no") << "\n";
+
+      allSkeletonsMatch &= (maxDifference == 0.0f) &&
+                           depthFirstHierarchy.HasContiguousSubtrees() &&
+                           breadthFirstSubtreesMatch &&
+                           depthFirstSubtreesMatch;
+   }
+
+   if (!allSkeletonsMatch)
+   {
+      std::cout << "Error - JointOrderingCheck - The breadth first and depth first skeletons don't match" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
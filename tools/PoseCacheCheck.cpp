@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "GLTFLoader.h"
+#include "PoseCache.h"
+
+/*
+   Simulates a crowd of 100 instances that play the first clip of a glTF file for 200 frames:
+   50 instances are synchronized, and the other 50 are split into 5 groups whose times are offset from each other,
+   one of which is synchronized with the first 50 instances
+   That's 5 unique poses per frame, so 95% of the lookups must be hits
+
+   Every pose that the cache returns must match the pose that's sampled directly, both in its palette and in its skin matrices
+
+   Usage: PoseCacheCheck <glTF file>
+*/
+
+namespace PoseCacheCheckHelpers
+{
+   const unsigned int numInstances             = 100;
+   const unsigned int numSynchronizedInstances = 50;
+   const unsigned int numGroupsOfInstances     = 5;
+   const unsigned int numFrames                = 200;
+   const float        timeOffsetOfGroups       = 0.3f;
+   const float        deltaTime                = 0.016f;
+
+   float CalculateMaxDifference(const std::vector<glm::mat4>& lhs, const std::vector<glm::mat4>& rhs)
+   {
+      if (lhs.size() != rhs.size())
+      {
+         return 1.0f;
+      }
+
+      float maxDifference = 0.0f;
+      for (unsigned int i = 0, size = static_cast<unsigned int>(lhs.size()); i < size; ++i)
+      {
+         for (int column = 0; column < 4; ++column)
+         {
+            maxDifference = std::max(maxDifference, glm::length(lhs[i][column] - rhs[i][column]));
+         }
+      }
+
+      return maxDifference;
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: PoseCacheCheck <glTF file>" << "\n";
+      return 1;
+   }
+
+   cgltf_data* data = LoadGLTFFile(argv[1]);
+   if (data == nullptr)
+   {
+      return 1;
+   }
+
+   Skeleton skeleton = LoadSkeleton(data);
+   Clip     clip     = LoadClip(data, 0);
+   FastClip fastClip = OptimizeClip(clip);
+   FreeGLTFFile(data);
+
+   std::vector<glm::mat4>& inverseBindPose = skeleton.GetInvBindPose();
+
+   PoseCache              cache;
+   float                  maxDifference = 0.0f;
+   Pose                   sampledPose;
+   std::vector<glm::mat4> sampledPosePalette;
+   std::vector<glm::mat4> sampledSkinMatrices;
+   for (unsigned int frameIndex = 0; frameIndex < PoseCacheCheckHelpers::numFrames; ++frameIndex)
+   {
+      cache.BeginFrame();
+
+      float timeOfFrame = frameIndex * PoseCacheCheckHelpers::deltaTime;
+      for (unsigned int instanceIndex = 0; instanceIndex < PoseCacheCheckHelpers::numInstances; ++instanceIndex)
+      {
+         unsigned int groupIndex     = (instanceIndex < PoseCacheCheckHelpers::numSynchronizedInstances) ? 0 : (instanceIndex % PoseCacheCheckHelpers::numGroupsOfInstances);
+         float        timeOfInstance = fastClip.AdjustTimeToBeWithinClip(timeOfFrame + (groupIndex * PoseCacheCheckHelpers::timeOffsetOfGroups));
+
+         const PoseCache::Entry& cachedPose = cache.GetPose(fastClip, timeOfInstance, skeleton);
+
+         sampledPose = skeleton.GetRestPose();
+         fastClip.Sample(sampledPose, timeOfInstance);
+         sampledPose.GetMatrixPalette(sampledPosePalette);
+         sampledSkinMatrices.resize(sampledPosePalette.size());
+         for (unsigned int i = 0, size = static_cast<unsigned int>(sampledPosePalette.size()); i < size; ++i)
+         {
+            sampledSkinMatrices[i] = sampledPosePalette[i] * inverseBindPose[i];
+         }
+
+         maxDifference = std::max(maxDifference, PoseCacheCheckHelpers::CalculateMaxDifference(cachedPose.posePalette, sampledPosePalette));
+         maxDifference = std::max(maxDifference, PoseCacheCheckHelpers::CalculateMaxDifference(cachedPose.skinMatrices, sampledSkinMatrices));
+      }
+   }
+
+   const PoseCache::Statistics& totalStatistics = cache.GetTotalStatistics();
+   unsigned int numLookups = totalStatistics.numHits + totalStatistics.numMisses;
+   float        hitRate    = (numLookups > 0) ? (static_cast<float>(totalStatistics.numHits) / numLookups) : 0.0f;
+   std::cout << "Hits: " << totalStatistics.numHits << ", Misses: " << totalStatistics.numMisses
+             << ", Hit rate: " << (100.0f * hitRate) << "%, Max difference from direct sampling: " << maxDifference << "\n";
+
+   if (numLookups != PoseCacheCheckHelpers::numInstances * PoseCacheCheckHelpers::numFrames || hitRate < 0.95f || maxDifference != 0.0f)
+   {
+      std::cout << "Error - PoseCacheCheck - The pose cache doesn't share the poses of the synchronized instances, or it returns different poses" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,101 @@
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HeadlessContext.h"
+#include "PerFrameUniformBuffer.h"
+#include "ProgramBinaryCache.h"
+#include "shader_loader.h"
+
+/*
+   Measures the time it takes to load the programs of the model viewer and to draw once with each of them,
+   which is the part of the time to first frame that the program binary cache affects
+
+   Usage: ProgramBinaryCacheBenchmark <resources directory> [--clear-cache]
+
+   With --clear-cache, the cache file is deleted first, so every program is compiled and stored (a cold start)
+   Without it, every program is expected to be loaded from the cache file written by a previous run (a warm start),
+   and the benchmark fails if any program had to be compiled
+
+   Unlike the time to first frame that the model viewer logs, this waits for the GPU with glFinish,
+   so it includes the work that drivers defer until a program is first used
+*/
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: ProgramBinaryCacheBenchmark <resources directory> [--clear-cache]" << "\n";
+      return 1;
+   }
+
+   std::string shadersDirectory = std::string(argv[1]) + "/shaders/";
+   bool        clearCache       = (argc > 2) && (std::string(argv[2]) == "--clear-cache");
+   if (clearCache)
+   {
+      std::remove(ProgramBinaryCache::GetCacheFilePath());
+   }
+
+   HeadlessContext context;
+   if (!context.IsValid())
+   {
+      return HeadlessContext::skipReturnCode;
+   }
+
+   std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+   // These are the programs that ModelViewerState::loadShaders loads
+   ShaderLoader                         loader;
+   std::vector<std::shared_ptr<Shader>> shaders;
+   shaders.push_back(loader.loadResource(shadersDirectory + "animated_mesh_with_pregenerated_skin_matrices.vert", shadersDirectory + "diffuse_illumination.frag"));
+   for (unsigned int numInfluences : { 1u, 2u, 4u })
+   {
+      std::vector<std::string> defines { "NUM_INFLUENCES " + std::to_string(numInfluences) };
+      shaders.push_back(loader.loadResource(shadersDirectory + "animated_mesh_with_packed_vertices.vert", shadersDirectory + "diffuse_illumination.frag", defines));
+   }
+   std::vector<std::string> skinnedVaryings { "skinnedPosition", "skinnedNormal" };
+   shaders.push_back(loader.loadResource(shadersDirectory + "skinning_transform_feedback.vert", shadersDirectory + "skinning_transform_feedback.frag", std::vector<std::string>(), skinnedVaryings));
+   shaders.push_back(loader.loadResource(shadersDirectory + "static_mesh.vert", shadersDirectory + "diffuse_illumination.frag"));
+   shaders.push_back(loader.loadResource(shadersDirectory + "static_mesh.vert", shadersDirectory + "ambient_diffuse_illumination.frag"));
+
+   // Draw a triangle without any attributes with each program, so that the drivers that defer work until the first draw do it now
+   PerFrameUniformBuffer perFrameUniformBuffer;
+   perFrameUniformBuffer.Upload(PerFrameUniformBuffer::Data{});
+   unsigned int emptyVAO = 0;
+   glGenVertexArrays(1, &emptyVAO);
+   glBindVertexArray(emptyVAO);
+   for (const std::shared_ptr<Shader>& shader : shaders)
+   {
+      if (!shader)
+      {
+         std::cout << "Error - ProgramBinaryCacheBenchmark - A program could not be loaded" << "\n";
+         return 1;
+      }
+
+      shader->use(true);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      shader->use(false);
+   }
+   glBindVertexArray(0);
+   glFinish();
+
+   float timeToFirstFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+   std::cout << (clearCache ? "Cold start" : "Warm start") << " - Time to first frame: " << timeToFirstFrame << " ms ("
+             << ProgramBinaryCache::GetNumberOfLoadedPrograms() << " programs loaded from the binary cache, "
+             << ProgramBinaryCache::GetNumberOfCompiledPrograms() << " programs compiled)" << "\n";
+
+   glDeleteVertexArrays(1, &emptyVAO);
+
+   if (!clearCache && ProgramBinaryCache::GetNumberOfCompiledPrograms() != 0)
+   {
+      std::cout << "Error - ProgramBinaryCacheBenchmark - Some programs weren't loaded from the binary cache" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,234 @@
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Clip.h"
+#include "HeadlessContext.h"
+#include "Skeleton.h"
+#include "TrackVisualizer.h"
+
+/*
+   Builds a synthetic skeleton with 500 joints and a clip that rotates every one of them, pages through the graphs of the clip
+   with the track visualizer, and checks that:
+   - The graphs are split into pages and setPage visits each one of them
+   - The tracks that aren't on the current page cost almost nothing when setTracks is called
+   - Building a page takes about as long as building the graphs of a clip that fits on a single page, no matter how many tracks there are
+
+   Both the curves that are evaluated on the GPU and the ones that are sampled on the CPU are checked
+
+   Usage: TrackVisualizerPagingCheck
+
+   The track visualizer loads its shaders from resources/shaders, so the check must run from a folder that contains the resources
+   The build times are the fastest of a few repetitions, so that a busy machine doesn't make the check fail
+*/
+
+namespace TrackVisualizerPagingCheckHelpers
+{
+   const unsigned int numJoints                      = 500;
+   const unsigned int numFrames                      = 30;
+   const float        duration                       = 2.0f;
+   const unsigned int numRepetitions                 = 5;
+
+   // This must match mMaxNumGraphsPerPage in TrackVisualizer.cpp
+   const unsigned int maxNumGraphsPerPage            = 36;
+
+   // An off-page track is only checked and copied, so it must cost a small fraction of a track that is sampled and gets geometry
+   const float        maxRelativeCostOfOffPageTrack  = 0.1f;
+
+   // The tools are built without optimizations by default, which makes sampling the curves on the CPU several times slower than in the model viewer
+   const float        maxRelativePageBuildTime       = 1.5f;
+   const float        maxPageBuildTimeInMilliseconds = 100.0f;
+
+   Skeleton CreateSkeleton()
+   {
+      // The joints form a binary tree, so the skeleton is as deep as the ones of real characters
+      Pose                     restPose(numJoints);
+      std::vector<std::string> jointNames(numJoints);
+      for (unsigned int jointIndex = 0; jointIndex < numJoints; ++jointIndex)
+      {
+         int parentIndex = (jointIndex == 0) ? -1 : static_cast<int>((jointIndex - 1) / 2);
+         restPose.SetParent(jointIndex, parentIndex);
+         restPose.SetLocalTransform(jointIndex, Transform(glm::vec3((jointIndex % 2 == 0) ? 0.1f : -0.1f, 0.2f, 0.0f), Q::quat(), glm::vec3(1.0f)));
+         jointNames[jointIndex] = "Joint " + std::to_string(jointIndex);
+      }
+
+      return Skeleton(restPose, restPose, jointNames);
+   }
+
+   FastClip CreateClip(Skeleton& skeleton)
+   {
+      // Like the stress test of the model viewer, each track rotates its joint around its own axis with a cubic oscillation
+      const float amplitude = glm::half_pi<float>();
+
+      FastClip clip;
+      clip.SetName("Stress test");
+      for (unsigned int jointIndex = 0, size = skeleton.GetRestPose().GetNumberOfJoints(); jointIndex < size; ++jointIndex)
+      {
+         float     jointIndexAsFloat = static_cast<float>(jointIndex);
+         glm::vec3 axis              = glm::normalize(glm::vec3(glm::sin(jointIndexAsFloat * 1.3f), glm::cos(jointIndexAsFloat * 0.7f), glm::sin(jointIndexAsFloat * 0.3f) + 1.5f));
+         float     angularFrequency  = glm::two_pi<float>() * static_cast<float>(1 + (jointIndex % 5)) / duration;
+
+         FastQuaternionTrack& rotationTrack = clip.GetTransformTrackOfJoint(jointIndex).GetRotationTrack();
+         rotationTrack.SetInterpolation(Interpolation::Cubic);
+         rotationTrack.SetNumberOfFrames(numFrames);
+         for (unsigned int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+         {
+            float time       = duration * static_cast<float>(frameIndex) / static_cast<float>(numFrames - 1);
+            float angle      = amplitude * glm::sin(angularFrequency * time);
+            float angleSpeed = amplitude * angularFrequency * glm::cos(angularFrequency * time);
+
+            // The derivative of angleAxis(angle(t), axis) with respect to time
+            Q::quat   value         = Q::angleAxis(angle, axis);
+            glm::vec3 slopeOfVector = axis * (glm::cos(angle * 0.5f) * 0.5f * angleSpeed);
+            float     slopeOfScalar = -glm::sin(angle * 0.5f) * 0.5f * angleSpeed;
+
+            QuaternionFrame& frame = rotationTrack.GetFrame(frameIndex);
+            frame.mTime = time;
+            frame.mValue[0] = value.x;
+            frame.mValue[1] = value.y;
+            frame.mValue[2] = value.z;
+            frame.mValue[3] = value.w;
+            frame.mInSlope[0] = frame.mOutSlope[0] = slopeOfVector.x;
+            frame.mInSlope[1] = frame.mOutSlope[1] = slopeOfVector.y;
+            frame.mInSlope[2] = frame.mOutSlope[2] = slopeOfVector.z;
+            frame.mInSlope[3] = frame.mOutSlope[3] = slopeOfScalar;
+         }
+
+         rotationTrack.GenerateSampleToFrameIndexMap();
+      }
+
+      clip.RecalculateDuration();
+      return clip;
+   }
+
+   float MeasureSetTracks(TrackVisualizer& trackVisualizer, std::vector<FastTransformTrack>& tracks)
+   {
+      float fastestTime = 0.0f;
+      for (unsigned int repetitionIndex = 0; repetitionIndex < numRepetitions; ++repetitionIndex)
+      {
+         std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+         trackVisualizer.setTracks(tracks);
+         float time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+         fastestTime = (repetitionIndex == 0) ? time : std::min(fastestTime, time);
+      }
+
+      return fastestTime;
+   }
+
+   float MeasureSetPage(TrackVisualizer& trackVisualizer, unsigned int page)
+   {
+      // Switching to the page that is already displayed does nothing, so we leave it before each repetition
+      unsigned int otherPage   = (page == 0) ? 1 : 0;
+      float        fastestTime = 0.0f;
+      for (unsigned int repetitionIndex = 0; repetitionIndex < numRepetitions; ++repetitionIndex)
+      {
+         trackVisualizer.setPage(otherPage);
+
+         std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+         trackVisualizer.setPage(page);
+         float time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+         fastestTime = (repetitionIndex == 0) ? time : std::min(fastestTime, time);
+      }
+
+      return fastestTime;
+   }
+
+   bool CheckPaging(TrackVisualizer& trackVisualizer, FastClip& clip, bool evaluateCurvesOnGPU)
+   {
+      trackVisualizer.setEvaluateCurvesOnGPU(evaluateCurvesOnGPU);
+
+      // The tracks of the first page on their own are the reference for the cost of the tracks that are on the current page
+      std::vector<FastTransformTrack>& tracks = clip.GetTransformTracks();
+      std::vector<FastTransformTrack>  tracksOfFirstPage(tracks.begin(), tracks.begin() + maxNumGraphsPerPage);
+
+      float timeOfFirstPage = MeasureSetTracks(trackVisualizer, tracksOfFirstPage);
+      bool  firstPageFits   = (trackVisualizer.getNumberOfPages() == 1);
+
+      float        timeOfAllTracks         = MeasureSetTracks(trackVisualizer, tracks);
+      unsigned int numPages                = trackVisualizer.getNumberOfPages();
+      unsigned int expectedNumPages        = (numJoints + maxNumGraphsPerPage - 1) / maxNumGraphsPerPage;
+      bool         setTracksShowsFirstPage = (trackVisualizer.getPage() == 0);
+
+      unsigned int numOffPageTracks      = numJoints - maxNumGraphsPerPage;
+      float        costOfOnPageTrack     = timeOfFirstPage / maxNumGraphsPerPage;
+      float        costOfOffPageTrack    = std::max(timeOfAllTracks - timeOfFirstPage, 0.0f) / numOffPageTracks;
+      bool         offPageTracksAreCheap = (costOfOffPageTrack <= maxRelativeCostOfOffPageTrack * costOfOnPageTrack);
+
+      // Visit every page, and then go back to the first one
+      float maxPageBuildTime   = 0.0f;
+      bool  setPageVisitsPages = (numPages > 1);
+      for (unsigned int pageIndex = 1; pageIndex <= numPages && setPageVisitsPages; ++pageIndex)
+      {
+         unsigned int page = pageIndex % numPages;
+         maxPageBuildTime    = std::max(maxPageBuildTime, MeasureSetPage(trackVisualizer, page));
+         setPageVisitsPages &= (trackVisualizer.getPage() == page);
+      }
+      bool pagesAreFastToBuild = (maxPageBuildTime <= maxRelativePageBuildTime * timeOfFirstPage) &&
+                                 (maxPageBuildTime <= maxPageBuildTimeInMilliseconds);
+
+      // A page past the last one shows the last one
+      trackVisualizer.setPage(numPages);
+      setPageVisitsPages &= (trackVisualizer.getPage() == numPages - 1);
+
+      std::cout << (evaluateCurvesOnGPU ? "GPU curves" : "CPU curves")
+                << " - Pages: " << numPages
+                << ", setTracks (first page / all tracks): " << timeOfFirstPage << " / " << timeOfAllTracks << " ms"
+                << ", Cost per track (on page / off page): " << (1000.0f * costOfOnPageTrack) << " / " << (1000.0f * costOfOffPageTrack) << " us"
+                << ", Max page build time: " << maxPageBuildTime << " ms"
+                << ", Off-page tracks are cheap: " << (offPageTracksAreCheap ? "yes" : "no")
+                << ", Pages are visited: " << (setPageVisitsPages ? "yes" : "no") << "\n";
+
+      return firstPageFits &&
+             (numPages == expectedNumPages) &&
+             setTracksShowsFirstPage &&
+             setPageVisitsPages &&
+             offPageTracksAreCheap &&
+             pagesAreFastToBuild;
+   }
+}
+
+int main()
+{
+   HeadlessContext context;
+   if (!context.IsValid())
+   {
+      return HeadlessContext::skipReturnCode;
+   }
+
+   if (!std::ifstream("resources/shaders/graph.vert"))
+   {
+      std::cout << "Error - TrackVisualizerPagingCheck - The shaders of the track visualizer could not be found in resources/shaders" << "\n";
+      return 1;
+   }
+
+   Skeleton skeleton = TrackVisualizerPagingCheckHelpers::CreateSkeleton();
+   FastClip clip     = TrackVisualizerPagingCheckHelpers::CreateClip(skeleton);
+   if (clip.GetNumberOfTransformTracks() != TrackVisualizerPagingCheckHelpers::numJoints)
+   {
+      std::cout << "Error - TrackVisualizerPagingCheck - The clip doesn't animate every joint of the skeleton" << "\n";
+      return 1;
+   }
+
+   // The shaders and the buffers of the track visualizer must be deleted before the context
+   bool allChecksPass = true;
+   {
+      ResourceManager<Shader> shaderManager;
+      TrackVisualizer         trackVisualizer(shaderManager);
+
+      allChecksPass &= TrackVisualizerPagingCheckHelpers::CheckPaging(trackVisualizer, clip, true);
+      allChecksPass &= TrackVisualizerPagingCheckHelpers::CheckPaging(trackVisualizer, clip, false);
+   }
+
+   if (!allChecksPass)
+   {
+      std::cout << "Error - TrackVisualizerPagingCheck - The off-page tracks aren't cheap or the pages take too long to build" << "\n";
+      return 1;
+   }
+
+   return 0;
+}
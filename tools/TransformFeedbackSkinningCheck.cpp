@@ -0,0 +1,210 @@
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CPUSkinning.h"
+#include "GLTFLoader.h"
+#include "HeadlessContext.h"
+#include "RearrangeBones.h"
+#include "shader_loader.h"
+
+/*
+   Skins the meshes of the glTF files that are passed as arguments with transform feedback, in the same way as the model viewer,
+   reads the skinned vertices back and compares them with the vertices that SkinMesh skins on the CPU
+
+   Usage: TransformFeedbackSkinningCheck <resources directory> <glTF file>...
+
+   The GPU skins the quantized vertices of the packed format, so the differences come from the 8-bit weights and the 16-bit normals
+*/
+
+namespace TransformFeedbackSkinningCheckHelpers
+{
+   // This must match MAX_NUMBER_OF_SKIN_MATRICES in skinning_transform_feedback.vert
+   const unsigned int maxNumberOfSkinMatrices = 49;
+
+   // The position differences are relative to the size of the mesh, and the normal differences are in degrees
+   // The 8-bit weights alone can move a vertex by a few thousandths of the size of the mesh with the random skin matrices below
+   const float maxRelativePositionDifference = 0.005f;
+   const float maxNormalDifference           = 1.0f;
+
+   std::vector<glm::mat4> GenerateSkinMatrices(unsigned int numMatrices, std::mt19937& randomEngine)
+   {
+      std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+      std::vector<glm::mat4> skinMatrices(numMatrices);
+      for (glm::mat4& skinMatrix : skinMatrices)
+      {
+         skinMatrix = glm::mat4(1.0f);
+         for (int column = 0; column < 3; ++column)
+         {
+            for (int row = 0; row < 3; ++row)
+            {
+               skinMatrix[column][row] += 0.3f * distribution(randomEngine);
+            }
+         }
+         skinMatrix[3] = glm::vec4(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine), 1.0f);
+      }
+
+      return skinMatrices;
+   }
+
+   float CalculateSizeOfMesh(const AnimatedMesh& mesh)
+   {
+      if (mesh.GetPositions().empty())
+      {
+         return 1.0f;
+      }
+
+      glm::vec3 minPosition = mesh.GetPositions()[0];
+      glm::vec3 maxPosition = mesh.GetPositions()[0];
+      for (const glm::vec3& position : mesh.GetPositions())
+      {
+         minPosition = glm::min(minPosition, position);
+         maxPosition = glm::max(maxPosition, position);
+      }
+
+      return std::max(glm::length(maxPosition - minPosition), 1e-6f);
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: TransformFeedbackSkinningCheck <resources directory> <glTF file>..." << "\n";
+      return 1;
+   }
+
+   HeadlessContext context;
+   if (!context.IsValid())
+   {
+      return HeadlessContext::skipReturnCode;
+   }
+
+   // These are the shaders that the model viewer uses to skin the packed meshes and to configure their VAOs
+   std::string  shadersDirectory = std::string(argv[1]) + "/shaders/";
+   ShaderLoader loader;
+   std::shared_ptr<Shader> packedAnimatedMeshShader = loader.loadResource(shadersDirectory + "animated_mesh_with_packed_vertices.vert",
+                                                                          shadersDirectory + "diffuse_illumination.frag",
+                                                                          std::vector<std::string> { "NUM_INFLUENCES 4" });
+   std::shared_ptr<Shader> skinningShader           = loader.loadResource(shadersDirectory + "skinning_transform_feedback.vert",
+                                                                          shadersDirectory + "skinning_transform_feedback.frag",
+                                                                          std::vector<std::string>(),
+                                                                          std::vector<std::string> { "skinnedPosition", "skinnedNormal" });
+   std::shared_ptr<Shader> preSkinnedMeshShader     = loader.loadResource(shadersDirectory + "static_mesh.vert",
+                                                                          shadersDirectory + "diffuse_illumination.frag");
+   if (!packedAnimatedMeshShader || !skinningShader || !preSkinnedMeshShader)
+   {
+      std::cout << "Error - TransformFeedbackSkinningCheck - The shaders could not be loaded" << "\n";
+      return 1;
+   }
+
+   std::mt19937 randomEngine(3);
+   bool         allMeshesMatch = true;
+
+   for (int argIndex = 2; argIndex < argc; ++argIndex)
+   {
+      cgltf_data* data = LoadGLTFFile(argv[argIndex]);
+      if (data == nullptr)
+      {
+         return 1;
+      }
+
+      // Like the model viewer, the skeleton is rearranged so that only the joints that influence the meshes need skin matrices
+      Skeleton                  skeleton = LoadSkeleton(data);
+      JointMap                  jointMap = RearrangeSkeleton(skeleton, JointOrdering::DepthFirst);
+      std::vector<AnimatedMesh> meshes   = LoadAnimatedMeshes(data);
+      FreeGLTFFile(data);
+
+      unsigned int numJoints = skeleton.GetRestPose().GetNumberOfJoints();
+      if (numJoints > TransformFeedbackSkinningCheckHelpers::maxNumberOfSkinMatrices)
+      {
+         std::cout << "Error - TransformFeedbackSkinningCheck - " << argv[argIndex] << " has more joints than the skinning shader supports" << "\n";
+         allMeshesMatch = false;
+         continue;
+      }
+
+      std::vector<glm::mat4> skinMatrices = TransformFeedbackSkinningCheckHelpers::GenerateSkinMatrices(numJoints, randomEngine);
+
+      float        maxPositionDifference = 0.0f;
+      float        maxNormalDifference   = 0.0f;
+      unsigned int numVertices           = 0;
+      for (AnimatedMesh& mesh : meshes)
+      {
+         RearrangeMesh(mesh, jointMap);
+         if (!mesh.CanPackVertices())
+         {
+            std::cout << "Error - TransformFeedbackSkinningCheck - A mesh of " << argv[argIndex] << " can't use the packed vertex format" << "\n";
+            allMeshesMatch = false;
+            continue;
+         }
+
+         mesh.LoadPackedBuffers();
+         mesh.ConfigurePackedVAO(packedAnimatedMeshShader->getAttributeLocation("position"),
+                                 packedAnimatedMeshShader->getAttributeLocation("normal"),
+                                 packedAnimatedMeshShader->getAttributeLocation("texCoord"),
+                                 packedAnimatedMeshShader->getAttributeLocation("weights"),
+                                 packedAnimatedMeshShader->getAttributeLocation("joints"));
+         mesh.ConfigureSkinnedVAO(preSkinnedMeshShader->getAttributeLocation("position"),
+                                  preSkinnedMeshShader->getAttributeLocation("normal"),
+                                  preSkinnedMeshShader->getAttributeLocation("texCoord"));
+
+         skinningShader->use(true);
+         skinningShader->getUniform<std::vector<glm::mat4>>("animated[0]").set(skinMatrices);
+         glBindVertexArray(mesh.GetVAO());
+         mesh.CaptureSkinnedVertices();
+         glBindVertexArray(0);
+         skinningShader->use(false);
+
+         std::vector<glm::vec3> gpuPositions, gpuNormals, cpuPositions, cpuNormals;
+         mesh.ReadSkinnedVertices(gpuPositions, gpuNormals);
+         SkinMesh(mesh, skinMatrices, cpuPositions, cpuNormals);
+         if (gpuPositions.size() != cpuPositions.size() || gpuNormals.size() != cpuNormals.size())
+         {
+            std::cout << "Error - TransformFeedbackSkinningCheck - The number of skinned vertices doesn't match" << "\n";
+            allMeshesMatch = false;
+            continue;
+         }
+
+         float sizeOfMesh = TransformFeedbackSkinningCheckHelpers::CalculateSizeOfMesh(mesh);
+         for (unsigned int i = 0, size = static_cast<unsigned int>(gpuPositions.size()); i < size; ++i)
+         {
+            maxPositionDifference = std::max(maxPositionDifference, glm::length(gpuPositions[i] - cpuPositions[i]) / sizeOfMesh);
+            float cosOfAngle      = glm::clamp(glm::dot(gpuNormals[i], cpuNormals[i]), -1.0f, 1.0f);
+            maxNormalDifference   = std::max(maxNormalDifference, glm::degrees(std::acos(cosOfAngle)));
+         }
+         numVertices += static_cast<unsigned int>(gpuPositions.size());
+
+         // Drawing the skinned VAO with the static mesh shader makes sure that it's complete
+         preSkinnedMeshShader->use(true);
+         glBindVertexArray(mesh.GetSkinnedVAO());
+         mesh.DrawLevelOfDetail(0);
+         glBindVertexArray(0);
+         preSkinnedMeshShader->use(false);
+      }
+
+      GLenum error = glGetError();
+      std::cout << argv[argIndex] << " - Vertices: " << numVertices
+                << ", Max relative position difference: " << maxPositionDifference
+                << ", Max normal difference: " << maxNormalDifference << " degrees"
+                << ", GL error: " << error << "\n";
+
+      allMeshesMatch &= (error == GL_NO_ERROR) &&
+                        (maxPositionDifference <= TransformFeedbackSkinningCheckHelpers::maxRelativePositionDifference) &&
+                        (maxNormalDifference <= TransformFeedbackSkinningCheckHelpers::maxNormalDifference);
+   }
+
+   if (!allMeshesMatch)
+   {
+      std::cout << "Error - TransformFeedbackSkinningCheck - The skinned vertices don't match" << "\n";
+      return 1;
+   }
+
+   return 0;
+}